@@ -47,6 +47,20 @@ nfc_manager_start(
     NfcManager* manager)
     G_GNUC_INTERNAL;
 
+/* Enables persistent caching of Type 2 tag contents */
+void
+nfc_manager_set_t2_cache_dir(
+    NfcManager* manager,
+    const char* dir)
+    G_GNUC_INTERNAL;
+
+/* Records the traffic of each tag into a separate file in this directory */
+void
+nfc_manager_set_trace_dir(
+    NfcManager* manager,
+    const char* dir)
+    G_GNUC_INTERNAL;
+
 #endif /* NFC_MANAGER_INTERNAL_H */
 
 /*
@@ -75,6 +75,8 @@ typedef enum nfc_adapter_param_key {
     NFC_ADAPTER_PARAM_LA_NFCID1, /* (nfcid1) NFCID1 in NFC-A Listen mode */
     /* Since 1.2.4 */
     NFC_ADAPTER_PARAM_LI_A_HB, /* (hb) ATS Historical Bytes in Listen A mode */
+    /* Since 1.2.8 */
+    NFC_ADAPTER_PARAM_T4_NDEF_LAZY, /* (b) Read Type4 NDEF on demand */
     NFC_ADAPTER_PARAM_COUNT /* Number of known params, version dependent */
 } NFC_ADAPTER_PARAM; /* Since 1.2.2 */
 
@@ -89,6 +89,31 @@ nfc_peer_connection_rmiu(
     NfcPeerConnection* pc)
     NFCD_EXPORT;
 
+/*
+ * Local receive window RW(L) and MIU are advertised in CONNECT or CC
+ * PDU, so changing them only makes sense before that happens, e.g. in
+ * NfcPeerServiceClass::new_connect or new_accept. By default, they are
+ * inherited from the service. Zero means the default (maximum) value.
+ */
+void
+nfc_peer_connection_set_rw(
+    NfcPeerConnection* pc,
+    guint rw) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+void
+nfc_peer_connection_set_miu(
+    NfcPeerConnection* pc,
+    guint miu) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+/* Inherited from the service, see nfc_peer_service_set_ack_delay() */
+void
+nfc_peer_connection_set_ack_delay(
+    NfcPeerConnection* pc,
+    guint ms) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 gboolean
 nfc_peer_connection_send(
     NfcPeerConnection* pc,
@@ -77,6 +77,37 @@ nfc_peer_service_disconnect_all(
     NfcPeerService* service)
     NFCD_EXPORT;
 
+/*
+ * Receive window RW(L) and MIU advertised to the peer by the data link
+ * connections of this service. Values are clipped to the valid range,
+ * zero means the default (maximum). Only the connections created after
+ * the call are affected.
+ */
+void
+nfc_peer_service_set_rw(
+    NfcPeerService* service,
+    guint rw) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+void
+nfc_peer_service_set_miu(
+    NfcPeerService* service,
+    guint miu) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+/*
+ * How long (in milliseconds) the data link connections of this service
+ * may hold the acknowledgement of the received I PDUs, giving the local
+ * side a chance to piggyback it onto its own data. Zero (the default)
+ * means no delay. Only the connections created after the call are
+ * affected.
+ */
+void
+nfc_peer_service_set_ack_delay(
+    NfcPeerService* service,
+    guint ms) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 G_END_DECLS
 
 #endif /* NFC_PEER_SERVICE_H */
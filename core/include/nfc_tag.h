@@ -44,6 +44,7 @@ typedef struct nfc_tag_priv NfcTagPriv;
 typedef enum nfc_tag_flags {
     NFC_TAG_FLAGS_NONE = 0x00,
     NFC_TAG_FLAG_INITIALIZED = 0x01,
+    NFC_TAG_FLAG_NDEF_DEFERRED = 0x02   /* Since 1.2.8 */
 } NFC_TAG_FLAGS;
 
 struct nfc_tag {
@@ -54,7 +55,7 @@ struct nfc_tag {
     gboolean present;
     NFC_TAG_TYPE type;
     NFC_TAG_FLAGS flags;
-    NfcNdefRec* ndef;  /* Valid only when initialized */
+    NfcNdefRec* ndef;  /* Valid only when initialized and not deferred */
 };
 
 GType nfc_tag_get_type(void) NFCD_EXPORT;
@@ -88,6 +89,20 @@ nfc_tag_deactivate(
     NfcTag* tag)
     NFCD_EXPORT;
 
+/*
+ * If NFC_TAG_FLAG_NDEF_DEFERRED flag is set, the tag has been reported
+ * as initialized without reading its NDEF. nfc_tag_read_ndef() starts
+ * (or joins) the read. TRUE means that the read is pending, in which
+ * case the NDEF ready signal gets emitted when it's done. FALSE means
+ * that NDEF (if any) is already there and there's nothing to wait for.
+ * If the flag was set, the NDEF ready signal has been emitted before
+ * nfc_tag_read_ndef() returns FALSE.
+ */
+gboolean
+nfc_tag_read_ndef(
+    NfcTag* tag) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 gulong
 nfc_tag_add_gone_handler(
     NfcTag* tag,
@@ -102,6 +117,13 @@ nfc_tag_add_initialized_handler(
     void* user_data)
     NFCD_EXPORT;
 
+gulong
+nfc_tag_add_ndef_ready_handler(
+    NfcTag* tag,
+    NfcTagFunc func,
+    void* user_data) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 void
 nfc_tag_remove_handler(
     NfcTag* tag,
@@ -200,6 +200,34 @@ nfc_tag_t2_write_data_seq(
     void* user_data) /* Since 1.0.17 */
     NFCD_EXPORT;
 
+/*
+ * Writes only the blocks which differ from what's stored on the tag,
+ * fetching the blocks which haven't been cached yet. The number of
+ * blocks which didn't need to be written is passed to the completion
+ * callback, along with the number of bytes known to be on the tag
+ * (whether they were actually written or not).
+ */
+
+typedef
+void
+(*NfcTagType2WriteDiffFunc)(
+    NfcTagType2* tag,
+    NFC_TAG_T2_IO_STATUS status,
+    guint written,
+    guint skipped,
+    void* user_data); /* Since 1.2.8 */
+
+guint
+nfc_tag_t2_write_data_diff(
+    NfcTagType2* tag,
+    guint offset,
+    GBytes* bytes,
+    NfcTargetSequence* seq,
+    NfcTagType2WriteDiffFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 G_END_DECLS
 
 #endif /* NFC_TAG_T2_H */
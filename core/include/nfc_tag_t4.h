@@ -157,6 +157,113 @@ nfc_isodep_reset(
     void* user_data) /* Since 1.0.44 */
     NFCD_EXPORT;
 
+/*
+ * Extended transmission modes. With NFC_ISODEP_TX_FLAG_GET_RESPONSE,
+ * 61xx status words are followed by GET RESPONSE until the card has
+ * returned everything, and 6Cxx causes the command to be repeated with
+ * the right Le. With NFC_ISODEP_TX_FLAG_CHAINING, command data which
+ * doesn't fit into a short APDU is sent as a command chain. Either way,
+ * the whole exchange is performed within one sequence and the response
+ * function is invoked once, with the reassembled response data.
+ *
+ * The returned id can be passed to nfc_isodep_cancel(), which also
+ * accepts ids returned by nfc_isodep_transmit().
+ */
+
+typedef enum nfc_isodep_tx_flags {
+    NFC_ISODEP_TX_FLAGS_NONE = 0x00,
+    NFC_ISODEP_TX_FLAG_GET_RESPONSE = 0x01,
+    NFC_ISODEP_TX_FLAG_CHAINING = 0x02
+} NFC_ISODEP_TX_FLAGS; /* Since 1.2.8 */
+
+guint
+nfc_isodep_transmit2(
+    NfcTagType4* tag,
+    guint8 cla,             /* Class byte */
+    guint8 ins,             /* Instruction byte */
+    guint8 p1,              /* Parameter byte 1 */
+    guint8 p2,              /* Parameter byte 2 */
+    const GUtilData* data,  /* Command data */
+    guint le,               /* Expected length, zero if none */
+    NFC_ISODEP_TX_FLAGS flags,
+    NfcTargetSequence* seq,
+    NfcTagType4ResponseFunc resp,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+gboolean
+nfc_isodep_cancel(
+    NfcTagType4* tag,
+    guint id) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+/*
+ * The currently selected DF and EF are tracked by watching SELECT
+ * commands and their responses. The selection is forgotten after reset,
+ * reactivation and any error other than a failed SELECT (which leaves
+ * the selection unchanged). In select cache mode, a SELECT that would
+ * select what's already selected is completed with the FCI recorded last
+ * time, without sending anything to the card. Such requests can only be
+ * cancelled with nfc_isodep_cancel().
+ *
+ * Raw transmissions bypassing nfc_isodep_transmit() aren't tracked,
+ * the cache must not be enabled if those are being used. Enabling the
+ * cache forgets the current selection.
+ */
+
+typedef struct nfc_isodep_select_stats {
+    guint sent;     /* SELECT commands sent to the card */
+    guint cached;   /* SELECT commands completed from the cache */
+} NfcIsoDepSelectStats; /* Since 1.2.8 */
+
+void
+nfc_isodep_set_select_cache(
+    NfcTagType4* tag,
+    gboolean enable) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+const NfcIsoDepSelectStats*
+nfc_isodep_select_stats(
+    NfcTagType4* tag) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+/*
+ * NDEF Update Procedure (NFCForum-TS-Type-4-Tag_2.0, Section 5.4.5).
+ * NLEN is zeroed first, then the message is written with UPDATE BINARY
+ * commands as large as allowed by MLc (and extended Lc support), and
+ * finally NLEN is set to the new length. The whole thing is done within
+ * one sequence. Note that tag->ndef isn't updated.
+ *
+ * The returned id can be passed to nfc_isodep_cancel().
+ */
+
+typedef enum nfc_tag_t4_write_status {
+    NFC_TAG_T4_WRITE_OK,            /* NDEF written */
+    NFC_TAG_T4_WRITE_FAILURE,       /* Unspecified failure */
+    NFC_TAG_T4_WRITE_IO_ERROR,      /* Transmission error */
+    NFC_TAG_T4_WRITE_NOT_NDEF,      /* No NDEF Tag Application */
+    NFC_TAG_T4_WRITE_READ_ONLY,     /* Write access not granted */
+    NFC_TAG_T4_WRITE_TOO_BIG        /* NDEF file is too small */
+} NFC_TAG_T4_WRITE_STATUS; /* Since 1.2.8 */
+
+typedef
+void
+(*NfcTagType4WriteNdefFunc)(
+    NfcTagType4* tag,
+    NFC_TAG_T4_WRITE_STATUS status,
+    void* user_data); /* Since 1.2.8 */
+
+guint
+nfc_tag_t4_write_ndef(
+    NfcTagType4* tag,
+    GBytes* ndef,
+    NfcTargetSequence* seq,
+    NfcTagType4WriteNdefFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 G_END_DECLS
 
 #endif /* NFC_TAG_T4_H */
@@ -101,6 +101,47 @@ nfc_target_set_transmit_timeout(
     int ms) /* Since 1.0.37 */
     NFCD_EXPORT;
 
+/*
+ * In adaptive mode, the transmission timeout is derived from the measured
+ * round-trip times (the way TCP computes its retransmission timeout) and
+ * the value set by nfc_target_set_transmit_timeout() becomes the upper
+ * limit. Zero still means no timeout at all.
+ */
+void
+nfc_target_set_adaptive_timeout(
+    NfcTarget* target,
+    gboolean enable) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+/*
+ * By default, the next queued request is submitted from an idle callback
+ * after the previous one has completed. In synchronous mode it's submitted
+ * directly from nfc_target_transmit_done() unless nfc_target_transmit_done()
+ * is being called from inside the transmit method, in which case NfcTarget
+ * still falls back to the idle callback.
+ */
+
+typedef enum nfc_target_dispatch_mode {
+    NFC_TARGET_DISPATCH_IDLE,
+    NFC_TARGET_DISPATCH_SYNC
+} NFC_TARGET_DISPATCH_MODE; /* Since 1.2.8 */
+
+typedef struct nfc_target_dispatch_stats {
+    guint sync;   /* Requests submitted directly on completion */
+    guint idle;   /* Requests submitted from the idle callback */
+} NfcTargetDispatchStats; /* Since 1.2.8 */
+
+void
+nfc_target_set_dispatch_mode(
+    NfcTarget* target,
+    NFC_TARGET_DISPATCH_MODE mode) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
+const NfcTargetDispatchStats*
+nfc_target_dispatch_stats(
+    NfcTarget* target) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 gulong
 nfc_target_add_sequence_handler(
     NfcTarget* target,
@@ -174,6 +215,16 @@ nfc_target_transmit(
     void* user_data)
     NFCD_EXPORT;
 
+guint
+nfc_target_transmit_bytes(
+    NfcTarget* target,
+    GBytes* data,
+    NfcTargetSequence* seq,
+    NfcTargetTransmitFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 gboolean
 nfc_target_cancel_transmit(
     NfcTarget* target,
@@ -63,9 +63,21 @@ typedef struct nfc_target_class {
      * Reactivation isn't cancellable, it either succeeds or fails. */
     gboolean (*reactivate)(NfcTarget* target);  /* Since 1.0.27 */
 
+    /* If implemented, it's called instead of transmit. Implementation
+     * may hold a reference to the data until the transmission completes,
+     * i.e. pass it to the driver without copying. */
+    gboolean (*transmit_bytes)(NfcTarget* target, GBytes* data);
+                                                /* Since 1.2.8 */
+
+    /* If implemented, it's used for submitting several frames of the same
+     * sequence at once, when more than one is queued. The implementation
+     * calls nfc_target_transmit_done() once per frame, in the same order
+     * as the frames were passed in. If it returns FALSE, it must not have
+     * completed any of them. cancel_transmit cancels the whole batch. */
+    gboolean (*transmit_batch)(NfcTarget* target, GBytes* const* frames,
+        guint count);                           /* Since 1.2.8 */
+
     /* Padding for future expansion */
-    void (*_reserved1)(void);
-    void (*_reserved2)(void);
     void (*_reserved3)(void);
     void (*_reserved4)(void);
     void (*_reserved5)(void);
@@ -86,6 +98,15 @@ nfc_target_transmit_done(
     guint len)
     NFCD_EXPORT;
 
+/* Maximum size of a frame which the adapter can receive from the target,
+ * zero if unknown. Tag implementations use it to decide how much data
+ * can be requested in a single transmission. */
+void
+nfc_target_set_max_frame_size(
+    NfcTarget* target,
+    guint size) /* Since 1.2.8 */
+    NFCD_EXPORT;
+
 void
 nfc_target_reactivated(
     NfcTarget* target) /* Since 1.0.27 */
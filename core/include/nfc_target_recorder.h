@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFC_TARGET_RECORDER_H
+#define NFC_TARGET_RECORDER_H
+
+#include "nfc_types.h"
+
+/* Since 1.2.8 */
+
+G_BEGIN_DECLS
+
+/*
+ * Recorder writes NfcTarget traffic into a binary trace which can be
+ * replayed later on. All multi-byte numbers are big-endian.
+ *
+ * Header (8 bytes):
+ *
+ *   +--------+---------+------------+----------+----------+
+ *   | "NFCT" | version | technology | protocol | reserved |
+ *   +--------+---------+------------+----------+----------+
+ *
+ * Followed by records (14 bytes + data):
+ *
+ *   +------+--------+--------+------------+----------------+------+
+ *   | type | status | id (4) | length (4) | time delta (4) | data |
+ *   +------+--------+--------+------------+----------------+------+
+ *
+ * Time delta is the number of microseconds elapsed since the previous
+ * record (or since the recording has started, for the first record).
+ * Id identifies the transmission, each NFC_TARGET_TRACE_TRANSMIT record
+ * is followed (not necessarily immediately) by NFC_TARGET_TRACE_RESPONSE
+ * or NFC_TARGET_TRACE_CANCEL with the same id. Status is only meaningful
+ * for NFC_TARGET_TRACE_RESPONSE records.
+ */
+
+#define NFC_TARGET_TRACE_MAGIC "NFCT"
+#define NFC_TARGET_TRACE_VERSION (1)
+#define NFC_TARGET_TRACE_HEADER_SIZE (8)
+#define NFC_TARGET_TRACE_RECORD_SIZE (14)
+
+typedef enum nfc_target_trace_type {
+    NFC_TARGET_TRACE_TRANSMIT = 1,      /* Frame sent to the target */
+    NFC_TARGET_TRACE_RESPONSE,          /* Transmission completed */
+    NFC_TARGET_TRACE_SEQUENCE_START,    /* Sequence became active */
+    NFC_TARGET_TRACE_SEQUENCE_END,      /* Sequence finished */
+    NFC_TARGET_TRACE_CANCEL             /* Transmission cancelled */
+} NFC_TARGET_TRACE_TYPE;
+
+/* Returns NULL if the file can't be created or target is already
+ * being recorded. */
+NfcTargetRecorder*
+nfc_target_recorder_new(
+    NfcTarget* target,
+    const char* path)
+    NFCD_EXPORT;
+
+void
+nfc_target_recorder_free(
+    NfcTargetRecorder* recorder)
+    NFCD_EXPORT;
+
+G_END_DECLS
+
+#endif /* NFC_TARGET_RECORDER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -69,6 +69,7 @@ typedef struct nfc_tag_t4a NfcTagType4a; /* Since 1.0.20 */
 typedef struct nfc_tag_t4b NfcTagType4b; /* Since 1.0.20 */
 typedef struct nfc_target NfcTarget;
 typedef struct nfc_target_sequence NfcTargetSequence;
+typedef struct nfc_target_recorder NfcTargetRecorder; /* Since 1.2.8 */
 
 typedef struct nfc_param_listen_a NfcParamListenA;  /* Since 1.1.0 */
 typedef struct nfc_param_iso_dep_poll_a NfcParamIsoDepPollA; /* Since 1.0.20 */
@@ -42,6 +42,7 @@
 #include "nfc_tag_p.h"
 #include "nfc_tag_t4_p.h"
 #include "nfc_peer_p.h"
+#include "nfc_target_recorder.h"
 #include "nfc_log.h"
 
 #include <gutil_misc.h>
@@ -54,6 +55,7 @@
 #define NFC_TAG_NAME_FORMAT "tag%u"
 #define NFC_PEER_NAME_FORMAT "peer%u"
 #define NFC_HOST_NAME_FORMAT "host%u"
+#define NFC_TRACE_NAME_FORMAT "%s-%s-%u.nfct"
 
 struct nfc_adapter_param_request {
     NfcAdapter* adapter;
@@ -64,6 +66,7 @@ struct nfc_adapter_param_request {
 typedef struct nfc_adapter_object_entry {
     gpointer obj;
     gulong gone_id;
+    NfcTargetRecorder* recorder;
 } NfcAdapterObjectEntry;
 
 struct nfc_adapter_priv {
@@ -77,6 +80,7 @@ struct nfc_adapter_priv {
     guint next_tag_index;
     guint next_peer_index;
     guint next_host_index;
+    guint next_trace_index;
     guint32 pending_signals;
     NFC_MODE mode_submitted;
     gboolean mode_pending;
@@ -84,6 +88,7 @@ struct nfc_adapter_priv {
     gboolean power_pending;
     NFC_ADAPTER_PARAM* supported_params;
     gboolean t4_ndef;
+    gboolean t4_ndef_lazy;
     GQueue param_requests;
 };
 
@@ -141,7 +146,8 @@ static guint nfc_adapter_signals[SIGNAL_COUNT] = { 0 };
 #define NFC_ADAPTER_PARAMS(p) \
     p(T4_NDEF) \
     p(LA_NFCID1) \
-    p(LI_A_HB)
+    p(LI_A_HB) \
+    p(T4_NDEF_LAZY)
 
 static const char* nfc_adapter_param_names[] = {
     NULL, /* NFC_ADAPTER_PARAM_NONE */
@@ -166,10 +172,12 @@ G_STATIC_ASSERT(G_N_ELEMENTS(nfc_adapter_param_detailed_signals) ==
 /* These are being handled internally by nfcd */
 static const NFC_ADAPTER_PARAM nfc_adapter_builtin_params[] = {
     NFC_ADAPTER_PARAM_T4_NDEF,
+    NFC_ADAPTER_PARAM_T4_NDEF_LAZY,
     NFC_ADAPTER_PARAM_NONE
 };
 
 #define NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF TRUE
+#define NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF_LAZY FALSE
 
 static
 void
@@ -458,6 +466,7 @@ nfc_adapter_object_entry_free(
     NfcAdapterObjectEntry* entry = data;
 
     g_signal_handler_disconnect(entry->obj, entry->gone_id);
+    nfc_target_recorder_free(entry->recorder);
     g_object_unref(entry->obj);
     gutil_slice_free(entry);
 }
@@ -471,6 +480,38 @@ nfc_adapter_get_manager(
     return NFC_MANAGER(gutil_weakref_get(priv->manager_ref));
 }
 
+static
+NfcTargetRecorder*
+nfc_adapter_record_target(
+    NfcAdapter* self,
+    NfcTarget* target)
+{
+    NfcAdapterPriv* priv = self->priv;
+    NfcManager* manager = nfc_adapter_get_manager(priv);
+    const char* dir = nfc_manager_trace_dir(manager);
+    NfcTargetRecorder* recorder = NULL;
+
+    /*
+     * Recording has to start before the tag object gets created,
+     * because that's when the tag initialization sequence starts.
+     */
+    if (dir && target) {
+        GDateTime* now = g_date_time_new_now_local();
+        char* stamp = g_date_time_format(now, "%Y%m%d-%H%M%S");
+        char* file = g_strdup_printf(NFC_TRACE_NAME_FORMAT,
+            priv->name ? priv->name : "nfc", stamp, priv->next_trace_index++);
+        char* path = g_build_filename(dir, file, NULL);
+
+        recorder = nfc_target_recorder_new(target, path);
+        g_free(path);
+        g_free(file);
+        g_free(stamp);
+        g_date_time_unref(now);
+    }
+    nfc_manager_unref(manager);
+    return recorder;
+}
+
 static
 void
 nfc_adapter_tag_gone(
@@ -480,13 +521,24 @@ nfc_adapter_tag_gone(
     nfc_adapter_remove_tag(THIS(adapter), tag->name);
 }
 
+static
+NFC_TAG_T4_NDEF_MODE
+nfc_adapter_t4_ndef_mode(
+    NfcAdapterPriv* priv)
+{
+    return !priv->t4_ndef ? NFC_TAG_T4_NDEF_SKIP :
+        priv->t4_ndef_lazy ? NFC_TAG_T4_NDEF_LAZY :
+        NFC_TAG_T4_NDEF_READ;
+}
+
 static
 NfcTag*
 nfc_adapter_add_tag(
     NfcAdapter* self,
-    NfcTag* tag)
+    NfcTag* tag,
+    NfcTargetRecorder* recorder)
 {
-    /* This function takes ownership of the tag */
+    /* This function takes ownership of the tag and the recorder */
     if (tag->present) {
         NfcAdapterPriv* priv = self->priv;
         NfcAdapterObjectEntry* entry = g_slice_new(NfcAdapterObjectEntry);
@@ -496,6 +548,7 @@ nfc_adapter_add_tag(
         GASSERT(!tag->name);
         nfc_tag_set_name(tag, name);
         entry->obj = tag;
+        entry->recorder = recorder;
         entry->gone_id = nfc_tag_add_gone_handler(tag, nfc_adapter_tag_gone,
             self);
         g_hash_table_insert(priv->tag_table, name, entry);
@@ -505,6 +558,7 @@ nfc_adapter_add_tag(
         g_signal_emit(self, nfc_adapter_signals[SIGNAL_TAG_ADDED], 0, tag);
         return tag;
     } else {
+        nfc_target_recorder_free(recorder);
         nfc_tag_unref(tag);
         return NULL;
     }
@@ -535,6 +589,7 @@ nfc_adapter_add_peer(
         GASSERT(!peer->name);
         nfc_peer_set_name(peer, name);
         entry->obj = peer;
+        entry->recorder = NULL;
         entry->gone_id = nfc_peer_add_gone_handler(peer, nfc_adapter_peer_gone,
             self);
         g_hash_table_insert(priv->peer_table, name, entry);
@@ -831,11 +886,16 @@ nfc_adapter_add_tag_t2(
     const NfcTagParamT2* params)
 {
     if (G_LIKELY(self)) {
-        NfcTagType2* t2 = nfc_tag_t2_new(target, params);
+        NfcManager* manager = nfc_adapter_get_manager(self->priv);
+        NfcTargetRecorder* recorder = nfc_adapter_record_target(self, target);
+        NfcTagType2* t2 = nfc_tag_t2_new(target, params,
+            nfc_manager_t2_cache(manager));
 
+        nfc_manager_unref(manager);
         if (t2) {
-            return nfc_adapter_add_tag(self, NFC_TAG(t2));
+            return nfc_adapter_add_tag(self, NFC_TAG(t2), recorder);
         }
+        nfc_target_recorder_free(recorder);
     }
     return NULL;
 }
@@ -849,12 +909,14 @@ nfc_adapter_add_tag_t4a(
 {
     if (G_LIKELY(self) && G_LIKELY(target)) {
         NfcAdapterPriv* priv = self->priv;
-        NfcTagType4a* t4a = nfc_tag_t4a_new(target, priv->t4_ndef,
-            tech_param, iso_dep_param);
+        NfcTargetRecorder* recorder = nfc_adapter_record_target(self, target);
+        NfcTagType4a* t4a = nfc_tag_t4a_new(target,
+            nfc_adapter_t4_ndef_mode(priv), tech_param, iso_dep_param);
 
         if (t4a) {
-            return nfc_adapter_add_tag(self, NFC_TAG(t4a));
+            return nfc_adapter_add_tag(self, NFC_TAG(t4a), recorder);
         }
+        nfc_target_recorder_free(recorder);
     }
     return NULL;
 }
@@ -868,12 +930,14 @@ nfc_adapter_add_tag_t4b(
 {
     if (G_LIKELY(self) && G_LIKELY(target)) {
         NfcAdapterPriv* priv = self->priv;
-        NfcTagType4b* t4b = nfc_tag_t4b_new(target, priv->t4_ndef,
-            tech_param, iso_dep_param);
+        NfcTargetRecorder* recorder = nfc_adapter_record_target(self, target);
+        NfcTagType4b* t4b = nfc_tag_t4b_new(target,
+            nfc_adapter_t4_ndef_mode(priv), tech_param, iso_dep_param);
 
         if (t4b) {
-            return nfc_adapter_add_tag(self, NFC_TAG(t4b));
+            return nfc_adapter_add_tag(self, NFC_TAG(t4b), recorder);
         }
+        nfc_target_recorder_free(recorder);
     }
     return NULL;
 }
@@ -893,11 +957,13 @@ nfc_adapter_add_other_tag2(
     const NfcParamPoll* poll) /* Since 1.0.33 */
 {
     if (G_LIKELY(self)) {
+        NfcTargetRecorder* recorder = nfc_adapter_record_target(self, target);
         NfcTag* tag = nfc_tag_new(target, poll);
 
         if (tag) {
-            return nfc_adapter_add_tag(self, tag);
+            return nfc_adapter_add_tag(self, tag, recorder);
         }
+        nfc_target_recorder_free(recorder);
     }
     return NULL;
 }
@@ -1474,8 +1540,15 @@ nfc_adapter_default_get_param(
     NfcAdapterPriv* priv = self->priv;
     NfcAdapterParamValue* value = NULL;
 
-    if (id == NFC_ADAPTER_PARAM_T4_NDEF) {
+    switch (id) {
+    case NFC_ADAPTER_PARAM_T4_NDEF:
         (value = g_new0(NfcAdapterParamValue, 1))->b = priv->t4_ndef;
+        break;
+    case NFC_ADAPTER_PARAM_T4_NDEF_LAZY:
+        (value = g_new0(NfcAdapterParamValue, 1))->b = priv->t4_ndef_lazy;
+        break;
+    default:
+        break;
     }
     return value;
 }
@@ -1489,9 +1562,11 @@ nfc_adapter_default_set_params(
 {
     NfcAdapterPriv* priv = self->priv;
     const gboolean prev_t4_ndef = priv->t4_ndef;
+    const gboolean prev_t4_ndef_lazy = priv->t4_ndef_lazy;
 
     if (reset) {
         priv->t4_ndef = NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF;
+        priv->t4_ndef_lazy = NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF_LAZY;
     }
 
     if (params) {
@@ -1500,8 +1575,15 @@ nfc_adapter_default_set_params(
         while (*ptr) {
             const NfcAdapterParam* p = *ptr++;
 
-            if (p->id == NFC_ADAPTER_PARAM_T4_NDEF) {
+            switch (p->id) {
+            case NFC_ADAPTER_PARAM_T4_NDEF:
                 priv->t4_ndef = p->value.b != FALSE;
+                break;
+            case NFC_ADAPTER_PARAM_T4_NDEF_LAZY:
+                priv->t4_ndef_lazy = p->value.b != FALSE;
+                break;
+            default:
+                break;
             }
         }
     }
@@ -1509,6 +1591,10 @@ nfc_adapter_default_set_params(
     if (priv->t4_ndef != prev_t4_ndef) {
         nfc_adapter_param_change_notify(self, NFC_ADAPTER_PARAM_T4_NDEF);
     }
+    if (priv->t4_ndef_lazy != prev_t4_ndef_lazy) {
+        nfc_adapter_param_change_notify(self,
+            NFC_ADAPTER_PARAM_T4_NDEF_LAZY);
+    }
 }
 
 static
@@ -1530,6 +1616,7 @@ nfc_adapter_init(
     priv->host_table = g_hash_table_new_full(g_str_hash, g_str_equal,
         g_free, nfc_adapter_object_entry_free);
     priv->t4_ndef = NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF;
+    priv->t4_ndef_lazy = NFC_ADAPTER_PARAM_DEFAULT_T4_NDEF_LAZY;
     g_queue_init(&priv->param_requests);
 }
 
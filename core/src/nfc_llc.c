@@ -36,6 +36,7 @@
 #include "nfc_llc.h"
 #include "nfc_llc_io.h"
 #include "nfc_llc_param.h"
+#include "nfc_llc_queue.h"
 #include "nfc_peer_connection_p.h"
 #include "nfc_peer_service_p.h"
 #include "nfc_peer_services.h"
@@ -109,7 +110,9 @@ typedef struct nfc_llc_object {
     guint miu;
     guint lto;
     guint packets_handled;
-    GList* pdu_queue;
+    guint ack_timer_id;
+    NfcLlcAckStats ack_stats;
+    NfcLlcQueue* pdu_queue;
     GSList* connect_queue;
     GHashTable* conn_table;
 } NfcLlcObject;
@@ -156,6 +159,12 @@ nfc_llc_handle_pdu(
     const void* data,
     gsize len);
 
+static
+void
+nfc_llc_flush_acks(
+    NfcLlcObject* self,
+    gboolean force);
+
 /*==========================================================================*
  * Implementation
  *==========================================================================*/
@@ -293,20 +302,110 @@ nfc_llc_connect_req_free(
     g_slice_free1(sizeof(*req), req);
 }
 
+static
+GBytes*
+nfc_llc_pdu_update_nr(
+    NfcLlcObject* self,
+    GBytes* pdu) /* Takes ownership */
+{
+    gsize size;
+    const guint8* pkt = g_bytes_get_data(pdu, &size);
+    const guint hdr = (((guint)(pkt[0])) << 8) | pkt[1];
+    const LLCP_PTYPE ptype = LLCP_GET_PTYPE(hdr);
+
+    if (size > 2 && (ptype == LLCP_PTYPE_I || ptype == LLCP_PTYPE_RR ||
+        ptype == LLCP_PTYPE_RNR)) {
+        NfcPeerConnection* conn = g_hash_table_lookup(self->conn_table,
+            LLCP_CONN_KEY(LLCP_GET_SSAP(hdr), LLCP_GET_DSAP(hdr)));
+
+        /*
+         * N(R) was filled in when the PDU was queued. If more I PDUs
+         * have been received since then, bring it up to date so that
+         * the PDU being sent acknowledges everything received so far.
+         * That's what makes a separate RR unnecessary. N(R) is the
+         * lower nibble of the third byte, both in I and RR/RNR PDUs.
+         */
+        if (conn) {
+            NfcPeerConnectionLlcpState* ps = nfc_peer_connection_ps(conn);
+
+            if ((pkt[2] & 0x0f) != ps->vr) {
+                guint8* data = g_bytes_unref_to_data(pdu, &size);
+
+                data[2] = (data[2] & 0xf0) | ps->vr;
+                pdu = g_bytes_new_take(data, size);
+            }
+            if (ptype == LLCP_PTYPE_I && ps->nrt != ps->vr) {
+                /* This I PDU acknowledges something, no RR needed */
+                self->ack_stats.piggybacked++;
+            }
+            ps->nrt = ps->vr;
+            ps->vra = ps->vr;
+        }
+    }
+    return pdu;
+}
+
 static
 GBytes*
 nfc_llc_dequeue_pdu(
     NfcLlcObject* self)
 {
-    GList* first = g_list_first(self->pdu_queue);
+    GBytes* pdu = nfc_llc_queue_pop(self->pdu_queue);
+
+    return pdu ? nfc_llc_pdu_update_nr(self, pdu) : NULL;
+}
+
+static
+gboolean
+nfc_llc_find_i_pdu(
+    NfcLlcObject* self,
+    guint8 dsap,
+    guint8 ssap)
+{
+    const guint hdr = LLCP_MAKE_HDR(dsap, LLCP_PTYPE_I, ssap);
+    const guint n = nfc_llc_queue_size(self->pdu_queue);
+    guint i;
 
-    if (first) {
-        GBytes* bytes = first->data;
+    for (i = 0; i < n; i++) {
+        GBytes* pdu = nfc_llc_queue_peek(self->pdu_queue, i);
+        const guint8* pkt = g_bytes_get_data(pdu, NULL);
 
-        self->pdu_queue = g_list_delete_link(self->pdu_queue, first);
-        return bytes;
+        if (((((guint)(pkt[0])) << 8) | pkt[1]) == hdr) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+NFC_LLC_QUEUE_CLASS
+nfc_llc_pdu_class(
+    NfcLlcObject* self,
+    GBytes* pdu)
+{
+    const guint8* pkt = g_bytes_get_data(pdu, NULL);
+    const guint hdr = (((guint)(pkt[0])) << 8) | pkt[1];
+
+    switch (LLCP_GET_PTYPE(hdr)) {
+    case LLCP_PTYPE_I:
+    case LLCP_PTYPE_UI:
+        return NFC_LLC_QUEUE_DATA;
+    case LLCP_PTYPE_DISC:
+        /* DISC must not overtake the data sent over this connection */
+        return NFC_LLC_QUEUE_DATA;
+    case LLCP_PTYPE_RR:
+    case LLCP_PTYPE_RNR:
+        /*
+         * An I PDU already queued for the same connection carries
+         * an older N(R). The acknowledgement must not overtake it,
+         * otherwise the peer would see N(R) going backwards.
+         */
+        return nfc_llc_find_i_pdu(self, LLCP_GET_DSAP(hdr),
+            LLCP_GET_SSAP(hdr)) ? NFC_LLC_QUEUE_DATA :
+            NFC_LLC_QUEUE_CONTROL;
+    default:
+        return NFC_LLC_QUEUE_CONTROL;
     }
-    return NULL;
 }
 
 static
@@ -385,7 +484,7 @@ nfc_llc_submit(
     NfcLlcObject* self,
     GBytes* pdu)
 {
-    self->pdu_queue = g_list_append(self->pdu_queue, g_bytes_ref(pdu));
+    nfc_llc_queue_push(self->pdu_queue, nfc_llc_pdu_class(self, pdu), pdu);
     if (self->io->can_send) {
         nfc_llc_send_next_pdu(self);
     }
@@ -559,11 +658,86 @@ nfc_llc_ack_internal(
         pkt[0] = (guint8)(hdr >> 8);
         pkt[1] = (guint8)hdr;
         pkt[2] = ps->vra;
+        self->ack_stats.sent++;
         nfc_llc_submit(self, pdu);
         g_bytes_unref(pdu);
     }
 }
 
+static
+gboolean
+nfc_llc_ack_timeout(
+    gpointer user_data)
+{
+    NfcLlcObject* self = THIS(user_data);
+
+    GDEBUG("Ack timer expired");
+    self->ack_timer_id = 0;
+    if (self->pub.state < NFC_LLC_STATE_ERROR) {
+        nfc_llc_flush_acks(self, TRUE);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_llc_flush_acks(
+    NfcLlcObject* self,
+    gboolean force)
+{
+    GSList* acks = NULL;
+    guint delay = 0;
+    GHashTableIter it;
+    gpointer value;
+
+    /*
+     * Received I PDUs are acknowledged lazily. An I PDU already queued
+     * for the connection will carry the current N(R) when it's actually
+     * sent (see nfc_llc_pdu_update_nr), so nothing needs to be done for
+     * such connections. Otherwise, a standalone RR gets submitted if
+     * the connection has no ack delay, the local receive window is
+     * filling up or the ack timer has expired. Until then, the application
+     * has a chance to respond and have N(R) piggybacked onto its data.
+     * The timer is shared by all connections, it's started with the
+     * shortest delay of those waiting for it.
+     */
+    g_hash_table_iter_init(&it, self->conn_table);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        NfcPeerConnection* conn = value;
+        const NfcPeerConnectionLlcpState* ps = nfc_peer_connection_ps(conn);
+
+        if (conn->state == NFC_LLC_CO_ACTIVE && ps->vra != ps->vr &&
+            !nfc_llc_find_i_pdu(self, conn->rsap, conn->service->sap)) {
+            const guint ms = nfc_peer_connection_ack_delay(conn);
+
+            if (force || !ms || nfc_peer_connection_ack_due(conn)) {
+                acks = g_slist_append(acks, nfc_peer_connection_ref(conn));
+            } else if (!delay || delay > ms) {
+                delay = ms;
+            }
+        }
+    }
+
+    if (delay) {
+        if (!self->ack_timer_id) {
+            self->ack_timer_id = g_timeout_add(delay, nfc_llc_ack_timeout,
+                self);
+        }
+    } else if (self->ack_timer_id) {
+        g_source_remove(self->ack_timer_id);
+        self->ack_timer_id = 0;
+    }
+
+    if (acks) {
+        GSList* l;
+
+        for (l = acks; l; l = l->next) {
+            nfc_llc_ack_internal(self, l->data, FALSE);
+        }
+        g_slist_free_full(acks, (GDestroyNotify) nfc_peer_connection_unref);
+    }
+}
+
 static
 void
 nfc_llc_handle_connect(
@@ -944,6 +1118,9 @@ nfc_llc_handle_pax(
     guint change = nfc_llc_apply_params(self, nfc_llc_param_constify(params));
 
     nfc_llc_param_free(params);
+    if (change & (1 << NFC_LLC_PARAM_LTO)) {
+        nfc_llc_io_set_lto(self->io, self->lto);
+    }
     /* Signal the change */
     if (change & (1 << NFC_LLC_PARAM_WKS)) {
         g_signal_emit(self, nfc_llc_signals[SIGNAL_WKS_CHANGED], 0);
@@ -961,7 +1138,7 @@ nfc_llc_handle_agf(
     const guint8* end = pkt + size;
 
     while ((pkt + 1) < end) {
-        const guint len = ((guint)pkt[0]) + pkt[1];
+        const guint len = (((guint)pkt[0]) << 8) | pkt[1];
 
         /* Eat the length */
         pkt += 2;
@@ -1048,9 +1225,9 @@ nfc_llc_handle_i(
          */
         if (ps->vr == ns) {
             ps->vr = ((ps->vr + 1) & 0x0f);
+            /* The ack is submitted later by nfc_llc_flush_acks() */
             nfc_peer_connection_ref(conn);
             nfc_peer_connection_data_received(conn, data, len);
-            nfc_llc_ack_internal(self, conn, FALSE);
             nfc_peer_connection_unref(conn);
         } else {
             nfc_llc_submit_frmr(self, ssap, dsap, NFC_LLC_FRMR_S,
@@ -1352,11 +1529,13 @@ nfc_llc_receive(
             return LLC_IO_IGNORE;
         }
     }
+    nfc_llc_flush_acks(self, FALSE);
     if (self->io->can_send) {
         nfc_llc_send_next_pdu(self);
     }
     if (self->packets_handled == packets_handled && io->can_send) {
-        nfc_llc_set_idle(self, !self->pdu_queue && !self->connect_queue);
+        nfc_llc_set_idle(self, !nfc_llc_queue_size(self->pdu_queue) &&
+            !self->connect_queue && !self->ack_timer_id);
         return LLC_IO_IGNORE;
     } else {
         nfc_llc_set_idle(self, FALSE);
@@ -1375,81 +1554,219 @@ nfc_llc_error(
 }
 
 static
-void
-nfc_llc_send_next_pdu(
-    NfcLlcObject* self)
+gboolean
+nfc_llc_pdu_can_aggregate(
+    GBytes* pdu)
 {
-    GBytes* packet = nfc_llc_dequeue_pdu(self);
+    gsize size;
+    const guint8* pkt = g_bytes_get_data(pdu, &size);
+    const guint hdr = (((guint)(pkt[0])) << 8) | pkt[1];
 
-    if (packet) {
+    /*
+     * NFCForum-TS-LLCP_1.1
+     * 4.3.3 Aggregated Frame (AGF)
+     *
+     * SYMM, PAX and AGF PDUs are not supposed to be encapsulated.
+     */
+    switch (LLCP_GET_PTYPE(hdr)) {
+    case LLCP_PTYPE_SYMM:
+    case LLCP_PTYPE_PAX:
+    case LLCP_PTYPE_AGF:
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
+static
+GPtrArray*
+nfc_llc_dequeue_agf(
+    NfcLlcObject* self,
+    GBytes* first)
+{
+    GPtrArray* pdus = NULL;
+
+    /*
+     * Pull as many PDUs from the queue as fit into the information field
+     * of a single AGF, the size of which is limited by the remote MIU.
+     * Each encapsulated PDU is preceded by its 2-byte length. Returns
+     * NULL if there's nothing to aggregate.
+     */
+    if (nfc_llc_pdu_can_aggregate(first)) {
+        gsize total = g_bytes_get_size(first) + 2;
+        GBytes* pdu;
+
+        while ((pdu = nfc_llc_queue_peek(self->pdu_queue, 0)) != NULL) {
+            const gsize size = g_bytes_get_size(pdu) + 2;
+
+            if ((total + size) > self->miu ||
+                !nfc_llc_pdu_can_aggregate(pdu)) {
+                break;
+            }
+            if (!pdus) {
+                pdus = g_ptr_array_new_with_free_func((GDestroyNotify)
+                    g_bytes_unref);
+                g_ptr_array_add(pdus, g_bytes_ref(first));
+            }
+            g_ptr_array_add(pdus, nfc_llc_dequeue_pdu(self));
+            total += size;
+        }
+    }
+    return pdus;
+}
+
+static
+GBytes*
+nfc_llc_agf_new(
+    GPtrArray* pdus)
+{
+    const guint hdr = LLCP_MAKE_HDR(0, LLCP_PTYPE_AGF, 0);
+    gsize total = 2;
+    guint8* frame;
+    guint8* ptr;
+    guint i;
+
+    /*
+     * The encapsulated PDUs are contiguous in memory, so this is where
+     * the payload of an aggregated I PDU gets copied the second time
+     * (the first one being nfc_llc_submit_i_pdu). The frame is sized
+     * upfront to avoid any further copying on reallocation.
+     */
+    for (i = 0; i < pdus->len; i++) {
+        total += g_bytes_get_size(pdus->pdata[i]) + 2;
+    }
+    frame = g_malloc(total);
+    frame[0] = (guint8)(hdr >> 8);
+    frame[1] = (guint8)hdr;
+    for (i = 0, ptr = frame + 2; i < pdus->len; i++) {
+        gsize size;
+        const guint8* pkt = g_bytes_get_data(pdus->pdata[i], &size);
+
+        ptr[0] = (guint8)(size >> 8);
+        ptr[1] = (guint8)size;
+        memcpy(ptr + 2, pkt, size);
+        ptr += size + 2;
+    }
+    return g_bytes_new_take(frame, total);
+}
+
+static
+void
+nfc_llc_log_pdu(
+    GBytes* packet)
+{
+#if GUTIL_LOG_DEBUG
+    if (GLOG_ENABLED(GLOG_LEVEL_DEBUG)) {
         gsize pktsize;
         const guint8* pkt = g_bytes_get_data(packet, &pktsize);
         const guint hdr = (((guint)(pkt[0])) << 8) | pkt[1];
+        const guint8 dsap = LLCP_GET_DSAP(hdr);
+        const guint8 ssap = LLCP_GET_SSAP(hdr);
 
-#if GUTIL_LOG_DEBUG
-        if (GLOG_ENABLED(GLOG_LEVEL_DEBUG)) {
-            const guint8 dsap = LLCP_GET_DSAP(hdr);
-            const guint8 ssap = LLCP_GET_SSAP(hdr);
-
-            switch (LLCP_GET_PTYPE(hdr)) {
-            case LLCP_PTYPE_SYMM:
-                /* These are actually sent (and logged) by NfcLlcIo */
-                GDEBUG("< SYMM");
-                break;
-            case LLCP_PTYPE_PAX:
-                GDEBUG("< PAX");
-                break;
-            case LLCP_PTYPE_AGF:
-                GDEBUG("< AGF");
-                break;
-            case LLCP_PTYPE_UI:
-                GDEBUG("< UI %u:%u", ssap, dsap);
-                break;
-            case LLCP_PTYPE_CONNECT:
-                GDEBUG("< CONNECT %u:%u", ssap, dsap);
-                break;
-            case LLCP_PTYPE_DISC:
-                GDEBUG("< DISC %u:%u", ssap, dsap);
-                break;
-            case LLCP_PTYPE_CC:
-                GDEBUG("< CC %u:%u", ssap, dsap);
-                break;
-            case LLCP_PTYPE_DM:
-                GDEBUG("< DM %u:%u (0x%02x)", ssap, dsap, pkt[2]);
-                break;
-            case LLCP_PTYPE_FRMR:
-                GDEBUG("< FRMR %u:%u (0x%02x)", ssap, dsap, (pkt[2] & 0x0f));
-                break;
-            case LLCP_PTYPE_SNL:
-                GDEBUG("< SNL");
-                break;
-            case LLCP_PTYPE_I:
-                GDEBUG("< I %u:%u (%u bytes)", ssap, dsap, (guint)pktsize - 3);
-                break;
-            case LLCP_PTYPE_RR:
-                GDEBUG("< RR %u:%u (0x%02x)", ssap, dsap, pkt[2]);
-                break;
-            case LLCP_PTYPE_RNR:
-                GDEBUG("< RNR %u:%u", ssap, dsap);
-                break;
-            }
+        switch (LLCP_GET_PTYPE(hdr)) {
+        case LLCP_PTYPE_SYMM:
+            /* These are actually sent (and logged) by NfcLlcIo */
+            GDEBUG("< SYMM");
+            break;
+        case LLCP_PTYPE_PAX:
+            GDEBUG("< PAX");
+            break;
+        case LLCP_PTYPE_AGF:
+            GDEBUG("< AGF");
+            break;
+        case LLCP_PTYPE_UI:
+            GDEBUG("< UI %u:%u", ssap, dsap);
+            break;
+        case LLCP_PTYPE_CONNECT:
+            GDEBUG("< CONNECT %u:%u", ssap, dsap);
+            break;
+        case LLCP_PTYPE_DISC:
+            GDEBUG("< DISC %u:%u", ssap, dsap);
+            break;
+        case LLCP_PTYPE_CC:
+            GDEBUG("< CC %u:%u", ssap, dsap);
+            break;
+        case LLCP_PTYPE_DM:
+            GDEBUG("< DM %u:%u (0x%02x)", ssap, dsap, pkt[2]);
+            break;
+        case LLCP_PTYPE_FRMR:
+            GDEBUG("< FRMR %u:%u (0x%02x)", ssap, dsap, (pkt[2] & 0x0f));
+            break;
+        case LLCP_PTYPE_SNL:
+            GDEBUG("< SNL");
+            break;
+        case LLCP_PTYPE_I:
+            GDEBUG("< I %u:%u (%u bytes)", ssap, dsap, (guint)pktsize - 3);
+            break;
+        case LLCP_PTYPE_RR:
+            GDEBUG("< RR %u:%u (0x%02x)", ssap, dsap, pkt[2]);
+            break;
+        case LLCP_PTYPE_RNR:
+            GDEBUG("< RNR %u:%u", ssap, dsap);
+            break;
         }
+    }
 #endif /* GUTIL_LOG_DEBUG */
+}
+
+static
+void
+nfc_llc_pdu_sent(
+    NfcLlcObject* self,
+    GBytes* packet)
+{
+    const guint8* pkt = g_bytes_get_data(packet, NULL);
+    const guint hdr = (((guint)(pkt[0])) << 8) | pkt[1];
+
+    if (LLCP_GET_PTYPE(hdr) == LLCP_PTYPE_I) {
+        const guint8 dsap = LLCP_GET_DSAP(hdr);
+        const guint8 ssap = LLCP_GET_SSAP(hdr);
+        NfcPeerConnection* conn = g_hash_table_lookup(self->conn_table,
+            LLCP_CONN_KEY(ssap, dsap) /* SSAP and DSAP reversed */);
+
+        if (conn) {
+            nfc_peer_connection_flush(conn);
+        }
+    }
+}
+
+static
+void
+nfc_llc_send_next_pdu(
+    NfcLlcObject* self)
+{
+    GBytes* packet = nfc_llc_dequeue_pdu(self);
+
+    if (packet) {
+        GPtrArray* agf = nfc_llc_dequeue_agf(self, packet);
 
-        if (nfc_llc_io_send(self->io, packet)) {
-            if (LLCP_GET_PTYPE(hdr) == LLCP_PTYPE_I) {
-                const guint8 dsap = LLCP_GET_DSAP(hdr);
-                const guint8 ssap = LLCP_GET_SSAP(hdr);
-                NfcPeerConnection* conn = g_hash_table_lookup(self->conn_table,
-                    LLCP_CONN_KEY(ssap, dsap) /* SSAP and DSAP reversed */);
+        if (agf) {
+            GBytes* frame = nfc_llc_agf_new(agf);
+            guint i;
 
-                if (conn) {
-                    nfc_peer_connection_flush(conn);
+            GDEBUG("< AGF (%u PDUs, %u bytes)", agf->len, (guint)
+                g_bytes_get_size(frame));
+            for (i = 0; i < agf->len; i++) {
+                nfc_llc_log_pdu(agf->pdata[i]);
+            }
+            if (nfc_llc_io_send(self->io, frame)) {
+                for (i = 0; i < agf->len; i++) {
+                    nfc_llc_pdu_sent(self, agf->pdata[i]);
                 }
+            } else {
+                GDEBUG("LLC transmit failed");
+                nfc_llc_set_state(self, NFC_LLC_STATE_PEER_LOST);
             }
+            g_bytes_unref(frame);
+            g_ptr_array_free(agf, TRUE);
         } else {
-            GDEBUG("LLC transmit failed");
-            nfc_llc_set_state(self, NFC_LLC_STATE_PEER_LOST);
+            nfc_llc_log_pdu(packet);
+            if (nfc_llc_io_send(self->io, packet)) {
+                nfc_llc_pdu_sent(self, packet);
+            } else {
+                GDEBUG("LLC transmit failed");
+                nfc_llc_set_state(self, NFC_LLC_STATE_PEER_LOST);
+            }
         }
         g_bytes_unref(packet);
     }
@@ -1477,6 +1794,7 @@ nfc_llc_new(
 
         /* Apply parameters provided by the MAC layer */
         nfc_llc_apply_params(self, params);
+        nfc_llc_io_set_lto(io, self->lto);
 
         /*
          * PAX PDU exchange is defined in LLCP spec but SHALL NOT be used.
@@ -1664,6 +1982,15 @@ nfc_llc_ack(
     }
 }
 
+const NfcLlcAckStats*
+nfc_llc_ack_stats(
+    NfcLlc* llc)
+{
+    NfcLlcObject* self = nfc_llc_object_cast(llc);
+
+    return G_LIKELY(self) ? &self->ack_stats : NULL;
+}
+
 gboolean
 nfc_llc_i_pdu_queued(
     NfcLlc* llc,
@@ -1671,25 +1998,8 @@ nfc_llc_i_pdu_queued(
 {
     NfcLlcObject* self = nfc_llc_object_cast(llc);
 
-    if (G_LIKELY(self) && G_LIKELY(conn)) {
-        GList* l = g_list_first(self->pdu_queue);
-
-        if (l) {
-            const guint8 dsap = conn->rsap;
-            const guint8 ssap = conn->service->sap;
-            const guint hdr = LLCP_MAKE_HDR(dsap, LLCP_PTYPE_I, ssap);
-
-            do {
-                const guint8* pkt = g_bytes_get_data((GBytes*)l->data, NULL);
-
-                if (((((guint)(pkt[0])) << 8) | pkt[1]) == hdr) {
-                    return TRUE;
-                }
-                l = l->next;
-            } while (l);
-        }
-    }
-    return FALSE;
+    return G_LIKELY(self) && G_LIKELY(conn) &&
+        nfc_llc_find_i_pdu(self, conn->rsap, conn->service->sap);
 }
 
 void
@@ -1732,8 +2042,8 @@ void
 nfc_llc_submit_i_pdu(
     NfcLlc* llc,
     NfcPeerConnection* conn,
-    const void* data,
-    guint len)
+    GBytes* const* payload,
+    guint count)
 {
     NfcLlcObject* self = nfc_llc_object_cast(llc);
 
@@ -1743,14 +2053,34 @@ nfc_llc_submit_i_pdu(
         const guint8 dsap = conn->rsap;
         const guint8 ssap = service->sap;
         const guint hdr = LLCP_MAKE_HDR(dsap, LLCP_PTYPE_I, ssap);
-        const guint size = 3 + len;
-        guint8* pkt = g_malloc(size);
-        GBytes* pdu = g_bytes_new_take(pkt, size);
+        gsize size = 3;
+        guint8* pkt;
+        guint8* ptr;
+        GBytes* pdu;
+        guint i;
 
+        /*
+         * The payload segments are copied straight into the PDU, which
+         * then gets passed down to NfcTarget by reference. If the PDU
+         * ends up in an AGF, it's copied once more by nfc_llc_agf_new.
+         */
+        for (i = 0; i < count; i++) {
+            size += g_bytes_get_size(payload[i]);
+        }
+        pkt = g_malloc(size);
+        pdu = g_bytes_new_take(pkt, size);
         pkt[0] = (guint8)(hdr >> 8);
         pkt[1] = (guint8)hdr;
         pkt[2] = (guint8)((ps->vs << 4) /* N(S) */ | ps->vr /* N(R) */);
-        memcpy(pkt + 3, data, len);
+        for (i = 0, ptr = pkt + 3; i < count; i++) {
+            gsize len;
+            const void* data = g_bytes_get_data(payload[i], &len);
+
+            if (len) {
+                memcpy(ptr, data, len);
+                ptr += len;
+            }
+        }
 
         /*
          * NFCForum-TS-LLCP_1.1
@@ -1808,6 +2138,7 @@ nfc_llc_object_init(
     self->miu = NFC_LLC_MIU_DEFAULT;
     self->lto = NFC_LLC_LTO_DEFAULT;
     self->pool = gutil_idle_pool_new();
+    self->pdu_queue = nfc_llc_queue_new();
     self->conn_table = g_hash_table_new_full(g_direct_hash, g_direct_equal,
         NULL, nfc_llc_connection_destroy);
 }
@@ -1819,12 +2150,15 @@ nfc_llc_object_finalize(
 {
     NfcLlcObject* self = THIS(object);
 
+    if (self->ack_timer_id) {
+        g_source_remove(self->ack_timer_id);
+    }
     nfc_llc_abort_all_connections(self);
     nfc_peer_services_unref(self->services);
     nfc_llc_io_remove_all_handlers(self->io, self->io_event);
     nfc_llc_io_unref(self->io);
     g_hash_table_unref(self->conn_table);
-    g_list_free_full(self->pdu_queue, (GDestroyNotify) g_bytes_unref);
+    nfc_llc_queue_free(self->pdu_queue);
     g_slist_free_full(self->connect_queue, (GDestroyNotify)
         nfc_llc_connect_req_free);
     gutil_idle_pool_destroy(self->pool);
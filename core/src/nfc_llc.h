@@ -178,6 +178,25 @@ nfc_llc_ack(
     gboolean last)
     NFCD_INTERNAL;
 
+/*
+ * Received I PDUs are not acknowledged right away. If the application
+ * sends something back within the ack delay of the connection (see
+ * nfc_peer_service_set_ack_delay), N(R) gets piggybacked onto the
+ * outgoing I PDU. Otherwise, a standalone RR is sent when the timer
+ * expires or when the local receive window is half full. With zero delay
+ * (the default) the RR goes out with the next frame, unless it can be
+ * folded into an I PDU sent in response to the same frame.
+ */
+typedef struct nfc_llc_ack_stats {
+    guint sent;         /* Standalone RR/RNR PDUs */
+    guint piggybacked;  /* Acks carried by I PDUs */
+} NfcLlcAckStats;
+
+const NfcLlcAckStats*
+nfc_llc_ack_stats(
+    NfcLlc* llc)
+    NFCD_INTERNAL;
+
 gboolean
 nfc_llc_i_pdu_queued(
     NfcLlc* llc,
@@ -205,12 +224,13 @@ nfc_llc_submit_cc_pdu(
     NfcPeerConnection* conn)
     NFCD_INTERNAL;
 
+/* I PDU payload is passed in as a list of segments */
 void
 nfc_llc_submit_i_pdu(
     NfcLlc* llc,
     NfcPeerConnection* conn,
-    const void* data,
-    guint len)
+    GBytes* const* payload,
+    guint count)
     NFCD_INTERNAL;
 
 void
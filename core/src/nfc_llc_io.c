@@ -31,6 +31,7 @@
  */
 
 #include "nfc_llc_io_impl.h"
+#include "nfc_llc_param.h"
 
 #define GLOG_MODULE_NAME NFC_LLC_LOG_MODULE
 #include <gutil_log.h>
@@ -164,6 +165,16 @@ nfc_llc_io_add_error_handler(
         SIGNAL_ERROR_NAME, G_CALLBACK(func), user_data) : 0;
 }
 
+void
+nfc_llc_io_set_lto(
+    NfcLlcIo* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        self->lto = ms;
+    }
+}
+
 void
 nfc_llc_io_remove_handlers(
     NfcLlcIo* self,
@@ -182,6 +193,7 @@ void
 nfc_llc_io_init(
     NfcLlcIo* self)
 {
+    self->lto = NFC_LLC_LTO_DEFAULT;
 }
 
 static
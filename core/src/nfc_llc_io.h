@@ -54,6 +54,7 @@ struct nfc_llc_io {
     GObject object;
     gboolean error;
     gboolean can_send;
+    guint lto; /* Remote link timeout, milliseconds */
 };
 
 GType nfc_llc_io_get_type(void) NFCD_INTERNAL;
@@ -129,6 +130,12 @@ nfc_llc_io_remove_handlers(
 #define nfc_llc_io_remove_all_handlers(io,ids) \
     nfc_llc_io_remove_handlers(io, ids, G_N_ELEMENTS(ids))
 
+void
+nfc_llc_io_set_lto(
+    NfcLlcIo* io,
+    guint ms)
+    NFCD_INTERNAL;
+
 /* Initiator-side I/O */
 
 NfcLlcIo*
@@ -136,6 +143,62 @@ nfc_llc_io_initiator_new(
     NfcTarget* target)
     NFCD_INTERNAL;
 
+/*
+ * When the link is idle, the Initiator keeps polling the peer with SYMM
+ * PDUs. The poll policy returns the delay (in milliseconds) before the
+ * next poll, given the number of consecutive polls which haven't brought
+ * any data. Zero idle count means that there was some traffic right
+ * before that. Zero delay means that the poll is sent as soon as there's
+ * nothing else to do.
+ *
+ * The default (adaptive) policy polls immediately after the traffic and
+ * then doubles the poll period on each idle poll, up to a half of the
+ * remote link timeout. The fixed policy takes the period from user_data
+ * (GUINT_TO_POINTER(ms)).
+ */
+
+typedef
+guint
+(*NfcLlcIoPollFunc)(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data);
+
+typedef struct nfc_llc_io_poll_stats {
+    guint polls;      /* SYMM polls sent while the link was idle */
+    guint resets;     /* Number of times the traffic has reset the period */
+    guint idle;       /* Consecutive idle polls since the last traffic */
+    guint period;     /* The last poll period, milliseconds */
+    guint max_period; /* The longest poll period so far, milliseconds */
+} NfcLlcIoPollStats;
+
+guint
+nfc_llc_io_poll_adaptive(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data)
+    NFCD_INTERNAL;
+
+guint
+nfc_llc_io_poll_fixed(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data)
+    NFCD_INTERNAL;
+
+void
+nfc_llc_io_initiator_set_poll_policy(
+    NfcLlcIo* io,
+    NfcLlcIoPollFunc func,
+    void* user_data,
+    GDestroyNotify destroy)
+    NFCD_INTERNAL;
+
+const NfcLlcIoPollStats*
+nfc_llc_io_initiator_poll_stats(
+    NfcLlcIo* io)
+    NFCD_INTERNAL;
+
 /* Target-side I/O */
 
 NfcLlcIo*
@@ -36,12 +36,16 @@
 #define GLOG_MODULE_NAME NFC_LLC_LOG_MODULE
 #include <gutil_log.h>
 
-#define DEFAULT_POLL_PERIOD (100) /* ms */
+#define POLL_MIN_PERIOD (10) /* ms */
+#define POLL_MAX_SHIFT (16)
 
 typedef struct nfc_llc_io_initiator {
     NfcLlcIo io;
     NfcTarget* target;
-    guint poll_period;
+    NfcLlcIoPollFunc poll_func;
+    void* poll_data;
+    GDestroyNotify poll_destroy;
+    NfcLlcIoPollStats poll_stats;
     guint poll_id;
     guint tx_id;
 } NfcLlcIoInitiator;
@@ -49,6 +53,7 @@ typedef struct nfc_llc_io_initiator {
 #define THIS(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), \
         THIS_TYPE, NfcLlcIoInitiator))
 #define THIS_TYPE (nfc_llc_io_initiator_get_type())
+#define IS_THIS(obj) G_TYPE_CHECK_INSTANCE_TYPE(obj, THIS_TYPE)
 #define PARENT_TYPE NFC_TYPE_LLC_IO
 #define PARENT_CLASS (nfc_llc_io_initiator_parent_class)
 
@@ -76,11 +81,49 @@ nfc_llc_io_initiator_poll(
     GASSERT(self->io.can_send);
     GASSERT(self->poll_id);
     self->poll_id = 0;
+    self->poll_stats.polls++;
+    self->poll_stats.idle++;
     GDEBUG("< SYMM (poll)");
     nfc_llc_io_initiator_send_symm(self);
     return G_SOURCE_REMOVE;
 }
 
+static
+void
+nfc_llc_io_initiator_schedule_poll(
+    NfcLlcIoInitiator* self)
+{
+    NfcLlcIoPollStats* stats = &self->poll_stats;
+    const guint ms = self->poll_func(&self->io, stats->idle, self->poll_data);
+
+    GASSERT(!self->poll_id);
+    stats->period = ms;
+    if (stats->max_period < ms) {
+        stats->max_period = ms;
+    }
+    if (ms) {
+        self->poll_id = g_timeout_add(ms, nfc_llc_io_initiator_poll, self);
+    } else {
+        /* Poll as soon as there's nothing else to do */
+        self->poll_id = g_idle_add_full(G_PRIORITY_LOW,
+            nfc_llc_io_initiator_poll, self, NULL);
+    }
+}
+
+static
+void
+nfc_llc_io_initiator_activity(
+    NfcLlcIoInitiator* self)
+{
+    NfcLlcIoPollStats* stats = &self->poll_stats;
+
+    if (stats->idle) {
+        /* Snap back to the shortest poll period */
+        stats->idle = 0;
+        stats->resets++;
+    }
+}
+
 static
 void
 nfc_llc_io_initiator_symm_transmit_done(
@@ -104,6 +147,7 @@ nfc_llc_io_initiator_symm_transmit_done(
         received.bytes = data;
         received.size = len;
         if (nfc_llc_io_receive(io, &received)) {
+            nfc_llc_io_initiator_activity(self);
             if (!self->tx_id) {
                 /* Something else might be coming, don't wait */
                 GDEBUG("< SYMM");
@@ -111,8 +155,7 @@ nfc_llc_io_initiator_symm_transmit_done(
             }
         } else if (!self->tx_id) {
             /* Nothing is expected to arrive urgently, start polling. */
-            self->poll_id = g_timeout_add(self->poll_period,
-                nfc_llc_io_initiator_poll, self);
+            nfc_llc_io_initiator_schedule_poll(self);
             nfc_llc_io_can_send(io);
         }
     } else {
@@ -186,12 +229,69 @@ nfc_llc_io_initiator_new(
         NfcLlcIoInitiator* self = g_object_new(THIS_TYPE, NULL);
 
         self->target = nfc_target_ref(target);
-        self->poll_period = DEFAULT_POLL_PERIOD;
         return &self->io;
     }
     return NULL;
 }
 
+guint
+nfc_llc_io_poll_adaptive(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data)
+{
+    if (idle) {
+        /* Leave the peer enough time to respond within its link timeout */
+        const guint max = MAX(io->lto / 2, POLL_MIN_PERIOD);
+
+        return MIN(POLL_MIN_PERIOD << MIN(idle - 1, POLL_MAX_SHIFT), max);
+    } else {
+        /* Poll immediately after the traffic */
+        return 0;
+    }
+}
+
+guint
+nfc_llc_io_poll_fixed(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data)
+{
+    return GPOINTER_TO_UINT(user_data);
+}
+
+void
+nfc_llc_io_initiator_set_poll_policy(
+    NfcLlcIo* io,
+    NfcLlcIoPollFunc func,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    if (G_LIKELY(IS_THIS(io))) {
+        NfcLlcIoInitiator* self = THIS(io);
+
+        if (self->poll_destroy) {
+            self->poll_destroy(self->poll_data);
+        }
+        if (func) {
+            self->poll_func = func;
+            self->poll_data = user_data;
+            self->poll_destroy = destroy;
+        } else {
+            self->poll_func = nfc_llc_io_poll_adaptive;
+            self->poll_data = NULL;
+            self->poll_destroy = NULL;
+        }
+    }
+}
+
+const NfcLlcIoPollStats*
+nfc_llc_io_initiator_poll_stats(
+    NfcLlcIo* io)
+{
+    return G_LIKELY(IS_THIS(io)) ? &THIS(io)->poll_stats : NULL;
+}
+
 /*==========================================================================*
  * Methods
  *==========================================================================*/
@@ -210,11 +310,10 @@ nfc_llc_io_initiator_send(
     NfcLlcIo* io,
     GBytes* send)
 {
-    gsize size;
-    const guint8* data = g_bytes_get_data(send, &size);
     NfcLlcIoInitiator* self = THIS(io);
 
     GASSERT(io->can_send);
+    nfc_llc_io_initiator_activity(self);
     if (self->poll_id) {
         /* Cancel scheduled polling */
         g_source_remove(self->poll_id);
@@ -222,7 +321,9 @@ nfc_llc_io_initiator_send(
     }
 
     io->can_send = FALSE;
-    self->tx_id = nfc_target_transmit(self->target, data, size, NULL,
+
+    /* Pass the frame down by reference, without copying */
+    self->tx_id = nfc_target_transmit_bytes(self->target, send, NULL,
         nfc_llc_io_initiator_pdu_transmit_done, NULL, self);
     if (self->tx_id) {
         return TRUE;
@@ -242,6 +343,7 @@ nfc_llc_io_initiator_init(
     NfcLlcIoInitiator* self)
 {
     self->io.can_send = TRUE;
+    self->poll_func = nfc_llc_io_poll_adaptive;
 }
 
 static
@@ -254,6 +356,9 @@ nfc_llc_io_initiator_finalize(
     if (self->poll_id) {
         g_source_remove(self->poll_id);
     }
+    if (self->poll_destroy) {
+        self->poll_destroy(self->poll_data);
+    }
     nfc_target_cancel_transmit(self->target, self->tx_id);
     nfc_target_unref(self->target);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
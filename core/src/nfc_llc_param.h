@@ -42,6 +42,10 @@
 #define NFC_LLC_RW_DEFAULT  (1)
 #define NFC_LLC_RW_MAX      (0xf)
 
+/* Default local parameters of a data link connection */
+#define NFC_LLC_LOCAL_RW    NFC_LLC_RW_MAX
+#define NFC_LLC_LOCAL_MIU   NFC_LLC_MIU_MAX
+
 typedef enum nfc_llc_param_type {
     NFC_LLC_PARAM_VERSION = 1,
     NFC_LLC_PARAM_MIUX = 2,
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfc_llc_queue.h"
+
+#define NFC_LLC_QUEUE_MIN_ALLOC (8) /* Must be a power of 2 */
+
+typedef struct nfc_llc_ring {
+    GBytes** buf;
+    guint alloc;    /* Zero or a power of 2 */
+    guint head;
+    guint count;
+} NfcLlcRing;
+
+struct nfc_llc_queue {
+    NfcLlcRing ring[NFC_LLC_QUEUE_CLASS_COUNT];
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+nfc_llc_ring_push(
+    NfcLlcRing* ring,
+    GBytes* pdu)
+{
+    if (ring->count == ring->alloc) {
+        const guint alloc = ring->alloc ? (ring->alloc << 1) :
+            NFC_LLC_QUEUE_MIN_ALLOC;
+        GBytes** buf = g_new(GBytes*, alloc);
+        guint i;
+
+        /* Unwrap the contents while copying them */
+        for (i = 0; i < ring->count; i++) {
+            buf[i] = ring->buf[(ring->head + i) & (ring->alloc - 1)];
+        }
+        g_free(ring->buf);
+        ring->buf = buf;
+        ring->alloc = alloc;
+        ring->head = 0;
+    }
+    ring->buf[(ring->head + ring->count) & (ring->alloc - 1)] = pdu;
+    ring->count++;
+}
+
+static
+GBytes*
+nfc_llc_ring_pop(
+    NfcLlcRing* ring)
+{
+    if (ring->count) {
+        GBytes* pdu = ring->buf[ring->head];
+
+        ring->head = (ring->head + 1) & (ring->alloc - 1);
+        ring->count--;
+        return pdu;
+    }
+    return NULL;
+}
+
+static
+void
+nfc_llc_ring_clear(
+    NfcLlcRing* ring)
+{
+    GBytes* pdu;
+
+    while ((pdu = nfc_llc_ring_pop(ring)) != NULL) {
+        g_bytes_unref(pdu);
+    }
+    g_free(ring->buf);
+}
+
+/*==========================================================================*
+ * Internal interface
+ *==========================================================================*/
+
+NfcLlcQueue*
+nfc_llc_queue_new(
+    void)
+{
+    return g_slice_new0(NfcLlcQueue);
+}
+
+void
+nfc_llc_queue_free(
+    NfcLlcQueue* self)
+{
+    if (G_LIKELY(self)) {
+        guint i;
+
+        for (i = 0; i < NFC_LLC_QUEUE_CLASS_COUNT; i++) {
+            nfc_llc_ring_clear(self->ring + i);
+        }
+        g_slice_free(NfcLlcQueue, self);
+    }
+}
+
+void
+nfc_llc_queue_push(
+    NfcLlcQueue* self,
+    NFC_LLC_QUEUE_CLASS cls,
+    GBytes* pdu)
+{
+    if (G_LIKELY(self) && G_LIKELY(pdu) &&
+        G_LIKELY(cls < NFC_LLC_QUEUE_CLASS_COUNT)) {
+        nfc_llc_ring_push(self->ring + cls, g_bytes_ref(pdu));
+    }
+}
+
+GBytes*
+nfc_llc_queue_pop(
+    NfcLlcQueue* self)
+{
+    if (G_LIKELY(self)) {
+        guint i;
+
+        for (i = 0; i < NFC_LLC_QUEUE_CLASS_COUNT; i++) {
+            GBytes* pdu = nfc_llc_ring_pop(self->ring + i);
+
+            if (pdu) {
+                return pdu;
+            }
+        }
+    }
+    return NULL;
+}
+
+GBytes*
+nfc_llc_queue_peek(
+    NfcLlcQueue* self,
+    guint pos)
+{
+    if (G_LIKELY(self)) {
+        guint i;
+
+        for (i = 0; i < NFC_LLC_QUEUE_CLASS_COUNT; i++) {
+            const NfcLlcRing* ring = self->ring + i;
+
+            if (pos < ring->count) {
+                return ring->buf[(ring->head + pos) & (ring->alloc - 1)];
+            }
+            pos -= ring->count;
+        }
+    }
+    return NULL;
+}
+
+guint
+nfc_llc_queue_count(
+    NfcLlcQueue* self,
+    NFC_LLC_QUEUE_CLASS cls)
+{
+    return (G_LIKELY(self) && G_LIKELY(cls < NFC_LLC_QUEUE_CLASS_COUNT)) ?
+        self->ring[cls].count : 0;
+}
+
+guint
+nfc_llc_queue_size(
+    NfcLlcQueue* self)
+{
+    guint size = 0;
+
+    if (G_LIKELY(self)) {
+        guint i;
+
+        for (i = 0; i < NFC_LLC_QUEUE_CLASS_COUNT; i++) {
+            size += self->ring[i].count;
+        }
+    }
+    return size;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFC_LLC_QUEUE_H
+#define NFC_LLC_QUEUE_H
+
+#include "nfc_types_p.h"
+
+/*
+ * Outgoing LLCP PDU queue. PDUs are stored in growable ring buffers,
+ * one per priority class. Control PDUs (supervisory and connection
+ * management) go out before any queued data PDUs, PDUs within the same
+ * class are sent in the order in which they have been queued.
+ */
+
+typedef enum nfc_llc_queue_class {
+    NFC_LLC_QUEUE_CONTROL,
+    NFC_LLC_QUEUE_DATA,
+    NFC_LLC_QUEUE_CLASS_COUNT
+} NFC_LLC_QUEUE_CLASS;
+
+NfcLlcQueue*
+nfc_llc_queue_new(
+    void)
+    NFCD_INTERNAL;
+
+void
+nfc_llc_queue_free(
+    NfcLlcQueue* queue)
+    NFCD_INTERNAL;
+
+/* Adds a reference to the PDU */
+void
+nfc_llc_queue_push(
+    NfcLlcQueue* queue,
+    NFC_LLC_QUEUE_CLASS cls,
+    GBytes* pdu)
+    NFCD_INTERNAL;
+
+/* Returns the reference to the caller, NULL if the queue is empty */
+GBytes*
+nfc_llc_queue_pop(
+    NfcLlcQueue* queue)
+    NFCD_INTERNAL;
+
+/* Returns i-th PDU in the transmission order, without adding a reference */
+GBytes*
+nfc_llc_queue_peek(
+    NfcLlcQueue* queue,
+    guint i)
+    NFCD_INTERNAL;
+
+/* Number of queued PDUs of the given class */
+guint
+nfc_llc_queue_count(
+    NfcLlcQueue* queue,
+    NFC_LLC_QUEUE_CLASS cls)
+    NFCD_INTERNAL;
+
+/* Total number of queued PDUs */
+guint
+nfc_llc_queue_size(
+    NfcLlcQueue* queue)
+    NFCD_INTERNAL;
+
+#endif /* NFC_LLC_QUEUE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
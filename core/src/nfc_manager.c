@@ -46,6 +46,7 @@
 #include "nfc_peer_service.h"
 #include "nfc_peer_services.h"
 #include "nfc_plugins.h"
+#include "nfc_tag_t2_cache.h"
 #include "nfc_log.h"
 
 #include <gutil_misc.h>
@@ -58,6 +59,7 @@
 GLOG_MODULE_DEFINE("nfc-core");
 
 #define NFC_ADAPTER_NAME_FORMAT "nfc%u"
+#define NFC_TRACE_DIR_PERM (0700)
 
 struct nfc_mode_request {
     NfcManager* manager;
@@ -79,6 +81,8 @@ struct nfc_manager_priv {
     GUtilWeakRef* ref;
     NfcPlugins* plugins;
     NfcPeerServices* peer_services;
+    NfcTagType2Cache* t2_cache;
+    char* trace_dir;
     NfcHostService** host_services;
     NfcHostApp** host_apps;
     NfcModeRequest* p2p_request;
@@ -965,6 +969,40 @@ nfc_manager_new(
     return self;
 }
 
+void
+nfc_manager_set_t2_cache_dir(
+    NfcManager* self,
+    const char* dir)
+{
+    if (G_LIKELY(self)) {
+        NfcManagerPriv* priv = self->priv;
+
+        nfc_tag_t2_cache_unref(priv->t2_cache);
+        priv->t2_cache = dir ? nfc_tag_t2_cache_new(dir, 0) : NULL;
+    }
+}
+
+void
+nfc_manager_set_trace_dir(
+    NfcManager* self,
+    const char* dir)
+{
+    if (G_LIKELY(self)) {
+        NfcManagerPriv* priv = self->priv;
+
+        g_free(priv->trace_dir);
+        priv->trace_dir = NULL;
+        if (dir) {
+            if (g_mkdir_with_parents(dir, NFC_TRACE_DIR_PERM) < 0) {
+                GWARN("Failed to create directory %s", dir);
+            } else {
+                GDEBUG("Recording NFC traffic to %s", dir);
+                priv->trace_dir = g_strdup(dir);
+            }
+        }
+    }
+}
+
 gboolean
 nfc_manager_start(
     NfcManager* self)
@@ -984,6 +1022,20 @@ nfc_manager_peer_services(
     return G_LIKELY(self) ? self->priv->peer_services : NULL;
 }
 
+NfcTagType2Cache*
+nfc_manager_t2_cache(
+    NfcManager* self)
+{
+    return G_LIKELY(self) ? self->priv->t2_cache : NULL;
+}
+
+const char*
+nfc_manager_trace_dir(
+    NfcManager* self)
+{
+    return G_LIKELY(self) ? self->priv->trace_dir : NULL;
+}
+
 NfcHostService* const*
 nfc_manager_host_services(
     NfcManager* self)
@@ -1039,6 +1091,8 @@ nfc_manager_finalize(
     nfc_manager_release_internal_p2p_mode_request(self);
     nfc_manager_release_internal_host_mode_request(self);
     nfc_peer_services_unref(priv->peer_services);
+    nfc_tag_t2_cache_unref(priv->t2_cache);
+    g_free(priv->trace_dir);
     g_hash_table_destroy(priv->adapters);
     g_free(self->adapters);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
@@ -64,6 +64,16 @@ nfc_manager_host_apps(
     NfcManager* manager)
     NFCD_INTERNAL;
 
+NfcTagType2Cache*
+nfc_manager_t2_cache(
+    NfcManager* manager)
+    NFCD_INTERNAL;
+
+const char*
+nfc_manager_trace_dir(
+    NfcManager* manager)
+    NFCD_INTERNAL;
+
 #endif /* NFC_MANAGER_PRIVATE_H */
 
 /*
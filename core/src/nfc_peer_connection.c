@@ -41,9 +41,6 @@
 #include <gutil_idlepool.h>
 #include <gutil_macros.h>
 
-#define NFC_LLC_LOCAL_RW NFC_LLC_RW_MAX
-#define NFC_LLC_LOCAL_MIU NFC_LLC_MIU_MAX
-
 struct nfc_peer_connection_priv {
     char* name;
     NfcLlc* llc;
@@ -54,7 +51,7 @@ struct nfc_peer_connection_priv {
     const NfcLlcParam* lp[3];
     guint send_off;
     GList* send_queue;
-    GByteArray* send_buf;
+    guint ack_delay;
     gboolean disc_sent;
 };
 
@@ -128,12 +125,12 @@ static
 void
 nfc_peer_connection_submit_i_pdu(
     NfcPeerConnection* self,
-    const void* data,
+    GPtrArray* segs,
     guint len)
 {
     NfcPeerConnectionPriv* priv = self->priv;
 
-    nfc_llc_submit_i_pdu(priv->llc, self, data, len);
+    nfc_llc_submit_i_pdu(priv->llc, self, (GBytes**)segs->pdata, segs->len);
     GASSERT(self->bytes_queued >= len);
     self->bytes_queued -= len;
     self->bytes_sent += len;
@@ -234,6 +231,38 @@ nfc_peer_connection_unref(
     }
 }
 
+void
+nfc_peer_connection_set_rw(
+    NfcPeerConnection* self,
+    guint rw)
+{
+    if (G_LIKELY(self)) {
+        self->priv->rw_param.value.rw = rw ? MIN(rw, NFC_LLC_RW_MAX) :
+            NFC_LLC_LOCAL_RW;
+    }
+}
+
+void
+nfc_peer_connection_set_miu(
+    NfcPeerConnection* self,
+    guint miu)
+{
+    if (G_LIKELY(self)) {
+        self->priv->miu_param.value.miu = miu ? MIN(MAX(miu,
+            NFC_LLC_MIU_MIN), NFC_LLC_MIU_MAX) : NFC_LLC_LOCAL_MIU;
+    }
+}
+
+void
+nfc_peer_connection_set_ack_delay(
+    NfcPeerConnection* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        self->priv->ack_delay = ms;
+    }
+}
+
 gboolean
 nfc_peer_connection_send(
     NfcPeerConnection* self,
@@ -329,6 +358,10 @@ nfc_peer_connection_init_connect(
     self->name = priv->name = g_strdup(name);
     self->service = nfc_peer_service_ref(service);
     self->rsap = rsap;
+    nfc_peer_connection_set_rw(self, nfc_peer_service_rw(service));
+    nfc_peer_connection_set_miu(self, nfc_peer_service_miu(service));
+    nfc_peer_connection_set_ack_delay(self,
+        nfc_peer_service_ack_delay(service));
     nfc_peer_service_connection_created(service, self);
     GDEBUG("Connection %u:%u %s", service->sap, self->rsap,
         nfc_peer_connection_state_name(priv, self->state));
@@ -345,6 +378,10 @@ nfc_peer_connection_init_accept(
     self->state = NFC_LLC_CO_ACCEPTING;
     self->service = nfc_peer_service_ref(service);
     self->rsap = rsap;
+    nfc_peer_connection_set_rw(self, nfc_peer_service_rw(service));
+    nfc_peer_connection_set_miu(self, nfc_peer_service_miu(service));
+    nfc_peer_connection_set_ack_delay(self,
+        nfc_peer_service_ack_delay(service));
     nfc_peer_service_connection_created(service, self);
     GDEBUG("Connection %u:%u %s", service->sap, self->rsap,
         nfc_peer_connection_state_name(priv, self->state));
@@ -494,63 +531,54 @@ nfc_peer_connection_flush(
     gboolean submitted = FALSE;
 
     /*
-     * If nfc_llc_i_pdu_queued return TRUE (i.e. an I-frame is already
-     * queued for this connection), just continue to accumulate the data.
-     * This function will be called again when I-frame is dequeued.
+     * V(S) is incremented when an I PDU is queued, so that
+     * nfc_peer_connection_can_send() counts the queued I PDUs
+     * along with the unacknowledged ones. Up to RW(R) of them
+     * can be in flight at any time. Once the window is full, the
+     * data keep accumulating until the next acknowledgement.
      */
-    while (priv->send_queue &&
-           nfc_peer_connection_can_send(self) &&
-           !nfc_llc_i_pdu_queued(priv->llc, self)) {
+    while (priv->send_queue && nfc_peer_connection_can_send(self)) {
         const NfcPeerConnectionLlcpState* ps = &priv->ps;
-        GList* first = g_list_first(priv->send_queue);
-        GBytes* block = first->data;
-        gsize block_size;
-        const guint8* block_data = g_bytes_get_data(block, &block_size);
-        const guint8* ptr = block_data + priv->send_off;
-        guint remaining = block_size - priv->send_off;
-
-        if (remaining > ps->rmiu) {
-            /* Send a full I frame and still have some data left in this
-             * buffer, shift the offset by MIU */
-            priv->send_off += ps->rmiu;
-            nfc_peer_connection_submit_i_pdu(self, ptr, ps->rmiu);
-            submitted = TRUE;
-        } else if (remaining == ps->rmiu || !priv->send_queue->next) {
-            /* Send the remaining data in this block as a single I PDU */
-            priv->send_off = 0;
-            priv->send_queue = g_list_delete_link(priv->send_queue,
-                priv->send_queue);
-            nfc_peer_connection_submit_i_pdu(self, ptr, remaining);
-            submitted = TRUE;
-            g_bytes_unref(block);
-        } else {
-            GByteArray* buf = priv->send_buf;
-
-            /* Have to concatenate blocks */
-            g_byte_array_set_size(buf, 0);
-            g_byte_array_append(buf, ptr, remaining);
-            g_bytes_unref(block);
-            priv->send_off = 0;
-            priv->send_queue = g_list_delete_link(priv->send_queue,
-                priv->send_queue);
-
-            while (buf->len < ps->rmiu && priv->send_queue) {
-                remaining = ps->rmiu - buf->len;
-                block = priv->send_queue->data;
-                block_data = g_bytes_get_data(block, &block_size);
-                if (block_size <= remaining) {
-                    g_byte_array_append(buf, block_data, block_size);
+        GPtrArray* segs = g_ptr_array_new_with_free_func((GDestroyNotify)
+            g_bytes_unref);
+        guint space = ps->rmiu;
+
+        /*
+         * Fill the I PDU with up to MIU bytes taken from the queued
+         * blocks. The payload is referenced rather than copied, partially
+         * sent blocks are sliced with g_bytes_new_from_bytes(). Note that
+         * this function may get re-entered from nfc_llc_submit_i_pdu(),
+         * that's why the segment array is not shared.
+         */
+        while (space && priv->send_queue) {
+            GBytes* block = priv->send_queue->data;
+            const gsize remaining = g_bytes_get_size(block) - priv->send_off;
+
+            if (remaining > space) {
+                /* Some data will be left in this block */
+                g_ptr_array_add(segs, g_bytes_new_from_bytes(block,
+                    priv->send_off, space));
+                priv->send_off += space;
+                space = 0;
+            } else {
+                /* The rest of the block goes to this I PDU */
+                if (priv->send_off) {
+                    g_ptr_array_add(segs, g_bytes_new_from_bytes(block,
+                        priv->send_off, remaining));
                     g_bytes_unref(block);
-                    priv->send_queue = g_list_delete_link(priv->send_queue,
-                        priv->send_queue);
                 } else {
-                    priv->send_off = remaining;
-                    g_byte_array_append(buf, block_data, remaining);
+                    /* The reference is transferred to the array */
+                    g_ptr_array_add(segs, block);
                 }
+                priv->send_off = 0;
+                priv->send_queue = g_list_delete_link(priv->send_queue,
+                    priv->send_queue);
+                space -= remaining;
             }
-            nfc_peer_connection_submit_i_pdu(self, buf->data, buf->len);
-            submitted = TRUE;
         }
+        nfc_peer_connection_submit_i_pdu(self, segs, ps->rmiu - space);
+        g_ptr_array_free(segs, TRUE);
+        submitted = TRUE;
     }
 
     if (!priv->send_queue &&
@@ -568,6 +596,29 @@ nfc_peer_connection_flush(
     }
 }
 
+guint
+nfc_peer_connection_ack_delay(
+    NfcPeerConnection* self)
+{
+    return self->priv->ack_delay;
+}
+
+gboolean
+nfc_peer_connection_ack_due(
+    NfcPeerConnection* self)
+{
+    NfcPeerConnectionPriv* priv = self->priv;
+    const NfcPeerConnectionLlcpState* ps = &priv->ps;
+    const guint unacked = (ps->vr - ps->vra) & 0x0f;
+
+    /*
+     * Don't let the peer run into the end of our receive window
+     * while we are holding the acknowledgement. Half of the window
+     * leaves enough room for the RR to get through in time.
+     */
+    return unacked && unacked >= MAX((priv->rw_param.value.rw + 1) / 2, 1);
+}
+
 /*==========================================================================*
  * Methods
  *==========================================================================*/
@@ -635,7 +686,6 @@ nfc_peer_connection_init(
     NfcLlcParam* rw = &priv->rw_param;
 
     self->priv = priv;
-    priv->send_buf = g_byte_array_new();
 
     /* Set up local parameters */
     miu->type = NFC_LLC_PARAM_MIUX;
@@ -666,7 +716,6 @@ nfc_peer_connection_finalize(
     nfc_peer_connection_drop_queued_data(self);
     nfc_peer_service_unref(self->service);
     gutil_idle_pool_destroy(priv->pool);
-    g_byte_array_free(priv->send_buf, TRUE);
     g_free(priv->name);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
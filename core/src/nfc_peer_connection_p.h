@@ -53,6 +53,12 @@ typedef struct nfc_peer_connection_llcp_state {
      */
     guint8 rwr;         /* Remote Receive Window Size, RW(R) */
     guint16 rmiu;       /* Remote Maximum Information Unit size for I PDUs */
+
+    /*
+     * V(RA) is updated when a PDU is queued, this one when it's actually
+     * handed over to the link.
+     */
+    guint8 nrt;         /* The last transmitted N(R) */
 } NfcPeerConnectionLlcpState;
 
 #define LLCP_CONN_KEY(lsap,rsap)  GINT_TO_POINTER(\
@@ -109,6 +115,16 @@ nfc_peer_connection_flush(
     NfcPeerConnection* pc)
     NFCD_INTERNAL;
 
+guint
+nfc_peer_connection_ack_delay(
+    NfcPeerConnection* pc)
+    NFCD_INTERNAL;
+
+gboolean
+nfc_peer_connection_ack_due(
+    NfcPeerConnection* pc)
+    NFCD_INTERNAL;
+
 #endif /* NFC_PEER_CONNECTION_PRIVATE_H */
 
 /*
@@ -34,6 +34,7 @@
 #include "nfc_peer_service_impl.h"
 #include "nfc_peer_service_p.h"
 #include "nfc_llc.h"
+#include "nfc_llc_param.h"
 
 #define GLOG_MODULE_NAME NFC_PEER_LOG_MODULE
 #include <gutil_log.h>
@@ -41,6 +42,9 @@
 struct nfc_peer_service_priv {
     char* name;
     NfcPeerConnection** conns;
+    guint rw;
+    guint miu;
+    guint ack_delay;
 };
 
 #define THIS(obj) NFC_PEER_SERVICE(obj)
@@ -106,6 +110,37 @@ nfc_peer_service_disconnect_all(
     }
 }
 
+void
+nfc_peer_service_set_rw(
+    NfcPeerService* self,
+    guint rw)
+{
+    if (G_LIKELY(self)) {
+        self->priv->rw = rw ? MIN(rw, NFC_LLC_RW_MAX) : NFC_LLC_LOCAL_RW;
+    }
+}
+
+void
+nfc_peer_service_set_miu(
+    NfcPeerService* self,
+    guint miu)
+{
+    if (G_LIKELY(self)) {
+        self->priv->miu = miu ? MIN(MAX(miu, NFC_LLC_MIU_MIN),
+            NFC_LLC_MIU_MAX) : NFC_LLC_LOCAL_MIU;
+    }
+}
+
+void
+nfc_peer_service_set_ack_delay(
+    NfcPeerService* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        self->priv->ack_delay = ms;
+    }
+}
+
 /*==========================================================================*
  * Internal interface
  *==========================================================================*/
@@ -154,6 +189,27 @@ nfc_peer_service_new_accept(
     return pc;
 }
 
+guint
+nfc_peer_service_rw(
+    NfcPeerService* self)
+{
+    return self->priv->rw;
+}
+
+guint
+nfc_peer_service_miu(
+    NfcPeerService* self)
+{
+    return self->priv->miu;
+}
+
+guint
+nfc_peer_service_ack_delay(
+    NfcPeerService* self)
+{
+    return self->priv->ack_delay;
+}
+
 void
 nfc_peer_service_connection_created(
     NfcPeerService* self,
@@ -281,6 +337,8 @@ nfc_peer_service_init(
         NfcPeerServicePriv);
 
     self->priv = priv;
+    priv->rw = NFC_LLC_LOCAL_RW;
+    priv->miu = NFC_LLC_LOCAL_MIU;
 }
 
 static
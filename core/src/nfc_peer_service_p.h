@@ -50,6 +50,21 @@ nfc_peer_service_new_accept(
     guint8 rsap)
     NFCD_INTERNAL;
 
+guint
+nfc_peer_service_rw(
+    NfcPeerService* service)
+    NFCD_INTERNAL;
+
+guint
+nfc_peer_service_miu(
+    NfcPeerService* service)
+    NFCD_INTERNAL;
+
+guint
+nfc_peer_service_ack_delay(
+    NfcPeerService* service)
+    NFCD_INTERNAL;
+
 void
 nfc_peer_service_connection_created(
     NfcPeerService* service,
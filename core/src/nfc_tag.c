@@ -64,11 +64,13 @@ G_DEFINE_TYPE(NfcTag, nfc_tag, PARENT_TYPE)
 
 enum nfc_tag_signal {
     SIGNAL_INITIALIZED,
+    SIGNAL_NDEF_READY,
     SIGNAL_GONE,
     SIGNAL_COUNT
 };
 
 #define SIGNAL_INITIALIZED_NAME "nfc-tag-initialized"
+#define SIGNAL_NDEF_READY_NAME  "nfc-tag-ndef-ready"
 #define SIGNAL_GONE_NAME        "nfc-tag-gone"
 
 static guint nfc_tag_signals[SIGNAL_COUNT] = { 0 };
@@ -138,6 +140,14 @@ nfc_tag_deactivate(
     }
 }
 
+gboolean
+nfc_tag_read_ndef(
+    NfcTag* self) /* Since 1.2.8 */
+{
+    return G_LIKELY(self) && (self->flags & NFC_TAG_FLAG_NDEF_DEFERRED) &&
+        GET_THIS_CLASS(self)->read_ndef(self);
+}
+
 gulong
 nfc_tag_add_initialized_handler(
     NfcTag* self,
@@ -148,6 +158,16 @@ nfc_tag_add_initialized_handler(
         SIGNAL_INITIALIZED_NAME, G_CALLBACK(func), user_data) : 0;
 }
 
+gulong
+nfc_tag_add_ndef_ready_handler(
+    NfcTag* self,
+    NfcTagFunc func,
+    void* user_data) /* Since 1.2.8 */
+{
+    return (G_LIKELY(self) && G_LIKELY(func)) ? g_signal_connect(self,
+        SIGNAL_NDEF_READY_NAME, G_CALLBACK(func), user_data) : 0;
+}
+
 gulong
 nfc_tag_add_gone_handler(
     NfcTag* self,
@@ -268,6 +288,16 @@ nfc_tag_set_initialized(
     }
 }
 
+void
+nfc_tag_set_ndef_ready(
+    NfcTag* self)
+{
+    if (self->flags & NFC_TAG_FLAG_NDEF_DEFERRED) {
+        self->flags &= ~NFC_TAG_FLAG_NDEF_DEFERRED;
+        g_signal_emit(self, nfc_tag_signals[SIGNAL_NDEF_READY], 0);
+    }
+}
+
 /*==========================================================================*
  * Methods
  *==========================================================================*/
@@ -283,6 +313,16 @@ nfc_tag_default_gone(
     g_signal_emit(self, nfc_tag_signals[SIGNAL_GONE], 0);
 }
 
+static
+gboolean
+nfc_tag_default_read_ndef(
+    NfcTag* self)
+{
+    /* Nothing to read by default */
+    nfc_tag_set_ndef_ready(self);
+    return FALSE;
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -318,10 +358,14 @@ nfc_tag_class_init(
 {
     g_type_class_add_private(klass, sizeof(NfcTagPriv));
     klass->gone = nfc_tag_default_gone;
+    klass->read_ndef = nfc_tag_default_read_ndef;
     G_OBJECT_CLASS(klass)->finalize = nfc_tag_finalize;
     nfc_tag_signals[SIGNAL_INITIALIZED] =
         g_signal_new(SIGNAL_INITIALIZED_NAME, G_OBJECT_CLASS_TYPE(klass),
             G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    nfc_tag_signals[SIGNAL_NDEF_READY] =
+        g_signal_new(SIGNAL_NDEF_READY_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
     nfc_tag_signals[SIGNAL_GONE] =
         g_signal_new(SIGNAL_GONE_NAME, G_OBJECT_CLASS_TYPE(klass),
             G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
@@ -40,6 +40,7 @@
 typedef struct nfc_tag_class {
     GObjectClass parent;
     void (*gone)(NfcTag* tag);
+    gboolean (*read_ndef)(NfcTag* tag);
 } NfcTagClass;
 
 #define NFC_TAG_CLASS(klass) G_TYPE_CHECK_CLASS_CAST((klass), \
@@ -51,10 +52,12 @@ nfc_tag_new(
     const NfcParamPoll* poll)
     NFCD_INTERNAL;
 
+/* The cache is optional */
 NfcTagType2*
 nfc_tag_t2_new(
     NfcTarget* target,
-    const NfcParamPollA* poll_a)
+    const NfcParamPollA* poll_a,
+    NfcTagType2Cache* cache)
     NFCD_INTERNAL;
 
 void
@@ -75,6 +78,12 @@ nfc_tag_set_initialized(
     NfcTag* tag)
     NFCD_INTERNAL;
 
+/* Clears NFC_TAG_FLAG_NDEF_DEFERRED and emits the NDEF ready signal */
+void
+nfc_tag_set_ndef_ready(
+    NfcTag* tag)
+    NFCD_INTERNAL;
+
 #endif /* NFC_TAG_PRIVATE_H */
 
 /*
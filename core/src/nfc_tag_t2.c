@@ -40,6 +40,7 @@
 
 #include "nfc_tag_p.h"
 #include "nfc_tag_t2.h"
+#include "nfc_tag_t2_cache.h"
 #include "nfc_target_p.h"
 #include "nfc_util.h"
 #include "nfc_log.h"
@@ -56,9 +57,29 @@
 
 #define NFC_TAG_T2_CC_NFC_FORUM_MAGIC (0xe1)
 #define NFC_TAG_T2_CC_MIN_VERSION (0x10)
+#define NFC_TAG_T2_CC_OFFSET (12)
 
 #define NXP_MANUFACTURER_ID (0x04)
 
+/*
+ * GET_VERSION response (NTAG21x and MIFARE Ultralight EV1 datasheets)
+ *
+ * Byte 0 - Fixed header (0x00)
+ * Byte 1 - Vendor ID (0x04 for NXP)
+ * Byte 2 - Product type
+ * Byte 3 - Product subtype
+ * Byte 4 - Major product version
+ * Byte 5 - Minor product version
+ * Byte 6 - Storage size
+ * Byte 7 - Protocol type (0x03)
+ */
+#define NXP_VERSION_SIZE (8)
+#define NXP_VERSION_VENDOR (1)
+#define NXP_VERSION_TYPE (2)
+#define NXP_VERSION_STORAGE (6)
+#define NXP_PRODUCT_TYPE_ULTRALIGHT (0x03)
+#define NXP_PRODUCT_TYPE_NTAG (0x04)
+
 /*
  * Command set.
  *
@@ -67,12 +88,41 @@
  */
 #define NFC_TAG_T2_CMD_READ (0x30)
 #define NFC_TAG_T2_CMD_WRITE (0xa2)
+#define NFC_TAG_T2_CMD_SECTOR_SELECT (0xc2)
+
+/* READ always returns 4 blocks (16 bytes) */
+#define NFC_TAG_T2_READ_BLOCKS (4)
+
+/* NXP specific commands */
+#define NFC_TAG_T2_CMD_GET_VERSION (0x60)
+#define NFC_TAG_T2_CMD_FAST_READ (0x3a)
+
+/* Assumed when the adapter doesn't tell us its frame size */
+#define NFC_TAG_T2_DEFAULT_FRAME_SIZE (64)
+
+/*
+ * GET_VERSION costs a round trip (and a reactivation if the tag doesn't
+ * understand it). With the default frame size, each FAST_READ replaces
+ * 4 READs, so it's not worth asking if the whole data area fits into 4
+ * READs anyway.
+ */
+#define NFC_TAG_T2_FAST_READ_MIN_DATA_SIZE \
+    (4 * NFC_TAG_T2_READ_BLOCKS * NFC_TAG_T2_BLOCK_SIZE)
+
+/* 4-bit ACK */
+#define NFC_TAG_T2_ACK (0x0a)
+#define NFC_TAG_T2_ACK_MASK (0x0f)
+
+/* Sector size is 256 blocks (1024 bytes) */
+#define NFC_TAG_T2_SECTOR_BLOCKS (256)
 
 typedef struct nfc_tag_t2_cmd_data {
     NfcTagType2* t2;
     NfcTagType2ReadFunc resp;
     GDestroyNotify destroy;
     void* user_data;
+    guint select_id;
+    guint id;
 } NfcTagType2Cmd;
 
 typedef struct nfc_tag_t2_read_data {
@@ -82,12 +132,18 @@ typedef struct nfc_tag_t2_read_data {
     guint read;
     guint offset;
     guint complete_id;
+    guint continue_id;
     guint cmd_id;
     guint seq_id;
     NfcTargetSequence* seq;
     NfcTagType2ReadDataFunc complete;
     GDestroyNotify destroy;
     void* user_data;
+    struct nfc_tag_t2_sector* fetch_sector; /* What's being fetched */
+    guint fetch_block;                      /* (if anything) */
+    guint fetch_count;
+    struct nfc_tag_t2_read_data* wait_for;  /* Whose fetch we are waiting */
+    GSList* waiters;                        /* Who is waiting for us */
 } NfcTagType2ReadData;
 
 typedef struct nfc_tag_t2_write_data {
@@ -99,31 +155,74 @@ typedef struct nfc_tag_t2_write_data {
     guint cmd_id;
     guint seq_id;
     gulong start_id;
+    guint start_idle_id;
+    guint skipped;
     NfcTargetSequence* seq;
     union nfc_tag_t2_write_data_complete {
         GCallback cb;
         NfcTagType2WriteFunc write_cb;
         NfcTagType2WriteDataFunc write_data_cb;
+        NfcTagType2WriteDiffFunc write_diff_cb;
     } complete;
     GDestroyNotify destroy;
     void* user_data;
+    guint8 block[NFC_TAG_T2_MAX_BLOCK_SIZE]; /* Diff write only */
 } NfcTagType2WriteData;
 
 typedef struct nfc_tag_t2_sector {
     guint size;             /* Number of bytes in the sector */
-    guint8* bytes;          /* Sector's contents (not necessarily valid) */
+    guint header;           /* Number of bytes preceding the data */
+    guint8* bytes;          /* Sector's contents (allocated on demand) */
     guint8* valid;          /* One bit per block, 1 = cached, 0 = dirty */
     GUtilData data;         /* Data portion of the sector */
 } NfcTagType2Sector;
 
+/*
+ * The sector which will be selected after all the commands queued for
+ * a particular sequence have been executed. Sequences which don't have
+ * an entry in the table are expected to start and finish in sector 0,
+ * i.e. anyone who selects another sector has to select sector 0 before
+ * letting the sequence go. The select_id identifies the last SECTOR
+ * SELECT queued for the sequence, the commands which follow it fail if
+ * that SECTOR SELECT fails.
+ */
+typedef struct nfc_tag_t2_selection {
+    guint sector;
+    guint select_id;
+} NfcTagType2Selection;
+
+typedef struct nfc_tag_t2_nxp_model {
+    guint8 type;
+    guint8 storage;
+    const char* name;
+} NfcTagType2NxpModel;
+
+static const NfcTagType2NxpModel nfc_tag_t2_nxp_models[] = {
+    { NXP_PRODUCT_TYPE_ULTRALIGHT, 0x0b, "MIFARE Ultralight EV1 (MF0UL11)" },
+    { NXP_PRODUCT_TYPE_ULTRALIGHT, 0x0e, "MIFARE Ultralight EV1 (MF0UL21)" },
+    { NXP_PRODUCT_TYPE_NTAG, 0x0b, "NTAG210" },
+    { NXP_PRODUCT_TYPE_NTAG, 0x0e, "NTAG212" },
+    { NXP_PRODUCT_TYPE_NTAG, 0x0f, "NTAG213" },
+    { NXP_PRODUCT_TYPE_NTAG, 0x11, "NTAG215" },
+    { NXP_PRODUCT_TYPE_NTAG, 0x13, "NTAG216" }
+};
+
 struct nfc_tag_t2_priv {
     NfcTargetSequence* init_seq;
     GHashTable* reads;
     GHashTable* writes;
+    GSList* inflight;  /* Reads waiting for READ or FAST_READ response */
+    GHashTable* selections;
+    GHashTable* cmds;
     GByteArray* cached_blocks;
     guint sector_count;
     NfcTagType2Sector* sectors;
     guint init_id;
+    guint last_select_id;
+    guint failed_select_id;
+    guint fast_read_blocks; /* Zero if FAST_READ is not supported */
+    NfcTagType2Cache* cache;
+    GBytes* cached;         /* Cached data being verified */
 };
 
 typedef struct nfc_tag_t2_class {
@@ -152,12 +251,11 @@ nfc_tag_t2_data_block_to_sector(
 
     for (i = 0; i < priv->sector_count; i++) {
         NfcTagType2Sector* sector = priv->sectors + i;
-        const GUtilData* data = &sector->data;
-        const guint data_blocks = data->size / block_size;
+        const guint data_blocks = sector->data.size / block_size;
 
         if (block < (sector_start + data_blocks)) {
-            const guint header = data->bytes - sector->bytes;
-            const guint rel_block = block - sector_start + header / block_size;
+            const guint rel_block = block - sector_start +
+                sector->header / block_size;
 
             if (bno) {
                 *bno = rel_block;
@@ -165,7 +263,8 @@ nfc_tag_t2_data_block_to_sector(
             if (cached) {
                 const guint8 bit = (1 << (rel_block % 8));
 
-                *cached = ((sector->valid[rel_block / 8] & bit) != 0);
+                *cached = sector->valid &&
+                    (sector->valid[rel_block / 8] & bit) != 0;
             }
             return sector;
         }
@@ -183,15 +282,26 @@ nfc_tag_t2_sector_init(
     guint data_blocks,
     guint trailer_blocks)
 {
-    const guint total_blocks = header_blocks + data_blocks + trailer_blocks;
-
-    sector->size = total_blocks * block_size;
-    sector->bytes = g_malloc0(sector->size);
-    sector->valid = g_malloc0((total_blocks + 7) / 8);
-    sector->data.bytes = sector->bytes + (header_blocks * block_size);
+    /* The buffers get allocated when we actually read something */
+    sector->size = (header_blocks + data_blocks + trailer_blocks) *
+        block_size;
+    sector->header = header_blocks * block_size;
     sector->data.size = data_blocks * block_size;
 }
 
+static
+void
+nfc_tag_t2_sector_alloc(
+    NfcTagType2Sector* sector,
+    guint block_size)
+{
+    if (!sector->bytes) {
+        sector->bytes = g_malloc0(sector->size);
+        sector->valid = g_malloc0((sector->size / block_size + 7) / 8);
+        sector->data.bytes = sector->bytes + sector->header;
+    }
+}
+
 static
 void
 nfc_tag_t2_sector_deinit(
@@ -212,13 +322,14 @@ nfc_tag_t2_sector_set_data(
 {
     const guint total_blocks = sector->size / block_size;
 
-    if (block < total_blocks) {
+    if (block < total_blocks && num_blocks) {
         guint i;
 
         if ((block + num_blocks) > total_blocks) {
             num_blocks = total_blocks - block;
         }
 
+        nfc_tag_t2_sector_alloc(sector, block_size);
         memcpy(sector->bytes + block * block_size, bytes,
             num_blocks * block_size);
 
@@ -240,16 +351,16 @@ nfc_tag_t2_sector_invalidate(
 #pragma message("TODO: Invalidate and re-read NDEF")
     const guint total_blocks = sector->size / block_size;
 
-    if (block < total_blocks) {
+    /* Nothing to invalidate if nothing has been cached yet */
+    if (sector->bytes && block < total_blocks) {
         guint i;
 
         if ((block + num_blocks) > total_blocks) {
             num_blocks = total_blocks - block;
         }
 
-        memset(sector->bytes + block, 0, num_blocks * block_size);
-
-        /* Mark blocks as invalid */
+        /* Mark blocks as invalid (the contents may still be needed
+         * for mixing with the unaligned data being written) */
         for (i = 0; i < num_blocks; i++) {
             sector->valid[(block + i) / 8] &= ~(1 << ((block + i) % 8));
         }
@@ -274,6 +385,34 @@ nfc_tag_t2_generate_id(
     return id;
 }
 
+static
+const guint8*
+nfc_tag_t2_cc(
+    NfcTagType2* self)
+{
+    NfcTagType2Sector* sector = self->priv->sectors;
+
+    /* Sectors only exist if the CC has been read and recognized */
+    return (sector && sector->bytes) ?
+        (sector->bytes + NFC_TAG_T2_CC_OFFSET) : NULL;
+}
+
+static
+void
+nfc_tag_t2_uncache(
+    NfcTagType2* self)
+{
+    NfcTagType2Priv* priv = self->priv;
+
+    if (priv->cache) {
+        GDEBUG("Dropping cached data");
+        nfc_tag_t2_cache_evict(priv->cache, &self->nfcid1,
+            nfc_tag_t2_cc(self));
+        nfc_tag_t2_cache_unref(priv->cache);
+        priv->cache = NULL;
+    }
+}
+
 /*==========================================================================*
  * Commands
  *==========================================================================*/
@@ -284,7 +423,11 @@ nfc_tag_t2_cmd_destroy(
     void* user_data)
 {
     NfcTagType2Cmd* cmd = user_data;
+    NfcTagType2Priv* priv = cmd->t2->priv;
 
+    if (priv->cmds) {
+        g_hash_table_remove(priv->cmds, cmd);
+    }
     if (cmd->destroy) {
         cmd->destroy(cmd->user_data);
     }
@@ -301,8 +444,18 @@ nfc_tag_t2_cmd_resp(
     void* user_data)
 {
     NfcTagType2Cmd* cmd = user_data;
-
-    cmd->resp(cmd->t2, status, data, len, cmd->user_data);
+    NfcTagType2* t2 = cmd->t2;
+    NfcTagType2ReadFunc resp = cmd->resp;
+
+    if (resp) {
+        cmd->resp = NULL;
+        if (cmd->select_id && cmd->select_id == t2->priv->failed_select_id) {
+            /* The sector this command was addressed to isn't selected */
+            resp(t2, NFC_TRANSMIT_STATUS_ERROR, NULL, 0, cmd->user_data);
+        } else {
+            resp(t2, status, data, len, cmd->user_data);
+        }
+    }
 }
 
 static
@@ -317,24 +470,220 @@ nfc_tag_t2_cmd(
     void* user_data)
 {
     NfcTag* tag = &self->tag;
+    NfcTagType2Priv* priv = self->priv;
     NfcTagType2Cmd* data = g_slice_new(NfcTagType2Cmd);
+    const NfcTagType2Selection* sel = (seq && priv->selections) ?
+        g_hash_table_lookup(priv->selections, seq) : NULL;
     guint id;
 
     data->t2 = self;
     data->resp = resp;
     data->destroy = destroy;
     data->user_data = user_data;
+    data->select_id = sel ? sel->select_id : 0;
+    data->id = 0;
 
+    if (!priv->cmds) {
+        priv->cmds = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_hash_table_add(priv->cmds, data);
     id = nfc_target_transmit(tag->target, cmd, size, seq,
         resp ? nfc_tag_t2_cmd_resp : NULL, nfc_tag_t2_cmd_destroy, data);
     if (id) {
+        /* The request may have already completed */
+        if (g_hash_table_contains(priv->cmds, data)) {
+            data->id = id;
+        }
         return id;
     } else {
+        g_hash_table_remove(priv->cmds, data);
         g_slice_free(NfcTagType2Cmd, data);
         return 0;
     }
 }
 
+static
+void
+nfc_tag_t2_select_failed(
+    NfcTagType2* self,
+    guint select_id)
+{
+    NfcTagType2Priv* priv = self->priv;
+    NfcTarget* target = self->tag.target;
+    GSList* ids = NULL;
+    GSList* l;
+    GHashTableIter it;
+    gpointer key;
+
+    GDEBUG("SECTOR SELECT failed");
+    priv->failed_select_id = select_id;
+
+    /* Don't let the commands meant for another sector hit this one */
+    g_hash_table_iter_init(&it, priv->cmds);
+    while (g_hash_table_iter_next(&it, &key, NULL)) {
+        NfcTagType2Cmd* cmd = key;
+
+        /* The one being completed has its resp callback cleared */
+        if (cmd->select_id == select_id && cmd->id && cmd->resp) {
+            ids = g_slist_append(ids, GUINT_TO_POINTER(cmd->id));
+        }
+    }
+
+    nfc_tag_ref(&self->tag);
+    for (l = ids; l; l = l->next) {
+        const guint id = GPOINTER_TO_UINT(l->data);
+
+        /* Completion callbacks may cancel other commands */
+        g_hash_table_iter_init(&it, priv->cmds);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            NfcTagType2Cmd* cmd = key;
+
+            if (cmd->id == id) {
+                NfcTagType2ReadFunc resp = cmd->resp;
+
+                if (resp) {
+                    cmd->resp = NULL;
+                    resp(self, NFC_TRANSMIT_STATUS_ERROR, NULL, 0,
+                        cmd->user_data);
+                }
+                nfc_target_cancel_transmit(target, id);
+                break;
+            }
+        }
+    }
+    nfc_tag_unref(&self->tag);
+    g_slist_free(ids);
+}
+
+static
+void
+nfc_tag_t2_sector_select1_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    const guint8* resp = data;
+
+    if (status != NFC_TRANSMIT_STATUS_OK || len != 1 ||
+        (resp[0] & NFC_TAG_T2_ACK_MASK) != NFC_TAG_T2_ACK) {
+        nfc_tag_t2_select_failed(self, GPOINTER_TO_UINT(user_data));
+    }
+}
+
+static
+void
+nfc_tag_t2_sector_select2_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    /*
+     * The second packet is acknowledged passively, i.e. the tag
+     * doesn't respond at all if everything is fine. Whatever comes
+     * back (if anything) is a NACK.
+     */
+    if (len > 0) {
+        nfc_tag_t2_select_failed(self, GPOINTER_TO_UINT(user_data));
+    }
+}
+
+static
+void
+nfc_tag_t2_selection_free(
+    gpointer data)
+{
+    g_slice_free(NfcTagType2Selection, data);
+}
+
+/*
+ * Queues SECTOR SELECT for the specified sequence, unless the sector
+ * is going to be selected anyway by the time the next command of this
+ * sequence gets executed.
+ */
+static
+gboolean
+nfc_tag_t2_select_sector(
+    NfcTagType2* self,
+    NfcTargetSequence* seq,
+    guint sector)
+{
+    NfcTagType2Priv* priv = self->priv;
+    NfcTagType2Selection* sel = (seq && priv->selections) ?
+        g_hash_table_lookup(priv->selections, seq) : NULL;
+
+    if ((sel ? sel->sector : 0) == sector) {
+        return TRUE;
+    } else {
+        guint8 cmd1[2], cmd2[4];
+        guint select_id = ++priv->last_select_id;
+        guint id;
+
+        GASSERT(seq);
+        if (!select_id) {
+            /* Zero means no SECTOR SELECT at all */
+            select_id = ++priv->last_select_id;
+        }
+
+        if (sector) {
+            if (!sel) {
+                if (!priv->selections) {
+                    priv->selections = g_hash_table_new_full(g_direct_hash,
+                        g_direct_equal, NULL, nfc_tag_t2_selection_free);
+                }
+                sel = g_slice_new(NfcTagType2Selection);
+                g_hash_table_insert(priv->selections, seq, sel);
+            }
+            sel->sector = sector;
+            sel->select_id = select_id;
+        } else {
+            g_hash_table_remove(priv->selections, seq);
+        }
+
+        /*
+         * NFCForum-TS-DigitalProtocol-1.0
+         * Section 9 "Type 2 Tag Platform"
+         * 9.8 SECTOR SELECT
+         */
+        cmd1[0] = NFC_TAG_T2_CMD_SECTOR_SELECT;
+        cmd1[1] = 0xff;
+        cmd2[0] = sector;
+        cmd2[1] = cmd2[2] = cmd2[3] = 0;
+        GDEBUG("Selecting sector %u", sector);
+        id = nfc_tag_t2_cmd(self, cmd1, sizeof(cmd1), seq,
+            nfc_tag_t2_sector_select1_resp, NULL,
+            GUINT_TO_POINTER(select_id));
+        if (id) {
+            if (nfc_tag_t2_cmd(self, cmd2, sizeof(cmd2), seq,
+                nfc_tag_t2_sector_select2_resp, NULL,
+                GUINT_TO_POINTER(select_id))) {
+                return TRUE;
+            }
+            nfc_target_cancel_transmit(self->tag.target, id);
+        }
+        priv->failed_select_id = select_id;
+        return FALSE;
+    }
+}
+
+static
+void
+nfc_tag_t2_release_sector(
+    NfcTagType2* self,
+    NfcTargetSequence* seq)
+{
+    NfcTagType2Priv* priv = self->priv;
+
+    /* Everyone else expects to find the tag in sector 0 */
+    if (seq && priv->selections &&
+        g_hash_table_contains(priv->selections, seq)) {
+        nfc_tag_t2_select_sector(self, seq, 0);
+    }
+}
+
 static
 guint
 nfc_tag_t2_cmd_read(
@@ -359,6 +708,58 @@ nfc_tag_t2_cmd_read(
     return 0;
 }
 
+static
+guint
+nfc_tag_t2_read_blocks_count(
+    NfcTagType2* self,
+    NfcTagType2Sector* sector,
+    guint block,   /* Relative to the start of the sector */
+    guint count)   /* Number of blocks we actually need */
+{
+    const guint sector_blocks = sector->size / self->block_size;
+
+    /* READ fetches 4 blocks anyway, FAST_READ is limited by frame size */
+    count = MAX(MIN(count, self->priv->fast_read_blocks),
+        NFC_TAG_T2_READ_BLOCKS);
+
+    /* Either way, only the blocks within the sector get cached */
+    if (block < sector_blocks && (block + count) > sector_blocks) {
+        count = sector_blocks - block;
+    }
+    return count;
+}
+
+static
+guint
+nfc_tag_t2_cmd_read_blocks(
+    NfcTagType2* self,
+    NfcTagType2Sector* sector,
+    guint block,   /* Relative to the start of the sector */
+    guint count,   /* Number of blocks we actually need */
+    NfcTargetSequence* seq,
+    NfcTagType2ReadFunc resp,
+    GDestroyNotify done,
+    void* user_data)
+{
+    count = nfc_tag_t2_read_blocks_count(self, sector, block, count);
+    if (count > NFC_TAG_T2_READ_BLOCKS) {
+        guint8 cmd[3];
+
+        /*
+         * NTAG21x and MIFARE Ultralight EV1 datasheets
+         * FAST_READ: start and end addresses (both inclusive)
+         */
+        cmd[0] = NFC_TAG_T2_CMD_FAST_READ;
+        cmd[1] = block;
+        cmd[2] = block + count - 1;
+        return nfc_tag_t2_cmd(self, cmd, sizeof(cmd), seq, resp, done,
+            user_data);
+    } else {
+        /* READ fetches 4 blocks anyway */
+        return nfc_tag_t2_cmd_read(self, block, seq, resp, done, user_data);
+    }
+}
+
 static
 guint
 nfc_tag_t2_cmd_write(
@@ -373,6 +774,9 @@ nfc_tag_t2_cmd_write(
     if (block <= 0xff) {
         guint8 cmd[2 + NFC_TAG_T2_MAX_BLOCK_SIZE];
 
+        /* Whatever we have cached on disk is about to become stale */
+        nfc_tag_t2_uncache(self);
+
         /*
          * NFCForum-TS-DigitalProtocol-1.0
          * Section 9 "Type 2 Tag Platform"
@@ -391,44 +795,197 @@ nfc_tag_t2_cmd_write(
  * Read
  *==========================================================================*/
 
+static
+gboolean
+nfc_tag_t2_read_continue_cb(
+    gpointer user_data);
+
 static
 void
 nfc_tag_t2_read_data_free(
     gpointer user_data)
 {
     NfcTagType2ReadData* read = user_data;
+    NfcTagType2Priv* priv = read->t2->priv;
+    GSList* l;
+
+    if (read->wait_for) {
+        read->wait_for->waiters = g_slist_remove(read->wait_for->waiters,
+            read);
+    }
+
+    /* Whoever was waiting for our data will have to fetch it themselves */
+    for (l = read->waiters; l; l = l->next) {
+        NfcTagType2ReadData* waiter = l->data;
+
+        waiter->wait_for = NULL;
+        waiter->continue_id = g_idle_add(nfc_tag_t2_read_continue_cb,
+            waiter);
+    }
+    g_slist_free(read->waiters);
+    priv->inflight = g_slist_remove(priv->inflight, read);
 
-    nfc_target_sequence_unref(read->seq);
     nfc_target_cancel_transmit(read->t2->tag.target, read->cmd_id);
+    nfc_tag_t2_release_sector(read->t2, read->seq);
+    nfc_target_sequence_unref(read->seq);
     if (read->destroy) {
         read->destroy(read->user_data);
     }
     if (read->complete_id) {
         g_source_remove(read->complete_id);
     }
+    if (read->continue_id) {
+        g_source_remove(read->continue_id);
+    }
     g_free(read->buffer);
     gutil_slice_free(read);
 }
 
+static
+void
+nfc_tag_t2_read_finish(
+    NfcTagType2ReadData* read,
+    NFC_TAG_T2_IO_STATUS status)
+{
+    NfcTagType2* t2 = read->t2;
+
+    if (read->complete) {
+        read->complete(t2, status, read->buffer, read->read, read->user_data);
+    }
+    g_hash_table_remove(t2->priv->reads, GUINT_TO_POINTER(read->seq_id));
+}
+
 static
 gboolean
 nfc_tag_t2_read_complete(
     gpointer user_data)
 {
     NfcTagType2ReadData* read = user_data;
-    NfcTagType2* t2 = read->t2;
-    NfcTagType2Priv* priv = t2->priv;
-    NfcTag* tag = &t2->tag;
-    const guint seq_id = read->seq_id;
+    NfcTag* tag = &read->t2->tag;
 
     read->complete_id = 0;
     nfc_tag_ref(tag);
-    if (read->complete) {
-        read->complete(t2, NFC_TAG_T2_IO_STATUS_OK, read->buffer, read->read,
-            read->user_data);
+    nfc_tag_t2_read_finish(read, NFC_TAG_T2_IO_STATUS_OK);
+    nfc_tag_unref(tag);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_tag_t2_read_cached(
+    NfcTagType2ReadData* read)
+{
+    NfcTagType2* t2 = read->t2;
+    const guint block_size = t2->block_size;
+
+    /* Copy cached data (possibly from more than one sector) */
+    while (read->read < read->size) {
+        const guint pos = read->offset + read->read;
+        const guint skip = pos % block_size;
+        const guint n = MIN(block_size - skip, read->size - read->read);
+        guint bno;
+        gboolean cached;
+        NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(t2,
+            pos / block_size, &bno, &cached);
+
+        if (sector && cached) {
+            memcpy(read->buffer + read->read, sector->bytes +
+                bno * block_size + skip, n);
+            read->read += n;
+        } else {
+            break;
+        }
     }
+}
+
+static
+void
+nfc_tag_t2_read_resp(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data);
+
+static
+gboolean
+nfc_tag_t2_read_submit(
+    NfcTagType2ReadData* read)
+{
+    NfcTagType2* t2 = read->t2;
+    NfcTagType2Priv* priv = t2->priv;
+    const guint block_size = t2->block_size;
+    const guint block = (read->offset + read->read) / block_size;
+    const guint count = (read->offset + read->size + block_size - 1) /
+        block_size - block;
+    guint bno;
+    NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(t2,
+        block, &bno, NULL);
+
+    if (sector) {
+        GSList* l;
 
-    g_hash_table_remove(priv->reads, GUINT_TO_POINTER(seq_id));
+        /*
+         * If this block is already being fetched, wait for it. Only
+         * join the fetches from the currently active sequence though,
+         * otherwise our own sequence may get activated first and block
+         * the one we would be waiting for.
+         */
+        for (l = priv->inflight; l; l = l->next) {
+            NfcTagType2ReadData* other = l->data;
+
+            if (other->fetch_sector == sector &&
+                bno >= other->fetch_block &&
+                bno < (other->fetch_block + other->fetch_count) &&
+                other->seq == t2->tag.target->sequence) {
+                GDEBUG("Block %u is already being fetched", bno);
+                read->wait_for = other;
+                other->waiters = g_slist_append(other->waiters, read);
+                return TRUE;
+            }
+        }
+
+        if (nfc_tag_t2_select_sector(t2, read->seq, sector - priv->sectors)) {
+            read->fetch_sector = sector;
+            read->fetch_block = bno;
+            read->fetch_count = nfc_tag_t2_read_blocks_count(t2, sector,
+                bno, count);
+            priv->inflight = g_slist_append(priv->inflight, read);
+            read->cmd_id = nfc_tag_t2_cmd_read_blocks(t2, sector, bno,
+                count, read->seq, nfc_tag_t2_read_resp, NULL, read);
+            if (read->cmd_id) {
+                return TRUE;
+            }
+            priv->inflight = g_slist_remove(priv->inflight, read);
+        }
+    }
+    return FALSE;
+}
+
+static
+void
+nfc_tag_t2_read_continue(
+    NfcTagType2ReadData* read)
+{
+    nfc_tag_t2_read_cached(read);
+    if (read->read == read->size) {
+        nfc_tag_t2_read_finish(read, NFC_TAG_T2_IO_STATUS_OK);
+    } else if (!nfc_tag_t2_read_submit(read)) {
+        nfc_tag_t2_read_finish(read, NFC_TAG_T2_IO_STATUS_IO_ERROR);
+    }
+}
+
+static
+gboolean
+nfc_tag_t2_read_continue_cb(
+    gpointer user_data)
+{
+    NfcTagType2ReadData* read = user_data;
+    NfcTag* tag = &read->t2->tag;
+
+    read->continue_id = 0;
+    nfc_tag_ref(tag);
+    nfc_tag_t2_read_continue(read);
     nfc_tag_unref(tag);
     return G_SOURCE_REMOVE;
 }
@@ -445,46 +1002,40 @@ nfc_tag_t2_read_resp(
     NfcTagType2ReadData* read = user_data;
     NfcTagType2Priv* priv = t2->priv;
     NfcTag* tag = &t2->tag;
-    const guint seq_id = read->seq_id;
+    const guint block_size = t2->block_size;
+    const guint done = read->read;
+    GSList* waiters = read->waiters;
+    GSList* l;
 
     read->cmd_id = 0;
-    nfc_tag_ref(tag);
-    if (status == NFC_TRANSMIT_STATUS_OK && len > 0) {
-        const guint block_size = t2->block_size;
-        const guint8* bytes = data;
-        guint rel_block;
-        NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(t2,
-            (read->offset + read->read) / block_size, &rel_block, NULL);
+    read->waiters = NULL;
+    priv->inflight = g_slist_remove(priv->inflight, read);
+    for (l = waiters; l; l = l->next) {
+        ((NfcTagType2ReadData*)l->data)->wait_for = NULL;
+    }
 
-        if (sector) {
-            const guint nb = len / block_size;
-            const guint offset = (read->offset + read->read) % block_size;
+    nfc_tag_ref(tag);
+    if (status == NFC_TRANSMIT_STATUS_OK && len >= block_size) {
+        /* This may satisfy more than one reader */
+        nfc_tag_t2_sector_set_data(read->fetch_sector, block_size, data,
+            read->fetch_block, len / block_size);
+        nfc_tag_t2_read_cached(read);
+    }
+    read->fetch_sector = NULL;
 
-            nfc_tag_t2_sector_set_data(sector, block_size, bytes,
-                rel_block, nb);
-            if (len > (read->size - read->read)) {
-                len = read->size - read->read;
-            }
-            memcpy(read->buffer + read->read, bytes + offset, len);
-            read->read += len;
-            if (read->read < read->size) {
-                /* Submit the next read */
-                read->cmd_id = nfc_tag_t2_cmd_read(t2, rel_block + nb,
-                    read->seq, nfc_tag_t2_read_resp, NULL, read);
-            }
-        }
-    } else {
+    if (read->read == done) {
         GDEBUG("Oops, read failed!");
+        nfc_tag_t2_read_finish(read, NFC_TAG_T2_IO_STATUS_IO_ERROR);
+    } else {
+        /* Submit the next read (possibly from the next sector) */
+        nfc_tag_t2_read_continue(read);
     }
 
-    if (!read->cmd_id) {
-        if (read->complete) {
-            read->complete(t2, (status == NFC_TRANSMIT_STATUS_OK) ?
-                NFC_TAG_T2_IO_STATUS_OK : NFC_TAG_T2_IO_STATUS_IO_ERROR,
-                read->buffer, read->read, read->user_data);
-        }
-        g_hash_table_remove(priv->reads, GUINT_TO_POINTER(seq_id));
+    /* If the read has failed, the waiters will retry on their own */
+    for (l = waiters; l; l = l->next) {
+        nfc_tag_t2_read_continue(l->data);
     }
+    g_slist_free(waiters);
     nfc_tag_unref(tag);
 }
 
@@ -501,6 +1052,15 @@ nfc_tag_t2_write_data_resp(
     guint len,
     void* user_data);
 
+static
+void
+nfc_tag_t2_write_data_fetch_resp(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data);
+
 static
 void
 nfc_tag_t2_write_data_free(
@@ -510,8 +1070,12 @@ nfc_tag_t2_write_data_free(
     NfcTarget* target = write->t2->tag.target;
 
     nfc_target_remove_handler(target, write->start_id);
-    nfc_target_sequence_unref(write->seq);
     nfc_target_cancel_transmit(target, write->cmd_id);
+    if (write->start_idle_id) {
+        g_source_remove(write->start_idle_id);
+    }
+    nfc_tag_t2_release_sector(write->t2, write->seq);
+    nfc_target_sequence_unref(write->seq);
     if (write->destroy) {
         write->destroy(write->user_data);
     }
@@ -553,6 +1117,36 @@ nfc_tag_t2_write_data_new(
     return write;
 }
 
+static
+guint
+nfc_tag_t2_write_submit_write(
+    NfcTagType2WriteData* write,
+    NfcTagType2Sector* sector,
+    guint block,
+    const guint8* data,
+    NfcTagType2ReadFunc resp)
+{
+    NfcTagType2* t2 = write->t2;
+
+    return nfc_tag_t2_select_sector(t2, write->seq, sector -
+        t2->priv->sectors) ? nfc_tag_t2_cmd_write(t2, block, data,
+        write->seq, resp, NULL, write) : 0;
+}
+
+static
+guint
+nfc_tag_t2_write_submit_fetch(
+    NfcTagType2WriteData* write,
+    NfcTagType2Sector* sector,
+    guint block)
+{
+    NfcTagType2* t2 = write->t2;
+
+    return nfc_tag_t2_select_sector(t2, write->seq, sector -
+        t2->priv->sectors) ? nfc_tag_t2_cmd_read(t2, block, write->seq,
+        nfc_tag_t2_write_data_fetch_resp, NULL, write) : 0;
+}
+
 static
 void
 nfc_tag_t2_write_data_error(
@@ -625,9 +1219,18 @@ nfc_tag_t2_write_resp(
         write->written += block_size;
         next_block = (write->offset + write->written)/block_size;
         nfc_tag_t2_sector_invalidate(sector, block_size, next_block, 1);
-        write->cmd_id = nfc_tag_t2_cmd_write(t2, next_block,
-            data + write->written, write->seq, nfc_tag_t2_write_resp,
-            NULL, write);
+        write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+            next_block, data + write->written, nfc_tag_t2_write_resp);
+        if (!write->cmd_id) {
+            NfcTagType2WriteFunc complete = write->complete.write_cb;
+
+            if (complete) {
+                write->complete.write_cb = NULL;
+                complete(write->t2, NFC_TRANSMIT_STATUS_ERROR,
+                    write->written, write->user_data);
+            }
+            g_hash_table_remove(priv->writes, GUINT_TO_POINTER(write->seq_id));
+        }
     }
     nfc_tag_unref(tag);
 }
@@ -668,12 +1271,11 @@ nfc_tag_t2_write_data_fetch_resp(
             /* First block (and possibly the last one) */
             GASSERT(block_offset);
             GASSERT(!write->written);
-            memcpy(b, sector->data.bytes + (write->offset - block_offset),
-                block_size);
+            memcpy(b, sector->bytes + next_block * block_size, block_size);
             memcpy(b + block_offset, write_data, MIN(block_size - block_offset,
                 write_size));
-            write->cmd_id = nfc_tag_t2_cmd_write(t2, next_block, b,
-                write->seq, nfc_tag_t2_write_data_resp, NULL, write);
+            write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                next_block, b, nfc_tag_t2_write_data_resp);
         } else {
             const guint remaining = write_size - write->written;
 
@@ -682,8 +1284,11 @@ nfc_tag_t2_write_data_fetch_resp(
             memcpy(b, write_data + write->written, remaining);
             memcpy(b + remaining, sector->bytes + (next_block * block_size +
                 remaining), block_size - remaining);
-            write->cmd_id = nfc_tag_t2_cmd_write(t2, next_block, b,
-                write->seq, nfc_tag_t2_write_data_resp, NULL, write);
+            write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                next_block, b, nfc_tag_t2_write_data_resp);
+        }
+        if (!write->cmd_id) {
+            nfc_tag_t2_write_data_error(write);
         }
     } else {
         GDEBUG("Oops, fetch failed!");
@@ -756,73 +1361,292 @@ nfc_tag_t2_write_data_resp(
                 memcpy(b + remaining, sector->bytes +
                     (next_block * block_size + remaining),
                     block_size - remaining);
-                write->cmd_id = nfc_tag_t2_cmd_write(t2, next_block, b,
-                    write->seq, nfc_tag_t2_write_data_resp, NULL, write);
+                write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                    next_block, b, nfc_tag_t2_write_data_resp);
             } else {
                 /* Have to fetch it first */
-                write->cmd_id = nfc_tag_t2_cmd_read(t2, next_block,
-                   write->seq, nfc_tag_t2_write_data_fetch_resp, NULL, write);
+                write->cmd_id = nfc_tag_t2_write_submit_fetch(write, sector,
+                    next_block);
             }
-        } else{
-            write->cmd_id = nfc_tag_t2_cmd_write(t2, next_block,
-                data + write->written, write->seq, nfc_tag_t2_write_data_resp,
-                NULL, write);
+        } else {
+            /* The next block may be in the next sector */
+            write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                next_block, data + write->written,
+                nfc_tag_t2_write_data_resp);
         }
+        if (!write->cmd_id) {
+            nfc_tag_t2_write_data_error(write);
+        }
+    }
+    nfc_tag_unref(tag);
+}
+
+static
+void
+nfc_tag_t2_write_data_unaligned_start(
+    NfcTagType2WriteData* write)
+{
+    NfcTagType2* t2 = write->t2;
+    const guint block_size = t2->block_size;
+    const guint block_offset = write->offset % block_size;
+    gsize write_size;
+    const guint8* write_data = g_bytes_get_data(write->bytes, &write_size);
+    guint start_block;
+    gboolean start_block_cached;
+    NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(t2,
+        write->offset / block_size, &start_block, &start_block_cached);
+
+    GASSERT(block_offset);
+    GASSERT(!write->cmd_id);
+
+    /* For unaligned writes we have to first read the block that
+     * we are going to (partially) overwrite. */
+    nfc_tag_t2_sector_invalidate(sector, block_size, start_block, 1);
+    if (start_block_cached) {
+        guint8 b[NFC_TAG_T2_MAX_BLOCK_SIZE];
+
+        /* Mix the contents */
+        memcpy(b, sector->bytes + start_block * block_size, block_size);
+        memcpy(b + block_offset, write_data, MIN(block_size - block_offset,
+            write_size));
+        write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+            start_block, b, nfc_tag_t2_write_data_resp);
+    } else {
+        /* Have to fetch it first */
+        write->cmd_id = nfc_tag_t2_write_submit_fetch(write, sector,
+            start_block);
+    }
+}
+
+static
+void
+nfc_tag_t2_write_data_unaligned_wait(
+    NfcTarget* target,
+    void* user_data)
+{
+    NfcTagType2WriteData* write = user_data;
+
+    if (target->sequence == write->seq) {
+        GDEBUG("Starting write #%u", write->seq_id);
+        nfc_target_remove_handler(target, write->start_id);
+        write->start_id = 0;
+        nfc_tag_t2_write_data_unaligned_start(write);
+        if (!write->cmd_id) {
+            nfc_tag_t2_write_data_error(write);
+        }
+    }
+}
+
+/*==========================================================================*
+ * Diff write
+ *==========================================================================*/
+
+static
+void
+nfc_tag_t2_write_diff_complete(
+    NfcTagType2WriteData* write,
+    NFC_TAG_T2_IO_STATUS status)
+{
+    NfcTagType2* t2 = write->t2;
+    NfcTagType2WriteDiffFunc complete = write->complete.write_diff_cb;
+
+    GDEBUG("Wrote %u byte(s), %u block(s) unchanged", write->written,
+        write->skipped);
+    if (complete) {
+        write->complete.write_diff_cb = NULL;
+        complete(t2, status, write->written, write->skipped,
+            write->user_data);
+    }
+    g_hash_table_remove(t2->priv->writes, GUINT_TO_POINTER(write->seq_id));
+}
+
+static
+NfcTagType2Sector*
+nfc_tag_t2_write_diff_block(
+    NfcTagType2WriteData* write,
+    guint* bno,
+    guint* skip,
+    guint* n,
+    gboolean* cached)
+{
+    NfcTagType2* t2 = write->t2;
+    const guint block_size = t2->block_size;
+    const guint pos = write->offset + write->written;
+
+    /* The block which contains the next byte to be written */
+    *skip = pos % block_size;
+    *n = MIN(block_size - *skip, g_bytes_get_size(write->bytes) -
+        write->written);
+    return nfc_tag_t2_data_block_to_sector(t2, pos / block_size, bno,
+        cached);
+}
+
+static
+void
+nfc_tag_t2_write_diff_next(
+    NfcTagType2WriteData* write);
+
+static
+void
+nfc_tag_t2_write_diff_fetch_resp(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcTagType2WriteData* write = user_data;
+    NfcTag* tag = &t2->tag;
+    const guint block_size = t2->block_size;
+
+    write->cmd_id = 0;
+    nfc_tag_ref(tag);
+    if (status == NFC_TRANSMIT_STATUS_OK && len >= block_size) {
+        guint bno, skip, n;
+        NfcTagType2Sector* sector = nfc_tag_t2_write_diff_block(write,
+            &bno, &skip, &n, NULL);
+
+        nfc_tag_t2_sector_set_data(sector, block_size, data, bno,
+            len / block_size);
+        nfc_tag_t2_write_diff_next(write);
+    } else {
+        GDEBUG("Oops, fetch failed!");
+        nfc_tag_t2_write_diff_complete(write, NFC_TAG_T2_IO_STATUS_IO_ERROR);
+    }
+    nfc_tag_unref(tag);
+}
+
+static
+void
+nfc_tag_t2_write_diff_resp(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    const void* resp,
+    guint len,
+    void* user_data)
+{
+    NfcTagType2WriteData* write = user_data;
+    NfcTag* tag = &t2->tag;
+    const guint8* ack = resp;
+
+    write->cmd_id = 0;
+    nfc_tag_ref(tag);
+    if (status == NFC_TRANSMIT_STATUS_OK && len == 1 &&
+        (ack[0] & NFC_TAG_T2_ACK_MASK) == NFC_TAG_T2_ACK) {
+        guint bno, skip, n;
+        NfcTagType2Sector* sector = nfc_tag_t2_write_diff_block(write,
+            &bno, &skip, &n, NULL);
+
+        /* Now we know exactly what's stored there */
+        nfc_tag_t2_sector_set_data(sector, t2->block_size, write->block,
+            bno, 1);
+        write->written += n;
+        nfc_tag_t2_write_diff_next(write);
+    } else {
+        GDEBUG("Oops, write failed!");
+        nfc_tag_t2_write_diff_complete(write, NFC_TAG_T2_IO_STATUS_IO_ERROR);
     }
     nfc_tag_unref(tag);
 }
 
 static
 void
-nfc_tag_t2_write_data_unaligned_start(
+nfc_tag_t2_write_diff_next(
     NfcTagType2WriteData* write)
 {
     NfcTagType2* t2 = write->t2;
     const guint block_size = t2->block_size;
-    const guint block_offset = write->offset % block_size;
-    gsize write_size;
-    const guint8* write_data = g_bytes_get_data(write->bytes, &write_size);
-    guint start_block;
-    gboolean start_block_cached;
-    NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(t2,
-        write->offset / block_size, &start_block, &start_block_cached);
+    gsize size;
+    const guint8* data = g_bytes_get_data(write->bytes, &size);
 
-    GASSERT(block_offset);
     GASSERT(!write->cmd_id);
+    while (write->written < size) {
+        guint bno, skip, n;
+        gboolean cached;
+        NfcTagType2Sector* sector = nfc_tag_t2_write_diff_block(write,
+            &bno, &skip, &n, &cached);
 
-    /* For unaligned writes we have to first read the block that
-     * we are going to (partially) overwrite. */
-    nfc_tag_t2_sector_invalidate(sector, block_size, start_block, 1);
-    if (start_block_cached) {
-        guint8 b[NFC_TAG_T2_MAX_BLOCK_SIZE];
+        if (!sector) {
+            break;
+        } else if (!cached) {
+            /* Fetch this block and as many following ones as we can */
+            const guint end = (write->offset + size + block_size - 1) /
+                block_size;
+            const guint count = end - (write->offset + write->written) /
+                block_size;
+
+            if (nfc_tag_t2_select_sector(t2, write->seq, sector -
+                t2->priv->sectors)) {
+                write->cmd_id = nfc_tag_t2_cmd_read_blocks(t2, sector, bno,
+                    count, write->seq, nfc_tag_t2_write_diff_fetch_resp,
+                    NULL, write);
+            }
+            break;
+        } else {
+            const guint8* stored = sector->bytes + bno * block_size;
+
+            memcpy(write->block, stored, block_size);
+            memcpy(write->block + skip, data + write->written, n);
+            if (memcmp(write->block, stored, block_size)) {
+                /* Contents of the block is unknown until it's ACKed */
+                nfc_tag_t2_sector_invalidate(sector, block_size, bno, 1);
+                write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                    bno, write->block, nfc_tag_t2_write_diff_resp);
+                break;
+            }
+            write->skipped++;
+            write->written += n;
+        }
+    }
 
-        /* Mix the contents */
-        memcpy(b, sector->data.bytes + (write->offset - block_offset),
-            block_size);
-        memcpy(b + block_offset, write_data, MIN(block_size - block_offset,
-            write_size));
-        write->cmd_id = nfc_tag_t2_cmd_write(t2, start_block, b, write->seq,
-            nfc_tag_t2_write_data_resp, NULL, write);
-    } else {
-        /* Have to fetch it first */
-        write->cmd_id = nfc_tag_t2_cmd_read(t2, start_block, write->seq,
-            nfc_tag_t2_write_data_fetch_resp, NULL, write);
+    if (!write->cmd_id) {
+        nfc_tag_t2_write_diff_complete(write, (write->written < size) ?
+            NFC_TAG_T2_IO_STATUS_IO_ERROR : NFC_TAG_T2_IO_STATUS_OK);
     }
 }
 
 static
 void
-nfc_tag_t2_write_data_unaligned_wait(
+nfc_tag_t2_write_diff_start(
+    NfcTagType2WriteData* write)
+{
+    NfcTarget* target = write->t2->tag.target;
+    NfcTag* tag = &write->t2->tag;
+
+    GDEBUG("Starting write #%u", write->seq_id);
+    nfc_target_remove_handler(target, write->start_id);
+    write->start_id = 0;
+    if (write->start_idle_id) {
+        g_source_remove(write->start_idle_id);
+        write->start_idle_id = 0;
+    }
+    nfc_tag_ref(tag);
+    nfc_tag_t2_write_diff_next(write);
+    nfc_tag_unref(tag);
+}
+
+static
+gboolean
+nfc_tag_t2_write_diff_start_cb(
+    gpointer user_data)
+{
+    NfcTagType2WriteData* write = user_data;
+
+    write->start_idle_id = 0;
+    nfc_tag_t2_write_diff_start(write);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_tag_t2_write_diff_wait(
     NfcTarget* target,
     void* user_data)
 {
     NfcTagType2WriteData* write = user_data;
 
     if (target->sequence == write->seq) {
-        GDEBUG("Starting write #%u", write->seq_id);
-        nfc_target_remove_handler(target, write->start_id);
-        write->start_id = 0;
-        nfc_tag_t2_write_data_unaligned_start(write);
+        nfc_tag_t2_write_diff_start(write);
     }
 }
 
@@ -845,6 +1669,161 @@ nfc_tag_t2_initialized(
     nfc_tag_set_initialized(tag);
 }
 
+static
+void
+nfc_tag_t2_init_data_done(
+    NfcTagType2* self,
+    guint block) /* The first block which hasn't been read */
+{
+    NfcTag* tag = &self->tag;
+    NfcTagType2Sector* sector = self->priv->sectors; /* sector 0 */
+    const guint block_size = self->block_size;
+    GUtilData data;
+
+    data.bytes = sector->data.bytes;
+    data.size = (block - NFC_TAG_T2_DATA_BLOCK0) * block_size;
+    GDEBUG("Tag data:");
+    nfc_hexdump_data(&data);
+    if ((block * block_size) < sector->size) {
+        /* Inficate that data wasn't fully read */
+        gutil_log(&nfc_dump_log, GLOG_LEVEL_DEBUG, "  %04X: ...",
+            block * block_size);
+    }
+
+    /*
+     * Find NDEF. Only sector 0 is scanned, TLVs continuing into
+     * the next sector(s) won't be recognized. The rest of the data
+     * area is still accessible via nfc_tag_t2_read_data() and friends.
+     */
+    tag->ndef = ndef_rec_new_from_tlv(&sector->data);
+    nfc_tag_t2_initialized(self);
+}
+
+static
+void
+nfc_tag_t2_init_read_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* bytes,
+    guint len,
+    void* user_data);
+
+static
+guint
+nfc_tag_t2_init_read_data(
+    NfcTagType2* self)
+{
+    NfcTagType2Priv* priv = self->priv;
+
+    return (priv->init_id = nfc_tag_t2_cmd_read_blocks(self, priv->sectors,
+        NFC_TAG_T2_DATA_BLOCK0, priv->sectors->size / self->block_size -
+        NFC_TAG_T2_DATA_BLOCK0, priv->init_seq, nfc_tag_t2_init_read_resp,
+        NULL, GUINT_TO_POINTER(NFC_TAG_T2_DATA_BLOCK0)));
+}
+
+static
+void
+nfc_tag_t2_init_verify_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcTagType2Priv* priv = self->priv;
+    const guint block = GPOINTER_TO_UINT(user_data);
+    const guint block_size = self->block_size;
+    const guint offset = (block - NFC_TAG_T2_DATA_BLOCK0) * block_size;
+    GBytes* cached = priv->cached;
+    gsize size;
+    const guint8* bytes = g_bytes_get_data(cached, &size);
+    const guint n = MIN(size - offset, NFC_TAG_T2_READ_BLOCKS * block_size);
+
+    priv->init_id = 0;
+    priv->cached = NULL;
+    if (status != NFC_TRANSMIT_STATUS_OK) {
+        /* That doesn't tell us anything about the cached data */
+        nfc_tag_t2_init_read_resp(self, status, data, len, user_data);
+    } else if (len >= n && !memcmp(data, bytes + offset, n)) {
+        const guint nb = size / block_size;
+        const guint last = NFC_TAG_T2_DATA_BLOCK0 + nb -
+            NFC_TAG_T2_READ_BLOCKS;
+
+        if (block < last) {
+            /* Check the other end of the cached data too */
+            priv->cached = cached;
+            priv->init_id = nfc_tag_t2_cmd_read(self, last, priv->init_seq,
+                nfc_tag_t2_init_verify_resp, NULL, GUINT_TO_POINTER(last));
+            if (priv->init_id) {
+                return;
+            }
+            priv->cached = NULL;
+            nfc_tag_t2_initialized(self);
+        } else {
+            GDEBUG("Using cached data");
+            nfc_tag_t2_sector_set_data(priv->sectors, block_size, bytes,
+                NFC_TAG_T2_DATA_BLOCK0, nb);
+            nfc_tag_t2_init_data_done(self, NFC_TAG_T2_DATA_BLOCK0 + nb);
+        }
+    } else {
+        GDEBUG("Cached data is stale");
+        nfc_tag_t2_cache_evict(priv->cache, &self->nfcid1,
+            nfc_tag_t2_cc(self));
+        if (block == NFC_TAG_T2_DATA_BLOCK0) {
+            /* Not wasting the data we have just read */
+            nfc_tag_t2_init_read_resp(self, status, data, len, user_data);
+        } else if (!nfc_tag_t2_init_read_data(self)) {
+            nfc_tag_t2_initialized(self);
+        }
+    }
+    g_bytes_unref(cached);
+}
+
+static
+gboolean
+nfc_tag_t2_init_verify_cache(
+    NfcTagType2* self)
+{
+    NfcTagType2Priv* priv = self->priv;
+    const guint8* cc = nfc_tag_t2_cc(self);
+    GBytes* cached = nfc_tag_t2_cache_lookup(priv->cache, &self->nfcid1, cc);
+
+    if (cached) {
+        const gsize size = g_bytes_get_size(cached);
+
+        if (size && size <= priv->sectors->data.size &&
+            !(size % self->block_size)) {
+            /*
+             * The CC (part of the cache key) has already been read with
+             * the control area. Only the first and the last READ of the
+             * cached data get compared with the tag. The first one covers
+             * the lock/memory control TLVs and the NDEF TLV header with
+             * the message length, the last one the end of the message and
+             * the terminator TLV. That's at most 2 READs instead of the
+             * whole TLV scan.
+             *
+             * The tradeoff is that if another device rewrites the message
+             * in place, keeping its length, the first and the last bytes,
+             * the change goes unnoticed. Writes made through this tag
+             * object drop the cache entry before touching the tag.
+             */
+            GDEBUG("Verifying cached data (%u bytes)", (guint)size);
+            priv->cached = cached;
+            priv->init_id = nfc_tag_t2_cmd_read(self, NFC_TAG_T2_DATA_BLOCK0,
+                priv->init_seq, nfc_tag_t2_init_verify_resp, NULL,
+                GUINT_TO_POINTER(NFC_TAG_T2_DATA_BLOCK0));
+            if (priv->init_id) {
+                return TRUE;
+            }
+            priv->cached = NULL;
+        } else {
+            nfc_tag_t2_cache_evict(priv->cache, &self->nfcid1, cc);
+        }
+        g_bytes_unref(cached);
+    }
+    return FALSE;
+}
+
 static
 void
 nfc_tag_t2_init_read_resp(
@@ -881,22 +1860,16 @@ nfc_tag_t2_init_read_resp(
         if ((block * block_size) < sector->size &&
             len >= block_size && !ndef_tlv_check(&data)) {
             /* Continue reading the data */
-            priv->init_id = nfc_tag_t2_cmd_read(self, block, priv->init_seq,
+            priv->init_id = nfc_tag_t2_cmd_read_blocks(self, sector, block,
+                total_blocks - block, priv->init_seq,
                 nfc_tag_t2_init_read_resp, NULL, GUINT_TO_POINTER(block));
         } else {
-            NfcTag* tag = &self->tag;
-
-            GDEBUG("Tag data:");
-            nfc_hexdump_data(&data);
-            if ((block * block_size) < sector->size) {
-                /* Inficate that data wasn't fully read */
-                gutil_log(&nfc_dump_log, GLOG_LEVEL_DEBUG, "  %04X: ...",
-                    block * block_size);
+            if (priv->cache && len >= block_size) {
+                /* Remember what we have read for the next time */
+                nfc_tag_t2_cache_store(priv->cache, &self->nfcid1,
+                    nfc_tag_t2_cc(self), &data);
             }
-
-            /* Find NDEF */
-            tag->ndef = ndef_rec_new_from_tlv(&sector->data);
-            nfc_tag_t2_initialized(self);
+            nfc_tag_t2_init_data_done(self, block);
         }
     } else {
         GDEBUG("Failed to read data block %u, giving up", block);
@@ -904,6 +1877,44 @@ nfc_tag_t2_init_read_resp(
     }
 }
 
+static
+void
+nfc_tag_t2_get_version_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data);
+
+static
+gboolean
+nfc_tag_t2_init_get_version(
+    NfcTagType2* self)
+{
+    NfcTagType2Priv* priv = self->priv;
+    NfcTag* tag = &self->tag;
+
+    /*
+     * GET_VERSION tells us whether FAST_READ is supported. Tags which
+     * don't understand GET_VERSION respond with NACK and go back to
+     * IDLE state, so don't even try if the tag can't be reactivated.
+     * Nor is it worth trying if FAST_READ can't save us anything.
+     */
+    if (tag->type == NFC_TAG_TYPE_MIFARE_ULTRALIGHT &&
+        self->data_size > NFC_TAG_T2_FAST_READ_MIN_DATA_SIZE &&
+        nfc_target_can_reactivate(tag->target)) {
+        static const guint8 cmd_get_version[] = {
+            NFC_TAG_T2_CMD_GET_VERSION
+        };
+
+        priv->init_id = nfc_tag_t2_cmd(self, cmd_get_version,
+            sizeof(cmd_get_version), priv->init_seq,
+            nfc_tag_t2_get_version_resp, NULL, NULL);
+        return priv->init_id != 0;
+    }
+    return FALSE;
+}
+
 static
 void
 nfc_tag_t2_control_area_read_resp(
@@ -932,26 +1943,50 @@ nfc_tag_t2_control_area_read_resp(
 
         if (cc[0] == NFC_TAG_T2_CC_NFC_FORUM_MAGIC &&
             cc[1] >= NFC_TAG_T2_CC_MIN_VERSION) {
-            NfcTagType2Sector* sector0;
+            const guint block_size = self->block_size;
+            const guint sector0_blocks = NFC_TAG_T2_SECTOR_BLOCKS -
+                NFC_TAG_T2_DATA_BLOCK0;
+            guint i, data_blocks;
 
             self->data_size = cc[2] * 8;
             GDEBUG("Data size: %u bytes", self->data_size);
-            /* Allocate sector descriptors (only one sector for now) */
+
+            /*
+             * The data area starts in sector 0 right after the CC and
+             * continues from the first block of each following sector.
+             * Sector contents are allocated when they are first read.
+             */
+            data_blocks = self->data_size / block_size;
             priv->sector_count = 1;
+            if (data_blocks > sector0_blocks) {
+                priv->sector_count += (data_blocks - sector0_blocks +
+                    NFC_TAG_T2_SECTOR_BLOCKS - 1) / NFC_TAG_T2_SECTOR_BLOCKS;
+                GDEBUG("%u sectors", priv->sector_count);
+            }
             priv->sectors = g_new0(NfcTagType2Sector, priv->sector_count);
-
-            sector0 = priv->sectors;
-            nfc_tag_t2_sector_init(sector0, self->block_size,
-                NFC_TAG_T2_DATA_BLOCK0, self->data_size / self->block_size, 0);
-            nfc_tag_t2_sector_set_data(sector0, self->block_size, data, 0,
-                len / self->block_size);
+            for (i = 0; i < priv->sector_count; i++) {
+                const guint header = i ? 0 : NFC_TAG_T2_DATA_BLOCK0;
+                const guint nb = MIN(data_blocks,
+                    NFC_TAG_T2_SECTOR_BLOCKS - header);
+
+                nfc_tag_t2_sector_init(priv->sectors + i, block_size,
+                    header, nb, 0);
+                data_blocks -= nb;
+            }
+            nfc_tag_t2_sector_set_data(priv->sectors, block_size, data, 0,
+                len / block_size);
 
             /* We can already mark it as NFC Forum compatible */
             self->t2flags |= NFC_TAG_T2_FLAG_NFC_FORUM_COMPATIBLE;
-            /* Start reading the data */
-            priv->init_id = nfc_tag_t2_cmd_read(self, NFC_TAG_T2_DATA_BLOCK0,
-                priv->init_seq, nfc_tag_t2_init_read_resp, NULL,
-                GUINT_TO_POINTER(NFC_TAG_T2_DATA_BLOCK0));
+            /*
+             * Start reading the data (unless we have it cached). If the
+             * data area is large enough, check whether FAST_READ can be
+             * used for that.
+             */
+            if ((!priv->cache || !nfc_tag_t2_init_verify_cache(self)) &&
+                !nfc_tag_t2_init_get_version(self)) {
+                nfc_tag_t2_init_read_data(self);
+            }
         } else {
             GDEBUG("Tag is not NFC Forum compatible");
             nfc_tag_t2_initialized(self);
@@ -962,6 +1997,94 @@ nfc_tag_t2_control_area_read_resp(
     }
 }
 
+static
+gboolean
+nfc_tag_t2_init_read_control_area(
+    NfcTagType2* self)
+{
+    NfcTagType2Priv* priv = self->priv;
+
+    /* Start initialization by reading first blocks of sector 0 */
+    priv->init_id = nfc_tag_t2_cmd_read(self, 0, priv->init_seq,
+        nfc_tag_t2_control_area_read_resp, NULL, NULL);
+    return priv->init_id != 0;
+}
+
+static
+void
+nfc_tag_t2_init_reactivated(
+    NfcTarget* target,
+    NFC_REACTIVATE_STATUS status,
+    void* tag)
+{
+    NfcTagType2* self = THIS(tag);
+
+    if (status != NFC_REACTIVATE_STATUS_SUCCESS) {
+        GDEBUG("Reactivation failed, giving up");
+        nfc_tag_t2_initialized(self);
+    } else if (!nfc_tag_t2_init_read_data(self)) {
+        nfc_tag_t2_initialized(self);
+    }
+    nfc_tag_unref(&self->tag);
+}
+
+static
+void
+nfc_tag_t2_get_version_resp(
+    NfcTagType2* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcTagType2Priv* priv = self->priv;
+    const guint8* version = data;
+
+    priv->init_id = 0;
+    if (status == NFC_TRANSMIT_STATUS_OK && len == NXP_VERSION_SIZE &&
+        version[NXP_VERSION_VENDOR] == NXP_MANUFACTURER_ID &&
+        (version[NXP_VERSION_TYPE] == NXP_PRODUCT_TYPE_ULTRALIGHT ||
+         version[NXP_VERSION_TYPE] == NXP_PRODUCT_TYPE_NTAG)) {
+        guint i, frame_size = nfc_target_max_frame_size(self->tag.target);
+        const char* model = NULL;
+
+        for (i = 0; i < G_N_ELEMENTS(nfc_tag_t2_nxp_models) && !model; i++) {
+            const NfcTagType2NxpModel* m = nfc_tag_t2_nxp_models + i;
+
+            if (m->type == version[NXP_VERSION_TYPE] &&
+                m->storage == version[NXP_VERSION_STORAGE]) {
+                model = m->name;
+            }
+        }
+
+        /* Both NTAG21x and Ultralight EV1 support FAST_READ */
+        if (!frame_size) {
+            frame_size = NFC_TAG_T2_DEFAULT_FRAME_SIZE;
+        }
+        priv->fast_read_blocks = frame_size / self->block_size;
+        if (model) {
+            GDEBUG("%s, up to %u blocks per FAST_READ", model,
+                priv->fast_read_blocks);
+        } else {
+            GDEBUG("NXP product type 0x%02x, up to %u blocks per FAST_READ",
+                version[NXP_VERSION_TYPE], priv->fast_read_blocks);
+        }
+        if (!nfc_tag_t2_init_read_data(self)) {
+            nfc_tag_t2_initialized(self);
+        }
+    } else {
+        /* Whatever it is, it may have gone back to IDLE state */
+        GDEBUG("No GET_VERSION, reactivating the tag");
+        nfc_tag_ref(&self->tag);
+        if (!nfc_target_reactivate(self->tag.target, priv->init_seq,
+            nfc_tag_t2_init_reactivated, NULL, self)) {
+            GDEBUG("Oops. Failed to reactivate, giving up");
+            nfc_tag_t2_initialized(self);
+            nfc_tag_unref(&self->tag);
+        }
+    }
+}
+
 static
 void
 nfc_tag_t2_init2(
@@ -997,7 +2120,8 @@ nfc_tag_t2_init2(
 NfcTagType2*
 nfc_tag_t2_new(
     NfcTarget* target,
-    const NfcParamPollA* param)
+    const NfcParamPollA* param,
+    NfcTagType2Cache* cache)
 {
     if (G_LIKELY(target) && G_LIKELY(param)) {
         NfcTagType2* self = g_object_new(THIS_TYPE, NULL);
@@ -1005,6 +2129,9 @@ nfc_tag_t2_new(
         NfcTag* tag = &self->tag;
         const char* desc = "";
 
+        /* Must be there before the data read starts */
+        priv->cache = nfc_tag_t2_cache_ref(cache);
+
         if (param->nfcid1.size == 7 &&
             param->nfcid1.bytes[0] == NXP_MANUFACTURER_ID &&
             param->sel_res == 0) {
@@ -1054,10 +2181,7 @@ nfc_tag_t2_new(
 
         GDEBUG("Type 2 tag%s", desc);
         nfc_tag_t2_init2(self, target, param);
-
-        /* Start initialization by reading first blocks of sector 0 */
-        priv->init_id = nfc_tag_t2_cmd_read(self, 0, priv->init_seq,
-            nfc_tag_t2_control_area_read_resp, NULL, NULL);
+        nfc_tag_t2_init_read_control_area(self);
         return self;
     }
     return NULL;
@@ -1076,9 +2200,25 @@ nfc_tag_t2_read(
     GDestroyNotify done,
     void* user_data)
 {
-#pragma message("TODO: Support more than one sector")
-    if (G_LIKELY(self) && sector == 0) {
-        return nfc_tag_t2_cmd_read(self, block, NULL, resp, done, user_data);
+    if (G_LIKELY(self)) {
+        NfcTagType2Priv* priv = self->priv;
+
+        if (!sector) {
+            return nfc_tag_t2_cmd_read(self, block, NULL, resp, done,
+                user_data);
+        } else if (sector < priv->sector_count && block <= 0xff) {
+            /* SECTOR SELECT, READ and back to sector 0 */
+            NfcTargetSequence* seq = nfc_target_sequence_new(self->tag.target);
+            guint id = 0;
+
+            if (nfc_tag_t2_select_sector(self, seq, sector)) {
+                id = nfc_tag_t2_cmd_read(self, block, seq, resp, done,
+                    user_data);
+            }
+            nfc_tag_t2_release_sector(self, seq);
+            nfc_target_sequence_unref(seq);
+            return id;
+        }
     }
     return 0;
 }
@@ -1106,81 +2246,45 @@ nfc_tag_t2_read_data_seq(
     GDestroyNotify destroy,
     void* user_data) /* Since 1.0.17 */
 {
-#pragma message("TODO: Support more than one sector and cross-sector reads")
-    if (G_LIKELY(self) && (self->tag.flags & NFC_TAG_FLAG_INITIALIZED)) {
+    if (G_LIKELY(self) && (self->tag.flags & NFC_TAG_FLAG_INITIALIZED) &&
+        offset < self->data_size) {
         NfcTagType2Priv* priv = self->priv;
-        NfcTagType2Sector* sector = priv->sectors;
-        const GUtilData* data = &sector->data;
-
-        if (offset < data->size) {
-            NfcTagType2ReadData* read = g_slice_new0(NfcTagType2ReadData);
-            const guint block_size = self->block_size;
-            const guint header_bytes = data->bytes - sector->bytes;
-            const guint header_blocks = header_bytes / block_size;
-            guint end_block, start_block = offset / block_size;
-            gboolean valid;
-
-            if (maxbytes > (data->size - offset)) {
-                maxbytes = (data->size - offset);
-            }
+        NfcTagType2ReadData* read = g_slice_new0(NfcTagType2ReadData);
 
-            read->t2 = self;
-            read->buffer = g_malloc0(maxbytes);
-            read->offset = offset;
-            read->size = maxbytes;
-            read->complete = complete;
-            read->destroy = destroy;
-            read->user_data = user_data;
-            read->seq_id = nfc_tag_t2_generate_id(self);
-
-            if (!priv->reads) {
-                priv->reads = g_hash_table_new_full(g_direct_hash,
-                    g_direct_equal, NULL, nfc_tag_t2_read_data_free);
-            }
-            g_hash_table_insert(priv->reads,
-                GUINT_TO_POINTER(read->seq_id), read);
-
-            end_block = (offset + read->size + block_size - 1) / block_size;
-            nfc_tag_t2_data_block_to_sector(self, start_block, NULL, &valid);
-            if (valid) {
-                guint i, cached_bytes = block_size - (offset % block_size);
-
-                for (i = start_block + 1; i < end_block; i++) {
-                    nfc_tag_t2_data_block_to_sector(self, i, NULL, &valid);
-                    if (valid) {
-                        cached_bytes += block_size;
-                    } else {
-                        break;
-                    }
-                }
+        if (maxbytes > (self->data_size - offset)) {
+            maxbytes = (self->data_size - offset);
+        }
 
-                /* Copy cached data */
-                if (cached_bytes > maxbytes) {
-                    cached_bytes = maxbytes;
-                }
-                memcpy(read->buffer, data->bytes + offset, cached_bytes);
-                read->read = cached_bytes;
-                start_block = i;
-            }
+        read->t2 = self;
+        read->buffer = g_malloc0(maxbytes);
+        read->offset = offset;
+        read->size = maxbytes;
+        read->complete = complete;
+        read->destroy = destroy;
+        read->user_data = user_data;
+        read->seq_id = nfc_tag_t2_generate_id(self);
+
+        if (!priv->reads) {
+            priv->reads = g_hash_table_new_full(g_direct_hash,
+                g_direct_equal, NULL, nfc_tag_t2_read_data_free);
+        }
+        g_hash_table_insert(priv->reads, GUINT_TO_POINTER(read->seq_id), read);
 
-            if (start_block == end_block) {
-                /* Everything was cached - call completion on a fresh stack */
-                read->complete_id = g_idle_add(nfc_tag_t2_read_complete, read);
+        nfc_tag_t2_read_cached(read);
+        if (read->read == read->size) {
+            /* Everything was cached - call completion on a fresh stack */
+            read->complete_id = g_idle_add(nfc_tag_t2_read_complete, read);
+            return read->seq_id;
+        } else {
+            /* We actually need to read something */
+            read->seq = seq ? nfc_target_sequence_ref(seq) :
+                nfc_target_sequence_new(self->tag.target);
+            if (nfc_tag_t2_read_submit(read)) {
                 return read->seq_id;
-            } else {
-                /* We actually need to read something */
-                read->seq = seq ? nfc_target_sequence_ref(seq) :
-                    nfc_target_sequence_new(self->tag.target);
-                read->cmd_id = nfc_tag_t2_cmd_read(self, header_blocks +
-                    start_block, read->seq, nfc_tag_t2_read_resp, NULL, read);
-                if (read->cmd_id) {
-                    return read->seq_id;
-                }
-                /* Read failed */
-                read->destroy = NULL;
-                g_hash_table_remove(priv->reads,
-                    GUINT_TO_POINTER(read->seq_id));
             }
+            /* Read failed */
+            read->destroy = NULL;
+            g_hash_table_remove(priv->reads, GUINT_TO_POINTER(read->seq_id));
         }
     }
     return 0;
@@ -1197,52 +2301,44 @@ nfc_tag_t2_read_data_sync(
         const guint block_size = self->block_size;
         const guint start_block = offset / block_size;
         const guint end_block = (offset + size + block_size - 1) / block_size;
-        gboolean valid;
-        NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(self,
-            start_block, NULL, &valid);
+        guint i;
 
-        if (!sector) {
+        if (!nfc_tag_t2_data_block_to_sector(self, start_block, NULL, NULL)) {
             return NFC_TAG_T2_IO_STATUS_BAD_BLOCK;
         } else if (!nfc_tag_t2_data_block_to_sector(self, end_block - 1,
             NULL, NULL)) {
             return NFC_TAG_T2_IO_STATUS_BAD_SIZE;
-        } else if (!valid) {
-            /* The very first block is invalid, we are done */
-            return NFC_TAG_T2_IO_STATUS_NOT_CACHED;
-        } else {
-            guint i;
-            guint sect_offset = offset;
-            guint sect_bytes = block_size - (offset % block_size);
-            const GUtilData* data = &sector->data;
+        }
 
-            /* Check the remaining blocks */
-            for (i = start_block + 1; i < end_block; i++) {
-                /* Since we have checked the range, sector must be found */
-                NfcTagType2Sector* next = nfc_tag_t2_data_block_to_sector
-                    (self, i, NULL, &valid);
-                if (!valid) {
-                    return NFC_TAG_T2_IO_STATUS_NOT_CACHED;
-                } else if (sector == next) {
-                    /* Count bytes in this sector */
-                    sect_bytes += block_size;
-                } else {
-                    /* Copy bytes from this sector and switch to the next */
-                    if (buffer) {
-                        memcpy(buffer, data->bytes + sect_offset, sect_bytes);
-                        buffer += sect_bytes;
-                    }
-                    sect_offset = 0;
-                    sect_bytes = 0;
-                    sector = next;
-                    data = &sector->data;
-                }
+        /* Check the blocks */
+        for (i = start_block; i < end_block; i++) {
+            gboolean valid;
+
+            nfc_tag_t2_data_block_to_sector(self, i, NULL, &valid);
+            if (!valid) {
+                return NFC_TAG_T2_IO_STATUS_NOT_CACHED;
             }
+        }
+
+        /* Copy the data, sector by sector */
+        if (buffer) {
+            guint8* dest = buffer;
+
+            while (size > 0) {
+                guint bno, n;
+                NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector
+                    (self, offset / block_size, &bno, NULL);
+                const guint pos = bno * block_size + offset % block_size;
 
-            if (buffer) {
-                memcpy(buffer, data->bytes + sect_offset, sect_bytes);
+                /* Since we have checked the range, sector must be found */
+                n = MIN(sector->header + sector->data.size - pos, size);
+                memcpy(dest, sector->bytes + pos, n);
+                dest += n;
+                offset += n;
+                size -= n;
             }
-            return NFC_TAG_T2_IO_STATUS_OK;
         }
+        return NFC_TAG_T2_IO_STATUS_OK;
     }
     return NFC_TAG_T2_IO_STATUS_FAILURE;
 }
@@ -1274,9 +2370,9 @@ nfc_tag_t2_write_seq(
     GDestroyNotify destroy,
     void* user_data) /* Since 1.0.17 */
 {
-#pragma message("TODO: Support more than one sector and cross-sector writes")
-    if (G_LIKELY(self) && bytes && sector_number == 0 &&
-        (self->tag.flags & NFC_TAG_FLAG_INITIALIZED)) {
+    if (G_LIKELY(self) && bytes &&
+        (self->tag.flags & NFC_TAG_FLAG_INITIALIZED) &&
+        sector_number < self->priv->sector_count) {
         gsize size;
         const guint block_size = self->block_size;
         gsize offset = block * block_size;
@@ -1286,7 +2382,7 @@ nfc_tag_t2_write_seq(
 
         /* Round total size down to the nearest block boundary */
         size -= size % block_size;
-        if (sector && size > 0 && (offset + size) <= sector->size) {
+        if (size > 0 && (offset + size) <= sector->size) {
             NfcTagType2WriteData* write = nfc_tag_t2_write_data_new(self,
                 sector_number, offset, bytes, seq, G_CALLBACK(complete),
                 destroy, user_data);
@@ -1294,8 +2390,8 @@ nfc_tag_t2_write_seq(
             GDEBUG("Writing %u block(s) starting at %u", (guint)
                 (size / block_size), block);
             nfc_tag_t2_sector_invalidate(sector, block_size, block, 1);
-            write->cmd_id = nfc_tag_t2_cmd_write(self, block, data,
-                write->seq, nfc_tag_t2_write_resp, NULL, write);
+            write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                block, data, nfc_tag_t2_write_resp);
             if (write->cmd_id) {
                 return write->seq_id;
             }
@@ -1342,8 +2438,7 @@ nfc_tag_t2_write_data_seq(
         NfcTagType2Sector* sector = nfc_tag_t2_data_block_to_sector(self,
             offset / block_size, &start_block, &start_block_cached);
 
-#pragma message("TODO: Support more than one sector and cross-sector writes")
-        if (sector && size > 0 && (offset + size) <= sector->size) {
+        if (sector && size > 0 && (offset + size) <= self->data_size) {
             const guint block_offset = offset % block_size;
             NfcTagType2WriteData* write = nfc_tag_t2_write_data_new(self,
                 sector - priv->sectors, offset, bytes, seq,
@@ -1374,8 +2469,8 @@ nfc_tag_t2_write_data_seq(
             } else {
                 nfc_tag_t2_sector_invalidate(sector, block_size,
                     start_block, 1);
-                write->cmd_id = nfc_tag_t2_cmd_write(self, start_block,
-                    data, write->seq, nfc_tag_t2_write_data_resp, NULL, write);
+                write->cmd_id = nfc_tag_t2_write_submit_write(write, sector,
+                    start_block, data, nfc_tag_t2_write_data_resp);
                 if (write->cmd_id) {
                     return write->seq_id;
                 }
@@ -1389,6 +2484,45 @@ nfc_tag_t2_write_data_seq(
     return 0;
 }
 
+guint
+nfc_tag_t2_write_data_diff(
+    NfcTagType2* self,
+    guint offset,
+    GBytes* bytes,
+    NfcTargetSequence* seq,
+    NfcTagType2WriteDiffFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self) && bytes &&
+       (self->tag.flags & NFC_TAG_FLAG_INITIALIZED)) {
+        const gsize size = g_bytes_get_size(bytes);
+
+        if (size > 0 && (offset + size) <= self->data_size) {
+            NfcTarget* target = self->tag.target;
+            NfcTagType2WriteData* write = nfc_tag_t2_write_data_new(self,
+                0, offset, bytes, seq, G_CALLBACK(complete), destroy,
+                user_data);
+
+            GDEBUG("Updating %u data byte(s) starting at offset %u",
+                (guint)size, offset);
+
+            /* Nothing can be compared until our sequence starts */
+            write->start_id = nfc_target_add_sequence_handler(target,
+                nfc_tag_t2_write_diff_wait, write);
+            if (target->sequence == write->seq) {
+                /* Still, don't complete it on the caller's stack */
+                write->start_idle_id = g_idle_add(
+                    nfc_tag_t2_write_diff_start_cb, write);
+            } else {
+                GDEBUG("Write #%u is pending", write->seq_id);
+            }
+            return write->seq_id;
+        }
+    }
+    return 0;
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -1410,12 +2544,38 @@ nfc_tag_t2_finalize(
     NfcTagType2* self = THIS(object);
     NfcTagType2Priv* priv = self->priv;
 
+    if (priv->selections) {
+        /* No point in returning to sector 0 anymore */
+        g_hash_table_destroy(priv->selections);
+        priv->selections = NULL;
+    }
     if (priv->reads) {
         g_hash_table_destroy(priv->reads);
     }
     if (priv->writes) {
         g_hash_table_destroy(priv->writes);
     }
+    if (priv->cmds) {
+        GHashTable* cmds = priv->cmds;
+        GHashTableIter it;
+        gpointer key;
+        GSList* ids = NULL;
+        GSList* l;
+
+        /* Cancel whatever is still pending, nobody is there to listen */
+        priv->cmds = NULL;
+        g_hash_table_iter_init(&it, cmds);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            ids = g_slist_prepend(ids, GUINT_TO_POINTER
+                (((NfcTagType2Cmd*)key)->id));
+        }
+        g_hash_table_destroy(cmds);
+        for (l = ids; l; l = l->next) {
+            nfc_target_cancel_transmit(self->tag.target,
+                GPOINTER_TO_UINT(l->data));
+        }
+        g_slist_free(ids);
+    }
     if (priv->sectors) {
         guint i;
 
@@ -1424,6 +2584,10 @@ nfc_tag_t2_finalize(
         }
         g_free(priv->sectors);
     }
+    if (priv->cached) {
+        g_bytes_unref(priv->cached);
+    }
+    nfc_tag_t2_cache_unref(priv->cache);
     nfc_target_cancel_transmit(self->tag.target, priv->init_id);
     nfc_target_sequence_unref(priv->init_seq);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
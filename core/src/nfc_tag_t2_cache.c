@@ -0,0 +1,572 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfc_tag_t2_cache.h"
+#include "nfc_log.h"
+
+#include <nfc_crc.h>
+
+#include <gutil_macros.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#define NFC_TAG_T2_CACHE_DIR_PERM (0700)
+#define NFC_TAG_T2_CACHE_FILE_PERM (0600)
+#define NFC_TAG_T2_CACHE_INDEX "t2cache.idx"
+#define NFC_TAG_T2_CACHE_DATA "t2cache-%04x.bin"
+#define NFC_TAG_T2_CACHE_MAGIC (0x54324349) /* "T2CI" */
+#define NFC_TAG_T2_CACHE_VERSION (1)
+#define NFC_TAG_T2_CACHE_DEFAULT_CAPACITY (4096)
+#define NFC_TAG_T2_CACHE_MAX_UID (10)
+#define NFC_TAG_T2_CACHE_CC_SIZE (4)
+
+/*
+ * Index file layout (host byte order, the file never leaves the device):
+ *
+ * +--------+----------+----------+-------+
+ * | magic  | version  | capacity | clock |  header
+ * +--------+----------+----------+-------+
+ * | entry 0                              |  32 bytes each
+ * | ...                                  |
+ * | entry (capacity - 1)                 |
+ * +--------------------------------------+
+ *
+ * Data of the entry N is stored in NFC_TAG_T2_CACHE_DATA file with N
+ * substituted for %04x. The size and the CRC stored in the index entry
+ * protect against partially written and otherwise damaged data files.
+ *
+ * Data files are written by a worker thread, one file at a time, so that
+ * the main loop never waits for the disk. The index entry is updated right
+ * away and lookups are served from memory until the write completes.
+ */
+
+typedef struct nfc_tag_t2_cache_header {
+    guint32 magic;
+    guint32 version;
+    guint32 capacity;
+    guint32 clock;          /* Incremented on each hit and store */
+} NfcTagType2CacheHeader;
+
+typedef struct nfc_tag_t2_cache_entry {
+    guint8 uid_len;         /* Zero if the entry is unused */
+    guint8 uid[NFC_TAG_T2_CACHE_MAX_UID];
+    guint8 cc[NFC_TAG_T2_CACHE_CC_SIZE];
+    guint8 reserved1;
+    guint16 size;           /* Size of the data file */
+    guint16 crc;            /* CRC_A of the data */
+    guint32 last_used;      /* Header clock at the last hit or store */
+    guint8 reserved2[8];
+} NfcTagType2CacheEntry;
+
+G_STATIC_ASSERT(sizeof(NfcTagType2CacheHeader) == 16);
+G_STATIC_ASSERT(sizeof(NfcTagType2CacheEntry) == 32);
+
+struct nfc_tag_t2_cache {
+    gint refcount;
+    char* dir;
+    int fd;
+    void* map;
+    gsize map_size;
+    NfcTagType2CacheHeader* header;
+    NfcTagType2CacheEntry* entries;
+    GMainContext* context;
+    GThreadPool* pool;
+    GHashTable* pending;    /* Entry index => the latest NfcTagType2CacheWrite */
+    guint writes;           /* Writes in flight, including superseded ones */
+};
+
+typedef struct nfc_tag_t2_cache_write {
+    NfcTagType2Cache* cache;
+    guint index;
+    char* path;
+    GBytes* data;
+    GError* error;
+} NfcTagType2CacheWrite;
+
+static
+gboolean
+nfc_tag_t2_cache_key_ok(
+    const GUtilData* nfcid1,
+    const guint8* cc)
+{
+    return nfcid1 && cc && nfcid1->size > 0 &&
+        nfcid1->size <= NFC_TAG_T2_CACHE_MAX_UID;
+}
+
+static
+gboolean
+nfc_tag_t2_cache_entry_match(
+    const NfcTagType2CacheEntry* entry,
+    const GUtilData* nfcid1,
+    const guint8* cc)
+{
+    return entry->uid_len == nfcid1->size &&
+        !memcmp(entry->uid, nfcid1->bytes, nfcid1->size) &&
+        !memcmp(entry->cc, cc, NFC_TAG_T2_CACHE_CC_SIZE);
+}
+
+static
+NfcTagType2CacheEntry*
+nfc_tag_t2_cache_find(
+    NfcTagType2Cache* self,
+    const GUtilData* nfcid1,
+    const guint8* cc)
+{
+    const guint n = self->header->capacity;
+    guint i;
+
+    /* A few thousand entries are fine to scan linearly */
+    for (i = 0; i < n; i++) {
+        NfcTagType2CacheEntry* entry = self->entries + i;
+
+        if (nfc_tag_t2_cache_entry_match(entry, nfcid1, cc)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static
+char*
+nfc_tag_t2_cache_data_file(
+    NfcTagType2Cache* self,
+    NfcTagType2CacheEntry* entry)
+{
+    char* name = g_strdup_printf(NFC_TAG_T2_CACHE_DATA,
+        (guint)(entry - self->entries));
+    char* path = g_build_filename(self->dir, name, NULL);
+
+    g_free(name);
+    return path;
+}
+
+static
+void
+nfc_tag_t2_cache_drop(
+    NfcTagType2Cache* self,
+    NfcTagType2CacheEntry* entry)
+{
+    char* path = nfc_tag_t2_cache_data_file(self, entry);
+
+    memset(entry, 0, sizeof(*entry));
+    unlink(path);
+    g_free(path);
+}
+
+static
+NfcTagType2CacheWrite*
+nfc_tag_t2_cache_pending(
+    NfcTagType2Cache* self,
+    NfcTagType2CacheEntry* entry)
+{
+    return g_hash_table_lookup(self->pending,
+        GUINT_TO_POINTER(entry - self->entries));
+}
+
+static
+void
+nfc_tag_t2_cache_write_free(
+    NfcTagType2CacheWrite* write)
+{
+    NfcTagType2Cache* self = write->cache;
+
+    GASSERT(self->writes > 0);
+    self->writes--;
+    if (write->error) {
+        g_error_free(write->error);
+    }
+    g_bytes_unref(write->data);
+    g_free(write->path);
+    g_slice_free(NfcTagType2CacheWrite, write);
+    nfc_tag_t2_cache_unref(self);
+}
+
+static
+gboolean
+nfc_tag_t2_cache_write_done(
+    gpointer user_data)
+{
+    NfcTagType2CacheWrite* write = user_data;
+    NfcTagType2Cache* self = write->cache;
+    const gpointer key = GUINT_TO_POINTER(write->index);
+
+    /* Runs on the main loop */
+    if (write->error) {
+        GWARN("%s", GERRMSG(write->error));
+    }
+    if (g_hash_table_lookup(self->pending, key) == write) {
+        g_hash_table_remove(self->pending, key);
+        if (write->error) {
+            nfc_tag_t2_cache_drop(self, self->entries + write->index);
+        }
+    }
+    /* Otherwise the entry has been evicted or reused in the meantime */
+    nfc_tag_t2_cache_write_free(write);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_tag_t2_cache_write_proc(
+    gpointer data,
+    gpointer user_data)
+{
+    NfcTagType2CacheWrite* write = data;
+    GMainContext* context = write->cache->context;
+    GSource* done = g_idle_source_new();
+    gsize size;
+    const char* bytes = g_bytes_get_data(write->data, &size);
+
+    /* Runs on the worker thread */
+    g_file_set_contents(write->path, bytes, size, &write->error);
+    g_source_set_callback(done, nfc_tag_t2_cache_write_done, write, NULL);
+    g_source_attach(done, context);
+    g_source_unref(done);
+}
+
+static
+GBytes*
+nfc_tag_t2_cache_read(
+    const char* path,
+    gsize size)
+{
+    const int fd = open(path, O_RDONLY);
+
+    if (fd >= 0) {
+        /* One extra byte to detect the file being longer than expected */
+        guint8* buf = g_malloc(size + 1);
+        gsize len = 0;
+        gssize n;
+
+        do {
+            n = read(fd, buf + len, size + 1 - len);
+            if (n > 0) {
+                len += n;
+            }
+        } while ((n > 0 || (n < 0 && errno == EINTR)) && len <= size);
+        close(fd);
+        if (len == size) {
+            return g_bytes_new_take(buf, size);
+        }
+        g_free(buf);
+    }
+    return NULL;
+}
+
+static
+guint32
+nfc_tag_t2_cache_tick(
+    NfcTagType2Cache* self)
+{
+    NfcTagType2CacheHeader* header = self->header;
+
+    if (!++header->clock) {
+        const guint n = header->capacity;
+        guint i;
+
+        /* Wrapped around, age everything at once */
+        for (i = 0; i < n; i++) {
+            self->entries[i].last_used = 0;
+        }
+        header->clock = 1;
+    }
+    return header->clock;
+}
+
+static
+gboolean
+nfc_tag_t2_cache_map(
+    NfcTagType2Cache* self,
+    guint capacity)
+{
+    const gsize size = sizeof(NfcTagType2CacheHeader) +
+        capacity * sizeof(NfcTagType2CacheEntry);
+    char* path = g_build_filename(self->dir, NFC_TAG_T2_CACHE_INDEX, NULL);
+    gboolean ok = FALSE;
+    struct stat st;
+
+    self->fd = open(path, O_RDWR | O_CREAT, NFC_TAG_T2_CACHE_FILE_PERM);
+    if (self->fd < 0) {
+        GWARN("Failed to open %s: %s", path, strerror(errno));
+    } else if (fstat(self->fd, &st) < 0 ||
+        ((gsize)st.st_size != size && (ftruncate(self->fd, 0) < 0 ||
+         ftruncate(self->fd, size) < 0))) {
+        GWARN("Failed to resize %s: %s", path, strerror(errno));
+    } else {
+        self->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            self->fd, 0);
+        if (self->map == MAP_FAILED) {
+            GWARN("Failed to map %s: %s", path, strerror(errno));
+            self->map = NULL;
+        } else {
+            NfcTagType2CacheHeader* header = self->map;
+
+            self->map_size = size;
+            self->header = header;
+            self->entries = (NfcTagType2CacheEntry*)(header + 1);
+            if (header->magic != NFC_TAG_T2_CACHE_MAGIC ||
+                header->version != NFC_TAG_T2_CACHE_VERSION ||
+                header->capacity != capacity) {
+                GDEBUG("Initializing %s", path);
+                memset(self->map, 0, size);
+                header->magic = NFC_TAG_T2_CACHE_MAGIC;
+                header->version = NFC_TAG_T2_CACHE_VERSION;
+                header->capacity = capacity;
+            }
+            ok = TRUE;
+        }
+    }
+    g_free(path);
+    return ok;
+}
+
+static
+void
+nfc_tag_t2_cache_free(
+    NfcTagType2Cache* self)
+{
+    /* Pending writes hold references, there can't be any left */
+    GASSERT(!self->writes);
+    if (self->pool) {
+        g_thread_pool_free(self->pool, FALSE, TRUE);
+    }
+    g_hash_table_destroy(self->pending);
+    g_main_context_unref(self->context);
+    if (self->map) {
+        munmap(self->map, self->map_size);
+    }
+    if (self->fd >= 0) {
+        close(self->fd);
+    }
+    g_free(self->dir);
+    g_slice_free(NfcTagType2Cache, self);
+}
+
+/*==========================================================================*
+ * Interface
+ *==========================================================================*/
+
+NfcTagType2Cache*
+nfc_tag_t2_cache_new(
+    const char* dir,
+    guint capacity)
+{
+    if (G_LIKELY(dir)) {
+        NfcTagType2Cache* self = g_slice_new0(NfcTagType2Cache);
+
+        g_atomic_int_set(&self->refcount, 1);
+        self->dir = g_strdup(dir);
+        self->fd = -1;
+        self->context = g_main_context_ref_thread_default();
+        self->pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+        if (g_mkdir_with_parents(dir, NFC_TAG_T2_CACHE_DIR_PERM) < 0) {
+            GWARN("Failed to create directory %s", dir);
+        } else if (nfc_tag_t2_cache_map(self, capacity ? capacity :
+            NFC_TAG_T2_CACHE_DEFAULT_CAPACITY)) {
+            /* Single thread keeps the writes in order */
+            self->pool = g_thread_pool_new(nfc_tag_t2_cache_write_proc,
+                NULL, 1, FALSE, NULL);
+            GDEBUG("Type 2 tag cache %s, %u entries", dir,
+                self->header->capacity);
+            return self;
+        }
+        nfc_tag_t2_cache_free(self);
+    }
+    return NULL;
+}
+
+NfcTagType2Cache*
+nfc_tag_t2_cache_ref(
+    NfcTagType2Cache* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        g_atomic_int_inc(&self->refcount);
+    }
+    return self;
+}
+
+void
+nfc_tag_t2_cache_unref(
+    NfcTagType2Cache* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        if (g_atomic_int_dec_and_test(&self->refcount)) {
+            nfc_tag_t2_cache_free(self);
+        }
+    }
+}
+
+GBytes*
+nfc_tag_t2_cache_lookup(
+    NfcTagType2Cache* self,
+    const GUtilData* nfcid1,
+    const guint8* cc)
+{
+    if (G_LIKELY(self) && nfc_tag_t2_cache_key_ok(nfcid1, cc)) {
+        NfcTagType2CacheEntry* entry = nfc_tag_t2_cache_find(self,
+            nfcid1, cc);
+
+        if (entry) {
+            NfcTagType2CacheWrite* write = nfc_tag_t2_cache_pending(self,
+                entry);
+            GBytes* bytes;
+            char* path;
+
+            if (write) {
+                /* Still being written */
+                entry->last_used = nfc_tag_t2_cache_tick(self);
+                return g_bytes_ref(write->data);
+            }
+
+            /* The index tells exactly how much there is to read */
+            path = nfc_tag_t2_cache_data_file(self, entry);
+            bytes = nfc_tag_t2_cache_read(path, entry->size);
+            if (bytes) {
+                gsize len;
+                const guint8* contents = g_bytes_get_data(bytes, &len);
+
+                if (nfc_crc_a(contents, len) == entry->crc) {
+                    entry->last_used = nfc_tag_t2_cache_tick(self);
+                    g_free(path);
+                    return bytes;
+                }
+                g_bytes_unref(bytes);
+            }
+
+            /* The index is out of sync with the data */
+            GDEBUG("Dropping broken cache entry %s", path);
+            nfc_tag_t2_cache_drop(self, entry);
+            g_free(path);
+        }
+    }
+    return NULL;
+}
+
+void
+nfc_tag_t2_cache_store(
+    NfcTagType2Cache* self,
+    const GUtilData* nfcid1,
+    const guint8* cc,
+    const GUtilData* data)
+{
+    if (G_LIKELY(self) && nfc_tag_t2_cache_key_ok(nfcid1, cc) &&
+        G_LIKELY(data) && data->size > 0 && data->size <= G_MAXUINT16) {
+        NfcTagType2CacheEntry* entry = nfc_tag_t2_cache_find(self,
+            nfcid1, cc);
+        NfcTagType2CacheWrite* write;
+
+        if (!entry) {
+            const guint n = self->header->capacity;
+            guint i;
+
+            /* Pick a free entry or the least recently used one */
+            entry = self->entries;
+            for (i = 0; i < n && entry->uid_len; i++) {
+                NfcTagType2CacheEntry* e = self->entries + i;
+
+                if (!e->uid_len || e->last_used < entry->last_used) {
+                    entry = e;
+                }
+            }
+        }
+
+        /*
+         * Update the index right away. If we die before the data file
+         * gets written, the CRC check will catch that on the next lookup.
+         */
+        memset(entry, 0, sizeof(*entry));
+        entry->size = data->size;
+        entry->crc = nfc_crc_a(data->bytes, data->size);
+        entry->last_used = nfc_tag_t2_cache_tick(self);
+        memcpy(entry->uid, nfcid1->bytes, nfcid1->size);
+        memcpy(entry->cc, cc, NFC_TAG_T2_CACHE_CC_SIZE);
+        entry->uid_len = nfcid1->size;
+
+        /* Supersedes the write which may be pending for this entry */
+        write = g_slice_new0(NfcTagType2CacheWrite);
+        write->cache = nfc_tag_t2_cache_ref(self);
+        write->index = entry - self->entries;
+        write->path = nfc_tag_t2_cache_data_file(self, entry);
+        write->data = g_bytes_new(data->bytes, data->size);
+        g_hash_table_insert(self->pending, GUINT_TO_POINTER(write->index),
+            write);
+        self->writes++;
+        g_thread_pool_push(self->pool, write, NULL);
+    }
+}
+
+void
+nfc_tag_t2_cache_evict(
+    NfcTagType2Cache* self,
+    const GUtilData* nfcid1,
+    const guint8* cc)
+{
+    if (G_LIKELY(self) && nfc_tag_t2_cache_key_ok(nfcid1, cc)) {
+        NfcTagType2CacheEntry* entry = nfc_tag_t2_cache_find(self,
+            nfcid1, cc);
+
+        if (entry) {
+            /* Whatever is being written there is no longer needed */
+            g_hash_table_remove(self->pending,
+                GUINT_TO_POINTER(entry - self->entries));
+            nfc_tag_t2_cache_drop(self, entry);
+        }
+    }
+}
+
+void
+nfc_tag_t2_cache_flush(
+    NfcTagType2Cache* self)
+{
+    if (G_LIKELY(self)) {
+        while (self->writes) {
+            g_main_context_iteration(self->context, TRUE);
+        }
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFC_TAG_T2_CACHE_H
+#define NFC_TAG_T2_CACHE_H
+
+#include "nfc_types_p.h"
+
+/*
+ * Persistent cache of Type 2 tag contents, keyed by NFCID1 and the
+ * Capability Container. The index is memory-mapped, the data of each
+ * entry is stored in a separate file. Least recently used entries get
+ * evicted when the index is full.
+ *
+ * Data files are written in the background, the writes are completed
+ * on the main context which was the thread default when the cache was
+ * created.
+ */
+
+NfcTagType2Cache*
+nfc_tag_t2_cache_new(
+    const char* dir,
+    guint capacity) /* Zero for default */
+    NFCD_INTERNAL;
+
+NfcTagType2Cache*
+nfc_tag_t2_cache_ref(
+    NfcTagType2Cache* cache)
+    NFCD_INTERNAL;
+
+void
+nfc_tag_t2_cache_unref(
+    NfcTagType2Cache* cache)
+    NFCD_INTERNAL;
+
+GBytes*
+nfc_tag_t2_cache_lookup(
+    NfcTagType2Cache* cache,
+    const GUtilData* nfcid1,
+    const guint8* cc) /* 4 bytes */
+    NFCD_INTERNAL;
+
+void
+nfc_tag_t2_cache_store(
+    NfcTagType2Cache* cache,
+    const GUtilData* nfcid1,
+    const guint8* cc, /* 4 bytes */
+    const GUtilData* data)
+    NFCD_INTERNAL;
+
+void
+nfc_tag_t2_cache_evict(
+    NfcTagType2Cache* cache,
+    const GUtilData* nfcid1,
+    const guint8* cc) /* 4 bytes */
+    NFCD_INTERNAL;
+
+/* Blocks until the pending writes complete */
+void
+nfc_tag_t2_cache_flush(
+    NfcTagType2Cache* cache)
+    NFCD_INTERNAL;
+
+#endif /* NFC_TAG_T2_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
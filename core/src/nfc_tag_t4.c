@@ -47,14 +47,59 @@
 #include <nfcdef.h>
 
 #include <gutil_macros.h>
+#include <gutil_weakref.h>
+
+typedef enum nfc_isodep_sel_type {
+    NFC_ISODEP_SEL_NONE,    /* Doesn't affect the selection */
+    NFC_ISODEP_SEL_DF,      /* Selects DF by name (or MF) */
+    NFC_ISODEP_SEL_EF,      /* Selects EF by file identifier */
+    NFC_ISODEP_SEL_SFI,     /* Implicitly selects EF by short file id */
+    NFC_ISODEP_SEL_OTHER    /* Unpredictable effect on the selection */
+} NFC_ISODEP_SEL_TYPE;
+
+typedef struct nfc_isodep_selection {
+    guint8 p1;
+    guint8 p2;
+    guint le;
+    GBytes* id;             /* DF name or file identifier */
+    GBytes* fci;            /* Response data */
+} NfcIsoDepSelection;
 
 typedef struct nfc_isodep_tx {
     NfcTagType4* t4;
+    GUtilWeakRef* ref;      /* Set while the outcome is unknown */
+    guint id;               /* Key in priv->replies (cached only) */
+    guint reply_id;         /* Idle callback delivering cached response */
+    NFC_ISODEP_SEL_TYPE sel;
+    guint8 p1;
+    guint8 p2;
+    guint le;
+    GBytes* bytes;          /* SELECT data or cached FCI */
     NfcTagType4ResponseFunc resp;
     GDestroyNotify destroy;
     void* user_data;
 } NfcIsoDepTx;
 
+typedef struct nfc_isodep_xfer {
+    NfcTagType4* t4;
+    guint id;               /* Key in priv->xfers */
+    guint tx_id;            /* Transmission in progress */
+    NFC_ISODEP_TX_FLAGS flags;
+    NfcTargetSequence* seq;
+    guint8 cla;
+    guint8 ins;
+    guint8 p1;
+    guint8 p2;
+    GBytes* data;           /* Command data */
+    guint offset;           /* Offset of the current chunk */
+    guint le;
+    gboolean le_fixed;      /* Le was corrected after 6Cxx */
+    GByteArray* buf;        /* Reassembled response */
+    NfcTagType4ResponseFunc resp;
+    GDestroyNotify destroy;
+    void* user_data;
+} NfcIsoDepXfer;
+
 typedef struct nfc_iso_dep_ndef_read {
     NfcTagType4* t4;
     guint8 fid[2];
@@ -63,17 +108,50 @@ typedef struct nfc_iso_dep_ndef_read {
     GByteArray* data;
 } NfcIsoDepNdefRead;
 
+typedef struct nfc_iso_dep_ndef_write {
+    NfcTagType4* t4;
+    guint id;
+    guint tx_id;
+    NfcTargetSequence* seq;
+    GBytes* ndef;
+    guint8 fid[2];
+    guint max_write;        /* UPDATE BINARY chunk size */
+    guint offset;           /* Bytes of the message written so far */
+    NfcTagType4WriteNdefFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+} NfcIsoDepNdefWrite;
+
+typedef enum nfc_tag_t4_ext_len {
+    NFC_TAG_T4_EXT_LEN_UNKNOWN,
+    NFC_TAG_T4_EXT_LEN_NO,
+    NFC_TAG_T4_EXT_LEN_YES
+} NFC_TAG_T4_EXT_LEN;
+
 struct nfc_tag_t4_priv {
     guint mtu;  /* FSC (Type 4A) or FSD (Type 4B) */
-    GByteArray* buf;
+    NFC_TAG_T4_EXT_LEN ext_len;
     NfcTargetSequence* init_seq;
     NfcIsoDepNdefRead* init_read;
     guint init_id;
+    guint ndef_idle_id;      /* Lazy NDEF read timer */
     NfcParamIsoDep* iso_dep; /* Since 1.0.39 */
+    GHashTable* xfers;
+    GByteArray* buf; /* Spare response buffer */
+    GUtilWeakRef* ref;
+    NfcIsoDepSelection df;      /* Currently selected DF */
+    NfcIsoDepSelection ef;      /* Currently selected EF */
+    gboolean ef_none;           /* No EF is selected (as opposed to unknown) */
+    guint sel_busy;             /* Requests with yet unknown outcome */
+    gboolean sel_cache;
+    NfcIsoDepSelectStats sel_stats;
+    GHashTable* replies;        /* SELECTs being completed from the cache */
+    GHashTable* writes;         /* NDEF writes */
 };
 
 typedef struct nfc_isodep_reset_data {
     NfcTagType4* t4;
+    GUtilWeakRef* ref;
     NfcTagType4ResetRespFunc resp;
     GDestroyNotify destroy;
     void* user_data;
@@ -99,11 +177,200 @@ static const GUtilData ndef_cc_ef_data = { ndef_cc_ef, sizeof(ndef_cc_ef) };
 #define ISO_SW_NDEF_NOT_FOUND (0x6a82)
 #define NDEF_CC_LEN (15)
 #define NDEF_DATA_OFFSET (2)
+#define SHORT_LE_MAX (0x100)
+#define SHORT_LC_MAX (0xff)
+#define RESP_MAX (0x10000)
+#define ISO_SW1_MORE_DATA (0x61)
+#define ISO_SW1_WRONG_LE (0x6c)
+#define NDEF_IDLE_TIMEOUT_MS (500)
+#define NDEF_NLEN_MAX (0xfffe)
+#define UPDATE_BINARY_OFFSET_MAX (0x7fff)
+#define UPDATE_BINARY_HEADER (5) /* CLA|INS|P1|P2|Lc */
+#define ISO_DEP_BLOCK_OVERHEAD (3) /* PCB and CRC */
 
 /*==========================================================================*
  * Implementation
  *==========================================================================*/
 
+static
+void
+nfc_isodep_selection_clear(
+    NfcIsoDepSelection* sel)
+{
+    if (sel->id) {
+        g_bytes_unref(sel->id);
+        sel->id = NULL;
+    }
+    if (sel->fci) {
+        g_bytes_unref(sel->fci);
+        sel->fci = NULL;
+    }
+}
+
+static
+void
+nfc_isodep_selection_set(
+    NfcIsoDepSelection* sel,
+    const NfcIsoDepTx* tx,
+    const void* fci,
+    guint len)
+{
+    nfc_isodep_selection_clear(sel);
+    sel->p1 = tx->p1;
+    sel->p2 = tx->p2;
+    sel->le = tx->le;
+    sel->id = g_bytes_ref(tx->bytes);
+    sel->fci = g_bytes_new(fci, len);
+}
+
+static
+gboolean
+nfc_isodep_selection_equal(
+    const NfcIsoDepSelection* sel,
+    guint8 p1,
+    guint8 p2,
+    guint le,
+    GBytes* id)
+{
+    return sel->id && sel->p1 == p1 && sel->p2 == p2 && sel->le == le &&
+        g_bytes_equal(sel->id, id);
+}
+
+static
+NFC_ISODEP_SEL_TYPE
+nfc_isodep_sel_type(
+    guint8 cla,
+    guint8 ins,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data)
+{
+    /* Only the basic channel is tracked */
+    if (cla & (ISO_CLA_PROPRIETARY | ISO_CLA_CHANNEL_MASK)) {
+        return NFC_ISODEP_SEL_NONE;
+    }
+
+    switch (ins) {
+    case ISO_INS_SELECT:
+        if (!(cla & ISO_CLA_CHAIN) && (p2 & ISO_P2_SELECT_FILE_MASK) ==
+            ISO_P2_SELECT_FILE_FIRST) {
+            const guint size = data ? data->size : 0;
+
+            switch (p1) {
+            case ISO_P1_SELECT_DF_BY_NAME:
+                if (size) {
+                    return NFC_ISODEP_SEL_DF;
+                }
+                break;
+            case ISO_P1_SELECT_BY_ID:
+                if (!size || (size == 2 && ((((guint)data->bytes[0]) << 8) |
+                    data->bytes[1]) == ISO_MF)) {
+                    return NFC_ISODEP_SEL_DF;
+                }
+                /* fallthrough */
+            case ISO_P1_SELECT_CHILD_EF:
+                /*
+                 * Strictly speaking, P1 = 00h may select a DF too,
+                 * but the caller (most likely) knows what it's doing.
+                 */
+                if (size == 2) {
+                    return NFC_ISODEP_SEL_EF;
+                }
+                break;
+            }
+        }
+        /* Selection by path, parent DF, next occurrence and such */
+        return NFC_ISODEP_SEL_OTHER;
+    case ISO_INS_READ_BINARY:
+    case ISO_INS_WRITE_BINARY:
+    case ISO_INS_UPDATE_BINARY:
+        /* ISO/IEC 7816-4 Section 11.2.2 (P1 b8 set: b5-b1 is SFI) */
+        return (p1 & ISO_P1_SHORT_FID) ? NFC_ISODEP_SEL_SFI :
+            NFC_ISODEP_SEL_NONE;
+    case ISO_INS_READ_RECORD:
+    case ISO_INS_UPDATE_RECORD:
+    case ISO_INS_APPEND_RECORD:
+        /* ISO/IEC 7816-4 Section 11.3.2 (P2 b8-b4 is SFI, zero if none) */
+        return (p2 >> 3) ? NFC_ISODEP_SEL_SFI : NFC_ISODEP_SEL_NONE;
+    }
+    return NFC_ISODEP_SEL_NONE;
+}
+
+static
+void
+nfc_tag_t4_sel_invalidate(
+    NfcTagType4Priv* priv)
+{
+    if (priv->df.id || priv->ef.id || priv->ef_none) {
+        GVERBOSE("Forgetting the selection");
+        nfc_isodep_selection_clear(&priv->df);
+        nfc_isodep_selection_clear(&priv->ef);
+        priv->ef_none = FALSE;
+    }
+}
+
+static
+void
+nfc_tag_t4_sel_update(
+    NfcTagType4Priv* priv,
+    const NfcIsoDepTx* tx,
+    guint sw,
+    const void* data,
+    guint len)
+{
+    /* Warnings (62xx and 63xx) and 61xx mean that the command went through */
+    const guint sw1 = sw >> 8;
+    const gboolean ok = ISO_SW_SUCCESS(sw) || sw1 == ISO_SW1_MORE_DATA ||
+        sw1 == 0x62 || sw1 == 0x63;
+
+    switch (tx->sel) {
+    case NFC_ISODEP_SEL_DF:
+    case NFC_ISODEP_SEL_EF:
+        if (sw == ISO_SW_OK) {
+            if (tx->sel == NFC_ISODEP_SEL_DF) {
+                nfc_isodep_selection_set(&priv->df, tx, data, len);
+                nfc_isodep_selection_clear(&priv->ef);
+                priv->ef_none = TRUE;
+            } else {
+                nfc_isodep_selection_set(&priv->ef, tx, data, len);
+                priv->ef_none = FALSE;
+            }
+        } else if (ok || sw == ISO_SW_IO_ERR) {
+            /* Selected something but not quite what we expected */
+            nfc_tag_t4_sel_invalidate(priv);
+        }
+        /* Failed SELECT leaves the current selection unchanged */
+        break;
+    case NFC_ISODEP_SEL_SFI:
+        if (ok) {
+            /* Some EF is selected now, but we don't know its identifier */
+            nfc_isodep_selection_clear(&priv->ef);
+            priv->ef_none = FALSE;
+        } else {
+            nfc_tag_t4_sel_invalidate(priv);
+        }
+        break;
+    case NFC_ISODEP_SEL_OTHER:
+        nfc_tag_t4_sel_invalidate(priv);
+        break;
+    case NFC_ISODEP_SEL_NONE:
+        if (!ok) {
+            /* Who knows what the card does in case of an error */
+            nfc_tag_t4_sel_invalidate(priv);
+        }
+        break;
+    }
+}
+
+static
+void
+nfc_tag_t4_sel_busy_done(
+    NfcTagType4Priv* priv)
+{
+    GASSERT(priv->sel_busy);
+    priv->sel_busy--;
+}
+
 static
 void
 nfc_tag_t4_tx_free(
@@ -111,10 +378,33 @@ nfc_tag_t4_tx_free(
 {
     GDestroyNotify destroy = tx->destroy;
 
+    if (tx->ref) {
+        /* Cancelled (or dropped) while the outcome was unknown */
+        NfcTagType4* self = gutil_weakref_get(tx->ref);
+
+        if (self) {
+            NfcTagType4Priv* priv = self->priv;
+
+            nfc_tag_t4_sel_busy_done(priv);
+            if (tx->sel != NFC_ISODEP_SEL_NONE) {
+                nfc_tag_t4_sel_invalidate(priv);
+            }
+            nfc_tag_unref(&self->tag);
+        }
+        gutil_weakref_unref(tx->ref);
+        tx->ref = NULL;
+    }
+    if (tx->reply_id) {
+        g_source_remove(tx->reply_id);
+        tx->reply_id = 0;
+    }
     if (destroy) {
         tx->destroy = NULL;
         destroy(tx->user_data);
     }
+    if (tx->bytes) {
+        g_bytes_unref(tx->bytes);
+    }
     g_slice_free1(sizeof(*tx), tx);
 }
 
@@ -126,6 +416,32 @@ nfc_tag_t4_tx_free1(
     nfc_tag_t4_tx_free((NfcIsoDepTx*)data);
 }
 
+static
+void
+nfc_tag_t4_tx_done(
+    NfcIsoDepTx* tx,
+    guint sw,
+    const void* data,
+    guint len)
+{
+    NfcTagType4* self = gutil_weakref_get(tx->ref);
+
+    gutil_weakref_unref(tx->ref);
+    tx->ref = NULL;
+    if (self) {
+        NfcTagType4Priv* priv = self->priv;
+
+        nfc_tag_t4_sel_busy_done(priv);
+        nfc_tag_t4_sel_update(priv, tx, sw, data, len);
+    }
+    if (tx->resp) {
+        tx->resp(tx->t4, sw, data, len, tx->user_data);
+    }
+    if (self) {
+        nfc_tag_unref(&self->tag);
+    }
+}
+
 static
 void
 nfc_tag_t4_tx_resp(
@@ -140,19 +456,109 @@ nfc_tag_t4_tx_resp(
     if (status == NFC_TRANSMIT_STATUS_OK) {
         if (len < 2) {
             GWARN("Type 4 response too short, %u bytes(s)", len);
-            tx->resp(tx->t4, ISO_SW_IO_ERR, NULL, 0, tx->user_data);
+            nfc_tag_t4_tx_done(tx, ISO_SW_IO_ERR, NULL, 0);
         } else if (len > 0x10000) {
             GWARN("Type 4 response too long, %u bytes(s)", len);
-            tx->resp(tx->t4, ISO_SW_IO_ERR, NULL, 0, tx->user_data);
+            nfc_tag_t4_tx_done(tx, ISO_SW_IO_ERR, NULL, 0);
         } else {
             const guint8* sw = ((guint8*)data) + len - 2;
 
-            tx->resp(tx->t4, (((guint)sw[0]) << 8) | sw[1],  data, len - 2,
-                tx->user_data);
+            nfc_tag_t4_tx_done(tx, (((guint)sw[0]) << 8) | sw[1],  data,
+                len - 2);
         }
     } else {
-        tx->resp(tx->t4, ISO_SW_IO_ERR, NULL, 0, tx->user_data);
+        nfc_tag_t4_tx_done(tx, ISO_SW_IO_ERR, NULL, 0);
+    }
+}
+
+static
+guint
+nfc_isodep_generate_id(
+    NfcTagType4* self)
+{
+    NfcTagType4Priv* priv = self->priv;
+    guint id;
+
+    do {
+        /* It's highly unlikely that we have to repeat this more than once */
+        id = nfc_target_generate_id(self->tag.target);
+    } while ((priv->xfers &&
+        g_hash_table_contains(priv->xfers, GUINT_TO_POINTER(id))) ||
+        (priv->replies &&
+        g_hash_table_contains(priv->replies, GUINT_TO_POINTER(id))) ||
+        (priv->writes &&
+        g_hash_table_contains(priv->writes, GUINT_TO_POINTER(id))));
+    return id;
+}
+
+static
+gboolean
+nfc_isodep_reply(
+    gpointer user_data)
+{
+    NfcIsoDepTx* tx = user_data;
+    NfcTagType4* self = tx->t4;
+    NfcTag* tag = &self->tag;
+    gsize len;
+    const void* fci = g_bytes_get_data(tx->bytes, &len);
+
+    /* The callback may drop the last tag ref */
+    nfc_tag_ref(tag);
+    tx->reply_id = 0;
+    g_hash_table_steal(self->priv->replies, GUINT_TO_POINTER(tx->id));
+    if (tx->resp) {
+        tx->resp(self, ISO_SW_OK, fci, (guint)len, tx->user_data);
+    }
+    nfc_tag_t4_tx_free(tx);
+    nfc_tag_unref(tag);
+    return G_SOURCE_REMOVE;
+}
+
+static
+guint
+nfc_isodep_reply_cached(
+    NfcTagType4* self,
+    NFC_ISODEP_SEL_TYPE sel,
+    guint8 p1,
+    guint8 p2,
+    guint le,
+    GBytes* id,
+    NfcTargetSequence* seq,
+    NfcTagType4ResponseFunc resp,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    NfcTagType4Priv* priv = self->priv;
+    NfcTarget* target = self->tag.target;
+    const NfcIsoDepSelection* cur = (sel == NFC_ISODEP_SEL_DF) ?
+        (priv->ef_none ? &priv->df : NULL) : &priv->ef;
+
+    /*
+     * Nothing may be in flight, otherwise we can't be sure what's
+     * going to be selected by the time this request gets its turn.
+     */
+    if (cur && !priv->sel_busy && target->present &&
+        (!target->sequence || target->sequence == seq) &&
+        nfc_isodep_selection_equal(cur, p1, p2, le, id)) {
+        NfcIsoDepTx* tx = g_slice_new0(NfcIsoDepTx);
+
+        GDEBUG("Already selected");
+        tx->t4 = self;
+        tx->id = nfc_isodep_generate_id(self);
+        tx->bytes = g_bytes_ref(cur->fci);
+        tx->resp = resp;
+        tx->destroy = destroy;
+        tx->user_data = user_data;
+        tx->reply_id = g_idle_add(nfc_isodep_reply, tx);
+        if (!priv->replies) {
+            priv->replies = g_hash_table_new_full(g_direct_hash,
+                g_direct_equal, NULL, nfc_tag_t4_tx_free1);
+        }
+        g_hash_table_insert(priv->replies, GUINT_TO_POINTER(tx->id), tx);
+        priv->sel_stats.cached++;
+        return tx->id;
     }
+    return 0;
 }
 
 static
@@ -171,9 +577,35 @@ nfc_isodep_submit(
     void* user_data)
 {
     NfcTagType4Priv* priv = self->priv;
-    GByteArray* buf = priv->buf;
+    const NFC_ISODEP_SEL_TYPE sel = nfc_isodep_sel_type(cla, ins, p1, p2,
+        data);
+    GBytes* sel_id = NULL;
+    GByteArray* buf;
     NfcApdu apdu;
 
+    if (priv->ndef_idle_id) {
+        /*
+         * A client has started talking to the tag. Reading NDEF behind
+         * its back would reset the selected application, from now on
+         * NDEF only gets read on demand.
+         */
+        GDEBUG("Client APDU, NDEF will only be read on demand");
+        g_source_remove(priv->ndef_idle_id);
+        priv->ndef_idle_id = 0;
+    }
+    if (sel == NFC_ISODEP_SEL_DF || sel == NFC_ISODEP_SEL_EF) {
+        sel_id = g_bytes_new(data ? data->bytes : NULL, data ? data->size : 0);
+        if (priv->sel_cache) {
+            const guint id = nfc_isodep_reply_cached(self, sel, p1, p2, le,
+                sel_id, seq, resp, destroy, user_data);
+
+            if (id) {
+                g_bytes_unref(sel_id);
+                return id;
+            }
+        }
+    }
+
     apdu.cla = cla;
     apdu.ins = ins;
     apdu.p1 = p1;
@@ -185,27 +617,135 @@ nfc_isodep_submit(
         memset(&apdu.data, 0, sizeof(apdu.data));
     }
 
+    /*
+     * Encode the APDU into a buffer of its own and hand it over to
+     * NfcTarget, so that it doesn't get copied again if the request
+     * is queued (or by the adapter if it can take GBytes directly).
+     * Header + Lc + data + Le takes at most 10 bytes plus the data.
+     */
+    buf = g_byte_array_sized_new(apdu.data.size + 10);
     if (nfc_apdu_encode(buf, &apdu)) {
         NfcTag* tag = &self->tag;
         NfcIsoDepTx* tx = g_slice_new0(NfcIsoDepTx);
+        GBytes* bytes = g_byte_array_free_to_bytes(buf);
         guint id;
 
         tx->t4 = self;
+        tx->ref = gutil_weakref_ref(priv->ref);
+        tx->sel = sel;
+        tx->p1 = p1;
+        tx->p2 = p2;
+        tx->le = le;
+        tx->bytes = sel_id;
         tx->resp = resp;
         tx->destroy = destroy;
         tx->user_data = user_data;
-        id = nfc_target_transmit(tag->target, buf->data, buf->len, seq,
-            resp ? nfc_tag_t4_tx_resp : NULL, nfc_tag_t4_tx_free1, tx);
+        priv->sel_busy++;
+        id = nfc_target_transmit_bytes(tag->target, bytes, seq,
+            nfc_tag_t4_tx_resp, nfc_tag_t4_tx_free1, tx);
+        g_bytes_unref(bytes);
         if (id) {
+            if (sel_id) {
+                priv->sel_stats.sent++;
+            }
             return id;
         } else {
+            /* Nothing has been sent, the selection is intact */
+            nfc_tag_t4_sel_busy_done(priv);
+            gutil_weakref_unref(tx->ref);
+            tx->ref = NULL;
             tx->destroy = NULL;
             nfc_tag_t4_tx_free(tx);
         }
+    } else {
+        g_byte_array_free(buf, TRUE);
+        if (sel_id) {
+            g_bytes_unref(sel_id);
+        }
     }
     return 0;
 }
 
+static
+gboolean
+nfc_tag_t4_cancel_tx(
+    NfcTagType4* self,
+    guint id)
+{
+    NfcTagType4Priv* priv = self->priv;
+
+    if (priv->replies && g_hash_table_remove(priv->replies,
+        GUINT_TO_POINTER(id))) {
+        return TRUE;
+    }
+    return nfc_target_cancel_transmit(self->tag.target, id);
+}
+
+static
+NFC_TAG_T4_EXT_LEN
+nfc_tag_t4_ext_len_a(
+    const GUtilData* hb /* Historical bytes */)
+{
+    /*
+     * ISO/IEC 7816-4
+     * Section 8.1.1.1 Category indicator byte
+     *
+     * 00h - a status indicator (3 last bytes) follows compact-TLV objects
+     * 80h - compact-TLV objects, optionally including a status indicator
+     */
+    if (hb->bytes && hb->size > 0 && (hb->bytes[0] == 0x80 ||
+        (hb->bytes[0] == 0x00 && hb->size >= 4))) {
+        const guint8* ptr = hb->bytes + 1;
+        const guint8* end = hb->bytes + hb->size - (hb->bytes[0] ? 0 : 3);
+
+        while (ptr < end) {
+            const guint tag = (*ptr >> 4);
+            const guint len = (*ptr & 0x0f);
+
+            ptr++;
+            if (ptr + len > end) {
+                break;
+            } else if (tag == 0x7) {
+                /*
+                 * Section 8.1.1.2.7 Card capabilities
+                 *
+                 * b7 of the third software function table indicates
+                 * support for extended Lc and Le fields.
+                 */
+                if (len >= 3) {
+                    return (ptr[2] & 0x40) ?
+                        NFC_TAG_T4_EXT_LEN_YES :
+                        NFC_TAG_T4_EXT_LEN_NO;
+                }
+                break;
+            }
+            ptr += len;
+        }
+    }
+    return NFC_TAG_T4_EXT_LEN_UNKNOWN;
+}
+
+static
+gboolean
+nfc_tag_t4_ndef_fid_valid(
+    guint fid)
+{
+    /*
+     * 5.1.2.1 NDEF File Control TLV
+     *
+     * ...
+     * [RQ_T4T_NDA_016] File Identifier, 2 bytes. Indicates a valid
+     * NDEF file. The valid ranges are 0001h to E101h, E104h to 3EFFh,
+     * 3F01h to 3FFEh and 4000h to FFFEh. The values 0000h, E102h,
+     * E103h, 3F00h and 3FFFh are reserved (see [ISO/IEC_7816-4])
+     * and FFFFh is RFU.
+     */
+    return (fid >= 0x0001 && fid <= 0xE101) ||
+        (fid >= 0xE104 && fid <= 0x3EFF) ||
+        (fid >= 0x3F01 && fid <= 0x3FFE) ||
+        (fid >= 0x4000 && fid <= 0xFFFE);
+}
+
 static
 NfcIsoDepNdefRead*
 nfc_iso_dep_ndef_read_new(
@@ -220,28 +760,26 @@ nfc_iso_dep_ndef_read_new(
 
         /* Check NDEF file read access condition */
         if (v[4] == 0 /* read access granted */) {
-            /*
-             * 5.1.2.1 NDEF File Control TLV
-             *
-             * ...
-             * [RQ_T4T_NDA_016] File Identifier, 2 bytes. Indicates a valid
-             * NDEF file. The valid ranges are 0001h to E101h, E104h to 3EFFh,
-             * 3F01h to 3FFEh and 4000h to FFFEh. The values 0000h, E102h,
-             * E103h, 3F00h and 3FFFh are reserved (see [ISO/IEC_7816-4])
-             * and FFFFh is RFU.
-             */
             const guint fid = ((((guint)(v[0])) << 8) | v[1]);
 
-            if ((fid >= 0x0001 && fid <= 0xE101) ||
-                (fid >= 0xE104 && fid <= 0x3EFF) ||
-                (fid >= 0x3F01 && fid <= 0x3FFE) ||
-                (fid >= 0x4000 && fid <= 0xFFFE)) {
-                const guint max_read = ((((guint)(cc[3])) << 8) | cc[4]);
+            if (nfc_tag_t4_ndef_fid_valid(fid)) {
+                guint max_read = ((((guint)(cc[3])) << 8) | cc[4]);
 
                 /* The valid values for MLe are 000Fh-FFFFh */
                 if (max_read >= 0x000f) {
                     NfcIsoDepNdefRead* read = g_slice_new0(NfcIsoDepNdefRead);
 
+                    /*
+                     * MLe above 100h implies that the tag accepts extended
+                     * Le field. Unless the historical bytes say otherwise,
+                     * in which case we stick to the short form.
+                     */
+                    if (max_read > SHORT_LE_MAX &&
+                        self->priv->ext_len == NFC_TAG_T4_EXT_LEN_NO) {
+                        GDEBUG("Extended Le not supported, MLe %u => %u",
+                            max_read, SHORT_LE_MAX);
+                        max_read = SHORT_LE_MAX;
+                    }
                     read->max_read = max_read;
                     read->fid[0] = v[0];
                     read->fid[1] = v[1];
@@ -292,6 +830,7 @@ nfc_tag_t4_initialized(
     priv->init_seq = NULL;
     priv->init_read = NULL;
     nfc_tag_set_initialized(tag);
+    nfc_tag_set_ndef_ready(tag);
     g_object_unref(self);
 }
 
@@ -303,6 +842,11 @@ nfc_tag_t4_init_done(
     void* tag)
 {
     NfcTagType4* self = THIS(tag);
+    NfcTagType4Priv* priv = self->priv;
+
+    /* Reactivation resets the selection */
+    nfc_tag_t4_sel_busy_done(priv);
+    nfc_tag_t4_sel_invalidate(priv);
 
     /*
      * Still mark the tag as initialized even if reactivation times out,
@@ -326,9 +870,11 @@ nfc_tag_t4_ndef_read_done(
      */
     GDEBUG("Reactivating Type 4 tag");
     nfc_tag_ref(&self->tag);
+    priv->sel_busy++;
     if (!nfc_target_reactivate(self->tag.target, priv->init_seq,
         nfc_tag_t4_init_done, NULL, self)) {
         GDEBUG("Oops. Failed to reactivate, leaving the tag as is");
+        nfc_tag_t4_sel_busy_done(priv);
         nfc_tag_t4_initialized(self);
         nfc_tag_unref(&self->tag);
     }
@@ -596,6 +1142,18 @@ nfc_tag_t4_reset_data_free(
 {
     GDestroyNotify destroy = rst->destroy;
 
+    if (rst->ref) {
+        NfcTagType4* self = gutil_weakref_get(rst->ref);
+
+        if (self) {
+            NfcTagType4Priv* priv = self->priv;
+
+            nfc_tag_t4_sel_busy_done(priv);
+            nfc_tag_t4_sel_invalidate(priv);
+            nfc_tag_unref(&self->tag);
+        }
+        gutil_weakref_unref(rst->ref);
+    }
     if (destroy) {
         rst->destroy = NULL;
         destroy(rst->user_data);
@@ -619,7 +1177,13 @@ nfc_tag_t4_reset_data_resp(
     void* user_data)
 {
     NfcIsoDepResetData* rst = user_data;
+    NfcTagType4* self = gutil_weakref_get(rst->ref);
 
+    if (self) {
+        /* Whatever was selected before, it's not selected anymore */
+        nfc_tag_t4_sel_invalidate(self->priv);
+        nfc_tag_unref(&self->tag);
+    }
     if (rst->resp) {
         /* Result is FALSE in case of tag was gone or reactivation timed out */
         rst->resp(rst->t4, status == NFC_REACTIVATE_STATUS_SUCCESS,
@@ -627,62 +1191,671 @@ nfc_tag_t4_reset_data_resp(
     }
 }
 
-/*==========================================================================*
- * Internal interface
- *==========================================================================*/
-
-void
-nfc_tag_t4_init_base(
-    NfcTagType4* self,
-    NfcTarget* target,
-    guint mtu,
-    gboolean read_ndef,
-    const NfcParamPoll* poll,
-    const NfcParamIsoDep* iso_dep)
+static
+GByteArray*
+nfc_tag_t4_buf_take(
+    NfcTagType4Priv* priv)
 {
-    NfcTag* tag = &self->tag;
-    NfcTagType4Priv* priv = self->priv;
-
-    nfc_tag_init_base(tag, target, poll);
-    priv->mtu = mtu;
+    GByteArray* buf = priv->buf;
 
-    if (iso_dep) {
-        const gsize aligned_size = G_ALIGN8(sizeof(*iso_dep));
-        const GUtilData* src;
-        gsize size;
+    if (buf) {
+        priv->buf = NULL;
+        return buf;
+    } else {
+        return g_byte_array_new();
+    }
+}
 
-        /*
-         * Allocate the whole thing (including additional data) from a
-         * single memory block and adjust the pointers.
-         */
-        switch (target->technology) {
-        case NFC_TECHNOLOGY_A:
-            src = &iso_dep->a.t1;
-            size = src->size ? (aligned_size + src->size) : sizeof(*iso_dep);
-            *(priv->iso_dep = g_malloc0(size)) = *iso_dep;
-            if (src->bytes) {
-                guint8* dest = (guint8*)priv->iso_dep + aligned_size;
+static
+void
+nfc_tag_t4_buf_drop(
+    NfcTagType4Priv* priv,
+    GByteArray* buf)
+{
+    if (buf) {
+        if (priv->buf) {
+            g_byte_array_free(buf, TRUE);
+        } else {
+            /* Keep it for the next time */
+            g_byte_array_set_size(buf, 0);
+            priv->buf = buf;
+        }
+    }
+}
 
-                memcpy(dest, src->bytes, src->size);
-                priv->iso_dep->a.t1.bytes = dest;
-            }
-            self->iso_dep = priv->iso_dep;
-            break;
-        case NFC_TECHNOLOGY_B:
-            src = &iso_dep->b.hlr;
-            size = src->size ? (aligned_size + src->size) : sizeof(*iso_dep);
-            *(priv->iso_dep = g_malloc0(size)) = *iso_dep;
-            if (src->bytes) {
-                guint8* dest = (guint8*)priv->iso_dep + aligned_size;
+static
+void
+nfc_isodep_xfer_free(
+    gpointer data)
+{
+    NfcIsoDepXfer* xfer = data;
+    NfcTagType4* t4 = xfer->t4;
+
+    nfc_tag_t4_cancel_tx(t4, xfer->tx_id);
+    nfc_target_sequence_unref(xfer->seq);
+    nfc_tag_t4_buf_drop(t4->priv, xfer->buf);
+    if (xfer->destroy) {
+        xfer->destroy(xfer->user_data);
+    }
+    g_bytes_unref(xfer->data);
+    g_slice_free1(sizeof(*xfer), xfer);
+}
 
-                memcpy(dest, src->bytes, src->size);
-                priv->iso_dep->b.hlr.bytes = dest;
-            }
-            self->iso_dep = priv->iso_dep;
-            break;
-        case NFC_TECHNOLOGY_F:
-        case NFC_TECHNOLOGY_UNKNOWN:
-            break;
+static
+void
+nfc_isodep_xfer_done(
+    NfcIsoDepXfer* xfer,
+    guint sw,
+    const void* data,
+    guint len)
+{
+    NfcTagType4* t4 = xfer->t4;
+    NfcTag* tag = &t4->tag;
+    NfcTagType4ResponseFunc resp = xfer->resp;
+
+    /* The callback may cancel this transfer or drop the last tag ref */
+    nfc_tag_ref(tag);
+    g_hash_table_steal(t4->priv->xfers, GUINT_TO_POINTER(xfer->id));
+    xfer->resp = NULL;
+    if (resp) {
+        GByteArray* buf = xfer->buf;
+
+        if (buf && buf->len && sw != ISO_SW_IO_ERR) {
+            /* Deliver the whole thing */
+            g_byte_array_append(buf, data, len);
+            data = buf->data;
+            len = buf->len;
+        }
+        resp(t4, sw, data, len, xfer->user_data);
+    }
+    nfc_isodep_xfer_free(xfer);
+    nfc_tag_unref(tag);
+}
+
+static
+void
+nfc_isodep_xfer_resp(
+    NfcTagType4* t4,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data);
+
+static
+guint
+nfc_isodep_xfer_submit(
+    NfcIsoDepXfer* xfer)
+{
+    NfcTagType4* t4 = xfer->t4;
+    const guint remaining = (guint) g_bytes_get_size(xfer->data) -
+        xfer->offset;
+    GUtilData chunk;
+
+    chunk.bytes = (const guint8*) g_bytes_get_data(xfer->data, NULL) +
+        xfer->offset;
+    if ((xfer->flags & NFC_ISODEP_TX_FLAG_CHAINING) &&
+        remaining > SHORT_LC_MAX) {
+        /* Not the last command in the chain, no Le */
+        chunk.size = SHORT_LC_MAX;
+        return nfc_isodep_submit(t4, xfer->cla | ISO_CLA_CHAIN, xfer->ins,
+            xfer->p1, xfer->p2, &chunk, 0, xfer->seq, nfc_isodep_xfer_resp,
+            NULL, xfer);
+    } else {
+        chunk.size = remaining;
+        return nfc_isodep_submit(t4, xfer->cla, xfer->ins, xfer->p1,
+            xfer->p2, &chunk, xfer->le, xfer->seq, nfc_isodep_xfer_resp,
+            NULL, xfer);
+    }
+}
+
+static
+void
+nfc_isodep_xfer_get_response_resp(
+    NfcTagType4* t4,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepXfer* xfer = user_data;
+
+    xfer->tx_id = 0;
+    if ((sw >> 8) == ISO_SW1_MORE_DATA) {
+        NfcTagType4Priv* priv = t4->priv;
+        const guint le = (sw & 0xff) ? (sw & 0xff) : SHORT_LE_MAX;
+
+        if (!xfer->buf) {
+            xfer->buf = nfc_tag_t4_buf_take(priv);
+        }
+        if (xfer->buf->len + len + le <= RESP_MAX) {
+            /*
+             * ISO/IEC 7816-4
+             * Section 11.5.6 GET RESPONSE command
+             */
+            g_byte_array_append(xfer->buf, data, len);
+            xfer->tx_id = nfc_isodep_submit(t4, (xfer->cla &
+                ISO_CLA_PROPRIETARY) ? ISO_CLA : (xfer->cla &
+                ISO_CLA_CHANNEL_MASK), ISO_INS_GET_RESPONSE, 0, 0, NULL, le,
+                xfer->seq, nfc_isodep_xfer_get_response_resp, NULL, xfer);
+            if (xfer->tx_id) {
+                return;
+            }
+        } else {
+            GWARN("ISO-DEP response too long");
+        }
+        nfc_isodep_xfer_done(xfer, ISO_SW_IO_ERR, NULL, 0);
+    } else {
+        nfc_isodep_xfer_done(xfer, sw, data, len);
+    }
+}
+
+static
+void
+nfc_isodep_xfer_resp(
+    NfcTagType4* t4,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepXfer* xfer = user_data;
+    const guint total = (guint) g_bytes_get_size(xfer->data);
+    const guint remaining = total - xfer->offset;
+
+    xfer->tx_id = 0;
+    if ((xfer->flags & NFC_ISODEP_TX_FLAG_CHAINING) &&
+        remaining > SHORT_LC_MAX) {
+        /* Intermediate command in the chain */
+        if (sw == ISO_SW_OK) {
+            xfer->offset += SHORT_LC_MAX;
+            if ((xfer->tx_id = nfc_isodep_xfer_submit(xfer)) == 0) {
+                nfc_isodep_xfer_done(xfer, ISO_SW_IO_ERR, NULL, 0);
+            }
+        } else {
+            GDEBUG("Command chaining failed at %u/%u, %04X", xfer->offset,
+                total, sw);
+            nfc_isodep_xfer_done(xfer, sw, data, len);
+        }
+    } else if (xfer->flags & NFC_ISODEP_TX_FLAG_GET_RESPONSE) {
+        if ((sw >> 8) == ISO_SW1_WRONG_LE && !xfer->le_fixed) {
+            /* Repeat the last command with the right Le */
+            xfer->le_fixed = TRUE;
+            xfer->le = (sw & 0xff) ? (sw & 0xff) : SHORT_LE_MAX;
+            GDEBUG("Retrying with Le %u", xfer->le);
+            if ((xfer->tx_id = nfc_isodep_xfer_submit(xfer)) == 0) {
+                nfc_isodep_xfer_done(xfer, ISO_SW_IO_ERR, NULL, 0);
+            }
+        } else {
+            nfc_isodep_xfer_get_response_resp(t4, sw, data, len, xfer);
+        }
+    } else {
+        nfc_isodep_xfer_done(xfer, sw, data, len);
+    }
+}
+
+static
+gboolean
+nfc_tag_t4_ndef_read_start(
+    NfcTagType4* self)
+{
+    NfcTagType4Priv* priv = self->priv;
+
+    GASSERT(!priv->init_seq);
+    priv->init_seq = nfc_target_sequence_new(self->tag.target);
+
+    /*
+     * NFCForum-TS-Type-4-Tag_2.0
+     * Section 5.4.2. NDEF Tag Application Select Procedure
+     *
+     * Table 9: NDEF Tag Application Select C-APDU
+     * 00A4040007D276000085010100
+     */
+    if ((priv->init_id = nfc_isodep_submit(self, ISO_CLA, ISO_INS_SELECT,
+        ISO_P1_SELECT_DF_BY_NAME, ISO_P2_SELECT_FILE_FIRST, &ndef_aid_data,
+        0x100, priv->init_seq, nfc_tag_t4_init_select_ndef_app_resp,
+        NULL, NULL)) != 0) {
+        return TRUE;
+    }
+    nfc_target_sequence_unref(priv->init_seq);
+    priv->init_seq = NULL;
+    return FALSE;
+}
+
+static
+gboolean
+nfc_tag_t4_ndef_idle(
+    gpointer user_data)
+{
+    NfcTagType4* self = THIS(user_data);
+    NfcTagType4Priv* priv = self->priv;
+    NfcTag* tag = &self->tag;
+
+    if (tag->target->sequence) {
+        /* Someone is about to use the tag, keep waiting */
+        return G_SOURCE_CONTINUE;
+    }
+
+    GDEBUG("Tag is idle, reading NDEF");
+    priv->ndef_idle_id = 0;
+    nfc_tag_read_ndef(tag);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_iso_dep_ndef_write_free(
+    gpointer data)
+{
+    NfcIsoDepNdefWrite* write = data;
+    GDestroyNotify destroy = write->destroy;
+
+    nfc_tag_t4_cancel_tx(write->t4, write->tx_id);
+    nfc_target_sequence_unref(write->seq);
+    g_bytes_unref(write->ndef);
+    if (destroy) {
+        write->destroy = NULL;
+        destroy(write->user_data);
+    }
+    g_slice_free1(sizeof(*write), write);
+}
+
+static
+void
+nfc_iso_dep_ndef_write_done(
+    NfcIsoDepNdefWrite* write,
+    NFC_TAG_T4_WRITE_STATUS status)
+{
+    NfcTagType4* t4 = write->t4;
+    NfcTag* tag = &t4->tag;
+    NfcTagType4WriteNdefFunc complete = write->complete;
+
+    /* The callback may drop the last tag ref */
+    nfc_tag_ref(tag);
+    g_hash_table_steal(t4->priv->writes, GUINT_TO_POINTER(write->id));
+    write->tx_id = 0;
+    write->complete = NULL;
+    if (complete) {
+        complete(t4, status, write->user_data);
+    }
+    nfc_iso_dep_ndef_write_free(write);
+    nfc_tag_unref(tag);
+}
+
+static
+NFC_TAG_T4_WRITE_STATUS
+nfc_iso_dep_ndef_write_status(
+    guint sw)
+{
+    return (sw == ISO_SW_IO_ERR) ? NFC_TAG_T4_WRITE_IO_ERROR :
+        (sw == ISO_SW_NDEF_NOT_FOUND) ? NFC_TAG_T4_WRITE_NOT_NDEF :
+        NFC_TAG_T4_WRITE_FAILURE;
+}
+
+static
+gboolean
+nfc_iso_dep_ndef_write_submit(
+    NfcIsoDepNdefWrite* write,
+    guint8 ins,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    guint le,
+    NfcTagType4ResponseFunc resp)
+{
+    return (write->tx_id = nfc_isodep_submit(write->t4, ISO_CLA, ins, p1, p2,
+        data, le, write->seq, resp, NULL, write)) != 0;
+}
+
+static
+gboolean
+nfc_iso_dep_ndef_write_update(
+    NfcIsoDepNdefWrite* write,
+    guint offset,
+    const void* bytes,
+    guint len,
+    NfcTagType4ResponseFunc resp)
+{
+    GUtilData data;
+
+    /* Offset is guaranteed to fit into 15 bits */
+    data.bytes = bytes;
+    data.size = len;
+    return nfc_iso_dep_ndef_write_submit(write, ISO_INS_UPDATE_BINARY,
+        (guint8)(offset >> 8), (guint8)offset, &data, 0, resp);
+}
+
+static
+void
+nfc_iso_dep_ndef_write_commit_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        GDEBUG("NDEF written, %u byte(s)", write->offset);
+        nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_OK);
+    } else {
+        GDEBUG("NLEN update error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+static
+void
+nfc_iso_dep_ndef_write_data_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        gsize size;
+        const guint8* ndef = g_bytes_get_data(write->ndef, &size);
+
+        if (write->offset < size) {
+            const guint chunk = MIN(size - write->offset, write->max_write);
+            const guint offset = write->offset;
+
+            write->offset += chunk;
+            GVERBOSE("Writing %u byte(s) at %u", chunk, offset);
+            if (nfc_iso_dep_ndef_write_update(write, NDEF_DATA_OFFSET +
+                offset, ndef + offset, chunk,
+                nfc_iso_dep_ndef_write_data_resp)) {
+                return;
+            }
+        } else if (size) {
+            guint8 nlen[NDEF_DATA_OFFSET];
+
+            /* The message is there, now let the world know */
+            nlen[0] = (guint8)(size >> 8);
+            nlen[1] = (guint8)size;
+            if (nfc_iso_dep_ndef_write_update(write, 0, nlen, sizeof(nlen),
+                nfc_iso_dep_ndef_write_commit_resp)) {
+                return;
+            }
+        } else {
+            /* Zero NLEN is all it takes to write an empty message */
+            nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_OK);
+            return;
+        }
+        nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_FAILURE);
+    } else {
+        GDEBUG("NDEF update error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+static
+void
+nfc_iso_dep_ndef_write_select_ndef_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        static const guint8 zero_nlen[NDEF_DATA_OFFSET] = { 0, 0 };
+
+        /*
+         * 5.4.5 NDEF Update Procedure
+         *
+         * Write 0000h into the NLEN field, then the message and
+         * then the actual length into the NLEN field.
+         */
+        GDEBUG("Selected %02X%02X", write->fid[0], write->fid[1]);
+        if (nfc_iso_dep_ndef_write_update(write, 0, zero_nlen,
+            sizeof(zero_nlen), nfc_iso_dep_ndef_write_data_resp)) {
+            return;
+        }
+        nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_FAILURE);
+    } else {
+        GDEBUG("NDEF file selection error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+static
+NFC_TAG_T4_WRITE_STATUS
+nfc_iso_dep_ndef_write_parse_cc(
+    NfcIsoDepNdefWrite* write,
+    const guint8* cc /* At least 15 bytes */)
+{
+    /* See Table 4: Data Structure of the Capability Container File */
+    if ((cc[2] >> 4) == 2 /* We expect Version 2 of the spec */ &&
+        cc[7] == 4 && cc[8] == 6 /* File Control TLV, T = 4, L = 6 */) {
+        const guint8* v = cc + 9; /* V part of File Control TLV */
+        const guint fid = ((((guint)(v[0])) << 8) | v[1]);
+        const guint max_size = ((((guint)(v[2])) << 8) | v[3]);
+        const guint size = (guint) g_bytes_get_size(write->ndef);
+        const guint mtu = write->t4->priv->mtu;
+        guint max_write = ((((guint)(cc[5])) << 8) | cc[6]);
+
+        if (!nfc_tag_t4_ndef_fid_valid(fid)) {
+            GDEBUG("Invalid NDEF file id %04X", fid);
+        } else if (v[5] != 0 /* write access granted */) {
+            GDEBUG("NDEF write not allowed");
+            return NFC_TAG_T4_WRITE_READ_ONLY;
+        } else if (size + NDEF_DATA_OFFSET > max_size) {
+            GDEBUG("NDEF file is too small (%u < %u)", max_size,
+                size + NDEF_DATA_OFFSET);
+            return NFC_TAG_T4_WRITE_TOO_BIG;
+        } else if (max_write < 0x0001) {
+            /* The valid values for MLc are 0001h-FFFFh */
+            GDEBUG("MLc too small (%u)", max_write);
+        } else {
+            /*
+             * Same as with MLe, MLc above FFh implies that the tag
+             * accepts extended Lc field, unless the historical bytes
+             * say otherwise.
+             */
+            if (max_write > SHORT_LC_MAX &&
+                write->t4->priv->ext_len == NFC_TAG_T4_EXT_LEN_NO) {
+                GDEBUG("Extended Lc not supported, MLc %u => %u",
+                    max_write, SHORT_LC_MAX);
+                max_write = SHORT_LC_MAX;
+            }
+
+            /*
+             * Keep each UPDATE BINARY command within a single frame
+             * the tag is able to receive (FSC), so that it doesn't
+             * have to be chained.
+             */
+            if (mtu > UPDATE_BINARY_HEADER + ISO_DEP_BLOCK_OVERHEAD) {
+                guint fit = mtu - UPDATE_BINARY_HEADER -
+                    ISO_DEP_BLOCK_OVERHEAD;
+
+                if (fit > SHORT_LC_MAX) {
+                    /* Extended Lc takes 2 more bytes */
+                    fit -= 2;
+                }
+                if (max_write > fit) {
+                    GDEBUG("FSC %u, MLc %u => %u", mtu, max_write, fit);
+                    max_write = fit;
+                }
+            }
+            write->max_write = max_write;
+            write->fid[0] = v[0];
+            write->fid[1] = v[1];
+            GDEBUG("NDEF file: %04X", fid);
+            GVERBOSE("Max write: %u bytes", max_write);
+            return NFC_TAG_T4_WRITE_OK;
+        }
+    } else {
+        GDEBUG("Unexpected structure of NDEF Capability Container");
+    }
+    return NFC_TAG_T4_WRITE_FAILURE;
+}
+
+static
+void
+nfc_iso_dep_ndef_write_read_cc_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        NFC_TAG_T4_WRITE_STATUS status = NFC_TAG_T4_WRITE_FAILURE;
+
+        if (len < NDEF_CC_LEN) {
+            GDEBUG("Not enough data for NDEF Capability Container");
+        } else {
+            status = nfc_iso_dep_ndef_write_parse_cc(write, data);
+            if (status == NFC_TAG_T4_WRITE_OK) {
+                GUtilData fid;
+
+                /* Table 18: NDEF Select Command C-APDU */
+                fid.bytes = write->fid;
+                fid.size = sizeof(write->fid);
+                if (nfc_iso_dep_ndef_write_submit(write, ISO_INS_SELECT,
+                    ISO_P1_SELECT_BY_ID, ISO_P2_SELECT_FILE_FIRST |
+                    ISO_P2_RESPONSE_NONE, &fid, 0,
+                    nfc_iso_dep_ndef_write_select_ndef_resp)) {
+                    return;
+                }
+                status = NFC_TAG_T4_WRITE_FAILURE;
+            }
+        }
+        nfc_iso_dep_ndef_write_done(write, status);
+    } else {
+        GDEBUG("NDEF Capability Container read error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+static
+void
+nfc_iso_dep_ndef_write_select_cc_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        /* Read first 15 bytes of CC */
+        if (nfc_iso_dep_ndef_write_submit(write, ISO_INS_READ_BINARY, 0, 0,
+            NULL, NDEF_CC_LEN, nfc_iso_dep_ndef_write_read_cc_resp)) {
+            return;
+        }
+        nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_FAILURE);
+    } else {
+        GDEBUG("NDEF Capability Container selection error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+static
+void
+nfc_iso_dep_ndef_write_select_app_resp(
+    NfcTagType4* self,
+    guint sw,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    NfcIsoDepNdefWrite* write = user_data;
+
+    write->tx_id = 0;
+    if (sw == ISO_SW_OK) {
+        /* Table 12: Capability Container Select Command C-APDU */
+        if (nfc_iso_dep_ndef_write_submit(write, ISO_INS_SELECT,
+            ISO_P1_SELECT_BY_ID, ISO_P2_SELECT_FILE_FIRST |
+            ISO_P2_RESPONSE_NONE, &ndef_cc_ef_data, 0,
+            nfc_iso_dep_ndef_write_select_cc_resp)) {
+            return;
+        }
+        nfc_iso_dep_ndef_write_done(write, NFC_TAG_T4_WRITE_FAILURE);
+    } else {
+        GDEBUG("NDEF Tag Application selection error %04X", sw);
+        nfc_iso_dep_ndef_write_done(write,
+            nfc_iso_dep_ndef_write_status(sw));
+    }
+}
+
+/*==========================================================================*
+ * Internal interface
+ *==========================================================================*/
+
+void
+nfc_tag_t4_init_base(
+    NfcTagType4* self,
+    NfcTarget* target,
+    guint mtu,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
+    const NfcParamPoll* poll,
+    const NfcParamIsoDep* iso_dep)
+{
+    NfcTag* tag = &self->tag;
+    NfcTagType4Priv* priv = self->priv;
+
+    nfc_tag_init_base(tag, target, poll);
+    priv->mtu = mtu;
+
+    if (iso_dep) {
+        const gsize aligned_size = G_ALIGN8(sizeof(*iso_dep));
+        const GUtilData* src;
+        gsize size;
+
+        /*
+         * Allocate the whole thing (including additional data) from a
+         * single memory block and adjust the pointers.
+         */
+        switch (target->technology) {
+        case NFC_TECHNOLOGY_A:
+            src = &iso_dep->a.t1;
+            size = src->size ? (aligned_size + src->size) : sizeof(*iso_dep);
+            *(priv->iso_dep = g_malloc0(size)) = *iso_dep;
+            if (src->bytes) {
+                guint8* dest = (guint8*)priv->iso_dep + aligned_size;
+
+                memcpy(dest, src->bytes, src->size);
+                priv->iso_dep->a.t1.bytes = dest;
+            }
+            self->iso_dep = priv->iso_dep;
+            priv->ext_len = nfc_tag_t4_ext_len_a(&priv->iso_dep->a.t1);
+            break;
+        case NFC_TECHNOLOGY_B:
+            /* Higher layer response is proprietary, leave ext_len unknown */
+            src = &iso_dep->b.hlr;
+            size = src->size ? (aligned_size + src->size) : sizeof(*iso_dep);
+            *(priv->iso_dep = g_malloc0(size)) = *iso_dep;
+            if (src->bytes) {
+                guint8* dest = (guint8*)priv->iso_dep + aligned_size;
+
+                memcpy(dest, src->bytes, src->size);
+                priv->iso_dep->b.hlr.bytes = dest;
+            }
+            self->iso_dep = priv->iso_dep;
+            break;
+        case NFC_TECHNOLOGY_F:
+        case NFC_TECHNOLOGY_UNKNOWN:
+            break;
         }
     }
 
@@ -695,20 +1868,21 @@ nfc_tag_t4_init_base(
      * selection of a non-default application may be an irreversible
      * action (which of course depends on how the card is programmed).
      */
-    if (read_ndef && nfc_target_can_reactivate(tag->target)) {
-        priv->init_seq = nfc_target_sequence_new(target);
-
-        /*
-         * NFCForum-TS-Type-4-Tag_2.0
-         * Section 5.4.2. NDEF Tag Application Select Procedure
-         *
-         * Table 9: NDEF Tag Application Select C-APDU
-         * 00A4040007D276000085010100
-         */
-        if ((priv->init_id = nfc_isodep_submit(self, ISO_CLA, ISO_INS_SELECT,
-            ISO_P1_SELECT_DF_BY_NAME, ISO_P2_SELECT_FILE_FIRST, &ndef_aid_data,
-            0x100, priv->init_seq, nfc_tag_t4_init_select_ndef_app_resp,
-            NULL, NULL)) != 0) {
+    if (ndef_mode != NFC_TAG_T4_NDEF_SKIP &&
+        nfc_target_can_reactivate(tag->target)) {
+        if (ndef_mode == NFC_TAG_T4_NDEF_LAZY) {
+            /*
+             * Let the clients start talking to the tag right away. NDEF
+             * will be read when someone asks for it or when nobody has
+             * sent anything to the tag for a while.
+             */
+            GDEBUG("Deferring NDEF read");
+            tag->flags |= NFC_TAG_FLAG_NDEF_DEFERRED;
+            priv->ndef_idle_id = g_timeout_add(NDEF_IDLE_TIMEOUT_MS,
+                nfc_tag_t4_ndef_idle, self);
+            nfc_tag_set_initialized(tag);
+            return;
+        } else if (nfc_tag_t4_ndef_read_start(self)) {
             return;
         }
     }
@@ -737,6 +1911,82 @@ nfc_isodep_transmit(
         data, le, seq, resp, destroy, user_data) : 0;
 }
 
+guint
+nfc_isodep_transmit2(
+    NfcTagType4* self,
+    guint8 cla,             /* Class byte */
+    guint8 ins,             /* Instruction byte */
+    guint8 p1,              /* Parameter byte 1 */
+    guint8 p2,              /* Parameter byte 2 */
+    const GUtilData* data,  /* Command data */
+    guint le,               /* Expected length, zero if none */
+    NFC_ISODEP_TX_FLAGS flags,
+    NfcTargetSequence* seq,
+    NfcTagType4ResponseFunc resp,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        if (flags & (NFC_ISODEP_TX_FLAG_GET_RESPONSE |
+            NFC_ISODEP_TX_FLAG_CHAINING)) {
+            NfcTagType4Priv* priv = self->priv;
+            NfcTarget* target = self->tag.target;
+            NfcIsoDepXfer* xfer = g_slice_new0(NfcIsoDepXfer);
+
+            xfer->t4 = self;
+            xfer->flags = flags;
+            xfer->cla = cla;
+            xfer->ins = ins;
+            xfer->p1 = p1;
+            xfer->p2 = p2;
+            xfer->le = le;
+            xfer->data = data ? g_bytes_new(data->bytes, data->size) :
+                g_bytes_new_static(NULL, 0);
+
+            /* Nothing may get in between the pieces of the exchange */
+            xfer->seq = seq ? nfc_target_sequence_ref(seq) :
+                nfc_target_sequence_new(target);
+            xfer->tx_id = nfc_isodep_xfer_submit(xfer);
+            if (xfer->tx_id) {
+                xfer->id = nfc_isodep_generate_id(self);
+                xfer->resp = resp;
+                xfer->destroy = destroy;
+                xfer->user_data = user_data;
+                if (!priv->xfers) {
+                    priv->xfers = g_hash_table_new_full(g_direct_hash,
+                        g_direct_equal, NULL, nfc_isodep_xfer_free);
+                }
+                g_hash_table_insert(priv->xfers, GUINT_TO_POINTER(xfer->id),
+                    xfer);
+                return xfer->id;
+            }
+            nfc_isodep_xfer_free(xfer);
+        } else {
+            return nfc_isodep_submit(self, cla, ins, p1, p2, data, le, seq,
+                resp, destroy, user_data);
+        }
+    }
+    return 0;
+}
+
+gboolean
+nfc_isodep_cancel(
+    NfcTagType4* self,
+    guint id) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        NfcTagType4Priv* priv = self->priv;
+
+        if ((priv->xfers && g_hash_table_remove(priv->xfers,
+            GUINT_TO_POINTER(id))) || (priv->writes &&
+            g_hash_table_remove(priv->writes, GUINT_TO_POINTER(id)))) {
+            return TRUE;
+        }
+        return nfc_tag_t4_cancel_tx(self, id);
+    }
+    return FALSE;
+}
+
 gboolean
 nfc_isodep_reset(
     NfcTagType4* self,
@@ -749,15 +1999,18 @@ nfc_isodep_reset(
         NfcTag* tag = &self->tag;
 
         if (G_LIKELY(tag) && nfc_target_can_reactivate(tag->target)) {
+            NfcTagType4Priv* priv = self->priv;
             NfcIsoDepResetData* rst = g_slice_new0(NfcIsoDepResetData);
 
             rst->t4 = self;
+            rst->ref = gutil_weakref_ref(priv->ref);
             rst->resp = resp;
             rst->destroy = destroy;
             rst->user_data = user_data;
 
-            if (nfc_target_reactivate(tag->target, seq, resp ?
-                nfc_tag_t4_reset_data_resp : NULL, nfc_tag_t4_reset_data_free1,
+            priv->sel_busy++;
+            if (nfc_target_reactivate(tag->target, seq,
+                nfc_tag_t4_reset_data_resp, nfc_tag_t4_reset_data_free1,
                 rst)) {
                 return TRUE;
             } else {
@@ -766,6 +2019,9 @@ nfc_isodep_reset(
                 * always return TRUE in case if nfc_target_can_reactivate()
                 * succeeds.
                 */
+                nfc_tag_t4_sel_busy_done(priv);
+                gutil_weakref_unref(rst->ref);
+                rst->ref = NULL;
                 rst->destroy = NULL;
                 nfc_tag_t4_reset_data_free(rst);
             }
@@ -774,6 +2030,107 @@ nfc_isodep_reset(
     return FALSE;
 }
 
+guint
+nfc_tag_t4_write_ndef(
+    NfcTagType4* self,
+    GBytes* ndef,
+    NfcTargetSequence* seq,
+    NfcTagType4WriteNdefFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self) && G_LIKELY(ndef)) {
+        const gsize size = g_bytes_get_size(ndef);
+
+        /* Offsets beyond 7FFFh would require odd INS UPDATE BINARY */
+        if (size > NDEF_NLEN_MAX ||
+            size + NDEF_DATA_OFFSET > UPDATE_BINARY_OFFSET_MAX + 1) {
+            GDEBUG("NDEF is too large (%u bytes)", (guint) size);
+        } else {
+            NfcTagType4Priv* priv = self->priv;
+            NfcIsoDepNdefWrite* write = g_slice_new0(NfcIsoDepNdefWrite);
+
+            write->t4 = self;
+            write->ndef = g_bytes_ref(ndef);
+            write->seq = seq ? nfc_target_sequence_ref(seq) :
+                nfc_target_sequence_new(self->tag.target);
+
+            /* Table 10: NDEF Tag Application Select C-APDU */
+            if (nfc_iso_dep_ndef_write_submit(write, ISO_INS_SELECT,
+                ISO_P1_SELECT_DF_BY_NAME, ISO_P2_SELECT_FILE_FIRST,
+                &ndef_aid_data, SHORT_LE_MAX,
+                nfc_iso_dep_ndef_write_select_app_resp)) {
+                write->id = nfc_isodep_generate_id(self);
+                write->complete = complete;
+                write->destroy = destroy;
+                write->user_data = user_data;
+                if (!priv->writes) {
+                    priv->writes = g_hash_table_new_full(g_direct_hash,
+                        g_direct_equal, NULL, nfc_iso_dep_ndef_write_free);
+                }
+                g_hash_table_insert(priv->writes,
+                    GUINT_TO_POINTER(write->id), write);
+                GDEBUG("Writing %u bytes of NDEF", (guint) size);
+                return write->id;
+            }
+            nfc_iso_dep_ndef_write_free(write);
+        }
+    }
+    return 0;
+}
+
+void
+nfc_isodep_set_select_cache(
+    NfcTagType4* self,
+    gboolean enable) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        NfcTagType4Priv* priv = self->priv;
+
+        if (enable && !priv->sel_cache) {
+            /* Raw transmissions may have changed the selection meanwhile */
+            nfc_tag_t4_sel_invalidate(priv);
+        }
+        priv->sel_cache = (enable != FALSE);
+    }
+}
+
+const NfcIsoDepSelectStats*
+nfc_isodep_select_stats(
+    NfcTagType4* self) /* Since 1.2.8 */
+{
+    return G_LIKELY(self) ? &self->priv->sel_stats : NULL;
+}
+
+/*==========================================================================*
+ * Methods
+ *==========================================================================*/
+
+static
+gboolean
+nfc_tag_t4_read_ndef(
+    NfcTag* tag)
+{
+    NfcTagType4* self = THIS(tag);
+    NfcTagType4Priv* priv = self->priv;
+
+    if (priv->ndef_idle_id) {
+        g_source_remove(priv->ndef_idle_id);
+        priv->ndef_idle_id = 0;
+    }
+    if (priv->init_seq) {
+        /* Already reading */
+        return TRUE;
+    } else if (nfc_tag_t4_ndef_read_start(self)) {
+        /* Note that the tag gets reactivated after reading NDEF */
+        GDEBUG("Reading NDEF on demand");
+        return TRUE;
+    } else {
+        nfc_tag_set_ndef_ready(tag);
+        return FALSE;
+    }
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -787,7 +2144,7 @@ nfc_tag_t4_init(
         NfcTagType4Priv);
 
     self->priv = priv;
-    priv->buf = g_byte_array_sized_new(12);
+    priv->ref = gutil_weakref_new(self);
 }
 
 static
@@ -798,10 +2155,27 @@ nfc_tag_t4_finalize(
     NfcTagType4* self = THIS(object);
     NfcTagType4Priv* priv = self->priv;
 
-    nfc_target_cancel_transmit(self->tag.target, priv->init_id);
+    if (priv->xfers) {
+        g_hash_table_destroy(priv->xfers);
+    }
+    if (priv->writes) {
+        g_hash_table_destroy(priv->writes);
+    }
+    if (priv->buf) {
+        g_byte_array_free(priv->buf, TRUE);
+    }
+    if (priv->ndef_idle_id) {
+        g_source_remove(priv->ndef_idle_id);
+    }
+    nfc_tag_t4_cancel_tx(self, priv->init_id);
+    if (priv->replies) {
+        g_hash_table_destroy(priv->replies);
+    }
+    nfc_isodep_selection_clear(&priv->df);
+    nfc_isodep_selection_clear(&priv->ef);
     nfc_target_sequence_unref(priv->init_seq);
     nfc_iso_dep_ndef_read_free(priv->init_read);
-    g_byte_array_free(priv->buf, TRUE);
+    gutil_weakref_unref(priv->ref);
     g_free(priv->iso_dep);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
@@ -812,6 +2186,7 @@ nfc_tag_t4_class_init(
     NfcTagType4Class* klass)
 {
     g_type_class_add_private(klass, sizeof(NfcTagType4Priv));
+    klass->parent.read_ndef = nfc_tag_t4_read_ndef;
     G_OBJECT_CLASS(klass)->finalize = nfc_tag_t4_finalize;
 }
 
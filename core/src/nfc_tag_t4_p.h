@@ -48,10 +48,17 @@ typedef struct nfc_tag_t4_class {
     NfcTagClass parent;
 } NfcTagType4Class;
 
+/* Compatible with the old gboolean read_ndef parameter */
+typedef enum nfc_tag_t4_ndef_mode {
+    NFC_TAG_T4_NDEF_SKIP = FALSE,
+    NFC_TAG_T4_NDEF_READ = TRUE,
+    NFC_TAG_T4_NDEF_LAZY        /* Read on demand or when idle */
+} NFC_TAG_T4_NDEF_MODE;
+
 NfcTagType4a*
 nfc_tag_t4a_new(
     NfcTarget* target,
-    gboolean read_ndef,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
     const NfcParamPollA* poll_a,
     const NfcParamIsoDepPollA* iso_dep_param)
     NFCD_INTERNAL;
@@ -59,7 +66,7 @@ nfc_tag_t4a_new(
 NfcTagType4b*
 nfc_tag_t4b_new(
     NfcTarget* target,
-    gboolean read_ndef,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
     const NfcParamPollB* poll_b,
     const NfcParamIsoDepPollB* iso_dep_param)
     NFCD_INTERNAL;
@@ -69,7 +76,7 @@ nfc_tag_t4_init_base(
     NfcTagType4* tag,
     NfcTarget* target,
     guint mtu,
-    gboolean read_ndef,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
     const NfcParamPoll* poll,
     const NfcParamIsoDep* iso_dep)
     NFCD_INTERNAL;
@@ -59,7 +59,7 @@ G_DEFINE_TYPE(NfcTagType4a, nfc_tag_t4a, NFC_TYPE_TAG_T4)
 NfcTagType4a*
 nfc_tag_t4a_new(
     NfcTarget* target,
-    gboolean read_ndef,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
     const NfcParamPollA* poll_a,
     const NfcParamIsoDepPollA* iso_dep_a)
 {
@@ -79,7 +79,7 @@ nfc_tag_t4a_new(
             poll.a = *poll_a;
             pp = &poll;
         }
-        nfc_tag_t4_init_base(t4, target, iso_dep_a->fsc, read_ndef, pp,
+        nfc_tag_t4_init_base(t4, target, iso_dep_a->fsc, ndef_mode, pp,
             &iso_dep);
         return self;
     }
@@ -59,7 +59,7 @@ G_DEFINE_TYPE(NfcTagType4b, nfc_tag_t4b, NFC_TYPE_TAG_T4)
 NfcTagType4b*
 nfc_tag_t4b_new(
     NfcTarget* target,
-    gboolean read_ndef,
+    NFC_TAG_T4_NDEF_MODE ndef_mode,
     const NfcParamPollB* poll_b,
     const NfcParamIsoDepPollB* iso_dep_b)
 {
@@ -79,7 +79,7 @@ nfc_tag_t4b_new(
             iso_dep.b = *iso_dep_b;
             p = &iso_dep;
         }
-        nfc_tag_t4_init_base(t4, target, read_ndef, poll_b->fsc, &poll, p);
+        nfc_tag_t4_init_base(t4, target, poll_b->fsc, ndef_mode, &poll, p);
         return self;
     }
     return NULL;
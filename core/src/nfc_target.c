@@ -36,6 +36,7 @@
 
 #include "nfc_target_p.h"
 #include "nfc_target_impl.h"
+#include "nfc_target_recorder_p.h"
 #include "nfc_log.h"
 
 #include <gutil_macros.h>
@@ -43,8 +44,11 @@
 
 #define DEFAULT_TRANSMIT_TIMEOUT_MS (500)
 #define DEFAULT_REACTIVATION_TIMEOUT_MS (1500)
+#define TRANSMIT_BATCH_MAX (8)
+#define ADAPTIVE_TIMEOUT_MIN_MS (25)
 
 typedef struct nfc_target_request NfcTargetRequest;
+typedef struct nfc_target_run_entry NfcTargetRunEntry;
 typedef struct nfc_target_request_type {
     const char* name;
     gboolean (*submit)(NfcTargetRequest* req);
@@ -59,13 +63,35 @@ typedef struct nfc_target_request_type {
     void (*free)(NfcTargetRequest* req);
 } NfcTargetRequestType;
 
+/*
+ * The run queue determines the order in which requests get submitted when
+ * there's no active sequence. Its entries are either individual requests
+ * (those not associated with any sequence) or sequences with non-empty
+ * request queues. Sequences are placed in the run queue when they get
+ * their first pending request and leave it when the last one is gone.
+ */
+struct nfc_target_run_entry {
+    NfcTargetRunEntry* next;
+    NfcTargetRunEntry* prev;
+    NfcTargetSequence* seq;  /* NULL if this entry is a request */
+};
+
+typedef struct nfc_target_run_queue {
+    NfcTargetRunEntry* first;
+    NfcTargetRunEntry* last;
+} NfcTargetRunQueue;
+
 struct nfc_target_request {
-    NfcTargetRequest* next;
+    NfcTargetRequest* next;  /* Sequence queue or batch links */
+    NfcTargetRequest* prev;
+    NfcTargetRunEntry entry; /* Run queue links if there's no sequence */
     NfcTargetSequence* seq;
     const NfcTargetRequestType* type;
     NfcTarget* target;
     guint id;
-    guint timeout;
+    gboolean cancelled;
+    gint64 started;
+    gint64 deadline;
     GDestroyNotify destroy;
     void* user_data;
 };
@@ -73,7 +99,7 @@ struct nfc_target_request {
 typedef struct nfc_target_transmit_request {
     NfcTargetRequest request;
     const void* data;
-    void* copied_data;
+    GBytes* bytes;
     guint len;
     NfcTargetTransmitFunc complete;
 } NfcTargetTransmitRequest;
@@ -93,6 +119,8 @@ struct nfc_target_sequence {
     gint refcount;
     NfcTarget* target;
     NFC_SEQUENCE_FLAGS flags;
+    NfcTargetRunEntry entry;
+    NfcTargetRequestQueue req_queue;
 };
 
 typedef struct nfc_target_sequence_queue {
@@ -100,15 +128,37 @@ typedef struct nfc_target_sequence_queue {
     NfcTargetSequence* last;
 } NfcTargetSequenceQueue;
 
+typedef struct nfc_target_timer {
+    GSource source;
+    gint64 deadline;  /* Monotonic time, negative if disarmed */
+} NfcTargetTimer;
+
+/* Round-trip time estimates, in microseconds (see RFC 6298) */
+typedef struct nfc_target_rtt {
+    gint64 srtt;
+    gint64 rttvar;
+    gint64 rto;     /* Zero until the first sample is taken */
+} NfcTargetRtt;
+
 struct nfc_target_priv {
     guint last_req_id;
     guint continue_id;
+    GSource* timer;
     NfcTargetRequest* req_active;
+    NfcTargetRequestQueue batch;
     NfcTargetSequenceQueue seq_queue;
-    NfcTargetRequestQueue req_queue;
+    NfcTargetRunQueue run_queue;
+    GHashTable* req_table;
     guint tx_timeout_ms;
     guint ra_timeout_ms;
+    gboolean adaptive_timeout;
+    NfcTargetRtt rtt;
     gboolean reactivating;
+    gboolean submitting;
+    NFC_TARGET_DISPATCH_MODE dispatch_mode;
+    NfcTargetDispatchStats dispatch_stats;
+    NfcTargetRecorder* recorder;
+    guint max_frame_size;
 };
 
 #define THIS(obj) NFC_TARGET(obj)
@@ -142,6 +192,18 @@ nfc_target_set_sequence(
     NfcTarget* self,
     NfcTargetSequence* seq);
 
+static
+gboolean
+nfc_target_transmit_batch(
+    NfcTarget* self,
+    NfcTargetRequest* req);
+
+static
+void
+nfc_target_batch_flush(
+    NfcTarget* self,
+    gboolean requeue);
+
 /*==========================================================================*
  * Transmit request
  *==========================================================================*/
@@ -154,6 +216,19 @@ nfc_target_transmit_request_cast(
     return G_CAST(req, NfcTargetTransmitRequest, request);
 }
 
+static
+GBytes*
+nfc_target_transmit_request_bytes(
+    NfcTargetTransmitRequest* tx)
+{
+    if (!tx->bytes) {
+        /* The implementation may hold on to the data */
+        tx->data = g_bytes_get_data(tx->bytes =
+            g_bytes_new(tx->data, tx->len), NULL);
+    }
+    return tx->bytes;
+}
+
 static
 gboolean
 nfc_target_transmit_request_submit(
@@ -161,8 +236,27 @@ nfc_target_transmit_request_submit(
 {
     NfcTarget* target = req->target;
     NfcTargetTransmitRequest* tx = nfc_target_transmit_request_cast(req);
-
-    return GET_THIS_CLASS(target)->transmit(target, tx->data, tx->len);
+    NfcTargetClass* klass = GET_THIS_CLASS(target);
+    NfcTargetRecorder* recorder = target->priv->recorder;
+    NfcTargetRequest* next = req->seq ? req->seq->req_queue.first : NULL;
+    gboolean ok;
+
+    nfc_target_recorder_transmit(recorder, req->id, tx->data, tx->len);
+    if (klass->transmit_batch && next &&
+        next->type->submit == nfc_target_transmit_request_submit) {
+        /* More frames of the same sequence are waiting */
+        ok = nfc_target_transmit_batch(target, req);
+    } else if (klass->transmit_bytes) {
+        ok = klass->transmit_bytes(target,
+            nfc_target_transmit_request_bytes(tx));
+    } else {
+        ok = klass->transmit(target, tx->data, tx->len);
+    }
+    if (!ok) {
+        nfc_target_recorder_transmit_done(recorder, req->id,
+            NFC_TRANSMIT_STATUS_ERROR, NULL, 0);
+    }
+    return ok;
 }
 
 static
@@ -186,7 +280,17 @@ guint
 nfc_target_transmit_request_timeout_ms(
     NfcTargetRequest* req)
 {
-    return req->target->priv->tx_timeout_ms;
+    NfcTargetPriv* priv = req->target->priv;
+    const guint max_ms = priv->tx_timeout_ms;
+
+    if (priv->adaptive_timeout && priv->rtt.rto && max_ms) {
+        /* Configured timeout is the upper limit */
+        const gint64 ms = (priv->rtt.rto + G_TIME_SPAN_MILLISECOND - 1) /
+            G_TIME_SPAN_MILLISECOND;
+
+        return (guint) MIN(ms, max_ms);
+    }
+    return max_ms;
 }
 
 static
@@ -229,7 +333,9 @@ nfc_target_transmit_request_free(
 {
     NfcTargetTransmitRequest* tx = nfc_target_transmit_request_cast(req);
 
-    g_free(tx->copied_data);
+    if (tx->bytes) {
+        g_bytes_unref(tx->bytes);
+    }
     g_slice_free1(sizeof(*tx), tx);
 }
 
@@ -239,6 +345,7 @@ nfc_target_transmit_request_new(
     NfcTarget* target,
     const void* data,
     guint len,
+    GBytes* bytes,
     NfcTargetSequence* seq,
     NfcTargetTransmitFunc complete,
     GDestroyNotify destroy,
@@ -270,8 +377,16 @@ nfc_target_transmit_request_new(
     req->target = target;
     req->destroy = destroy;
     req->user_data = user_data;
-    tx->data = data;
-    tx->len = len;
+    if (bytes) {
+        gsize size;
+
+        tx->bytes = g_bytes_ref(bytes);
+        tx->data = g_bytes_get_data(bytes, &size);
+        tx->len = (guint) size;
+    } else {
+        tx->data = data;
+        tx->len = len;
+    }
     tx->complete = complete;
     return tx;
 };
@@ -471,8 +586,9 @@ nfc_target_sequence_dealloc(
                 queue->last = prev;
             }
         }
+        GASSERT(!self->req_queue.first);
         if (target->sequence == self) {
-            NfcTargetRequest* req = priv->req_queue.first;
+            NfcTargetRunEntry* next = priv->run_queue.first;
 
             /*
              * The last reference to the current sequence is gone.
@@ -484,7 +600,7 @@ nfc_target_sequence_dealloc(
              * current sequence and submit the request anyway (even
              * though there may be some sequences in the queue).
              */
-            nfc_target_set_sequence(target, req ? req->seq : queue->first);
+            nfc_target_set_sequence(target, next ? next->seq : queue->first);
 
             /* Finished sequence can unblock some requests */
             nfc_target_schedule_next_request(target);
@@ -550,6 +666,7 @@ nfc_target_sequence_new2(
         g_atomic_int_set(&self->refcount, 1);
         self->target = target;
         self->flags = flags;
+        self->entry.seq = self;
 
         /* Insert it to the queue */
         if (queue->last) {
@@ -589,6 +706,53 @@ nfc_target_sequence_flags(
  * Implementation
  *==========================================================================*/
 
+static
+void
+nfc_target_rtt_sample(
+    NfcTargetRtt* rtt,
+    gint64 r)
+{
+    if (rtt->rto) {
+        const gint64 delta = rtt->srtt - r;
+
+        /* RTTVAR <- 3/4 * RTTVAR + 1/4 * |SRTT - R'| */
+        rtt->rttvar = (3 * rtt->rttvar + ABS(delta)) / 4;
+        /* SRTT <- 7/8 * SRTT + 1/8 * R' */
+        rtt->srtt = (7 * rtt->srtt + r) / 8;
+    } else {
+        /* The first measurement */
+        rtt->srtt = r;
+        rtt->rttvar = r / 2;
+    }
+    rtt->rto = MAX(rtt->srtt + 4 * rtt->rttvar,
+        ADAPTIVE_TIMEOUT_MIN_MS * G_TIME_SPAN_MILLISECOND);
+}
+
+static
+void
+nfc_target_rtt_backoff(
+    NfcTargetRtt* rtt,
+    guint max_ms)
+{
+    /*
+     * Back off the timer. The next successful measurement will bring
+     * it back. Note that the timed out request isn't sampled (Karn's
+     * algorithm) because we don't know how long it would've taken.
+     */
+    if (rtt->rto) {
+        rtt->rto = MIN(2 * rtt->rto, (gint64)max_ms * G_TIME_SPAN_MILLISECOND);
+    }
+}
+
+static inline
+void
+nfc_target_timer_set(
+    GSource* source,
+    gint64 deadline)
+{
+    ((NfcTargetTimer*)source)->deadline = deadline;
+}
+
 static
 void
 nfc_target_free_request(
@@ -597,8 +761,9 @@ nfc_target_free_request(
     const NfcTargetRequestType* rt = req->type;
 
     nfc_target_sequence_unref(req->seq);
-    if (req->timeout) {
-        g_source_remove(req->timeout);
+    if (req->deadline) {
+        /* The timer is re-armed when the next request gets submitted */
+        nfc_target_timer_set(req->target->priv->timer, -1);
     }
     if (req->destroy) {
         req->destroy(req->user_data);
@@ -618,42 +783,217 @@ nfc_target_fail_request(
 }
 
 static
-gboolean
+void
 nfc_target_request_timeout(
+    NfcTarget* self)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetRequest* req = priv->req_active;
+
+    /* Only the active request can have the deadline */
+    if (req && req->deadline) {
+        const NfcTargetRequestType* rt = req->type;
+
+        GDEBUG("%s request timed out", rt->name);
+        if (rt->submit == nfc_target_transmit_request_submit) {
+            nfc_target_rtt_backoff(&priv->rtt, priv->tx_timeout_ms);
+            nfc_target_recorder_transmit_done(priv->recorder, req->id,
+                NFC_TRANSMIT_STATUS_TIMEOUT, NULL, 0);
+        }
+        req->deadline = 0;
+        nfc_target_ref(self);
+        priv->req_active = NULL;
+        rt->cancel(req);
+        /* The rest of the batch (if any) has been cancelled too */
+        nfc_target_batch_flush(self, TRUE);
+        rt->timed_out(req);
+        nfc_target_free_request(req);
+        nfc_target_schedule_next_request(self);
+        nfc_target_unref(self);
+    }
+}
+
+static
+gboolean
+nfc_target_timer_prepare(
+    GSource* source,
+    gint* timeout)
+{
+    const gint64 deadline = ((NfcTargetTimer*)source)->deadline;
+
+    if (deadline < 0) {
+        *timeout = -1;
+    } else {
+        const gint64 now = g_source_get_time(source);
+
+        if (now >= deadline) {
+            *timeout = 0;
+            return TRUE;
+        } else {
+            const gint64 ms = (deadline - now + G_TIME_SPAN_MILLISECOND - 1) /
+                G_TIME_SPAN_MILLISECOND;
+
+            *timeout = (gint) MIN(ms, G_MAXINT);
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+nfc_target_timer_check(
+    GSource* source)
+{
+    const gint64 deadline = ((NfcTargetTimer*)source)->deadline;
+
+    return deadline >= 0 && g_source_get_time(source) >= deadline;
+}
+
+static
+gboolean
+nfc_target_timer_dispatch(
+    GSource* source,
+    GSourceFunc callback,
     gpointer user_data)
 {
-    NfcTargetRequest* req = user_data;
-    const NfcTargetRequestType* rt = req->type;
-    NfcTarget* self = nfc_target_ref(req->target);
+    /* Disarm the timer, it stays attached until the target is gone */
+    nfc_target_timer_set(source, -1);
+    nfc_target_request_timeout(THIS(user_data));
+    return G_SOURCE_CONTINUE;
+}
+
+static
+void
+nfc_target_timer_arm(
+    NfcTarget* self,
+    NfcTargetRequest* req,
+    guint ms)
+{
     NfcTargetPriv* priv = self->priv;
 
-    GDEBUG("%s request timed out", rt->name);
-    GASSERT(req->timeout);
-    req->timeout = 0;
+    /*
+     * There's only one active request at any given time, so a single
+     * timer per target is enough. It gets created once and then simply
+     * re-armed for each request, which is a lot cheaper than creating
+     * and destroying a timeout source per request.
+     */
+    if (!priv->timer) {
+        static GSourceFuncs nfc_target_timer_funcs = {
+            nfc_target_timer_prepare,
+            nfc_target_timer_check,
+            nfc_target_timer_dispatch,
+            NULL
+        };
+
+        priv->timer = g_source_new(&nfc_target_timer_funcs,
+            sizeof(NfcTargetTimer));
+        nfc_target_timer_set(priv->timer, -1);
+        g_source_set_callback(priv->timer, NULL, self, NULL);
+        g_source_attach(priv->timer, NULL);
+    }
+    req->deadline = g_source_get_time(priv->timer) +
+        (gint64)ms * G_TIME_SPAN_MILLISECOND;
+    nfc_target_timer_set(priv->timer, req->deadline);
+}
 
-    GASSERT(req == priv->req_active);
-    priv->req_active = NULL;
-    rt->cancel(req);
-    rt->timed_out(req);
-    nfc_target_free_request(req);
-    nfc_target_schedule_next_request(self);
-    nfc_target_unref(self);
-    return G_SOURCE_REMOVE;
+static
+void
+nfc_target_run_queue_append(
+    NfcTargetRunQueue* queue,
+    NfcTargetRunEntry* entry)
+{
+    entry->next = NULL;
+    if ((entry->prev = queue->last) != NULL) {
+        queue->last->next = entry;
+    } else {
+        GASSERT(!queue->first);
+        queue->first = entry;
+    }
+    queue->last = entry;
+}
+
+static
+void
+nfc_target_run_queue_remove(
+    NfcTargetRunQueue* queue,
+    NfcTargetRunEntry* entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        GASSERT(queue->first == entry);
+        queue->first = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        GASSERT(queue->last == entry);
+        queue->last = entry->prev;
+    }
+    entry->next = entry->prev = NULL;
 }
 
 static
 void
 nfc_target_transmit_queue_req(
-    NfcTargetRequestQueue* queue,
+    NfcTarget* self,
     NfcTargetRequest* req)
 {
-    if (queue->last) {
-        queue->last->next = req;
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetSequence* seq = req->seq;
+
+    if (seq) {
+        NfcTargetRequestQueue* queue = &seq->req_queue;
+
+        req->next = NULL;
+        if ((req->prev = queue->last) != NULL) {
+            queue->last->next = req;
+        } else {
+            /* The sequence becomes runnable */
+            GASSERT(!queue->first);
+            queue->first = req;
+            nfc_target_run_queue_append(&priv->run_queue, &seq->entry);
+        }
+        queue->last = req;
     } else {
-        GASSERT(!queue->first);
-        queue->first = req;
+        nfc_target_run_queue_append(&priv->run_queue, &req->entry);
+    }
+    g_hash_table_insert(priv->req_table, GUINT_TO_POINTER(req->id), req);
+}
+
+static
+void
+nfc_target_transmit_unlink_req(
+    NfcTarget* self,
+    NfcTargetRequest* req)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetSequence* seq = req->seq;
+
+    if (seq) {
+        NfcTargetRequestQueue* queue = &seq->req_queue;
+
+        if (req->prev) {
+            req->prev->next = req->next;
+        } else {
+            GASSERT(queue->first == req);
+            queue->first = req->next;
+        }
+        if (req->next) {
+            req->next->prev = req->prev;
+        } else {
+            GASSERT(queue->last == req);
+            queue->last = req->prev;
+        }
+        req->next = req->prev = NULL;
+        if (!queue->first) {
+            /* Nothing left to run in this sequence */
+            nfc_target_run_queue_remove(&priv->run_queue, &seq->entry);
+        }
+    } else {
+        nfc_target_run_queue_remove(&priv->run_queue, &req->entry);
     }
-    queue->last = req;
+    g_hash_table_remove(priv->req_table, GUINT_TO_POINTER(req->id));
 }
 
 static
@@ -662,37 +1002,166 @@ nfc_target_transmit_dequeue_req(
     NfcTarget* self)
 {
     NfcTargetPriv* priv = self->priv;
-    NfcTargetRequestQueue* queue = &priv->req_queue;
-    NfcTargetRequest* req = queue->first;
     NfcTargetSequence* seq = self->sequence;
+    NfcTargetRequest* req = NULL;
+
+    if (seq) {
+        /* Only requests associated with the active sequence can run */
+        req = seq->req_queue.first;
+    } else {
+        NfcTargetRunEntry* entry = priv->run_queue.first;
 
+        if (entry) {
+            req = entry->seq ? entry->seq->req_queue.first :
+                G_CAST(entry, NfcTargetRequest, entry);
+        }
+    }
     if (req) {
-        if (!seq || req->seq == seq) {
-            if (!(queue->first = req->next)) {
-                queue->last = NULL;
-            }
-            req->next = NULL;
+        nfc_target_transmit_unlink_req(self, req);
+    }
+    return req;
+}
+
+static
+void
+nfc_target_transmit_requeue_req(
+    NfcTarget* self,
+    NfcTargetRequest* req)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetRequestQueue* queue = &req->seq->req_queue;
+
+    /* Puts the request back to the head of its sequence queue */
+    req->prev = NULL;
+    if ((req->next = queue->first) != NULL) {
+        queue->first->prev = req;
+    } else {
+        GASSERT(!queue->last);
+        queue->last = req;
+        nfc_target_run_queue_append(&priv->run_queue, &req->seq->entry);
+    }
+    queue->first = req;
+    g_hash_table_insert(priv->req_table, GUINT_TO_POINTER(req->id), req);
+}
+
+/*
+ * Frames submitted as a batch stay in priv->batch until the controller
+ * gets to them. The head of the batch becomes the active request when
+ * the previous frame completes, and only then its timer starts ticking.
+ */
+
+static
+void
+nfc_target_batch_append(
+    NfcTargetRequestQueue* batch,
+    NfcTargetRequest* req)
+{
+    req->next = NULL;
+    if ((req->prev = batch->last) != NULL) {
+        batch->last->next = req;
+    } else {
+        batch->first = req;
+    }
+    batch->last = req;
+}
+
+static
+NfcTargetRequest*
+nfc_target_batch_pop(
+    NfcTargetRequestQueue* batch)
+{
+    NfcTargetRequest* req = batch->first;
+
+    if (req) {
+        if ((batch->first = req->next) != NULL) {
+            batch->first->prev = NULL;
         } else {
-            NfcTargetRequest* prev = req;
-
-            /* Scan the queue */
-            req = req->next;
-            while (req) {
-                if (!seq || req->seq == seq) {
-                    if (!(prev->next = req->next)) {
-                        queue->last = prev;
-                    }
-                    req->next = NULL;
-                    break;
-                }
-                prev = req;
-                req = req->next;
-            }
+            batch->last = NULL;
         }
+        req->next = NULL;
     }
     return req;
 }
 
+static
+void
+nfc_target_batch_flush(
+    NfcTarget* self,
+    gboolean requeue)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetRequestQueue* batch = &priv->batch;
+    NfcTargetRequest* req;
+
+    /*
+     * The frames never made it through. Either put them back to the
+     * queue (in the original order) or fail them. Cancelled requests
+     * have nobody waiting for them and are simply dropped.
+     */
+    while ((req = batch->last) != NULL) {
+        if ((batch->last = req->prev) != NULL) {
+            batch->last->next = NULL;
+        } else {
+            batch->first = NULL;
+        }
+        req->prev = NULL;
+        if (requeue || req->cancelled) {
+            nfc_target_recorder_transmit_cancel(priv->recorder, req->id);
+        } else {
+            nfc_target_recorder_transmit_done(priv->recorder, req->id,
+                NFC_TRANSMIT_STATUS_ERROR, NULL, 0);
+        }
+        if (req->cancelled) {
+            nfc_target_free_request(req);
+        } else if (requeue) {
+            nfc_target_transmit_requeue_req(self, req);
+        } else {
+            nfc_target_fail_request(req);
+        }
+    }
+}
+
+static
+gboolean
+nfc_target_transmit_batch(
+    NfcTarget* self,
+    NfcTargetRequest* req)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetRequestQueue* queue = &req->seq->req_queue;
+    NfcTargetRequest* next;
+    GBytes* frames[TRANSMIT_BATCH_MAX];
+    guint n = 0;
+
+    GASSERT(!priv->batch.first);
+    frames[n++] = nfc_target_transmit_request_bytes
+        (nfc_target_transmit_request_cast(req));
+
+    /*
+     * The rest of the batch has to be in place before the frames get
+     * submitted, the completion may be signaled synchronously.
+     */
+    while (n < TRANSMIT_BATCH_MAX && (next = queue->first) != NULL &&
+        next->type->submit == req->type->submit) {
+        NfcTargetTransmitRequest* tx = nfc_target_transmit_request_cast(next);
+
+        nfc_target_transmit_unlink_req(self, next);
+        nfc_target_batch_append(&priv->batch, next);
+        frames[n++] = nfc_target_transmit_request_bytes(tx);
+        nfc_target_recorder_transmit(priv->recorder, next->id,
+            tx->data, tx->len);
+    }
+
+    if (GET_THIS_CLASS(self)->transmit_batch(self, frames, n)) {
+        GDEBUG("Submitted %u frames", n);
+        return TRUE;
+    } else {
+        /* Only the first request fails, the rest will be retried */
+        nfc_target_batch_flush(self, TRUE);
+        return FALSE;
+    }
+}
+
 static
 gboolean
 nfc_target_submit_request(
@@ -701,12 +1170,21 @@ nfc_target_submit_request(
 {
     NfcTargetPriv* priv = self->priv;
     const NfcTargetRequestType* rt = req->type;
+    const gboolean submitting = priv->submitting;
+    gboolean submitted;
 
     priv->req_active = req;
     if (!self->sequence && req->seq) {
         nfc_target_set_sequence(self, req->seq);
     }
-    if (rt->submit(req)) {
+
+    /* Completion may be signaled from inside the submit callback */
+    req->started = g_get_monotonic_time();
+    priv->submitting = TRUE;
+    submitted = rt->submit(req);
+    priv->submitting = submitting;
+
+    if (submitted) {
         /*
          * If the target goes away during submission of the request, the
          * request is already completed and freed by now (but we still
@@ -716,9 +1194,8 @@ nfc_target_submit_request(
             const guint ms = rt->timeout_ms(req);
 
             if (ms) {
-                GASSERT(!req->timeout);
-                req->timeout = g_timeout_add(ms,
-                    nfc_target_request_timeout, req);
+                GASSERT(!req->deadline);
+                nfc_target_timer_arm(self, req, ms);
             }
         }
         return TRUE;
@@ -731,7 +1208,8 @@ nfc_target_submit_request(
 static
 void
 nfc_target_submit_next_request(
-    NfcTarget* self)
+    NfcTarget* self,
+    guint* count)
 {
     NfcTargetPriv* priv = self->priv;
 
@@ -741,7 +1219,15 @@ nfc_target_submit_next_request(
         nfc_target_ref(self);
         while (req) {
             if (nfc_target_submit_request(self, req)) {
-                /* Request submitted, wait for completion */
+                /*
+                 * Request submitted, wait for completion. The dispatch
+                 * counter (if any) only counts actual submissions, the
+                 * queue may turn out to be empty or blocked by the
+                 * active sequence by the time we get here.
+                 */
+                if (count) {
+                    (*count)++;
+                }
                 nfc_target_unref(self);
                 return;
             }
@@ -761,7 +1247,7 @@ nfc_target_next_transmit(
     NfcTargetPriv* priv = self->priv;
 
     priv->continue_id = 0;
-    nfc_target_submit_next_request(self);
+    nfc_target_submit_next_request(self, &priv->dispatch_stats.idle);
     return G_SOURCE_REMOVE;
 }
 
@@ -772,18 +1258,42 @@ nfc_target_schedule_next_request(
 {
     NfcTargetPriv* priv = self->priv;
 
-    if (priv->req_queue.first && !priv->continue_id) {
+    if (priv->run_queue.first && !priv->continue_id) {
         priv->continue_id = g_idle_add(nfc_target_next_transmit, self);
     }
 }
 
+static
+void
+nfc_target_dispatch_next_request(
+    NfcTarget* self)
+{
+    NfcTargetPriv* priv = self->priv;
+
+    /*
+     * Submitting the next request right away is only safe if we are
+     * not inside the transmit callback, otherwise the implementation
+     * may get re-entered and the stack may grow with each request.
+     */
+    if (priv->dispatch_mode == NFC_TARGET_DISPATCH_SYNC &&
+        !priv->submitting && !priv->req_active && priv->run_queue.first) {
+        if (priv->continue_id) {
+            g_source_remove(priv->continue_id);
+            priv->continue_id = 0;
+        }
+        nfc_target_submit_next_request(self, &priv->dispatch_stats.sync);
+    } else {
+        nfc_target_schedule_next_request(self);
+    }
+}
+
 static
 void
 nfc_target_fail_requests(
     NfcTarget* self)
 {
     NfcTargetPriv* priv = self->priv;
-    NfcTargetRequestQueue* queue = &priv->req_queue;
+    NfcTargetRunQueue* queue = &priv->run_queue;
 
     if (priv->req_active) {
         NfcTargetRequest* req = priv->req_active;
@@ -791,14 +1301,19 @@ nfc_target_fail_requests(
 
         priv->req_active = NULL;
         rt->cancel(req);
+        if (rt->submit == nfc_target_transmit_request_submit) {
+            nfc_target_recorder_transmit_done(priv->recorder, req->id,
+                NFC_TRANSMIT_STATUS_ERROR, NULL, 0);
+        }
         nfc_target_fail_request(req);
     }
+    nfc_target_batch_flush(self, FALSE);
     while (queue->first) {
-        NfcTargetRequest* req = queue->first;
+        NfcTargetRunEntry* entry = queue->first;
+        NfcTargetRequest* req = entry->seq ? entry->seq->req_queue.first :
+            G_CAST(entry, NfcTargetRequest, entry);
 
-        if (!(queue->first = req->next)) {
-            queue->last = NULL;
-        }
+        nfc_target_transmit_unlink_req(self, req);
         nfc_target_fail_request(req);
     }
 }
@@ -850,6 +1365,41 @@ nfc_target_generate_id(
     return id;
 }
 
+static
+guint
+nfc_target_transmit_request_submit_or_queue(
+    NfcTarget* self,
+    NfcTargetTransmitRequest* tx)
+{
+    NfcTargetPriv* priv = self->priv;
+    NfcTargetRequest* req = &tx->request;
+
+    /* Request id to return */
+    guint id = req->id;
+
+    /* Check if the request can be submitted right away */
+    if (!priv->req_active && (req->seq == self->sequence)) {
+        /*
+         * The data will be copied by the transmit method, no need
+         * to make another copy and attach it to the request.
+         */
+        if (!nfc_target_submit_request(self, req)) {
+            nfc_target_set_sequence(self, NULL);
+            id = 0;
+            req->destroy = NULL;
+            nfc_target_free_request(req);
+        }
+    } else {
+        /*
+         * Can't pass the data pointer to the transmit implementation
+         * right away, make a copy (unless we already have one).
+         */
+        nfc_target_transmit_request_bytes(tx);
+        nfc_target_transmit_queue_req(self, req);
+    }
+    return id;
+}
+
 guint
 nfc_target_transmit(
     NfcTarget* self,
@@ -860,39 +1410,24 @@ nfc_target_transmit(
     GDestroyNotify destroy,
     void* user_data)
 {
-    guint id = 0;
-
-    if (G_LIKELY(self)) {
-        NfcTargetPriv* priv = self->priv;
-        NfcTargetTransmitRequest* tx = nfc_target_transmit_request_new(self,
-            data, len, seq, complete, destroy, user_data);
-        NfcTargetRequest* req = &tx->request;
-
-        /* Request id to return */
-        id = req->id;
+    return G_LIKELY(self) ? nfc_target_transmit_request_submit_or_queue(self,
+        nfc_target_transmit_request_new(self, data, len, NULL, seq,
+            complete, destroy, user_data)) : 0;
+}
 
-        /* Check if the request can be submitted right away */
-        if (!priv->req_active && (req->seq == self->sequence)) {
-            /*
-             * The data will be copied by the transmit method, no need
-             * to make another copy and attach it to the request.
-             */
-            if (!nfc_target_submit_request(self, req)) {
-                nfc_target_set_sequence(self, NULL);
-                id = 0;
-                req->destroy = NULL;
-                nfc_target_free_request(req);
-            }
-        } else {
-            /*
-             * Can't pass the data pointer to the transmit implementation
-             * right away, make a copy.
-             */
-            tx->data = tx->copied_data = gutil_memdup(data, len);
-            nfc_target_transmit_queue_req(&priv->req_queue, req);
-        }
-    }
-    return id;
+guint
+nfc_target_transmit_bytes(
+    NfcTarget* self,
+    GBytes* bytes,
+    NfcTargetSequence* seq,
+    NfcTargetTransmitFunc complete,
+    GDestroyNotify destroy,
+    void* user_data) /* Since 1.2.8 */
+{
+    return (G_LIKELY(self) && G_LIKELY(bytes)) ?
+        nfc_target_transmit_request_submit_or_queue(self,
+            nfc_target_transmit_request_new(self, NULL, 0, bytes, seq,
+                complete, destroy, user_data)) : 0;
 }
 
 gboolean
@@ -904,51 +1439,53 @@ nfc_target_cancel_transmit(
         NfcTargetPriv* priv = self->priv;
         NfcTargetRequest* req = priv->req_active;
 
-        if (req && req->id == id) {
+        if (req && priv->batch.first) {
+            /*
+             * Individual frames can't be pulled back from the batch.
+             * Just make sure that nobody gets notified, the request
+             * stays where it is until the controller gets to it.
+             */
+            NfcTargetRequest* batched = req;
+
+            if (batched->id != id) {
+                batched = priv->batch.first;
+                while (batched && batched->id != id) {
+                    batched = batched->next;
+                }
+            }
+            if (batched && !batched->cancelled) {
+                const NfcTargetRequestType* rt = batched->type;
+                GDestroyNotify destroy = batched->destroy;
+
+                batched->cancelled = TRUE;
+                batched->destroy = NULL;
+                rt->abandon(batched);
+                if (destroy) {
+                    destroy(batched->user_data);
+                }
+                return TRUE;
+            }
+        }
+        if (req && req->id == id && !req->cancelled) {
             const NfcTargetRequestType* rt = req->type;
 
             priv->req_active = NULL;
+            if (rt->submit == nfc_target_transmit_request_submit) {
+                nfc_target_recorder_transmit_cancel(priv->recorder, id);
+            }
             rt->abandon(req);
             rt->cancel(req);
             nfc_target_free_request(req);
             nfc_target_schedule_next_request(self);
             return TRUE;
-        } else {
-            NfcTargetRequestQueue* queue = &priv->req_queue;
-
-            req = queue->first;
-            if (req) {
-                if (req->id == id) {
-                    const NfcTargetRequestType* rt = req->type;
-
-                    /* The first queued request is cancelled */
-                    rt->abandon(req);
-                    if (!(queue->first = req->next)) {
-                        queue->last = NULL;
-                    }
-                    nfc_target_free_request(req);
-                    return TRUE;
-                } else {
-                    NfcTargetRequest* prev = req;
-
-                    /* Scan the queue */
-                    req = req->next;
-                    while (req) {
-                        if (req->id == id) {
-                            const NfcTargetRequestType* rt = req->type;
-
-                            rt->abandon(req);
-                            if (!(prev->next = req->next)) {
-                                queue->last = prev;
-                            }
-                            nfc_target_free_request(req);
-                            return TRUE;
-                        }
-                        prev = req;
-                        req = req->next;
-                    }
-                }
-            }
+        } else if ((req = g_hash_table_lookup(priv->req_table,
+            GUINT_TO_POINTER(id))) != NULL) {
+            const NfcTargetRequestType* rt = req->type;
+
+            rt->abandon(req);
+            nfc_target_transmit_unlink_req(self, req);
+            nfc_target_free_request(req);
+            return TRUE;
         }
     }
     return FALSE;
@@ -975,6 +1512,44 @@ nfc_target_set_transmit_timeout(
     }
 }
 
+void
+nfc_target_set_dispatch_mode(
+    NfcTarget* self,
+    NFC_TARGET_DISPATCH_MODE mode) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        NfcTargetPriv* priv = self->priv;
+
+        if (priv->dispatch_mode != mode) {
+            priv->dispatch_mode = mode;
+            GDEBUG("%s dispatch", (mode == NFC_TARGET_DISPATCH_SYNC) ?
+                "Synchronous" : "Idle");
+        }
+    }
+}
+
+void
+nfc_target_set_adaptive_timeout(
+    NfcTarget* self,
+    gboolean enable) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        NfcTargetPriv* priv = self->priv;
+
+        if (priv->adaptive_timeout != enable) {
+            priv->adaptive_timeout = enable;
+            GDEBUG("Adaptive transmission timeout %s", enable ? "on" : "off");
+        }
+    }
+}
+
+const NfcTargetDispatchStats*
+nfc_target_dispatch_stats(
+    NfcTarget* self) /* Since 1.2.8 */
+{
+    return G_LIKELY(self) ? &self->priv->dispatch_stats : NULL;
+}
+
 void
 nfc_target_deactivate(
     NfcTarget* self)
@@ -1008,8 +1583,8 @@ nfc_target_reactivate(
             NfcTargetRequest* req = nfc_target_reactivate_request_new(self,
                 seq, func, destroy, user_data);
 
-            nfc_target_transmit_queue_req(&priv->req_queue, req);
-            nfc_target_submit_next_request(self);
+            nfc_target_transmit_queue_req(self, req);
+            nfc_target_submit_next_request(self, NULL);
             return TRUE;
         }
     }
@@ -1026,6 +1601,13 @@ nfc_target_set_reactivate_timeout(
     }
 }
 
+guint
+nfc_target_max_frame_size(
+    NfcTarget* self)
+{
+    return G_LIKELY(self) ? self->priv->max_frame_size : 0;
+}
+
 gulong
 nfc_target_add_sequence_handler(
     NfcTarget* self,
@@ -1069,6 +1651,31 @@ nfc_target_remove_handlers(
  * Internal interface
  *==========================================================================*/
 
+gboolean
+nfc_target_set_recorder(
+    NfcTarget* self,
+    NfcTargetRecorder* recorder)
+{
+    NfcTargetPriv* priv = self->priv;
+
+    if (recorder && priv->recorder) {
+        return FALSE;
+    } else {
+        priv->recorder = recorder;
+        return TRUE;
+    }
+}
+
+void
+nfc_target_set_max_frame_size(
+    NfcTarget* self,
+    guint size) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        self->priv->max_frame_size = size;
+    }
+}
+
 void
 nfc_target_reactivated(
     NfcTarget* self)
@@ -1107,10 +1714,36 @@ nfc_target_transmit_done(
             const NfcTargetRequestType* rt = req->type;
 
             nfc_target_ref(self);
-            priv->req_active = NULL;
+            if (rt->submit == nfc_target_transmit_request_submit) {
+                nfc_target_recorder_transmit_done(priv->recorder, req->id,
+                    status, data, len);
+                if (status != NFC_TRANSMIT_STATUS_TIMEOUT && req->started) {
+                    const gint64 now = g_get_monotonic_time();
+
+                    nfc_target_rtt_sample(&priv->rtt, now - req->started);
+                }
+            }
+
+            /*
+             * The next frame of the batch (if there is one) becomes
+             * active before the completion callback gets invoked, so
+             * that nothing else gets submitted in the meantime.
+             */
+            if ((priv->req_active = nfc_target_batch_pop(&priv->batch))) {
+                priv->req_active->started = g_get_monotonic_time();
+            }
             rt->transmit_done(req, status, data, len);
             nfc_target_free_request(req);
-            nfc_target_schedule_next_request(self);
+            if (!priv->req_active) {
+                nfc_target_dispatch_next_request(self);
+            } else if (!priv->req_active->deadline) {
+                NfcTargetRequest* active = priv->req_active;
+                const guint ms = active->type->timeout_ms(active);
+
+                if (ms) {
+                    nfc_target_timer_arm(self, active, ms);
+                }
+            }
             nfc_target_unref(self);
         }
     }
@@ -1177,6 +1810,7 @@ nfc_target_init(
     self->priv = priv;
     priv->ra_timeout_ms = DEFAULT_REACTIVATION_TIMEOUT_MS;
     priv->tx_timeout_ms = DEFAULT_TRANSMIT_TIMEOUT_MS;
+    priv->req_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 static
@@ -1192,6 +1826,11 @@ nfc_target_dispose(
         priv->continue_id = 0;
     }
     nfc_target_fail_requests(self);
+    if (priv->timer) {
+        g_source_destroy(priv->timer);
+        g_source_unref(priv->timer);
+        priv->timer = NULL;
+    }
     G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
 }
 
@@ -1217,6 +1856,7 @@ nfc_target_finalize(
         seq = next;
     }
     queue->first = queue->last = NULL;
+    g_hash_table_destroy(priv->req_table);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
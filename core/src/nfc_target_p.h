@@ -76,6 +76,12 @@ nfc_target_set_reactivate_timeout(
     guint ms)
     NFCD_INTERNAL;
 
+/* Zero if unknown */
+guint
+nfc_target_max_frame_size(
+    NfcTarget* target)
+    NFCD_INTERNAL;
+
 guint
 nfc_target_generate_id(
     NfcTarget* target)
@@ -98,6 +104,13 @@ nfc_target_sequence_unref(
     NfcTargetSequence* seq)
     NFCD_INTERNAL;
 
+/* Returns FALSE if there's already a recorder attached */
+gboolean
+nfc_target_set_recorder(
+    NfcTarget* target,
+    NfcTargetRecorder* recorder)
+    NFCD_INTERNAL;
+
 #endif /* NFC_TARGET_PRIVATE_H */
 
 /*
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) ARISING
+ * IN ANY WAY OUT OF THE USE OR INABILITY TO USE THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfc_target_recorder_p.h"
+#include "nfc_target_p.h"
+#include "nfc_log.h"
+
+#include <gutil_macros.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+struct nfc_target_recorder {
+    NfcTarget* target;
+    NfcTargetSequence* seq;
+    FILE* out;
+    gint64 last;
+    gulong sequence_id;
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+guint8*
+nfc_target_recorder_put32(
+    guint8* ptr,
+    guint32 value)
+{
+    ptr[0] = (guint8)(value >> 24);
+    ptr[1] = (guint8)(value >> 16);
+    ptr[2] = (guint8)(value >> 8);
+    ptr[3] = (guint8)value;
+    return ptr + 4;
+}
+
+static
+void
+nfc_target_recorder_write(
+    NfcTargetRecorder* self,
+    NFC_TARGET_TRACE_TYPE type,
+    guint8 status,
+    guint id,
+    const void* data,
+    guint len)
+{
+    if (self->out) {
+        const gint64 now = g_get_monotonic_time();
+        guint8 rec[NFC_TARGET_TRACE_RECORD_SIZE];
+        guint8* ptr = rec;
+
+        *ptr++ = (guint8) type;
+        *ptr++ = status;
+        ptr = nfc_target_recorder_put32(ptr, id);
+        ptr = nfc_target_recorder_put32(ptr, len);
+        nfc_target_recorder_put32(ptr, (guint32) MIN(now - self->last,
+            G_MAXUINT32));
+        self->last = now;
+        if (fwrite(rec, sizeof(rec), 1, self->out) != 1 ||
+            (len && fwrite(data, len, 1, self->out) != 1)) {
+            GWARN("Failed to write NFC trace: %s", strerror(errno));
+            fclose(self->out);
+            self->out = NULL;
+        }
+    }
+}
+
+static
+void
+nfc_target_recorder_sequence_changed(
+    NfcTarget* target,
+    void* user_data)
+{
+    NfcTargetRecorder* self = user_data;
+    NfcTargetSequence* seq = target->sequence;
+
+    /* Sequence pointer is only compared, never dereferenced */
+    if (self->seq != seq) {
+        if (self->seq) {
+            nfc_target_recorder_write(self, NFC_TARGET_TRACE_SEQUENCE_END,
+                0, 0, NULL, 0);
+        }
+        if ((self->seq = seq) != NULL) {
+            nfc_target_recorder_write(self, NFC_TARGET_TRACE_SEQUENCE_START,
+                0, 0, NULL, 0);
+        }
+    }
+}
+
+static
+void
+nfc_target_recorder_target_finalized(
+    gpointer user_data,
+    GObject* dead_target)
+{
+    NfcTargetRecorder* self = user_data;
+
+    GDEBUG("Target is gone, recording stopped");
+    self->target = NULL;
+    self->sequence_id = 0;
+    if (self->out) {
+        fflush(self->out);
+    }
+}
+
+/*==========================================================================*
+ * Internal interface
+ *==========================================================================*/
+
+void
+nfc_target_recorder_transmit(
+    NfcTargetRecorder* self,
+    guint id,
+    const void* data,
+    guint len)
+{
+    if (self) {
+        nfc_target_recorder_write(self, NFC_TARGET_TRACE_TRANSMIT, 0, id,
+            data, len);
+    }
+}
+
+void
+nfc_target_recorder_transmit_done(
+    NfcTargetRecorder* self,
+    guint id,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len)
+{
+    if (self) {
+        nfc_target_recorder_write(self, NFC_TARGET_TRACE_RESPONSE, status, id,
+            data, len);
+    }
+}
+
+void
+nfc_target_recorder_transmit_cancel(
+    NfcTargetRecorder* self,
+    guint id)
+{
+    if (self) {
+        nfc_target_recorder_write(self, NFC_TARGET_TRACE_CANCEL, 0, id,
+            NULL, 0);
+    }
+}
+
+/*==========================================================================*
+ * Interface
+ *==========================================================================*/
+
+NfcTargetRecorder*
+nfc_target_recorder_new(
+    NfcTarget* target,
+    const char* path) /* Since 1.2.8 */
+{
+    if (G_LIKELY(target) && G_LIKELY(path)) {
+        NfcTargetRecorder* self = g_slice_new0(NfcTargetRecorder);
+
+        if (nfc_target_set_recorder(target, self)) {
+            FILE* out = fopen(path, "wb");
+
+            if (out) {
+                guint8 header[NFC_TARGET_TRACE_HEADER_SIZE];
+
+                memcpy(header, NFC_TARGET_TRACE_MAGIC, 4);
+                header[4] = NFC_TARGET_TRACE_VERSION;
+                header[5] = (guint8) target->technology;
+                header[6] = (guint8) target->protocol;
+                header[7] = 0;
+                if (fwrite(header, sizeof(header), 1, out) == 1) {
+                    GDEBUG("Recording NFC trace to %s", path);
+                    self->out = out;
+                    self->target = target;
+                    self->last = g_get_monotonic_time();
+                    self->sequence_id = nfc_target_add_sequence_handler(target,
+                        nfc_target_recorder_sequence_changed, self);
+                    nfc_target_recorder_sequence_changed(target, self);
+                    g_object_weak_ref(G_OBJECT(target),
+                        nfc_target_recorder_target_finalized, self);
+                    return self;
+                }
+                fclose(out);
+            }
+            GWARN("Failed to open %s: %s", path, strerror(errno));
+            nfc_target_set_recorder(target, NULL);
+        }
+        g_slice_free(NfcTargetRecorder, self);
+    }
+    return NULL;
+}
+
+void
+nfc_target_recorder_free(
+    NfcTargetRecorder* self) /* Since 1.2.8 */
+{
+    if (G_LIKELY(self)) {
+        NfcTarget* target = self->target;
+
+        if (target) {
+            nfc_target_remove_handler(target, self->sequence_id);
+            nfc_target_set_recorder(target, NULL);
+            g_object_weak_unref(G_OBJECT(target),
+                nfc_target_recorder_target_finalized, self);
+        }
+        if (self->out) {
+            fclose(self->out);
+        }
+        g_slice_free(NfcTargetRecorder, self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -50,7 +50,9 @@
 typedef struct nfc_llc NfcLlc;
 typedef struct nfc_llc_io NfcLlcIo;
 typedef struct nfc_llc_param NfcLlcParam;
+typedef struct nfc_llc_queue NfcLlcQueue;
 typedef struct nfc_peer_services NfcPeerServices;
+typedef struct nfc_tag_t2_cache NfcTagType2Cache;
 
 /*
  * SAP:
@@ -75,12 +77,22 @@ typedef struct nfc_peer_services NfcPeerServices;
 #define ISO_MF (0x3F00)
 
 #define ISO_CLA (0x00) /* Basic channel */
+#define ISO_CLA_CHAIN (0x10) /* Command chaining (not the last command) */
+#define ISO_CLA_PROPRIETARY (0x80) /* Proprietary class */
+#define ISO_CLA_CHANNEL_MASK (0x03) /* Logical channel number */
 
 #define ISO_SHORT_FID_MASK (0x1f) /* Short File ID mask */
+#define ISO_P1_SHORT_FID (0x80) /* P1 of BINARY commands contains SFI */
 
 /* Instruction byte */
 #define ISO_INS_SELECT (0xA4)
 #define ISO_INS_READ_BINARY (0xB0)
+#define ISO_INS_READ_RECORD (0xB2)
+#define ISO_INS_GET_RESPONSE (0xC0)
+#define ISO_INS_WRITE_BINARY (0xD0)
+#define ISO_INS_UPDATE_BINARY (0xD6)
+#define ISO_INS_UPDATE_RECORD (0xDC)
+#define ISO_INS_APPEND_RECORD (0xE2)
 
 /* Selection by file identifier */
 #define ISO_P1_SELECT_BY_ID (0x00)      /* Select MF, DF or EF */
@@ -98,6 +98,10 @@ nfc_hexdump_data(
  *
  * LE, LE1, LE2 may be 0x00, 0x00|0x00 (means the maximum, 256 or 65536)
  * LC must not be 0x00 and LC1|LC2 must not be 0x00|0x00
+ *
+ * Short and extended length fields can't be mixed in the same APDU.
+ * If either LC or LE doesn't fit into a single byte, both are encoded
+ * in the extended form.
  */
 
 gboolean
@@ -108,13 +112,15 @@ nfc_apdu_encode(
     const GUtilData* data = &apdu->data;
 
     if (data->size <= 0xffff && apdu->le <= 0x10000) {
+        const gboolean ext = (data->size > 0xff || apdu->le > 0x100);
+
         g_byte_array_set_size(buf, 4);
         buf->data[0] = apdu->cla;
         buf->data[1] = apdu->ins;
         buf->data[2] = apdu->p1;
         buf->data[3] = apdu->p2;
         if (data->size > 0) {
-            if (data->size <= 0xff) {
+            if (!ext) {
                 /* Cases 3s and 4s */
                 guint8 lc = (guint8) data->size;
 
@@ -131,7 +137,7 @@ nfc_apdu_encode(
             g_byte_array_append(buf, data->bytes, (guint) data->size);
         }
         if (apdu->le > 0) {
-            if (apdu->le <= 0x100 && data->size <= 0xff) {
+            if (!ext) {
                 /* Cases 2s and 4s */
                 guint8 le = (apdu->le == 0x100) ? 0 : ((guint8) apdu->le);
 
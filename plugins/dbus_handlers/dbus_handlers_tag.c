@@ -38,21 +38,63 @@ struct dbus_handlers_tag {
     NfcTag* tag;
     DBusHandlers* handlers;
     gulong init_id;
+    gulong ndef_id;
 };
 
 static
 void
-dbus_handlers_tag_initialized(
+dbus_handlers_tag_run(
     DBusHandlersTag* self)
 {
     NfcTag* tag = self->tag;
 
-    GDEBUG("%s is initialized", tag->name);
     if (tag->ndef) {
         dbus_handlers_run(self->handlers, tag->ndef);
     }
 }
 
+static
+void
+dbus_handlers_tag_initialized(
+    DBusHandlersTag* self)
+{
+    NfcTag* tag = self->tag;
+
+    GDEBUG("%s is initialized", tag->name);
+    dbus_handlers_tag_run(self);
+}
+
+static
+void
+dbus_handlers_tag_read_ndef(
+    DBusHandlersTag* self)
+{
+    NfcTag* tag = self->tag;
+
+    /*
+     * The handlers need the records, and the tag won't read them
+     * by itself once a client has started talking to it. They get
+     * run by the NDEF ready handler (possibly before this returns).
+     */
+    GDEBUG("Requesting %s NDEF", tag->name);
+    nfc_tag_read_ndef(tag);
+}
+
+static
+void
+dbus_handlers_tag_ndef_ready(
+    NfcTag* tag,
+    void* user_data)
+{
+    DBusHandlersTag* self = user_data;
+
+    nfc_tag_remove_handler(self->tag, self->ndef_id);
+    self->ndef_id = 0;
+
+    GDEBUG("%s NDEF is ready", tag->name);
+    dbus_handlers_tag_run(self);
+}
+
 static
 void
 dbus_handlers_tag_initialized_event(
@@ -64,7 +106,11 @@ dbus_handlers_tag_initialized_event(
     nfc_tag_remove_handler(self->tag, self->init_id);
     self->init_id = 0;
 
-    dbus_handlers_tag_initialized(self);
+    if (tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED) {
+        dbus_handlers_tag_read_ndef(self);
+    } else {
+        dbus_handlers_tag_initialized(self);
+    }
 }
 
 /*==========================================================================*
@@ -80,11 +126,15 @@ dbus_handlers_tag_new(
 
     self->handlers = handlers;
     self->tag = nfc_tag_ref(tag);
-    if (tag->flags & NFC_TAG_FLAG_INITIALIZED) {
-        dbus_handlers_tag_initialized(self);
-    } else {
+    self->ndef_id = nfc_tag_add_ndef_ready_handler(tag,
+        dbus_handlers_tag_ndef_ready, self);
+    if (!(tag->flags & NFC_TAG_FLAG_INITIALIZED)) {
         self->init_id = nfc_tag_add_initialized_handler(tag,
             dbus_handlers_tag_initialized_event, self);
+    } else if (tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED) {
+        dbus_handlers_tag_read_ndef(self);
+    } else {
+        dbus_handlers_tag_initialized(self);
     }
     return self;
 }
@@ -95,6 +145,7 @@ dbus_handlers_tag_free(
 {
     if (self) {
         nfc_tag_remove_handler(self->tag, self->init_id);
+        nfc_tag_remove_handler(self->tag, self->ndef_id);
         nfc_tag_unref(self->tag);
         g_free(self);
     }
@@ -47,6 +47,7 @@
 
 enum {
     TAG_INITIALIZED,
+    TAG_NDEF_READY,
     TAG_GONE,
     TAG_EVENT_COUNT
 };
@@ -200,6 +201,36 @@ dbus_neard_tag_unexport(
     }
 }
 
+static
+void
+dbus_neard_tag_handle_ndef(
+    DBusNeardTag* self)
+{
+    NfcTag* tag = self->tag;
+
+    dbus_neard_tag_export_records(self);
+    if (tag->ndef) {
+        dbus_neard_manager_handle_ndef(self->agent_manager, tag->ndef);
+    }
+}
+
+static
+void
+dbus_neard_tag_read_ndef(
+    DBusNeardTag* self)
+{
+    NfcTag* tag = self->tag;
+
+    /*
+     * The records are exported and passed to the agents, and the tag
+     * won't read them by itself once a client has started talking to
+     * it. They get handled by the NDEF ready handler (possibly before
+     * this returns).
+     */
+    GDEBUG("Requesting %s NDEF", tag->name);
+    nfc_tag_read_ndef(tag);
+}
+
 static
 void
 dbus_neard_tag_initialized(
@@ -210,12 +241,26 @@ dbus_neard_tag_initialized(
 
     /* This callbacks should only be invoked once, but just in case... */
     nfc_tag_remove_handlers(tag, self->tag_event_id + TAG_INITIALIZED, 1);
-    dbus_neard_tag_export_records(self);
-    if (tag->ndef) {
-        dbus_neard_manager_handle_ndef(self->agent_manager, tag->ndef);
+
+    if (tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED) {
+        dbus_neard_tag_read_ndef(self);
+    } else {
+        dbus_neard_tag_handle_ndef(self);
     }
 }
 
+static
+void
+dbus_neard_tag_ndef_ready(
+    NfcTag* tag,
+    void* user_data)
+{
+    DBusNeardTag* self = user_data;
+
+    nfc_tag_remove_handlers(tag, self->tag_event_id + TAG_NDEF_READY, 1);
+    dbus_neard_tag_handle_ndef(self);
+}
+
 static
 void
 dbus_neard_tag_gone(
@@ -303,16 +348,21 @@ dbus_neard_tag_new(
 
     GDEBUG("Created neard D-Bus object for tag %s", self->path);
 
+    self->tag_event_id[TAG_NDEF_READY] = nfc_tag_add_ndef_ready_handler(tag,
+        dbus_neard_tag_ndef_ready, self);
+    self->tag_event_id[TAG_GONE] = nfc_tag_add_gone_handler(tag,
+        dbus_neard_tag_gone, self);
+
     /* Export records now or wait until tag gets initialized */
-    if (tag->flags & NFC_TAG_FLAG_INITIALIZED) {
-        dbus_neard_tag_export_records(self);
-    } else {
+    if (!(tag->flags & NFC_TAG_FLAG_INITIALIZED)) {
         self->tag_event_id[TAG_INITIALIZED] =
             nfc_tag_add_initialized_handler(tag,
                 dbus_neard_tag_initialized, self);
+    } else if (tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED) {
+        dbus_neard_tag_read_ndef(self);
+    } else {
+        dbus_neard_tag_export_records(self);
     }
-    self->tag_event_id[TAG_GONE] = nfc_tag_add_gone_handler(tag,
-        dbus_neard_tag_gone, self);
 
     return self;
 }
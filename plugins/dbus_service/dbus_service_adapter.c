@@ -368,6 +368,7 @@ dbus_service_adapter_get_param_value(
                 /* These are not real ids */
                 break;
             case NFC_ADAPTER_PARAM_T4_NDEF:
+            case NFC_ADAPTER_PARAM_T4_NDEF_LAZY:
                 /* b */
                 var = g_variant_new_boolean(v->b);
                 break;
@@ -448,6 +449,7 @@ dbus_service_adapter_param_request_new(
                 /* These are not real ids */
                 break;
             case NFC_ADAPTER_PARAM_T4_NDEF:
+            case NFC_ADAPTER_PARAM_T4_NDEF_LAZY:
                 /* b */
                 if (g_variant_is_of_type(v, G_VARIANT_TYPE_BOOLEAN)) {
                     p.value.b = g_variant_get_boolean(v);
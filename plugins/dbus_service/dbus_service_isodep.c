@@ -47,6 +47,10 @@ enum {
     CALL_GET_ALL2,
     CALL_GET_ACTIVATION_PARAMETERS,
     CALL_RESET,
+    CALL_TRANSMIT2,
+    CALL_WRITE_NDEF,
+    CALL_SET_SELECT_CACHE,
+    CALL_GET_SELECT_STATS,
     CALL_COUNT
 };
 
@@ -57,7 +61,7 @@ struct dbus_service_isodep {
     gulong call_id[CALL_COUNT];
 };
 
-#define NFC_DBUS_ISODEP_INTERFACE_VERSION  (3)
+#define NFC_DBUS_ISODEP_INTERFACE_VERSION  (6)
 
 typedef struct dbus_service_isodep_async_call {
     OrgSailfishosNfcIsoDep* iface;
@@ -320,6 +324,174 @@ dbus_service_isodep_handle_reset(
     return TRUE;
 }
 
+/* Interface version 4 */
+
+/* Transmit2 */
+
+static
+void
+dbus_service_isodep_handle_transmit2_done(
+    NfcTagType4* tag,
+    guint sw,  /* 16 bits (SW1 << 8)|SW2 */
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    DBusServiceIsoDepAsyncCall* async = user_data;
+
+    if (sw) {
+        GDEBUG("%04X (%u bytes)", sw, len);
+        org_sailfishos_nfc_iso_dep_complete_transmit2(async->iface,
+            async->call, dbus_service_dup_byte_array_as_variant(data, len),
+            sw >> 8, sw & 0xff);
+    } else {
+        GDEBUG("oops");
+        g_dbus_method_invocation_return_error_literal(async->call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+            "APDU command failed");
+    }
+}
+
+static
+gboolean
+dbus_service_isodep_handle_transmit2(
+    OrgSailfishosNfcIsoDep* iface,
+    GDBusMethodInvocation* call,
+    guchar cla,
+    guchar ins,
+    guchar p1,
+    guchar p2,
+    GVariant* data_var,
+    guint le,
+    guint flags,
+    DBusServiceIsoDep* self)
+{
+    GUtilData data;
+    DBusServiceIsoDepAsyncCall* async =
+        dbus_service_isodep_async_call_new(iface, call);
+
+    data.size = g_variant_get_size(data_var);
+    data.bytes = g_variant_get_data(data_var);
+    GDEBUG("%02X %02X %02X %02X (%u bytes) %02X 0x%02x", cla, ins, p1, p2,
+        (guint) data.size, le, flags);
+    if (!nfc_isodep_transmit2(self->t4, cla, ins, p1, p2, &data, le, flags &
+        (NFC_ISODEP_TX_FLAG_GET_RESPONSE | NFC_ISODEP_TX_FLAG_CHAINING),
+        dbus_service_isodep_sequence(self, call),
+        dbus_service_isodep_handle_transmit2_done,
+        dbus_service_isodep_async_call_free1, async)) {
+        dbus_service_isodep_async_call_free(async);
+        g_dbus_method_invocation_return_error_literal(call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+            "Failed to submit APDU");
+    }
+    return TRUE;
+}
+
+/* Interface version 5 */
+
+/* WriteNdef */
+
+static
+void
+dbus_service_isodep_handle_write_ndef_done(
+    NfcTagType4* tag,
+    NFC_TAG_T4_WRITE_STATUS status,
+    void* user_data)
+{
+    DBusServiceIsoDepAsyncCall* async = user_data;
+
+    switch (status) {
+    case NFC_TAG_T4_WRITE_OK:
+        GDEBUG("NDEF written");
+        org_sailfishos_nfc_iso_dep_complete_write_ndef(async->iface,
+            async->call);
+        return;
+    case NFC_TAG_T4_WRITE_NOT_NDEF:
+        g_dbus_method_invocation_return_error_literal(async->call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_NOT_SUPPORTED,
+            "No NDEF Tag Application");
+        return;
+    case NFC_TAG_T4_WRITE_READ_ONLY:
+        g_dbus_method_invocation_return_error_literal(async->call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_ACCESS_DENIED,
+            "NDEF is read-only");
+        return;
+    case NFC_TAG_T4_WRITE_TOO_BIG:
+        g_dbus_method_invocation_return_error_literal(async->call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_INVALID_ARGS,
+            "NDEF doesn't fit");
+        return;
+    case NFC_TAG_T4_WRITE_IO_ERROR:
+    case NFC_TAG_T4_WRITE_FAILURE:
+        break;
+    }
+    GDEBUG("oops");
+    g_dbus_method_invocation_return_error_literal(async->call,
+        DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+        "NDEF write failed");
+}
+
+static
+gboolean
+dbus_service_isodep_handle_write_ndef(
+    OrgSailfishosNfcIsoDep* iface,
+    GDBusMethodInvocation* call,
+    GVariant* data_var,
+    DBusServiceIsoDep* self)
+{
+    GBytes* ndef = g_bytes_new(g_variant_get_data(data_var),
+        g_variant_get_size(data_var));
+    DBusServiceIsoDepAsyncCall* async =
+        dbus_service_isodep_async_call_new(iface, call);
+
+    GDEBUG("Writing %u bytes of NDEF", (guint) g_bytes_get_size(ndef));
+    if (!nfc_tag_t4_write_ndef(self->t4, ndef,
+        dbus_service_isodep_sequence(self, call),
+        dbus_service_isodep_handle_write_ndef_done,
+        dbus_service_isodep_async_call_free1, async)) {
+        dbus_service_isodep_async_call_free(async);
+        g_dbus_method_invocation_return_error_literal(call,
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+            "Failed to write NDEF");
+    }
+    g_bytes_unref(ndef);
+    return TRUE;
+}
+
+/* Interface version 6 */
+
+/* SetSelectCache */
+
+static
+gboolean
+dbus_service_isodep_handle_set_select_cache(
+    OrgSailfishosNfcIsoDep* iface,
+    GDBusMethodInvocation* call,
+    gboolean enabled,
+    DBusServiceIsoDep* self)
+{
+    GDEBUG("SELECT cache %s", enabled ? "on" : "off");
+    nfc_isodep_set_select_cache(self->t4, enabled);
+    org_sailfishos_nfc_iso_dep_complete_set_select_cache(iface, call);
+    return TRUE;
+}
+
+/* GetSelectStats */
+
+static
+gboolean
+dbus_service_isodep_handle_get_select_stats(
+    OrgSailfishosNfcIsoDep* iface,
+    GDBusMethodInvocation* call,
+    DBusServiceIsoDep* self)
+{
+    const NfcIsoDepSelectStats* stats = nfc_isodep_select_stats(self->t4);
+
+    org_sailfishos_nfc_iso_dep_complete_get_select_stats(iface, call,
+        stats->sent, stats->cached);
+    return TRUE;
+}
+
 /*==========================================================================*
  * Interface
  *==========================================================================*/
@@ -367,6 +539,18 @@ dbus_service_isodep_new(
     self->call_id[CALL_RESET] =
         g_signal_connect(self->iface, "handle-reset",
         G_CALLBACK(dbus_service_isodep_handle_reset), self);
+    self->call_id[CALL_TRANSMIT2] =
+        g_signal_connect(self->iface, "handle-transmit2",
+        G_CALLBACK(dbus_service_isodep_handle_transmit2), self);
+    self->call_id[CALL_WRITE_NDEF] =
+        g_signal_connect(self->iface, "handle-write-ndef",
+        G_CALLBACK(dbus_service_isodep_handle_write_ndef), self);
+    self->call_id[CALL_SET_SELECT_CACHE] =
+        g_signal_connect(self->iface, "handle-set-select-cache",
+        G_CALLBACK(dbus_service_isodep_handle_set_select_cache), self);
+    self->call_id[CALL_GET_SELECT_STATS] =
+        g_signal_connect(self->iface, "handle-get-select-stats",
+        G_CALLBACK(dbus_service_isodep_handle_get_select_stats), self);
 
     if (g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
         (self->iface), owner->connection, owner->path, &error)) {
@@ -44,6 +44,7 @@
 
 #include <nfc_core.h>
 #include <nfc_adapter.h>
+#include <nfc_config.h>
 #include <nfc_manager.h>
 #include <nfc_peer_service.h>
 #include <nfc_plugin_impl.h>
@@ -144,6 +145,9 @@ struct dbus_service_plugin {
     OrgSailfishosNfcDaemon* iface;
     gulong event_id[EVENT_COUNT];
     gulong call_id[CALL_COUNT];
+    guint llcp_rw;                /* Zero means the default */
+    guint llcp_miu;               /* Zero means the default */
+    guint llcp_ack_delay;         /* Milliseconds, zero means no delay */
 #ifdef HAVE_DBUSACCESS
     DAPolicy* policy;
 #endif
@@ -154,7 +158,31 @@ struct dbus_service_plugin {
 #define THIS_TYPE dbus_service_plugin_get_type()
 #define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, DBusServicePlugin)
 
-G_DEFINE_TYPE(DBusServicePlugin, dbus_service_plugin, PARENT_TYPE)
+static
+void
+dbus_service_plugin_config_init(
+    NfcConfigurableInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(DBusServicePlugin, dbus_service_plugin, PARENT_TYPE,
+G_IMPLEMENT_INTERFACE(NFC_TYPE_CONFIGURABLE, dbus_service_plugin_config_init))
+
+enum dbus_service_plugin_signal {
+    SIGNAL_CONFIG_VALUE_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_CONFIG_VALUE_CHANGED_NAME "dbus-service-config-value-changed"
+
+static guint dbus_service_plugin_signals[SIGNAL_COUNT] = { 0 };
+
+/*
+ * Configurable LLCP parameters of the peer services registered over D-Bus.
+ * Services created internally (e.g. the built-in SNEP server) aren't
+ * affected.
+ */
+#define DBUS_SERVICE_SETTINGS_KEY_LLCP_RW   "LlcpReceiveWindow"
+#define DBUS_SERVICE_SETTINGS_KEY_LLCP_MIU  "LlcpMIU"
+#define DBUS_SERVICE_SETTINGS_KEY_LLCP_ACK_DELAY "LlcpAckDelay"
 
 #define NFC_BUS         G_BUS_TYPE_SYSTEM
 #define NFC_DA_BUS      DA_BUS_SYSTEM
@@ -422,6 +450,9 @@ dbus_service_plugin_register_local_peer_service(
     if (obj) {
         NfcPeerService* service = &obj->service;
 
+        nfc_peer_service_set_rw(service, self->llcp_rw);
+        nfc_peer_service_set_miu(service, self->llcp_miu);
+        nfc_peer_service_set_ack_delay(service, self->llcp_ack_delay);
         if (nfc_manager_register_service(self->manager, service)) {
             DBusServiceClient* client = dbus_service_plugin_client_get
                 (self, dbus_name);
@@ -1373,6 +1404,158 @@ dbus_service_plugin_handle_release_block(
     return TRUE;
 }
 
+/*==========================================================================*
+ * NfcConfigurable
+ *==========================================================================*/
+
+static
+void
+dbus_service_plugin_apply_llcp_params(
+    DBusServicePlugin* self)
+{
+    if (self->clients) {
+        GHashTableIter it;
+        gpointer value;
+
+        /* Affects the connections created from now on */
+        g_hash_table_iter_init(&it, self->clients);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            DBusServiceClient* client = value;
+
+            if (client->peer_services) {
+                GHashTableIter it2;
+
+                g_hash_table_iter_init(&it2, client->peer_services);
+                while (g_hash_table_iter_next(&it2, NULL, &value)) {
+                    NfcPeerService* service = &((DBusServiceLocal*)
+                        value)->service;
+
+                    nfc_peer_service_set_rw(service, self->llcp_rw);
+                    nfc_peer_service_set_miu(service, self->llcp_miu);
+                    nfc_peer_service_set_ack_delay(service,
+                        self->llcp_ack_delay);
+                }
+            }
+        }
+    }
+}
+
+static
+gboolean
+dbus_service_plugin_config_uint(
+    GVariant* value,
+    guint* out)
+{
+    if (!value) {
+        *out = 0;
+        return TRUE;
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)) {
+        const gint32 i = g_variant_get_int32(value);
+
+        if (i >= 0) {
+            *out = i;
+            return TRUE;
+        }
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+        *out = g_variant_get_uint32(value);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+const char* const*
+dbus_service_plugin_config_get_keys(
+    NfcConfigurable* config)
+{
+    static const char* const dbus_service_plugin_keys[] = {
+        DBUS_SERVICE_SETTINGS_KEY_LLCP_RW,
+        DBUS_SERVICE_SETTINGS_KEY_LLCP_MIU,
+        DBUS_SERVICE_SETTINGS_KEY_LLCP_ACK_DELAY,
+        NULL
+    };
+
+    return dbus_service_plugin_keys;
+}
+
+static
+GVariant*
+dbus_service_plugin_config_get_value(
+    NfcConfigurable* config,
+    const char* key)
+{
+    DBusServicePlugin* self = THIS(config);
+
+    /* OK to return a floating reference */
+    if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_RW)) {
+        return g_variant_new_int32(self->llcp_rw);
+    } else if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_MIU)) {
+        return g_variant_new_int32(self->llcp_miu);
+    } else if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_ACK_DELAY)) {
+        return g_variant_new_int32(self->llcp_ack_delay);
+    } else {
+        return NULL;
+    }
+}
+
+static
+gboolean
+dbus_service_plugin_config_set_value(
+    NfcConfigurable* config,
+    const char* key,
+    GVariant* value)
+{
+    DBusServicePlugin* self = THIS(config);
+    guint* field = NULL;
+    guint newval;
+
+    if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_RW)) {
+        field = &self->llcp_rw;
+    } else if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_MIU)) {
+        field = &self->llcp_miu;
+    } else if (!g_strcmp0(key, DBUS_SERVICE_SETTINGS_KEY_LLCP_ACK_DELAY)) {
+        field = &self->llcp_ack_delay;
+    }
+
+    if (field && dbus_service_plugin_config_uint(value, &newval)) {
+        if (*field != newval) {
+            GDEBUG("%s %u", key, newval);
+            *field = newval;
+            dbus_service_plugin_apply_llcp_params(self);
+            g_signal_emit(self, dbus_service_plugin_signals
+                [SIGNAL_CONFIG_VALUE_CHANGED], g_quark_from_string(key),
+                key, value);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gulong
+dbus_service_plugin_config_add_change_handler(
+    NfcConfigurable* config,
+    const char* key,
+    NfcConfigChangeFunc func,
+    void* user_data)
+{
+    return g_signal_connect_closure_by_id(THIS(config),
+        dbus_service_plugin_signals[SIGNAL_CONFIG_VALUE_CHANGED],
+        key ? g_quark_from_string(key) : 0,
+        g_cclosure_new(G_CALLBACK(func), user_data, NULL), FALSE);
+}
+
+static
+void
+dbus_service_plugin_config_init(
+    NfcConfigurableInterface* iface)
+{
+    iface->get_keys = dbus_service_plugin_config_get_keys;
+    iface->get_value = dbus_service_plugin_config_get_value;
+    iface->set_value = dbus_service_plugin_config_set_value;
+    iface->add_change_handler = dbus_service_plugin_config_add_change_handler;
+}
+
 /*==========================================================================*
  * Name watching
  *==========================================================================*/
@@ -1588,6 +1771,11 @@ dbus_service_plugin_class_init(
     G_OBJECT_CLASS(klass)->finalize = dbus_service_plugin_finalize;
     klass->start = dbus_service_plugin_start;
     klass->stop = dbus_service_plugin_stop;
+    dbus_service_plugin_signals[SIGNAL_CONFIG_VALUE_CHANGED] =
+        g_signal_new(SIGNAL_CONFIG_VALUE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST |
+            G_SIGNAL_DETAILED, 0, NULL, NULL, NULL,
+            G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_VARIANT);
 }
 
 static
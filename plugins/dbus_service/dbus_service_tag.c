@@ -52,6 +52,7 @@ enum {
 
 enum {
     TAG_INITIALIZED,
+    TAG_NDEF_READY,
     TAG_EVENT_COUNT
 };
 
@@ -128,6 +129,7 @@ struct dbus_service_tag_priv {
     GSList* lock_waiters;
     DBusServiceTagLock* lock;
     DBusServiceTagCallQueue queue;
+    DBusServiceTagCallQueue ndef_queue; /* Waiting for deferred NDEF */
     GSList* ndefs;
     gulong target_event_id[TARGET_EVENT_COUNT];
     gulong tag_event_id[TAG_EVENT_COUNT];
@@ -138,7 +140,7 @@ struct dbus_service_tag_priv {
 };
 
 #define NFC_DBUS_TAG_INTERFACE "org.sailfishos.nfc.Tag"
-#define NFC_DBUS_TAG_INTERFACE_VERSION  (5)
+#define NFC_DBUS_TAG_INTERFACE_VERSION  (6)
 
 static const char* const dbus_service_tag_default_interfaces[] = {
     NFC_DBUS_TAG_INTERFACE, NULL
@@ -380,15 +382,13 @@ dbus_service_tag_lock_peer_vanished(
 
 static
 void
-dbus_service_tag_export_all(
+dbus_service_tag_export_ndef(
     DBusServiceTagPriv* self)
 {
     DBusServiceTag* pub = &self->pub;
-    NfcTag* tag = pub->tag;
-    NfcNdefRec* rec = tag->ndef;
-    GPtrArray* interfaces = g_ptr_array_new();
+    NfcNdefRec* rec = pub->tag->ndef;
 
-    /* Export NDEF records */
+    GASSERT(!self->ndefs);
     if (rec) {
         GString* buf = g_string_new(self->path);
         guint base_len, i;
@@ -409,6 +409,21 @@ dbus_service_tag_export_all(
         }
         g_string_free(buf, TRUE);
     }
+}
+
+static
+void
+dbus_service_tag_export_all(
+    DBusServiceTagPriv* self)
+{
+    DBusServiceTag* pub = &self->pub;
+    NfcTag* tag = pub->tag;
+    GPtrArray* interfaces = g_ptr_array_new();
+
+    /* Export NDEF records (unless they haven't been read yet) */
+    if (!(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED)) {
+        dbus_service_tag_export_ndef(self);
+    }
 
     /* Export sub-interfaces */
     g_ptr_array_add(interfaces, (gpointer)NFC_DBUS_TAG_INTERFACE);
@@ -523,11 +538,12 @@ dbus_service_tag_handle_call(
 static
 void
 dbus_service_tag_complete_pending_calls(
-    DBusServiceTagPriv* self)
+    DBusServiceTagPriv* self,
+    DBusServiceTagCallQueue* queue)
 {
     DBusServiceTagCall* call;
 
-    while ((call = dbus_service_tag_dequeue_call(&self->queue)) != NULL) {
+    while ((call = dbus_service_tag_dequeue_call(queue)) != NULL) {
         call->func(call->invocation, self);
         dbus_service_tag_free_call(call);
     }
@@ -665,7 +681,22 @@ dbus_service_tag_initialized(
     DBusServiceTagPriv* self = user_data;
 
     dbus_service_tag_export_all(self);
-    dbus_service_tag_complete_pending_calls(self);
+    dbus_service_tag_complete_pending_calls(self, &self->queue);
+}
+
+static
+void
+dbus_service_tag_ndef_ready(
+    NfcTag* tag,
+    void* user_data)
+{
+    DBusServiceTagPriv* self = user_data;
+
+    /* Deferred NDEF has been read */
+    dbus_service_tag_export_ndef(self);
+    org_sailfishos_nfc_tag_emit_ndef_records_changed(self->iface,
+        dbus_service_tag_get_ndef_rec_paths(self));
+    dbus_service_tag_complete_pending_calls(self, &self->ndef_queue);
 }
 
 /*==========================================================================*
@@ -808,6 +839,26 @@ dbus_service_tag_complete_get_ndef_records(
         dbus_service_tag_get_ndef_rec_paths(self));
 }
 
+static
+void
+dbus_service_tag_get_ndef_records(
+    GDBusMethodInvocation* call,
+    DBusServiceTagPriv* self)
+{
+    /*
+     * If NDEF reading has been deferred, this is the time to do it.
+     * Unless the tag is locked, in which case the read would have to
+     * wait for the lock to be released, which may never happen if it's
+     * the caller who's holding the lock.
+     */
+    if (!self->lock && nfc_tag_read_ndef(self->pub.tag)) {
+        dbus_service_tag_queue_call(&self->ndef_queue, call,
+            dbus_service_tag_complete_get_ndef_records);
+    } else {
+        dbus_service_tag_complete_get_ndef_records(call, self);
+    }
+}
+
 static
 gboolean
 dbus_service_tag_handle_get_ndef_records(
@@ -817,7 +868,7 @@ dbus_service_tag_handle_get_ndef_records(
 {
     /* Queue the call if the tag is not initialized yet */
     dbus_service_tag_handle_call(self, call,
-        dbus_service_tag_complete_get_ndef_records);
+        dbus_service_tag_get_ndef_records);
     return TRUE;
 }
 
@@ -971,6 +1022,11 @@ dbus_service_tag_handle_transceive(
     NfcTag* tag = self->tag;
     DBusServiceTagAsyncCall* async = g_slice_new(DBusServiceTagAsyncCall);
 
+    if (NFC_IS_TAG_T4(tag)) {
+        /* Raw commands may change the selection behind its back */
+        nfc_isodep_set_select_cache(NFC_TAG_T4(tag), FALSE);
+    }
+
     g_object_ref(async->iface = iface);
     g_object_ref(async->call = call);
     if (!nfc_target_transmit(tag->target,
@@ -1046,7 +1102,8 @@ dbus_service_tag_free_unexported(
     gutil_disconnect_handlers(self->iface, self->call_id, CALL_COUNT);
 
     /* Cancel pending calls if there are any */
-    while ((call = dbus_service_tag_dequeue_call(&self->queue)) != NULL) {
+    while ((call = dbus_service_tag_dequeue_call(&self->queue)) != NULL ||
+        (call = dbus_service_tag_dequeue_call(&self->ndef_queue)) != NULL) {
         g_dbus_method_invocation_return_error_literal(call->invocation,
             DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_ABORTED, "Object is gone");
         dbus_service_tag_free_call(call);
@@ -1141,6 +1198,9 @@ dbus_service_tag_new(
             nfc_tag_add_initialized_handler(tag,
                 dbus_service_tag_initialized, self);
     }
+    self->tag_event_id[TAG_NDEF_READY] =
+        nfc_tag_add_ndef_ready_handler(tag,
+            dbus_service_tag_ndef_ready, self);
     if (g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
         (self->iface), connection, self->path, &error)) {
         GDEBUG("Created D-Bus object %s", self->path);
@@ -265,22 +265,16 @@ dbus_service_tag_t2_handle_read(
     guint block,
     DBusServiceTagType2* self)
 {
-    if (sector != 0) {
+    DBusServiceTagType2AsyncCall* read =
+        dbus_service_tag_t2_async_call_new(iface, call);
+
+    if (!nfc_tag_t2_read(self->t2, sector, block,
+        dbus_service_tag_t2_handle_read_done,
+        dbus_service_tag_t2_async_call_free, read)) {
+        dbus_service_tag_t2_async_call_free1(read);
         g_dbus_method_invocation_return_error_literal(call,
-            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_NOT_SUPPORTED,
-            "Only sector 0 is supported");
-    } else {
-        DBusServiceTagType2AsyncCall* read =
-            dbus_service_tag_t2_async_call_new(iface, call);
-
-        if (!nfc_tag_t2_read(self->t2, sector, block,
-            dbus_service_tag_t2_handle_read_done,
-            dbus_service_tag_t2_async_call_free, read)) {
-            dbus_service_tag_t2_async_call_free1(read);
-            g_dbus_method_invocation_return_error_literal(call,
-                DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
-                "Read failed");
-        }
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+            "Read failed");
     }
     return TRUE;
 }
@@ -317,26 +311,20 @@ dbus_service_tag_t2_handle_write(
     GVariant* data,
     DBusServiceTagType2* self)
 {
-    if (sector != 0) {
+    GBytes* bytes = g_variant_get_data_as_bytes(data);
+    DBusServiceTagType2AsyncCall* write =
+        dbus_service_tag_t2_async_call_new(iface, call);
+
+    if (!nfc_tag_t2_write_seq(self->t2, sector, block, bytes,
+        dbus_service_tag_t2_sequence(self, call),
+        dbus_service_tag_t2_handle_write_done,
+        dbus_service_tag_t2_async_call_free, write)) {
+        dbus_service_tag_t2_async_call_free1(write);
         g_dbus_method_invocation_return_error_literal(call,
-            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_NOT_SUPPORTED,
-            "Only sector 0 is supported");
-    } else {
-        GBytes* bytes = g_variant_get_data_as_bytes(data);
-        DBusServiceTagType2AsyncCall* write =
-            dbus_service_tag_t2_async_call_new(iface, call);
-
-        if (!nfc_tag_t2_write_seq(self->t2, sector, block, bytes,
-            dbus_service_tag_t2_sequence(self, call),
-            dbus_service_tag_t2_handle_write_done,
-            dbus_service_tag_t2_async_call_free, write)) {
-            dbus_service_tag_t2_async_call_free1(write);
-            g_dbus_method_invocation_return_error_literal(call,
-                DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
-                "Write failed");
-        }
-        g_bytes_unref(bytes);
+            DBUS_SERVICE_ERROR, DBUS_SERVICE_ERROR_FAILED,
+            "Write failed");
     }
+    g_bytes_unref(bytes);
     return TRUE;
 }
 
@@ -60,6 +60,8 @@ static FILE* nfcd_log_file = NULL;
 
 typedef struct nfcd_opt {
     char* plugin_dir;
+    char* t2_cache_dir;
+    char* trace_dir;
     gboolean dont_unload;
 } NfcdOpt;
 
@@ -108,6 +110,12 @@ nfcd_run(
     };
     NfcManager* nfc = nfc_manager_new(&plugins_info);
 
+    if (opts->t2_cache_dir) {
+        nfc_manager_set_t2_cache_dir(nfc, opts->t2_cache_dir);
+    }
+    if (opts->trace_dir) {
+        nfc_manager_set_trace_dir(nfc, opts->trace_dir);
+    }
     if (nfc_manager_start(nfc)) {
         if (!nfc->stopped) {
             GMainLoop* loop = g_main_loop_new(NULL, FALSE);
@@ -292,6 +300,10 @@ nfcd_opt_parse(
           "Disable plugins (repeatable)", "PLUGINS"},
         { "dont-unload", 'U', 0, G_OPTION_ARG_NONE, &opt->dont_unload,
           "Don't unload external plugins on exit", NULL },
+        { "t2-cache", 0, 0, G_OPTION_ARG_FILENAME, &opt->t2_cache_dir,
+          "Cache Type 2 tag contents in this directory", "DIR" },
+        { "record", 0, 0, G_OPTION_ARG_FILENAME, &opt->trace_dir,
+          "Record tag traffic into this directory", "DIR" },
         { NULL }
     };
     GOptionContext* options = g_option_context_new("- NFC daemon");
@@ -325,6 +337,8 @@ nfcd_opt_cleanup(
         fclose(nfcd_log_file);
     }
     g_free(opts->plugin_dir);
+    g_free(opts->t2_cache_dir);
+    g_free(opts->trace_dir);
     g_strfreev(nfcd_enable_plugins);
     g_strfreev(nfcd_disable_plugins);
 }
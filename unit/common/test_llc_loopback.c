@@ -0,0 +1,516 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+
+#include "test_llc_loopback.h"
+
+#include "nfc_target_impl.h"
+#include "nfc_initiator_impl.h"
+
+#include <gutil_log.h>
+#include <gutil_macros.h>
+
+#define TEST_LLC_LOOPBACK_SEED (0x4c4c4350) /* "LLCP" */
+#define TEST_LLC_LOOPBACK_MAX_LOSS (90)
+
+/* NFCForum-TS-LLCP_1.1, 4.3 PDU Descriptions */
+#define TEST_LLCP_PTYPE_SYMM (0x00)
+#define TEST_LLCP_PTYPE_AGF (0x02)
+#define TEST_LLCP_PTYPE_I (0x0c)
+#define TEST_LLCP_PTYPE_RR (0x0d)
+#define TEST_LLCP_PTYPE_RNR (0x0e)
+
+typedef struct test_llc_loopback_impl TestLlcLoopbackImpl;
+
+/* Remote target, as seen by the Initiator side I/O */
+typedef NfcTargetClass TestLoopbackTargetClass;
+typedef struct test_loopback_target {
+    NfcTarget target;
+    TestLlcLoopbackImpl* impl;
+} TestLoopbackTarget;
+
+/* Remote initiator, as seen by the Target side I/O */
+typedef NfcInitiatorClass TestLoopbackInitiatorClass;
+typedef struct test_loopback_initiator {
+    NfcInitiator initiator;
+    TestLlcLoopbackImpl* impl;
+} TestLoopbackInitiator;
+
+struct test_llc_loopback_impl {
+    TestLlcLoopback pub;
+    TestLlcLoopbackConfig config;
+    GRand* rand;
+    TestLoopbackTarget* target;
+    TestLoopbackInitiator* initiator;
+    GBytes* request;        /* Initiator => Target */
+    GBytes* response;       /* Target => Initiator */
+    guint request_id;
+    guint response_id;
+    guint cancelled;        /* Responses nobody is waiting for */
+};
+
+G_DEFINE_TYPE(TestLoopbackTarget, test_loopback_target, NFC_TYPE_TARGET)
+#define TEST_TYPE_LOOPBACK_TARGET (test_loopback_target_get_type())
+#define TEST_LOOPBACK_TARGET(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_LOOPBACK_TARGET, TestLoopbackTarget))
+
+G_DEFINE_TYPE(TestLoopbackInitiator, test_loopback_initiator,
+    NFC_TYPE_INITIATOR)
+#define TEST_TYPE_LOOPBACK_INITIATOR (test_loopback_initiator_get_type())
+#define TEST_LOOPBACK_INITIATOR(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_LOOPBACK_INITIATOR, TestLoopbackInitiator))
+
+/*==========================================================================*
+ * Link
+ *==========================================================================*/
+
+static
+void
+test_llc_loopback_count(
+    TestLlcLoopbackStats* stats,
+    const guint8* pkt,
+    gsize len)
+{
+    if (len >= 2) {
+        const guint ptype = ((pkt[0] & 0x03) << 2) | (pkt[1] >> 6);
+
+        switch (ptype) {
+        case TEST_LLCP_PTYPE_SYMM:
+            stats->symm++;
+            break;
+        case TEST_LLCP_PTYPE_AGF:
+            /* Each PDU in the AGF is prefixed with a 2-byte length */
+            pkt += 2;
+            len -= 2;
+            while (len >= 2) {
+                const gsize n = ((gsize)pkt[0] << 8) | pkt[1];
+
+                if (n + 2 > len) {
+                    break;
+                }
+                test_llc_loopback_count(stats, pkt + 2, n);
+                pkt += n + 2;
+                len -= n + 2;
+            }
+            break;
+        case TEST_LLCP_PTYPE_I:
+            stats->i_pdus++;
+            stats->pdus++;
+            break;
+        case TEST_LLCP_PTYPE_RR:
+        case TEST_LLCP_PTYPE_RNR:
+            stats->ack_pdus++;
+            /* fallthrough */
+        default:
+            stats->pdus++;
+            break;
+        }
+    }
+}
+
+static
+guint
+test_llc_loopback_delay(
+    TestLlcLoopbackImpl* self,
+    gsize len)
+{
+    const TestLlcLoopbackConfig* config = &self->config;
+    TestLlcLoopbackStats* stats = &self->pub.stats;
+    const guint n = (config->frame_size && len > config->frame_size) ?
+        ((len + config->frame_size - 1) / config->frame_size) : 1;
+    guint i, ms = 0;
+
+    for (i = 0; i < n; i++) {
+        stats->rf_frames++;
+        ms += config->latency_ms;
+        while (config->loss &&
+            g_rand_int_range(self->rand, 0, 100) < (gint32)config->loss) {
+            stats->lost++;
+            stats->rf_frames++;
+            ms += config->retry_ms + config->latency_ms;
+        }
+    }
+    return ms;
+}
+
+static
+guint
+test_llc_loopback_schedule(
+    TestLlcLoopbackImpl* self,
+    GBytes* frame,
+    GSourceFunc fn)
+{
+    TestLlcLoopbackStats* stats = &self->pub.stats;
+    gsize len;
+    const guint8* pkt = g_bytes_get_data(frame, &len);
+    guint ms;
+
+    stats->frames++;
+    stats->bytes += len;
+    test_llc_loopback_count(stats, pkt, len);
+    ms = test_llc_loopback_delay(self, len);
+    return ms ? g_timeout_add(ms, fn, self) : g_idle_add(fn, self);
+}
+
+static
+void
+test_llc_loopback_cancel_all(
+    TestLlcLoopbackImpl* self)
+{
+    if (self->request_id) {
+        g_source_remove(self->request_id);
+        self->request_id = 0;
+    }
+    if (self->response_id) {
+        g_source_remove(self->response_id);
+        self->response_id = 0;
+    }
+    if (self->request) {
+        g_bytes_unref(self->request);
+        self->request = NULL;
+    }
+    if (self->response) {
+        g_bytes_unref(self->response);
+        self->response = NULL;
+    }
+    self->cancelled = 0;
+}
+
+static
+gboolean
+test_llc_loopback_request_cb(
+    gpointer user_data)
+{
+    TestLlcLoopbackImpl* self = user_data;
+    GBytes* request = self->request;
+    gsize len;
+    const void* data = g_bytes_get_data(request, &len);
+
+    self->request_id = 0;
+    self->request = NULL;
+    nfc_initiator_transmit(&self->initiator->initiator, data, len);
+    g_bytes_unref(request);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_llc_loopback_response_cb(
+    gpointer user_data)
+{
+    TestLlcLoopbackImpl* self = user_data;
+    GBytes* response = self->response;
+    gsize len;
+    const void* data = g_bytes_get_data(response, &len);
+
+    self->response_id = 0;
+    self->response = NULL;
+    self->pub.stats.exchanges++;
+    nfc_initiator_response_sent(&self->initiator->initiator,
+        NFC_TRANSMIT_STATUS_OK);
+    if (self->cancelled) {
+        self->cancelled--;
+    } else {
+        nfc_target_transmit_done(&self->target->target,
+            NFC_TRANSMIT_STATUS_OK, data, len);
+    }
+    g_bytes_unref(response);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_llc_loopback_request(
+    TestLlcLoopbackImpl* self,
+    GBytes* frame)
+{
+    g_assert(!self->request_id);
+    self->request = g_bytes_ref(frame);
+    self->request_id = test_llc_loopback_schedule(self, frame,
+        test_llc_loopback_request_cb);
+}
+
+static
+void
+test_llc_loopback_respond(
+    TestLlcLoopbackImpl* self,
+    GBytes* frame)
+{
+    g_assert(!self->response_id);
+    self->response = g_bytes_ref(frame);
+    self->response_id = test_llc_loopback_schedule(self, frame,
+        test_llc_loopback_response_cb);
+}
+
+static
+void
+test_llc_loopback_cancel(
+    TestLlcLoopbackImpl* self)
+{
+    if (self->request_id) {
+        /* The request hasn't reached the other side yet */
+        g_source_remove(self->request_id);
+        g_bytes_unref(self->request);
+        self->request_id = 0;
+        self->request = NULL;
+    } else {
+        /* Drop the response when it arrives */
+        self->cancelled++;
+    }
+}
+
+static
+void
+test_llc_loopback_drop(
+    TestLlcLoopbackImpl* self)
+{
+    test_llc_loopback_cancel_all(self);
+    nfc_target_gone(&self->target->target);
+    nfc_initiator_gone(&self->initiator->initiator);
+}
+
+/*==========================================================================*
+ * Target
+ *==========================================================================*/
+
+static
+gboolean
+test_loopback_target_transmit(
+    NfcTarget* target,
+    const void* data,
+    guint len)
+{
+    TestLoopbackTarget* self = TEST_LOOPBACK_TARGET(target);
+
+    if (self->impl) {
+        GBytes* frame = g_bytes_new(data, len);
+
+        test_llc_loopback_request(self->impl, frame);
+        g_bytes_unref(frame);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+test_loopback_target_transmit_bytes(
+    NfcTarget* target,
+    GBytes* data)
+{
+    TestLoopbackTarget* self = TEST_LOOPBACK_TARGET(target);
+
+    if (self->impl) {
+        test_llc_loopback_request(self->impl, data);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+void
+test_loopback_target_cancel_transmit(
+    NfcTarget* target)
+{
+    TestLoopbackTarget* self = TEST_LOOPBACK_TARGET(target);
+
+    if (self->impl) {
+        test_llc_loopback_cancel(self->impl);
+    }
+}
+
+static
+void
+test_loopback_target_deactivate(
+    NfcTarget* target)
+{
+    TestLoopbackTarget* self = TEST_LOOPBACK_TARGET(target);
+
+    if (self->impl) {
+        test_llc_loopback_drop(self->impl);
+    } else {
+        nfc_target_gone(target);
+    }
+}
+
+static
+void
+test_loopback_target_init(
+    TestLoopbackTarget* self)
+{
+    NfcTarget* target = &self->target;
+
+    target->technology = NFC_TECHNOLOGY_A;
+    target->protocol = NFC_PROTOCOL_NFC_DEP;
+}
+
+static
+void
+test_loopback_target_class_init(
+    TestLoopbackTargetClass* klass)
+{
+    klass->transmit = test_loopback_target_transmit;
+    klass->transmit_bytes = test_loopback_target_transmit_bytes;
+    klass->cancel_transmit = test_loopback_target_cancel_transmit;
+    klass->deactivate = test_loopback_target_deactivate;
+}
+
+/*==========================================================================*
+ * Initiator
+ *==========================================================================*/
+
+static
+gboolean
+test_loopback_initiator_respond(
+    NfcInitiator* initiator,
+    const void* data,
+    guint len)
+{
+    TestLoopbackInitiator* self = TEST_LOOPBACK_INITIATOR(initiator);
+
+    if (self->impl) {
+        GBytes* frame = g_bytes_new(data, len);
+
+        test_llc_loopback_respond(self->impl, frame);
+        g_bytes_unref(frame);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+test_loopback_initiator_respond_bytes(
+    NfcInitiator* initiator,
+    GBytes* data)
+{
+    TestLoopbackInitiator* self = TEST_LOOPBACK_INITIATOR(initiator);
+
+    if (self->impl) {
+        test_llc_loopback_respond(self->impl, data);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+void
+test_loopback_initiator_deactivate(
+    NfcInitiator* initiator)
+{
+    TestLoopbackInitiator* self = TEST_LOOPBACK_INITIATOR(initiator);
+
+    if (self->impl) {
+        test_llc_loopback_drop(self->impl);
+    } else {
+        nfc_initiator_gone(initiator);
+    }
+}
+
+static
+void
+test_loopback_initiator_init(
+    TestLoopbackInitiator* self)
+{
+    NfcInitiator* initiator = &self->initiator;
+
+    initiator->technology = NFC_TECHNOLOGY_A;
+    initiator->protocol = NFC_PROTOCOL_NFC_DEP;
+}
+
+static
+void
+test_loopback_initiator_class_init(
+    TestLoopbackInitiatorClass* klass)
+{
+    klass->respond = test_loopback_initiator_respond;
+    klass->respond_bytes = test_loopback_initiator_respond_bytes;
+    klass->deactivate = test_loopback_initiator_deactivate;
+}
+
+/*==========================================================================*
+ * Interface
+ *==========================================================================*/
+
+TestLlcLoopback*
+test_llc_loopback_new(
+    const TestLlcLoopbackConfig* config)
+{
+    TestLlcLoopbackImpl* self = g_new0(TestLlcLoopbackImpl, 1);
+    TestLlcLoopback* loopback = &self->pub;
+
+    if (config) {
+        self->config = *config;
+        self->config.loss = MIN(config->loss, TEST_LLC_LOOPBACK_MAX_LOSS);
+    }
+    self->rand = g_rand_new_with_seed(TEST_LLC_LOOPBACK_SEED);
+    self->target = g_object_new(TEST_TYPE_LOOPBACK_TARGET, NULL);
+    self->initiator = g_object_new(TEST_TYPE_LOOPBACK_INITIATOR, NULL);
+    self->target->impl = self;
+    self->initiator->impl = self;
+    loopback->initiator = nfc_llc_io_initiator_new(&self->target->target);
+    loopback->target = nfc_llc_io_target_new(&self->initiator->initiator);
+    return loopback;
+}
+
+void
+test_llc_loopback_free(
+    TestLlcLoopback* loopback)
+{
+    if (loopback) {
+        TestLlcLoopbackImpl* self = G_CAST(loopback, TestLlcLoopbackImpl, pub);
+
+        test_llc_loopback_cancel_all(self);
+        self->target->impl = NULL;
+        self->initiator->impl = NULL;
+        nfc_llc_io_unref(loopback->initiator);
+        nfc_llc_io_unref(loopback->target);
+        nfc_target_unref(&self->target->target);
+        nfc_initiator_unref(&self->initiator->initiator);
+        g_rand_free(self->rand);
+        g_free(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+
+#ifndef TEST_LLC_LOOPBACK_H
+#define TEST_LLC_LOOPBACK_H
+
+#include "test_types.h"
+
+#include "nfc_llc_io.h"
+
+/*
+ * Connects Initiator and Target side LLC I/O objects back to back,
+ * so that two NfcLlc instances can talk to each other within the same
+ * process. Each frame is delivered after latency_ms per RF frame, the
+ * LLC frame being split into RF frames of up to frame_size bytes (zero
+ * means no limit). Lost RF frames are retransmitted after retry_ms the
+ * way NFC-DEP recovers from transmission errors, so that the loss only
+ * costs time. The loss rate is in percent, the random sequence is the
+ * same for every run.
+ */
+
+typedef struct test_llc_loopback_config {
+    guint latency_ms;
+    guint frame_size;
+    guint loss;
+    guint retry_ms;
+} TestLlcLoopbackConfig;
+
+typedef struct test_llc_loopback_stats {
+    guint exchanges;    /* Completed request/response pairs */
+    guint frames;       /* LLC frames in both directions */
+    guint symm;         /* SYMM frames */
+    guint rf_frames;    /* RF frames, including retransmissions */
+    guint lost;         /* Lost (and retransmitted) RF frames */
+    guint pdus;         /* LLCP PDUs except SYMM, AGF counted by content */
+    guint i_pdus;       /* I PDUs */
+    guint ack_pdus;     /* RR and RNR PDUs */
+    guint64 bytes;      /* LLC frame bytes in both directions */
+} TestLlcLoopbackStats;
+
+typedef struct test_llc_loopback {
+    NfcLlcIo* initiator;
+    NfcLlcIo* target;
+    TestLlcLoopbackStats stats;
+} TestLlcLoopback;
+
+/* NULL config means no delays and no losses */
+TestLlcLoopback*
+test_llc_loopback_new(
+    const TestLlcLoopbackConfig* config);
+
+void
+test_llc_loopback_free(
+    TestLlcLoopback* loopback);
+
+#endif /* TEST_LLC_LOOPBACK_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
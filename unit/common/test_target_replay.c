@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_target_replay.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+
+struct test_target_replay_frame {
+    guint id;
+    GUtilData tx;
+    GUtilData rx;
+    NFC_TRANSMIT_STATUS status;
+    gboolean response;      /* FALSE if the transmission was cancelled */
+    gboolean done;
+    gint64 sent;
+    gint64 delay;           /* Microseconds */
+};
+
+#define PARENT_CLASS test_target_replay_parent_class
+G_DEFINE_TYPE(TestTargetReplay, test_target_replay, TEST_TYPE_TARGET)
+
+static
+guint32
+test_target_replay_get32(
+    const guint8* ptr)
+{
+    return ((guint32)ptr[0] << 24) | ((guint32)ptr[1] << 16) |
+        ((guint32)ptr[2] << 8) | ptr[3];
+}
+
+static
+gboolean
+test_target_replay_parse(
+    TestTargetReplay* self)
+{
+    NfcTarget* target = &self->parent.target;
+    gsize size;
+    const guint8* data = g_bytes_get_data(self->trace, &size);
+    const guint8* end = data + size;
+    const guint8* ptr = data + NFC_TARGET_TRACE_HEADER_SIZE;
+    GArray* frames;
+    gint64 now = 0, last_done = 0;
+
+    if (size < NFC_TARGET_TRACE_HEADER_SIZE ||
+        memcmp(data, NFC_TARGET_TRACE_MAGIC, 4) ||
+        data[4] != NFC_TARGET_TRACE_VERSION) {
+        GDEBUG("Not a trace");
+        return FALSE;
+    }
+
+    target->technology = data[5];
+    target->protocol = data[6];
+    frames = g_array_new(FALSE, TRUE, sizeof(TestTargetReplayFrame));
+    while (ptr < end) {
+        guint8 type, status;
+        guint32 id, len;
+
+        if ((gsize)(end - ptr) < NFC_TARGET_TRACE_RECORD_SIZE) {
+            break;
+        }
+        type = ptr[0];
+        status = ptr[1];
+        id = test_target_replay_get32(ptr + 2);
+        len = test_target_replay_get32(ptr + 6);
+        now += test_target_replay_get32(ptr + 10);
+        ptr += NFC_TARGET_TRACE_RECORD_SIZE;
+        if ((gsize)(end - ptr) < len) {
+            break;
+        }
+
+        if (type == NFC_TARGET_TRACE_TRANSMIT) {
+            TestTargetReplayFrame frame;
+
+            memset(&frame, 0, sizeof(frame));
+            frame.id = id;
+            frame.tx.bytes = ptr;
+            frame.tx.size = len;
+            frame.sent = now;
+            g_array_append_val(frames, frame);
+        } else if (type == NFC_TARGET_TRACE_RESPONSE ||
+            type == NFC_TARGET_TRACE_CANCEL) {
+            guint i = frames->len;
+
+            /* Find the matching transmission */
+            while (i > 0) {
+                TestTargetReplayFrame* frame = &g_array_index(frames,
+                    TestTargetReplayFrame, --i);
+
+                if (frame->id == id && !frame->done) {
+                    frame->done = TRUE;
+                    frame->response = (type == NFC_TARGET_TRACE_RESPONSE);
+                    frame->status = status;
+                    frame->rx.bytes = ptr;
+                    frame->rx.size = len;
+                    frame->delay = now - MAX(frame->sent, last_done);
+                    last_done = now;
+                    break;
+                }
+            }
+        }
+        /* Sequence boundaries are ignored */
+        ptr += len;
+    }
+
+    if (ptr < end) {
+        GDEBUG("Trace is truncated");
+        g_array_free(frames, TRUE);
+        return FALSE;
+    } else {
+        self->count = frames->len;
+        self->frames = (TestTargetReplayFrame*) g_array_free(frames, FALSE);
+        GDEBUG("%u frame(s) to replay", self->count);
+        return TRUE;
+    }
+}
+
+static
+gboolean
+test_target_replay_respond(
+    gpointer user_data)
+{
+    TestTargetReplay* self = TEST_TARGET_REPLAY(user_data);
+    const TestTargetReplayFrame* frame = self->frames + self->next - 1;
+
+    self->response_id = 0;
+    nfc_target_transmit_done(&self->parent.target, frame->status,
+        frame->rx.bytes, frame->rx.size);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_target_replay_transmit(
+    NfcTarget* target,
+    const void* data,
+    guint len)
+{
+    TestTargetReplay* self = TEST_TARGET_REPLAY(target);
+
+    g_assert(!self->response_id);
+    if (self->next < self->count) {
+        const TestTargetReplayFrame* frame = self->frames + self->next;
+
+        if (frame->tx.size == len &&
+            (!len || !memcmp(frame->tx.bytes, data, len))) {
+            self->next++;
+            if (frame->response) {
+                const guint ms = (guint)(frame->delay * self->scale /
+                    G_TIME_SPAN_MILLISECOND);
+
+                self->response_id = ms ?
+                    g_timeout_add(ms, test_target_replay_respond, self) :
+                    g_idle_add(test_target_replay_respond, self);
+            }
+            /* Cancelled transmission stays pending until cancelled */
+            return TRUE;
+        }
+        GDEBUG("Frame %u mismatch", self->next);
+        self->mismatches++;
+    } else {
+        GDEBUG("End of trace");
+    }
+    return FALSE;
+}
+
+static
+void
+test_target_replay_cancel_transmit(
+    NfcTarget* target)
+{
+    TestTargetReplay* self = TEST_TARGET_REPLAY(target);
+
+    if (self->response_id) {
+        g_source_remove(self->response_id);
+        self->response_id = 0;
+    }
+}
+
+static
+void
+test_target_replay_init(
+    TestTargetReplay* self)
+{
+    self->scale = 1.0;
+}
+
+static
+void
+test_target_replay_finalize(
+    GObject* object)
+{
+    TestTargetReplay* self = TEST_TARGET_REPLAY(object);
+
+    if (self->response_id) {
+        g_source_remove(self->response_id);
+    }
+    if (self->trace) {
+        g_bytes_unref(self->trace);
+    }
+    g_free(self->frames);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+test_target_replay_class_init(
+    NfcTargetClass* klass)
+{
+    klass->transmit = test_target_replay_transmit;
+    klass->cancel_transmit = test_target_replay_cancel_transmit;
+    G_OBJECT_CLASS(klass)->finalize = test_target_replay_finalize;
+}
+
+NfcTarget*
+test_target_replay_new(
+    GBytes* trace,
+    gdouble scale)
+{
+    TestTargetReplay* self = g_object_new(TEST_TYPE_TARGET_REPLAY, NULL);
+
+    self->trace = g_bytes_ref(trace);
+    self->scale = MAX(scale, 0);
+    if (test_target_replay_parse(self)) {
+        return NFC_TARGET(self);
+    }
+    g_object_unref(self);
+    return NULL;
+}
+
+NfcTarget*
+test_target_replay_new_from_file(
+    const char* path,
+    gdouble scale)
+{
+    NfcTarget* target = NULL;
+    gchar* contents = NULL;
+    gsize len = 0;
+
+    if (g_file_get_contents(path, &contents, &len, NULL)) {
+        GBytes* trace = g_bytes_new_take(contents, len);
+
+        target = test_target_replay_new(trace, scale);
+        g_bytes_unref(trace);
+    }
+    return target;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
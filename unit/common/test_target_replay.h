@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef TEST_TARGET_REPLAY_H
+#define TEST_TARGET_REPLAY_H
+
+#include "test_target.h"
+
+#include "nfc_target_recorder.h"
+
+/*
+ * Replays traces written by NfcTargetRecorder. The frames are expected
+ * to arrive in the same order as they were recorded, the responses are
+ * delivered after the recorded delay multiplied by the scale factor
+ * (1.0 for the original timing, 0.0 for no delays at all).
+ */
+
+typedef struct test_target_replay_frame TestTargetReplayFrame;
+typedef TestTargetClass TestTargetReplayClass;
+typedef struct test_target_replay {
+    TestTarget parent;
+    GBytes* trace;
+    TestTargetReplayFrame* frames;
+    guint count;
+    guint next;
+    gdouble scale;
+    guint response_id;
+    guint mismatches;
+} TestTargetReplay;
+
+GType test_target_replay_get_type(void);
+#define TEST_TYPE_TARGET_REPLAY (test_target_replay_get_type())
+#define TEST_TARGET_REPLAY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_TARGET_REPLAY, TestTargetReplay))
+
+/* These return NULL if the trace is broken */
+
+NfcTarget*
+test_target_replay_new(
+    GBytes* trace,
+    gdouble scale);
+
+NfcTarget*
+test_target_replay_new_from_file(
+    const char* path,
+    gdouble scale);
+
+#define test_target_replay_remaining(target) \
+    (TEST_TARGET_REPLAY(target)->count - TEST_TARGET_REPLAY(target)->next)
+
+#endif /* TEST_TARGET_REPLAY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -43,6 +43,21 @@
 typedef NfcTargetClass TestTargetT2Class;
 G_DEFINE_TYPE(TestTargetT2, test_target_t2, NFC_TYPE_TARGET)
 
+static
+guint
+test_target_t2_offset(
+    TestTargetT2* self,
+    guint block,
+    guint* sector_size)
+{
+    /* Reads and writes wrap around within the current sector */
+    const guint base = self->sector * TEST_TARGET_T2_SECTOR_SIZE;
+    const guint size = MIN(self->data.size - base, TEST_TARGET_T2_SECTOR_SIZE);
+
+    *sector_size = size;
+    return (block * TEST_TARGET_T2_BLOCK_SIZE) % size;
+}
+
 static
 gboolean
 test_target_t2_read_done(
@@ -51,22 +66,24 @@ test_target_t2_read_done(
     TestTargetT2Read* read = user_data;
     TestTargetT2* self = read->target;
     NfcTarget* target = &self->target;
-    const GUtilData* data = &self->data;
     NFC_TRANSMIT_STATUS status = NFC_TRANSMIT_STATUS_OK;
-    guint offset = (read->block * TEST_TARGET_T2_BLOCK_SIZE) % data->size;
+    guint size;
+    guint offset = test_target_t2_offset(self, read->block, &size);
+    const guint8* bytes = self->data.bytes +
+        self->sector * TEST_TARGET_T2_SECTOR_SIZE;
     guint8 buf[TEST_TARGET_T2_READ_SIZE];
     guint len = sizeof(buf);
 
     g_assert(self->transmit_id);
     self->transmit_id = 0;
 
-    if ((offset + TEST_TARGET_T2_READ_SIZE) <= data->size) {
-        memcpy(buf, data->bytes + offset, TEST_TARGET_T2_READ_SIZE);
+    if ((offset + TEST_TARGET_T2_READ_SIZE) <= size) {
+        memcpy(buf, bytes + offset, TEST_TARGET_T2_READ_SIZE);
     } else {
-        const guint remain = (offset + TEST_TARGET_T2_READ_SIZE) - data->size;
+        const guint remain = (offset + TEST_TARGET_T2_READ_SIZE) - size;
 
-        memcpy(buf, data->bytes + offset, TEST_TARGET_T2_READ_SIZE - remain);
-        memcpy(buf + (TEST_TARGET_T2_READ_SIZE - remain), data->bytes, remain);
+        memcpy(buf, bytes + offset, TEST_TARGET_T2_READ_SIZE - remain);
+        memcpy(buf + (TEST_TARGET_T2_READ_SIZE - remain), bytes, remain);
     }
 
     if (self->read_error && self->read_error->block == read->block) {
@@ -143,19 +160,21 @@ test_target_t2_write_done(
         }
         self->write_error = NULL;
     } else {
-        const guint data_size = self->data.size;
-        guint offset = (write->block * TEST_TARGET_T2_BLOCK_SIZE) % data_size;
+        guint data_size;
+        guint offset = test_target_t2_offset(self, write->block, &data_size);
+        guint8* storage = self->storage +
+            self->sector * TEST_TARGET_T2_SECTOR_SIZE;
         guint size = write->size;
         const guint8* src = write->data;
 
         while (size > 0) {
             if ((offset + size) <= data_size) {
-                memcpy(self->storage + offset, src, size);
+                memcpy(storage + offset, src, size);
                 break;
             } else {
                 const guint to_copy = data_size - offset;
 
-                memcpy(self->storage + offset, src, to_copy);
+                memcpy(storage + offset, src, to_copy);
                 size -= to_copy;
                 src += to_copy;
                 offset = 0;
@@ -167,6 +186,39 @@ test_target_t2_write_done(
     return G_SOURCE_REMOVE;
 }
 
+static
+gboolean
+test_target_t2_resp_done(
+    gpointer user_data)
+{
+    TestTargetT2Resp* resp = user_data;
+    TestTargetT2* self = resp->target;
+
+    g_assert(self->transmit_id);
+    self->transmit_id = 0;
+    nfc_target_transmit_done(&self->target, resp->status, &resp->data,
+        resp->len);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_target_t2_resp(
+    TestTargetT2* self,
+    NFC_TRANSMIT_STATUS status,
+    guint8 data,
+    guint len)
+{
+    TestTargetT2Resp* resp = g_new(TestTargetT2Resp, 1);
+
+    resp->target = self;
+    resp->status = status;
+    resp->data = data;
+    resp->len = len;
+    self->transmit_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+        test_target_t2_resp_done, resp, g_free);
+}
+
 static
 void
 test_target_t2_write_free(
@@ -191,6 +243,21 @@ test_target_t2_transmit(
     if (self->transmit_error > 0) {
         self->transmit_error--;
         GDEBUG("Simulating transmission failure");
+    } else if (self->sector_select) {
+        const guint8* cmd = data;
+
+        /* Second packet of SECTOR SELECT, passive ACK */
+        self->sector_select = FALSE;
+        if (len == 4 && (cmd[0] * TEST_TARGET_T2_SECTOR_SIZE) <
+            self->data.size) {
+            GDEBUG("Sector #%u", cmd[0]);
+            self->sector = cmd[0];
+            self->sector_selects++;
+            test_target_t2_resp(self, NFC_TRANSMIT_STATUS_TIMEOUT, 0, 0);
+        } else {
+            test_target_t2_resp(self, NFC_TRANSMIT_STATUS_NACK, 0, 1);
+        }
+        return TRUE;
     } else if (len > 0) {
         const guint8* cmd = data;
 
@@ -201,6 +268,7 @@ test_target_t2_transmit(
 
                 read->target = self;
                 read->block = cmd[1];
+                self->reads++;
                 GDEBUG("Read block #%u", read->block);
                 self->transmit_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
                     test_target_t2_read_done, read, g_free);
@@ -215,6 +283,7 @@ test_target_t2_transmit(
                 write->block = cmd[1];
                 write->size = len - 2;
                 write->data = gutil_memdup(cmd + 2, write->size);
+                self->writes++;
                 GDEBUG("Write block #%u, %u bytes", write->block, write->size);
                 self->transmit_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
                     test_target_t2_write_done, write,
@@ -222,6 +291,18 @@ test_target_t2_transmit(
                 return TRUE;
             }
             break;
+        case 0xc2: /* SECTOR SELECT */
+            if (len == 2 && cmd[1] == 0xff) {
+                if (self->sector_nack) {
+                    self->sector_nack = FALSE;
+                    test_target_t2_resp(self, NFC_TRANSMIT_STATUS_NACK, 0, 1);
+                } else {
+                    self->sector_select = TRUE;
+                    test_target_t2_resp(self, NFC_TRANSMIT_STATUS_OK, 0x0a, 1);
+                }
+                return TRUE;
+            }
+            break;
         }
     }
     return FALSE;
@@ -40,6 +40,7 @@
 #define TEST_TARGET_T2_FIRST_DATA_BLOCK (4)
 #define TEST_TARGET_T2_DATA_OFFSET \
     (TEST_TARGET_T2_FIRST_DATA_BLOCK * TEST_TARGET_T2_BLOCK_SIZE)
+#define TEST_TARGET_T2_SECTOR_SIZE (1024)
 
 typedef struct test_target_t2_error TestTargetT2Error;
 typedef struct test_target_t2 {
@@ -50,6 +51,12 @@ typedef struct test_target_t2 {
     const TestTargetT2Error* read_error;
     const TestTargetT2Error* write_error;
     gboolean transmit_error;
+    guint sector;             /* Currently selected sector */
+    gboolean sector_select;   /* Waiting for the second SECTOR SELECT packet */
+    gboolean sector_nack;     /* NACK the next SECTOR SELECT */
+    guint sector_selects;     /* Number of completed SECTOR SELECTs */
+    guint reads;              /* Number of READ commands */
+    guint writes;             /* Number of WRITE commands */
 } TestTargetT2;
 
 typedef enum test_target_t2_error_type {
@@ -70,6 +77,13 @@ typedef struct test_target_t2_read {
     guint block;
 } TestTargetT2Read;
 
+typedef struct test_target_t2_resp {
+    TestTargetT2* target;
+    NFC_TRANSMIT_STATUS status;
+    guint8 data;
+    guint len;
+} TestTargetT2Resp;
+
 typedef struct test_target_t2_write {
     TestTargetT2* target;
     guint block;
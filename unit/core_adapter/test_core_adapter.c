@@ -469,7 +469,7 @@ test_params(
     };
 
     /* Matches NFC_ADAPTER_PARAMS in core/src/nfc_adapter.c */
-    #define PARAMS(p) p(T4_NDEF) p(LA_NFCID1)
+    #define PARAMS(p) p(T4_NDEF) p(LA_NFCID1) p(T4_NDEF_LAZY)
 
     g_assert(!nfc_adapter_param_name(NFC_ADAPTER_PARAM_NONE));
     g_assert(!nfc_adapter_param_name(NFC_ADAPTER_PARAM_COUNT));
@@ -491,6 +491,10 @@ test_params(
     g_assert((v = nfc_adapter_param_get(adapter, NFC_ADAPTER_PARAM_T4_NDEF)));
     g_assert_true(v->b);
     g_free(v);
+    g_assert((v = nfc_adapter_param_get(adapter,
+        NFC_ADAPTER_PARAM_T4_NDEF_LAZY)));
+    g_assert_false(v->b);
+    g_free(v);
 
     req1 = nfc_adapter_param_request_new(adapter, NULL, TRUE);
     g_assert_cmpint(count, == ,0); /* Nothing has changed */
@@ -115,6 +115,7 @@ struct test_connection {
     TestConnectionHook state_change_hook;
     TestConnectionHook finalize_hook;
     gboolean accept_connection;
+    gboolean echo;
     GByteArray* received;
 };
 
@@ -153,6 +154,21 @@ test_connection_state_changed(
         state_changed(conn);
 }
 
+static
+gboolean
+test_connection_echo(
+    gpointer user_data)
+{
+    NfcPeerConnection* conn = user_data;
+    TestConnection* test = TEST_CONNECTION(conn);
+    GBytes* bytes = g_bytes_new(test->received->data, test->received->len);
+
+    /* Send back everything received so far */
+    g_assert(nfc_peer_connection_send(conn, bytes));
+    g_bytes_unref(bytes);
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 test_connection_data_received(
@@ -163,6 +179,12 @@ test_connection_data_received(
     TestConnection* test = TEST_CONNECTION(conn);
 
     g_byte_array_append(test->received, data, len);
+    if (test->echo) {
+        /* Respond asynchronously */
+        g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, test_connection_echo,
+            nfc_peer_connection_ref(conn), (GDestroyNotify)
+            nfc_peer_connection_unref);
+    }
     NFC_PEER_CONNECTION_CLASS(test_connection_parent_class)->
         data_received(conn, data, len);
 }
@@ -380,6 +402,9 @@ test_null(
     g_assert(!nfc_peer_connection_add_state_changed_handler(NULL, NULL, NULL));
     nfc_peer_connection_remove_handler(NULL, 0);
     nfc_peer_connection_unref(NULL);
+    nfc_peer_connection_set_rw(NULL, 0);
+    nfc_peer_connection_set_miu(NULL, 0);
+    nfc_peer_connection_set_ack_delay(NULL, 0);
     g_assert(!nfc_llc_connect_sn(NULL, NULL, NULL, NULL, NULL, NULL));
     g_assert(!nfc_llc_connect_sn(llc, NULL, NULL, NULL, NULL, NULL));
     g_assert(!nfc_llc_connect(NULL, NULL, 0, NULL, NULL, NULL));
@@ -393,6 +418,7 @@ test_null(
     nfc_llc_submit_cc_pdu(NULL, NULL);
     nfc_llc_ack(NULL, NULL, FALSE);
     nfc_llc_ack(llc, NULL, FALSE);
+    g_assert(!nfc_llc_ack_stats(NULL));
     nfc_llc_remove_handler(NULL, 0);
     nfc_llc_remove_handler(NULL, 1);
     nfc_llc_remove_handlers(NULL, NULL, 0);
@@ -404,6 +430,9 @@ test_null(
     g_assert(!nfc_llc_io_add_can_send_handler(NULL, NULL, NULL));
     g_assert(!nfc_llc_io_add_receive_handler(NULL, NULL, NULL));
     g_assert(!nfc_llc_io_add_error_handler(NULL, NULL, NULL));
+    g_assert(!nfc_llc_io_initiator_poll_stats(NULL));
+    nfc_llc_io_initiator_set_poll_policy(NULL, NULL, NULL, NULL);
+    nfc_llc_io_set_lto(NULL, 0);
     nfc_llc_io_unref(NULL);
 
     g_bytes_unref(pdu);
@@ -440,6 +469,143 @@ test_basic(
     nfc_target_unref(target);
 }
 
+/*==========================================================================*
+ * poll
+ *==========================================================================*/
+
+static
+guint
+test_poll_custom(
+    NfcLlcIo* io,
+    guint idle,
+    void* user_data)
+{
+    return 1;
+}
+
+static
+void
+test_poll_destroy(
+    gpointer user_data)
+{
+    (*(int*)user_data)++;
+}
+
+static
+void
+test_poll_run(
+    NfcLlcIo* io)
+{
+    NfcLlc* llc = nfc_llc_new(io, NULL, NULL);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    gulong id;
+
+    /* Run until the tx list is exhausted and the link dies */
+    id = nfc_llc_add_state_changed_handler(llc, test_llc_quit_loop_cb, loop);
+    test_run(&test_opt, loop);
+    g_assert_cmpint(llc->state, == ,NFC_LLC_STATE_ACTIVE);
+    test_run(&test_opt, loop);
+    g_assert_cmpint(llc->state, == ,NFC_LLC_STATE_PEER_LOST);
+    nfc_llc_remove_handler(llc, id);
+    nfc_llc_free(llc);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_poll_adaptive(
+    void)
+{
+    static const TestTx tx[] = {
+        {
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        },{
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        },{
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        },{
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        }
+    };
+    NfcTarget* target = test_target_new_with_tx(TEST_ARRAY_AND_COUNT(tx));
+    NfcLlcIo* io = nfc_llc_io_initiator_new(target);
+    const NfcLlcIoPollStats* stats = nfc_llc_io_initiator_poll_stats(io);
+
+    /* The period doubles up to a half of LTO */
+    nfc_llc_io_set_lto(io, 1000);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 0, NULL), == ,0);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 1, NULL), == ,10);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 2, NULL), == ,20);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 6, NULL), == ,320);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 7, NULL), == ,500);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 100, NULL), == ,500);
+    nfc_llc_io_set_lto(io, 0);
+    g_assert_cmpuint(nfc_llc_io_poll_adaptive(io, 100, NULL), == ,10);
+
+    /* Immediate poll after the first SYMM, then 10, 20 and 40 ms */
+    g_assert(stats);
+    test_poll_run(io);
+    g_assert_cmpuint(stats->polls, == ,4);
+    g_assert_cmpuint(stats->idle, == ,4);
+    g_assert_cmpuint(stats->resets, == ,0);
+    g_assert_cmpuint(stats->period, == ,40);
+    g_assert_cmpuint(stats->max_period, == ,40);
+    g_assert_cmpuint(io->lto, == ,NFC_LLC_LTO_DEFAULT);
+
+    nfc_llc_io_unref(io);
+    nfc_target_unref(target);
+}
+
+static
+void
+test_poll_fixed(
+    void)
+{
+    static const TestTx tx[] = {
+        {
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        },{
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+            { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+        }
+    };
+    NfcTarget* target = test_target_new_with_tx(TEST_ARRAY_AND_COUNT(tx));
+    NfcInitiator* init = test_initiator_new();
+    NfcLlcIo* io = nfc_llc_io_initiator_new(target);
+    NfcLlcIo* io2 = nfc_llc_io_target_new(init);
+    const NfcLlcIoPollStats* stats = nfc_llc_io_initiator_poll_stats(io);
+    int destroyed = 0;
+
+    /* Target-side I/O doesn't poll */
+    g_assert(!nfc_llc_io_initiator_poll_stats(io2));
+    nfc_llc_io_initiator_set_poll_policy(io2, test_poll_custom,
+        &destroyed, test_poll_destroy);
+    g_assert_cmpint(destroyed, == ,0);
+
+    /* Resetting the policy destroys the old one */
+    nfc_llc_io_initiator_set_poll_policy(io, test_poll_custom,
+        &destroyed, test_poll_destroy);
+    nfc_llc_io_initiator_set_poll_policy(io, NULL, NULL, NULL);
+    g_assert_cmpint(destroyed, == ,1);
+
+    nfc_llc_io_initiator_set_poll_policy(io, nfc_llc_io_poll_fixed,
+        GUINT_TO_POINTER(1), NULL);
+    test_poll_run(io);
+    g_assert_cmpuint(stats->polls, == ,2);
+    g_assert_cmpuint(stats->period, == ,1);
+    g_assert_cmpuint(stats->max_period, == ,1);
+
+    nfc_llc_io_unref(io);
+    nfc_llc_io_unref(io2);
+    nfc_initiator_unref(init);
+    nfc_target_unref(target);
+}
+
 /*==========================================================================*
  * initiator
  *==========================================================================*/
@@ -665,6 +831,30 @@ static const guint8 connect_sap_32_3_data[] = {
 };
 static const guint8 dm_noservice_17_32_data[] = { 0x81, 0xd1, 0x02 };
 static const guint8 dm_noservice_3_32_data[] = { 0x81, 0xc3, 0x02 };
+static const guint8 agf_connect_data[] = {
+    0x00, 0x80,
+    /* CONNECT 32:17 */
+    0x00, 0x09,
+    0x45, 0x20, 0x02, 0x02, 0x07, 0xff, 0x05, 0x01,
+    0x0f,
+    /* CONNECT 32:3 */
+    0x00, 0x09,
+    0x0d, 0x20, 0x02, 0x02, 0x07, 0xff, 0x05, 0x01,
+    0x0f,
+    /* CONNECT 33:17 */
+    0x00, 0x09,
+    0x45, 0x21, 0x02, 0x02, 0x07, 0xff, 0x05, 0x01,
+    0x0f
+};
+static const guint8 agf_dm_noservice_data[] = {
+    0x00, 0x80,
+    /* DM 3:32 */
+    0x00, 0x03,
+    0x81, 0xc3, 0x02,
+    /* DM 17:33 */
+    0x00, 0x03,
+    0x85, 0xd1, 0x02
+};
 
 static const TestTx advanced_pkt_1 [] = {
     {
@@ -930,6 +1120,20 @@ static const TestTx advanced_agf_pax_pkt [] = {
         { NULL, 0 }
     }
 };
+static const TestTx advanced_agf_connect_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(agf_connect_data) }
+    },{
+        /* The first response goes out immediately */
+        { TEST_ARRAY_AND_SIZE(dm_noservice_17_32_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* The other two get aggregated */
+        { TEST_ARRAY_AND_SIZE(agf_dm_noservice_data) },
+        { NULL, 0 }
+    }
+};
 static const TestTx advanced_ui_valid_pkt [] = {
     {
         { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
@@ -1042,6 +1246,9 @@ static const TestAdvancedData advanced_tests [] = {
     },{
         "agf_pax",
         TEST_ARRAY_AND_COUNT(advanced_agf_pax_pkt),
+    },{
+        "agf_connect",
+        TEST_ARRAY_AND_COUNT(advanced_agf_connect_pkt),
     },{
         "ui_valid",
         TEST_ARRAY_AND_COUNT(advanced_ui_valid_pkt),
@@ -1067,10 +1274,12 @@ typedef struct test_connect_data {
     gboolean exit_when_connected;
     NFC_LLC_STATE exit_state;
     GUtilData data_received;
+    const NfcLlcAckStats* ack_stats;
 } TestConnectData;
 
 struct test_connect_run {
     const TestConnectData* test;
+    NfcLlcIo* io;
     NfcLlc* llc;
     NfcPeerService* service;
     GMainLoop* loop;
@@ -1156,6 +1365,56 @@ test_connect_snep_sap(
         run->test->connect_complete, test_connect_done, run));
 }
 
+static
+void
+test_connect_snep_sap_params(
+    TestConnectRun* run)
+{
+    NfcPeerService* service = run->service;
+
+    /* Local RW and MIU are taken from the service */
+    nfc_peer_service_set_rw(service, 4);
+    nfc_peer_service_set_miu(service, 256);
+    test_connect_snep_sap(run);
+}
+
+static
+void
+test_connect_snep_sap_echo(
+    TestConnectRun* run)
+{
+    NfcPeerConnection* conn = nfc_llc_connect(run->llc, run->service,
+        NFC_LLC_SAP_SNEP, run->test->connect_complete, test_connect_done,
+        run);
+
+    g_assert(conn);
+    TEST_CONNECTION(conn)->echo = TRUE;
+    nfc_peer_connection_set_ack_delay(conn, 1000);
+}
+
+static
+void
+test_connect_snep_sap_rw(
+    TestConnectRun* run)
+{
+    /* RR is due when the receive window is half full */
+    nfc_peer_service_set_rw(run->service, 4);
+    nfc_peer_service_set_ack_delay(run->service, 1000);
+    test_connect_snep_sap(run);
+}
+
+static
+void
+test_connect_snep_sap_ack_timer(
+    TestConnectRun* run)
+{
+    /* Make sure that the ack timer expires before the next poll */
+    nfc_llc_io_initiator_set_poll_policy(run->io, nfc_llc_io_poll_fixed,
+        GUINT_TO_POINTER(1000), NULL);
+    nfc_peer_service_set_ack_delay(run->service, 10);
+    test_connect_snep_sap(run);
+}
+
 static
 void
 test_connect(
@@ -1172,6 +1431,7 @@ test_connect(
 
     memset(&run, 0, sizeof(run));
     run.test = test;
+    run.io = io;
     run.loop = g_main_loop_new(NULL, TRUE);
     run.service = NFC_PEER_SERVICE(test_service);
 
@@ -1200,6 +1460,13 @@ test_connect(
     g_assert_cmpint(run.llc->state, == ,test->exit_state);
     g_assert(run.connect_complete == (test->connect_complete != NULL));
     g_assert(run.connect_done);
+    if (test->ack_stats) {
+        const NfcLlcAckStats* stats = nfc_llc_ack_stats(run.llc);
+
+        g_assert_cmpuint(stats->sent, == ,test->ack_stats->sent);
+        g_assert_cmpuint(stats->piggybacked, == ,
+            test->ack_stats->piggybacked);
+    }
     nfc_llc_remove_handler(run.llc, id);
     g_main_loop_unref(run.loop);
 
@@ -1224,6 +1491,14 @@ static const guint8 connect_snep_sap_data[] = {
     0x11, 0x20, 0x02, 0x02, 0x07, 0xff, 0x05, 0x01,
     0x0f
 };
+static const guint8 connect_snep_sap_params_data[] = {
+    0x11, 0x20, 0x02, 0x02, 0x00, 0x80, 0x05, 0x01,
+    0x04
+};
+static const guint8 connect_snep_sap_rw4_data[] = {
+    0x11, 0x20, 0x02, 0x02, 0x07, 0xff, 0x05, 0x01,
+    0x04
+};
 static const guint8 cc_snep_data[] = {
     0x81, 0x84, 0x02, 0x02, 0x07, 0xff, 0x04, 0x01,
     0xff, 0x05, 0x01, 0x0f 
@@ -1234,6 +1509,17 @@ static const guint8 connect_snep_name_ok_transfer_expected_data[] = { 0x01 };
 static const guint8 i_32_4_1_pdu_data[] = { 0x83, 0x04, 0x00, 0x01 };
 static const guint8 i_33_4_1_pdu_data[] = { 0x87, 0x04, 0x00, 0x02 };
 static const guint8 rr_4_32_0_pdu_data[] = { 0x13, 0x60, 0x01 };
+static const guint8 rr_4_32_2_pdu_data[] = { 0x13, 0x60, 0x02 };
+static const guint8 i_32_4_2_pdu_data[] = { 0x83, 0x04, 0x10, 0x02 };
+static const guint8 i_4_32_echo_pdu_data[] = { 0x13, 0x20, 0x01, 0x01 };
+static const guint8 agf_i_32_4_pdu_data[] = {
+    0x00, 0x80,
+    0x00, 0x04, 0x83, 0x04, 0x00, 0x01,
+    0x00, 0x04, 0x83, 0x04, 0x10, 0x02
+};
+static const guint8 connect_ack_expected_data[] = { 0x01, 0x02 };
+static const NfcLlcAckStats connect_ack_one_rr = { 1, 0 };
+static const NfcLlcAckStats connect_ack_piggybacked = { 0, 1 };
 static const guint8 frmr_connect_data[] = {
     0x82, 0x00, 0x84, 0x00, 0x00, 0x00
 };
@@ -1310,6 +1596,94 @@ static const TestTx connect_snep_sap_ok_pkt [] = {
         { NULL, 0 }
     }
 };
+static const TestTx connect_snep_sap_params_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_params_data) },
+        { TEST_ARRAY_AND_SIZE(cc_snep_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { NULL, 0 }
+    }
+};
+static const TestTx connect_ack_coalesce_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
+        { TEST_ARRAY_AND_SIZE(cc_snep_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(agf_i_32_4_pdu_data) }
+    },{
+        /* A single RR acknowledges both I PDUs */
+        { TEST_ARRAY_AND_SIZE(rr_4_32_2_pdu_data) },
+        { NULL, 0 }
+    }
+};
+static const TestTx connect_ack_piggyback_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
+        { TEST_ARRAY_AND_SIZE(cc_snep_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(i_32_4_1_pdu_data) }
+    },{
+        /* RR is being held */
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* N(R) is carried by the response */
+        { TEST_ARRAY_AND_SIZE(i_4_32_echo_pdu_data) },
+        { NULL, 0 }
+    }
+};
+static const TestTx connect_ack_window_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_rw4_data) },
+        { TEST_ARRAY_AND_SIZE(cc_snep_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(i_32_4_1_pdu_data) }
+    },{
+        /* RR is being held */
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(i_32_4_2_pdu_data) }
+    },{
+        /* Half of the receive window is used, time to ack */
+        { TEST_ARRAY_AND_SIZE(rr_4_32_2_pdu_data) },
+        { NULL, 0 }
+    }
+};
+static const TestTx connect_ack_timer_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
+        { TEST_ARRAY_AND_SIZE(cc_snep_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(i_32_4_1_pdu_data) }
+    },{
+        /* RR is being held */
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* Sent when the ack timer expires */
+        { TEST_ARRAY_AND_SIZE(rr_4_32_0_pdu_data) },
+        { NULL, 0 }
+    }
+};
 static const TestTx connect_snep_name_noservice_pkt [] = {
     {
         { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
@@ -1407,6 +1781,39 @@ static const TestConnectData connect_tests [] = {
         TEST_ARRAY_AND_COUNT(connect_snep_sap_ok_pkt),
         test_connect_snep_sap, test_connect_complete,
         NFC_PEER_CONNECT_OK, TRUE, NFC_LLC_STATE_ACTIVE
+    },{
+        "ack_coalesce",
+        TEST_ARRAY_AND_COUNT(connect_ack_coalesce_pkt),
+        test_connect_snep_sap, test_connect_complete,
+        NFC_PEER_CONNECT_OK, FALSE, NFC_LLC_STATE_PEER_LOST,
+        { TEST_ARRAY_AND_SIZE(connect_ack_expected_data) },
+        &connect_ack_one_rr
+    },{
+        "ack_piggyback",
+        TEST_ARRAY_AND_COUNT(connect_ack_piggyback_pkt),
+        test_connect_snep_sap_echo, test_connect_complete,
+        NFC_PEER_CONNECT_OK, FALSE, NFC_LLC_STATE_PEER_LOST,
+        { TEST_ARRAY_AND_SIZE(connect_snep_name_ok_transfer_expected_data) },
+        &connect_ack_piggybacked
+    },{
+        "ack_window",
+        TEST_ARRAY_AND_COUNT(connect_ack_window_pkt),
+        test_connect_snep_sap_rw, test_connect_complete,
+        NFC_PEER_CONNECT_OK, FALSE, NFC_LLC_STATE_PEER_LOST,
+        { TEST_ARRAY_AND_SIZE(connect_ack_expected_data) },
+        &connect_ack_one_rr
+    },{
+        "ack_timer",
+        TEST_ARRAY_AND_COUNT(connect_ack_timer_pkt),
+        test_connect_snep_sap_ack_timer, test_connect_complete,
+        NFC_PEER_CONNECT_OK, FALSE, NFC_LLC_STATE_PEER_LOST,
+        { TEST_ARRAY_AND_SIZE(connect_snep_name_ok_transfer_expected_data) },
+        &connect_ack_one_rr
+    },{
+        "snep_sap_params",
+        TEST_ARRAY_AND_COUNT(connect_snep_sap_params_pkt),
+        test_connect_snep_sap_params, test_connect_complete,
+        NFC_PEER_CONNECT_OK, FALSE, NFC_LLC_STATE_PEER_LOST
     },{
         "snep_name_noservice/1",
         TEST_ARRAY_AND_COUNT(connect_snep_name_noservice_pkt),
@@ -1636,6 +2043,14 @@ static const guint8 send_cc_snep_data[] = {
     0x81, 0x84, 0x02, 0x02, 0x00, 0x00, 0x04, 0x01,
     0xff, 0x05, 0x01, 0x02, 
 };
+static const guint8 send_cc_snep_rw4_data[] = {
+    0x81, 0x84, 0x02, 0x02, 0x00, 0x00, 0x04, 0x01,
+    0xff, 0x05, 0x01, 0x04
+};
+static const guint8 send_cc_snep_rw15_data[] = {
+    0x81, 0x84, 0x02, 0x02, 0x00, 0x00, 0x04, 0x01,
+    0xff, 0x05, 0x01, 0x0f
+};
 static const guint8 send_frame_264[] = {
     0x00, 0x01, 0x02, 0x03, 0x03, 0x05, 0x06, 0x07,
     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
@@ -1703,6 +2118,9 @@ static const guint8 send_small_frames_i[] = {
 static const guint8 send_frame_rr_1[] = { 0x83, 0x44, 0x01 };
 static const guint8 send_frame_rr_2[] = { 0x83, 0x44, 0x02 };
 static const guint8 send_frame_rr_3[] = { 0x83, 0x44, 0x03 };
+static const guint8 send_frame_rr_4[] = { 0x83, 0x44, 0x04 };
+static const guint8 send_frame_rr_5[] = { 0x83, 0x44, 0x05 };
+static const guint8 send_frame_rr_8[] = { 0x83, 0x44, 0x08 };
 static const guint8 send_large_frame_i[] = {
     0x13, 0x20, 0x00,
     0x00, 0x01, 0x02, 0x03, 0x03, 0x05, 0x06, 0x07,
@@ -1722,7 +2140,30 @@ static const guint8 send_large_frame_i[] = {
     0x70, 0x71, 0x72, 0x73, 0x73, 0x75, 0x76, 0x77,
     0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f
 };
-static const guint8 send_large_frames_i_1[] = {
+static const guint8 send_extra_large_frame_i_1[] = { 0x13, 0x20, 0x10, 0x80 };
+static const guint8 send_window_agf[] = {
+    0x00, 0x80,
+    0x00, 0x04, 0x13, 0x20, 0x10, 0x01,
+    0x00, 0x04, 0x13, 0x20, 0x20, 0x02,
+    0x00, 0x04, 0x13, 0x20, 0x30, 0x03
+};
+static const guint8 send_window_i[] = {
+    0x13, 0x20, 0x40,
+    0x03, 0x05, 0x06, 0x07
+};
+static const guint8 send_agf[] = {
+    0x00, 0x80,
+    0x00, 0x04, 0x13, 0x20, 0x10, 0x01,
+    0x00, 0x04, 0x13, 0x20, 0x20, 0x02,
+    0x00, 0x04, 0x13, 0x20, 0x30, 0x03,
+    0x00, 0x04, 0x13, 0x20, 0x40, 0x03,
+    0x00, 0x04, 0x13, 0x20, 0x50, 0x05,
+    0x00, 0x04, 0x13, 0x20, 0x60, 0x06,
+    0x00, 0x04, 0x13, 0x20, 0x70, 0x07
+};
+static const guint8 send_large_frames_agf[] = {
+    0x00, 0x80,
+    0x00, 0x83,
     0x13, 0x20, 0x10,
     0x80, 0x81, 0x82, 0x83, 0x83, 0x85, 0x86, 0x87,
     0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
@@ -1739,13 +2180,51 @@ static const guint8 send_large_frames_i_1[] = {
     0xe0, 0xe1, 0xe2, 0xe3, 0xe3, 0xe5, 0xe6, 0xe7,
     0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
     0xf0, 0xf1, 0xf2, 0xf3, 0xf3, 0xf5, 0xf6, 0xf7,
-    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+    0x00, 0x0b,
+    0x13, 0x20, 0x20,
+    0x00, 0x01, 0x02, 0x03, 0x03, 0x05, 0x06, 0x07
 };
-static const guint8 send_large_frames_i_2[] = {
+static const guint8 send_large_frames_abort_agf[] = {
+    0x00, 0x80,
+    0x00, 0x4b,
+    0x13, 0x20, 0x10,
+    0x80, 0x81, 0x82, 0x83, 0x83, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x93, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa3, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb3, 0xb5, 0xb6, 0xb7,
+    0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc3, 0xc5, 0xc6, 0xc7,
+    0x00, 0x02,
+    0x11, 0x60
+};
+static const guint8 send_large_frames_disconnect_agf[] = {
+    0x00, 0x80,
+    0x00, 0x4b,
+    0x13, 0x20, 0x10,
+    0x80, 0x81, 0x82, 0x83, 0x83, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x93, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa3, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb3, 0xb5, 0xb6, 0xb7,
+    0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc3, 0xc5, 0xc6, 0xc7,
+    0x00, 0x43,
     0x13, 0x20, 0x20,
+    0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+    0xd0, 0xd1, 0xd2, 0xd3, 0xd3, 0xd5, 0xd6, 0xd7,
+    0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+    0xe0, 0xe1, 0xe2, 0xe3, 0xe3, 0xe5, 0xe6, 0xe7,
+    0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf3, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
     0x00, 0x01, 0x02, 0x03, 0x03, 0x05, 0x06, 0x07
 };
-static const guint8 send_extra_large_frame_i_1[] = { 0x13, 0x20, 0x10, 0x80 };
 static const TestTx send_no_frames_pkt [] = {
     {
         { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
@@ -1813,6 +2292,49 @@ static const TestTx send_small_frames_pkt [] = {
         { TEST_ARRAY_AND_SIZE(send_frame_rr_1) }
     }
 };
+static const TestTx send_window_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
+        { TEST_ARRAY_AND_SIZE(send_cc_snep_rw4_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* Each send queues another I PDU while this one is in flight */
+        { TEST_ARRAY_AND_SIZE(send_small_frame_i) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* Four I PDUs are unacknowledged now, RW(R) is full */
+        { TEST_ARRAY_AND_SIZE(send_window_agf) },
+        { TEST_ARRAY_AND_SIZE(send_frame_rr_4) }
+    },{
+        /* The rest of the data, accumulated while the window was full */
+        { TEST_ARRAY_AND_SIZE(send_window_i) },
+        { TEST_ARRAY_AND_SIZE(send_frame_rr_5) }
+    }
+};
+static const TestTx send_agf_pkt [] = {
+    {
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
+        { TEST_ARRAY_AND_SIZE(send_cc_snep_rw15_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        { TEST_ARRAY_AND_SIZE(send_small_frame_i) },
+        { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
+    },{
+        /* Seven I PDUs of the same connection in a single frame */
+        { TEST_ARRAY_AND_SIZE(send_agf) },
+        { TEST_ARRAY_AND_SIZE(send_frame_rr_8) }
+    }
+};
 static const TestTx send_large_frame_pkt [] = {
     {
         { TEST_ARRAY_AND_SIZE(symm_pdu_data) },
@@ -1833,13 +2355,12 @@ static const TestTx send_large_frames_pkt [] = {
         { TEST_ARRAY_AND_SIZE(connect_snep_sap_data) },
         { TEST_ARRAY_AND_SIZE(send_cc_snep_data) }
     },{
+        /* The second I PDU gets queued while this one is in flight */
         { TEST_ARRAY_AND_SIZE(send_large_frame_i) },
         { TEST_ARRAY_AND_SIZE(send_frame_rr_1) }
     },{
-        { TEST_ARRAY_AND_SIZE(send_large_frames_i_1) },
-        { TEST_ARRAY_AND_SIZE(send_frame_rr_2) }
-    },{
-        { TEST_ARRAY_AND_SIZE(send_large_frames_i_2) },
+        /* RW(R) is 2, the third one had to wait for the ack */
+        { TEST_ARRAY_AND_SIZE(send_large_frames_agf) },
         { TEST_ARRAY_AND_SIZE(send_frame_rr_3) }
     }
 };
@@ -1856,8 +2377,8 @@ static const TestTx send_large_frames_abort_pkt [] = {
     },{
         { TEST_ARRAY_AND_SIZE(send_large_frame_i) },
         { TEST_ARRAY_AND_SIZE(send_frame_rr_1) }
-    },{ /* The remaining data are dropped */
-        { TEST_ARRAY_AND_SIZE(disc_4_32_pdu_data) },
+    },{ /* The data which didn't fit into the window are dropped */
+        { TEST_ARRAY_AND_SIZE(send_large_frames_abort_agf) },
         { TEST_ARRAY_AND_SIZE(dm_32_4_pdu_data) }
     },{
         { TEST_ARRAY_AND_SIZE(symm_pdu_data) }
@@ -1877,10 +2398,7 @@ static const TestTx send_large_frames_disconnect_pkt [] = {
         { TEST_ARRAY_AND_SIZE(send_large_frame_i) },
         { TEST_ARRAY_AND_SIZE(send_frame_rr_1) }
     },{
-        { TEST_ARRAY_AND_SIZE(send_large_frames_i_1) },
-        { TEST_ARRAY_AND_SIZE(send_frame_rr_2) }
-    },{
-        { TEST_ARRAY_AND_SIZE(send_large_frames_i_2) },
+        { TEST_ARRAY_AND_SIZE(send_large_frames_disconnect_agf) },
         { TEST_ARRAY_AND_SIZE(send_frame_rr_3) }
     },{
         { TEST_ARRAY_AND_SIZE(disc_4_32_pdu_data) },
@@ -1928,6 +2446,18 @@ static const TestSendConfig send_tests [] = {
         TEST_ARRAY_AND_COUNT(send_small_frames_pkt),
         NULL, TEST_SEND_NO_FLAGS,
         8, NFC_LLC_CO_ACTIVE, NFC_LLC_STATE_PEER_LOST
+    },{
+        "window",
+        TEST_ARRAY_AND_COUNT(send_small_frames_send_data),
+        TEST_ARRAY_AND_COUNT(send_window_pkt),
+        NULL, TEST_SEND_LATER,
+        8, NFC_LLC_CO_ACTIVE, NFC_LLC_STATE_PEER_LOST
+    },{
+        "agf",
+        TEST_ARRAY_AND_COUNT(send_small_frames_send_data),
+        TEST_ARRAY_AND_COUNT(send_agf_pkt),
+        NULL, TEST_SEND_LATER,
+        8, NFC_LLC_CO_ACTIVE, NFC_LLC_STATE_PEER_LOST
     },{
         "large_frame",
         TEST_ARRAY_AND_COUNT(send_large_frame_send_data),
@@ -1945,7 +2475,7 @@ static const TestSendConfig send_tests [] = {
         TEST_ARRAY_AND_COUNT(send_large_frames_send_data),
         TEST_ARRAY_AND_COUNT(send_large_frames_abort_pkt),
         test_send_connected_abort, TEST_SEND_LATER,
-        128, NFC_LLC_CO_DEAD, NFC_LLC_STATE_ACTIVE
+        200, NFC_LLC_CO_DEAD, NFC_LLC_STATE_ACTIVE
     },{
         "large_frames_disconnect",
         TEST_ARRAY_AND_COUNT(send_large_frames_send_data),
@@ -2210,6 +2740,8 @@ int main(int argc, char* argv[])
     g_test_init(&argc, &argv, NULL);
     g_test_add_func(TEST_("null"), test_null);
     g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("poll/adaptive"), test_poll_adaptive);
+    g_test_add_func(TEST_("poll/fixed"), test_poll_fixed);
     g_test_add_func(TEST_("initiator"), test_initiator);
     for (i = 0; i < G_N_ELEMENTS(advanced_tests); i++) {
         const TestAdvancedData* test = advanced_tests + i;
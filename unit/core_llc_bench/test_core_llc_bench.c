@@ -0,0 +1,816 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+
+#include "nfc_types_p.h"
+#include "nfc_ndef.h"
+#include "nfc_llc.h"
+#include "nfc_llc_io.h"
+#include "nfc_llc_param.h"
+#include "nfc_peer_services.h"
+#include "nfc_peer_service_impl.h"
+#include "nfc_peer_connection_impl.h"
+#include "nfc_peer_socket.h"
+#include "nfc_snep_server.h"
+
+#include "test_common.h"
+#include "test_llc_loopback.h"
+
+#include <gutil_log.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+
+/*
+ * Runs SNEP PUTs and NfcPeerSocket bulk transfers between two NfcLlc
+ * instances connected back to back and reports the throughput, the
+ * number of PDUs per exchange and the acknowledgement overhead. The
+ * default sizes are small enough for a regular unit test run, the
+ * perf mode (-m perf) makes them TEST_PERF_SCALE times larger.
+ */
+
+static TestOpt test_opt;
+
+#define TEST_(name) "/core/llc_bench/" name
+#define TEST_SERVICE_NAME "bench"
+#define TEST_PERF_SCALE (16)
+#define TEST_WRITE_CHUNK (4096)
+
+#define SNEP_VERSION (0x10)
+#define SNEP_REQUEST_PUT (0x02)
+#define SNEP_HEADER_SIZE (6)
+#define NDEF_HEADER_SIZE (6) /* MB|ME, TNF Unknown, 32-bit payload length */
+
+static const guint8 param_tlv_data[] = {
+    0x01, 0x01, 0x11, 0x02, 0x02, 0x07, 0xff, 0x03,
+    0x02, 0x00, 0x13, 0x04, 0x01, 0xff, 0x07, 0x01,
+    0x03
+};
+static const GUtilData param_tlv = { TEST_ARRAY_AND_SIZE(param_tlv_data) };
+
+typedef struct test_bench_config {
+    const char* name;
+    TestLlcLoopbackConfig link;
+    guint ack_delay;    /* Milliseconds */
+    guint rw;           /* Local receive window, zero for default */
+    guint miu;          /* Local MIU, zero for default */
+    guint size;         /* Bytes per PUT or per bulk transfer */
+    guint count;        /* Number of PUTs */
+    gboolean reverse;   /* Target sends, Initiator receives */
+} TestBenchConfig;
+
+typedef struct test_bench {
+    const TestBenchConfig* config;
+    GMainLoop* loop;
+    TestLlcLoopback* link;
+    NfcLlcParam** params;
+    NfcPeerServices* services[2];
+    NfcLlc* llc[2];
+    NfcLlc* client;
+    NfcPeerService* client_service;
+    NfcPeerConnection* conn;
+    gulong conn_state_id;
+    GSourceFunc dead_fn;
+    guint dead_id;
+    GIOChannel* out;
+    GBytes* out_data;
+    gsize written;
+    guint write_id;
+    NfcPeerSocket* in;
+    GIOChannel* in_channel;
+    guint read_id;
+    guint64 received;
+    guint size;
+    guint started;
+    guint done;
+    gint64 start;
+    gint64 end;
+} TestBench;
+
+static
+guint8
+test_bench_pattern(
+    guint64 offset)
+{
+    return (guint8)(offset * 7 + (offset >> 8));
+}
+
+static
+void
+test_bench_fill(
+    guint8* data,
+    gsize size)
+{
+    gsize i;
+
+    for (i = 0; i < size; i++) {
+        data[i] = test_bench_pattern(i);
+    }
+}
+
+static
+GBytes*
+test_bench_data_new(
+    gsize size)
+{
+    guint8* data = g_malloc(size);
+
+    test_bench_fill(data, size);
+    return g_bytes_new_take(data, size);
+}
+
+/*==========================================================================*
+ * Test service
+ *==========================================================================*/
+
+typedef
+void
+(*TestBenchAcceptFunc)(
+    NfcPeerSocket* socket,
+    void* user_data);
+
+typedef NfcPeerServiceClass TestBenchServiceClass;
+typedef struct test_bench_service {
+    NfcPeerService service;
+    TestBenchAcceptFunc accept_fn;
+    void* accept_data;
+} TestBenchService;
+
+G_DEFINE_TYPE(TestBenchService, test_bench_service, NFC_TYPE_PEER_SERVICE)
+#define TEST_TYPE_BENCH_SERVICE (test_bench_service_get_type())
+#define TEST_BENCH_SERVICE(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_BENCH_SERVICE, TestBenchService))
+
+static
+NfcPeerConnection*
+test_bench_service_new_connect(
+    NfcPeerService* service,
+    guint8 rsap,
+    const char* name)
+{
+    NfcPeerSocket* s = nfc_peer_socket_new_connect(service, rsap, name);
+
+    return s ? NFC_PEER_CONNECTION(s) : NULL;
+}
+
+static
+NfcPeerConnection*
+test_bench_service_new_accept(
+    NfcPeerService* service,
+    guint8 rsap)
+{
+    TestBenchService* self = TEST_BENCH_SERVICE(service);
+    NfcPeerSocket* s = nfc_peer_socket_new_accept(service, rsap);
+
+    if (s) {
+        if (self->accept_fn) {
+            self->accept_fn(s, self->accept_data);
+        }
+        return NFC_PEER_CONNECTION(s);
+    }
+    return NULL;
+}
+
+static
+void
+test_bench_service_init(
+    TestBenchService* self)
+{
+}
+
+static
+void
+test_bench_service_class_init(
+    TestBenchServiceClass* klass)
+{
+    klass->new_connect = test_bench_service_new_connect;
+    klass->new_accept = test_bench_service_new_accept;
+}
+
+static
+NfcPeerService*
+test_bench_service_new(
+    const char* name,
+    TestBenchAcceptFunc accept_fn,
+    void* accept_data)
+{
+    TestBenchService* self = g_object_new(TEST_TYPE_BENCH_SERVICE, NULL);
+    NfcPeerService* service = &self->service;
+
+    self->accept_fn = accept_fn;
+    self->accept_data = accept_data;
+    nfc_peer_service_init_base(service, name);
+    return service;
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+static
+void
+test_bench_init(
+    TestBench* bench,
+    const TestBenchConfig* config,
+    NfcPeerService* client,
+    NfcPeerService* server)
+{
+    const guint c = config->reverse ? 1 : 0;
+    const guint s = !c;
+    TestLlcLoopback* link;
+
+    memset(bench, 0, sizeof(*bench));
+    bench->config = config;
+    bench->size = config->size * (g_test_perf() ? TEST_PERF_SCALE : 1);
+    bench->loop = g_main_loop_new(NULL, TRUE);
+    bench->link = link = test_llc_loopback_new(&config->link);
+    bench->params = nfc_llc_param_decode(&param_tlv);
+    bench->client_service = client;
+    if (config->rw) {
+        nfc_peer_service_set_rw(client, config->rw);
+        nfc_peer_service_set_rw(server, config->rw);
+    }
+    if (config->miu) {
+        nfc_peer_service_set_miu(client, config->miu);
+        nfc_peer_service_set_miu(server, config->miu);
+    }
+    nfc_peer_service_set_ack_delay(client, config->ack_delay);
+    nfc_peer_service_set_ack_delay(server, config->ack_delay);
+    bench->services[c] = nfc_peer_services_new();
+    bench->services[s] = nfc_peer_services_new();
+    g_assert(nfc_peer_services_add(bench->services[c], client));
+    g_assert(nfc_peer_services_add(bench->services[s], server));
+    bench->llc[0] = nfc_llc_new(link->initiator, bench->services[0],
+        nfc_llc_param_constify(bench->params));
+    bench->llc[1] = nfc_llc_new(link->target, bench->services[1],
+        nfc_llc_param_constify(bench->params));
+    bench->client = bench->llc[c];
+}
+
+static
+void
+test_bench_write_stop(
+    TestBench* bench)
+{
+    if (bench->write_id) {
+        g_source_remove(bench->write_id);
+        bench->write_id = 0;
+    }
+    if (bench->out) {
+        g_io_channel_unref(bench->out);
+        bench->out = NULL;
+    }
+    if (bench->out_data) {
+        g_bytes_unref(bench->out_data);
+        bench->out_data = NULL;
+    }
+}
+
+static
+gboolean
+test_bench_write_cb(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    TestBench* bench = user_data;
+    gsize size;
+    const guint8* data = g_bytes_get_data(bench->out_data, &size);
+
+    if (condition & G_IO_OUT) {
+        const gsize left = size - bench->written;
+        const ssize_t n = write(g_io_channel_unix_get_fd(channel),
+            data + bench->written, MIN(left, TEST_WRITE_CHUNK));
+
+        if (n > 0) {
+            bench->written += n;
+            if (bench->written < size) {
+                return G_SOURCE_CONTINUE;
+            }
+        } else if (n < 0 && errno == EAGAIN) {
+            return G_SOURCE_CONTINUE;
+        }
+    }
+    GDEBUG("Wrote %u bytes", (guint)bench->written);
+    bench->write_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_bench_write_start(
+    TestBench* bench,
+    GBytes* data)
+{
+    const int fd = nfc_peer_socket_fd(NFC_PEER_SOCKET(bench->conn));
+
+    g_assert(fd >= 0);
+    g_assert(fcntl(fd, F_SETFL, O_NONBLOCK) >= 0);
+    test_bench_write_stop(bench);
+    bench->out = g_io_channel_unix_new(fd);
+    bench->out_data = g_bytes_ref(data);
+    bench->written = 0;
+    bench->write_id = g_io_add_watch(bench->out, G_IO_OUT | G_IO_ERR |
+        G_IO_HUP, test_bench_write_cb, bench);
+}
+
+static
+void
+test_bench_connection_state_changed(
+    NfcPeerConnection* conn,
+    void* user_data)
+{
+    TestBench* bench = user_data;
+
+    /* Don't drop the connection from its own signal handler */
+    if (conn->state == NFC_LLC_CO_DEAD && !bench->dead_id) {
+        bench->dead_id = g_idle_add(bench->dead_fn, bench);
+    }
+}
+
+static
+void
+test_bench_connect(
+    TestBench* bench,
+    guint rsap,
+    const char* sn,
+    GSourceFunc dead_fn)
+{
+    bench->conn = sn ?
+        nfc_llc_connect_sn(bench->client, bench->client_service, sn,
+            NULL, NULL, NULL) :
+        nfc_llc_connect(bench->client, bench->client_service, rsap,
+            NULL, NULL, NULL);
+    g_assert(bench->conn);
+    nfc_peer_connection_ref(bench->conn);
+    bench->dead_fn = dead_fn;
+    bench->conn_state_id = nfc_peer_connection_add_state_changed_handler
+        (bench->conn, test_bench_connection_state_changed, bench);
+}
+
+static
+void
+test_bench_connection_free(
+    TestBench* bench)
+{
+    test_bench_write_stop(bench);
+    if (bench->conn) {
+        nfc_peer_connection_remove_handler(bench->conn,
+            bench->conn_state_id);
+        nfc_peer_connection_unref(bench->conn);
+        bench->conn_state_id = 0;
+        bench->conn = NULL;
+    }
+}
+
+static
+gdouble
+test_bench_rate(
+    TestBench* bench,
+    guint64 bytes)
+{
+    const gint64 usec = MAX(bench->end - bench->start, 1);
+
+    return bytes * (gdouble)G_USEC_PER_SEC / usec;
+}
+
+static
+void
+test_bench_report(
+    TestBench* bench,
+    guint64 bytes)
+{
+    const char* name = bench->config->name;
+    const TestLlcLoopbackStats* stats = &bench->link->stats;
+    const NfcLlcAckStats* ack0 = nfc_llc_ack_stats(bench->llc[0]);
+    const NfcLlcAckStats* ack1 = nfc_llc_ack_stats(bench->llc[1]);
+    const gint64 usec = MAX(bench->end - bench->start, 1);
+    const gdouble rate = test_bench_rate(bench, bytes);
+    const gdouble pdus = stats->exchanges ?
+        ((gdouble)stats->pdus / stats->exchanges) : 0;
+    const gdouble overhead = stats->i_pdus ?
+        ((gdouble)stats->ack_pdus / stats->i_pdus) : 0;
+
+    g_test_message("%s: %" G_GUINT64_FORMAT " bytes in %.3f s, "
+        "%u exchanges, %u frames (%u SYMM, %" G_GUINT64_FORMAT " bytes)",
+        name, bytes, usec / (gdouble)G_USEC_PER_SEC, stats->exchanges,
+        stats->frames, stats->symm, stats->bytes);
+    g_test_message("%s: %u RF frames (%u lost), %u I PDUs, %u RR/RNR, "
+        "%u acks piggybacked", name, stats->rf_frames, stats->lost,
+        stats->i_pdus, ack0->sent + ack1->sent,
+        ack0->piggybacked + ack1->piggybacked);
+    g_test_maximized_result(rate, "%s: %.0f bytes/s", name, rate);
+    g_test_maximized_result(pdus, "%s: %.2f PDUs per exchange", name, pdus);
+    g_test_minimized_result(overhead, "%s: %.3f RR/RNR per I PDU", name,
+        overhead);
+
+    /* The link must have been carrying acks, one way or another */
+    g_assert(!stats->i_pdus || stats->ack_pdus ||
+        ack0->piggybacked || ack1->piggybacked);
+}
+
+static
+void
+test_bench_deinit(
+    TestBench* bench)
+{
+    test_bench_connection_free(bench);
+    if (bench->dead_id) {
+        g_source_remove(bench->dead_id);
+    }
+    if (bench->read_id) {
+        g_source_remove(bench->read_id);
+    }
+    if (bench->in_channel) {
+        g_io_channel_unref(bench->in_channel);
+    }
+    if (bench->in) {
+        nfc_peer_connection_unref(NFC_PEER_CONNECTION(bench->in));
+    }
+    nfc_llc_free(bench->llc[0]);
+    nfc_llc_free(bench->llc[1]);
+    nfc_peer_services_unref(bench->services[0]);
+    nfc_peer_services_unref(bench->services[1]);
+    nfc_llc_param_free(bench->params);
+    test_llc_loopback_free(bench->link);
+    g_main_loop_unref(bench->loop);
+}
+
+/*==========================================================================*
+ * snep
+ *==========================================================================*/
+
+static
+GBytes*
+test_bench_snep_put_new(
+    guint size)
+{
+    const guint ndef_size = NDEF_HEADER_SIZE + size;
+    const gsize total = SNEP_HEADER_SIZE + ndef_size;
+    guint8* buf = g_malloc(total);
+    guint8* ptr = buf;
+
+    *ptr++ = SNEP_VERSION;
+    *ptr++ = SNEP_REQUEST_PUT;
+    *ptr++ = (guint8)(ndef_size >> 24);
+    *ptr++ = (guint8)(ndef_size >> 16);
+    *ptr++ = (guint8)(ndef_size >> 8);
+    *ptr++ = (guint8)ndef_size;
+    *ptr++ = 0xc5; /* MB|ME, TNF Unknown */
+    *ptr++ = 0x00; /* No type */
+    *ptr++ = (guint8)(size >> 24);
+    *ptr++ = (guint8)(size >> 16);
+    *ptr++ = (guint8)(size >> 8);
+    *ptr++ = (guint8)size;
+    test_bench_fill(ptr, size);
+    return g_bytes_new_take(buf, total);
+}
+
+static
+gboolean
+test_bench_snep_next(
+    gpointer user_data)
+{
+    TestBench* bench = user_data;
+
+    bench->dead_id = 0;
+    test_bench_connection_free(bench);
+    g_assert_cmpuint(bench->done, == ,bench->started);
+    if (bench->started < bench->config->count) {
+        GBytes* put = test_bench_snep_put_new(bench->size);
+
+        bench->started++;
+        test_bench_connect(bench, NFC_LLC_SAP_SNEP, NULL,
+            test_bench_snep_next);
+        test_bench_write_start(bench, put);
+        g_bytes_unref(put);
+    } else {
+        bench->end = g_get_monotonic_time();
+        g_main_loop_quit(bench->loop);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_bench_snep_ndef_changed(
+    NfcSnepServer* snep,
+    void* user_data)
+{
+    TestBench* bench = user_data;
+    NfcNdefRec* ndef = snep->ndef;
+
+    g_assert(ndef);
+    g_assert_cmpuint(ndef->payload.size, == ,bench->size);
+    g_assert_cmpuint(ndef->payload.bytes[bench->size - 1], == ,
+        test_bench_pattern(bench->size - 1));
+    bench->done++;
+    GDEBUG("PUT #%u done", bench->done);
+}
+
+static
+void
+test_snep(
+    gconstpointer test_data)
+{
+    const TestBenchConfig* config = test_data;
+    NfcPeerService* client = test_bench_service_new(NULL, NULL, NULL);
+    NfcSnepServer* snep = nfc_snep_server_new();
+    TestBench bench;
+    gulong id;
+
+    test_bench_init(&bench, config, client, NFC_PEER_SERVICE(snep));
+    id = nfc_snep_server_add_ndef_changed_handler(snep,
+        test_bench_snep_ndef_changed, &bench);
+
+    bench.start = g_get_monotonic_time();
+    test_bench_snep_next(&bench);
+    test_run(&test_opt, bench.loop);
+    g_assert_cmpuint(bench.done, == ,config->count);
+    test_bench_report(&bench, (guint64)bench.size * bench.done);
+
+    nfc_snep_server_remove_handler(snep, id);
+    test_bench_deinit(&bench);
+    nfc_peer_service_unref(client);
+    nfc_peer_service_unref(NFC_PEER_SERVICE(snep));
+}
+
+/*==========================================================================*
+ * bulk
+ *==========================================================================*/
+
+static
+gboolean
+test_bench_bulk_read_cb(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    TestBench* bench = user_data;
+    guint8 buf[TEST_WRITE_CHUNK];
+    const ssize_t n = read(g_io_channel_unix_get_fd(channel), buf,
+        sizeof(buf));
+
+    if (n > 0) {
+        ssize_t i;
+
+        for (i = 0; i < n; i++) {
+            g_assert_cmpuint(buf[i], == ,
+                test_bench_pattern(bench->received + i));
+        }
+        bench->received += n;
+        g_assert_cmpuint(bench->received, <= ,bench->size);
+        if (bench->received == bench->size) {
+            /* Everything has arrived, close the connection */
+            GDEBUG("Received %u bytes", bench->size);
+            bench->end = g_get_monotonic_time();
+            nfc_peer_connection_disconnect(bench->conn);
+        }
+        return G_SOURCE_CONTINUE;
+    } else if (n < 0 && errno == EAGAIN) {
+        return G_SOURCE_CONTINUE;
+    }
+    bench->read_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_bench_bulk_accept(
+    NfcPeerSocket* socket,
+    void* user_data)
+{
+    TestBench* bench = user_data;
+    const int fd = nfc_peer_socket_fd(socket);
+
+    g_assert(!bench->in);
+    g_assert(fd >= 0);
+    g_assert(fcntl(fd, F_SETFL, O_NONBLOCK) >= 0);
+    bench->in = socket;
+    nfc_peer_connection_ref(NFC_PEER_CONNECTION(socket));
+    bench->in_channel = g_io_channel_unix_new(fd);
+    bench->read_id = g_io_add_watch(bench->in_channel, G_IO_IN |
+        G_IO_ERR | G_IO_HUP, test_bench_bulk_read_cb, bench);
+}
+
+static
+gboolean
+test_bench_bulk_done(
+    gpointer user_data)
+{
+    TestBench* bench = user_data;
+
+    bench->dead_id = 0;
+    g_main_loop_quit(bench->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gdouble
+test_bench_bulk_run(
+    const TestBenchConfig* config,
+    TestLlcLoopbackStats* stats)
+{
+    NfcPeerService* client = test_bench_service_new(NULL, NULL, NULL);
+    NfcPeerService* server;
+    TestBench bench;
+    GBytes* data;
+    gdouble rate;
+
+    server = test_bench_service_new(TEST_SERVICE_NAME,
+        test_bench_bulk_accept, &bench);
+    test_bench_init(&bench, config, client, server);
+    data = test_bench_data_new(bench.size);
+
+    bench.start = g_get_monotonic_time();
+    test_bench_connect(&bench, 0, TEST_SERVICE_NAME, test_bench_bulk_done);
+    test_bench_write_start(&bench, data);
+    g_bytes_unref(data);
+    test_run(&test_opt, bench.loop);
+    g_assert(bench.in);
+    g_assert_cmpuint(bench.received, == ,bench.size);
+    g_assert_cmpuint(bench.conn->bytes_sent, == ,bench.size);
+    test_bench_report(&bench, bench.received);
+    rate = test_bench_rate(&bench, bench.received);
+    if (stats) {
+        *stats = bench.link->stats;
+    }
+
+    test_bench_deinit(&bench);
+    nfc_peer_service_unref(client);
+    nfc_peer_service_unref(server);
+    return rate;
+}
+
+static
+void
+test_bulk(
+    gconstpointer test_data)
+{
+    test_bench_bulk_run(test_data, NULL);
+}
+
+/*==========================================================================*
+ * compare
+ *==========================================================================*/
+
+typedef struct test_bench_compare {
+    const char* name;
+    TestBenchConfig base;
+    TestBenchConfig tuned;
+} TestBenchCompare;
+
+static
+void
+test_compare(
+    gconstpointer test_data)
+{
+    const TestBenchCompare* test = test_data;
+    TestLlcLoopbackStats base, tuned;
+    const gdouble base_rate = test_bench_bulk_run(&test->base, &base);
+    const gdouble tuned_rate = test_bench_bulk_run(&test->tuned, &tuned);
+    const gdouble gain = tuned_rate / MAX(base_rate, 1);
+
+    g_test_message("%s: %u exchanges (%s) vs %u (%s)", test->name,
+        base.exchanges, test->base.name, tuned.exchanges, test->tuned.name);
+    g_test_maximized_result(gain, "%s: %.2fx throughput", test->name, gain);
+
+    /* The link is lossless, the number of exchanges is deterministic */
+    g_assert_cmpuint(tuned.exchanges, < ,base.exchanges);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+static const TestBenchConfig snep_tests[] = {
+    {
+        "ideal", { 0, 0, 0, 0 }, 0, 0, 0, 1024, 4, FALSE
+    },{
+        "small_frames", { 1, 64, 0, 0 }, 0, 0, 0, 1024, 2, FALSE
+    },{
+        "lossy", { 1, 254, 10, 5 }, 0, 0, 0, 1024, 2, FALSE
+    },{
+        "reverse", { 0, 0, 0, 0 }, 0, 0, 0, 1024, 4, TRUE
+    }
+};
+
+static const TestBenchConfig bulk_tests[] = {
+    {
+        "ideal", { 0, 0, 0, 0 }, 0, 0, 0, 65536, 1, FALSE
+    },{
+        "reverse", { 0, 0, 0, 0 }, 0, 0, 0, 65536, 1, TRUE
+    },{
+        "rw1", { 0, 0, 0, 0 }, 0, 1, 0, 65536, 1, FALSE
+    },{
+        "ack_delay", { 0, 0, 0, 0 }, 5, 0, 0, 65536, 1, FALSE
+    },{
+        "latency", { 1, 254, 0, 0 }, 0, 0, 0, 16384, 1, FALSE
+    },{
+        "lossy", { 1, 254, 5, 10 }, 0, 0, 0, 16384, 1, FALSE
+    }
+};
+
+/*
+ * The baseline is what LLCP specifies by default, i.e. RW 1 and 128-byte
+ * MIU. The receive window only makes a difference if the I PDUs are small
+ * enough for several of them to fit into one frame, while a large MIU
+ * pays off even when each I PDU has to be acknowledged separately.
+ */
+#define TEST_COMPARE_LINK { 1, 254, 0, 0 }
+#define TEST_COMPARE_SIZE (16384)
+#define TEST_COMPARE_BASE \
+    { "rw1_miu128", TEST_COMPARE_LINK, 0, 1, NFC_LLC_MIU_MIN, \
+      TEST_COMPARE_SIZE, 1, FALSE }
+
+static const TestBenchCompare compare_tests[] = {
+    {
+        "rw", TEST_COMPARE_BASE,
+        { "rw15_miu128", TEST_COMPARE_LINK, 0, NFC_LLC_RW_MAX,
+          NFC_LLC_MIU_MIN, TEST_COMPARE_SIZE, 1, FALSE }
+    },{
+        "miu", TEST_COMPARE_BASE,
+        { "rw1_miu2175", TEST_COMPARE_LINK, 0, 1, NFC_LLC_MIU_MAX,
+          TEST_COMPARE_SIZE, 1, FALSE }
+    },{
+        "default", TEST_COMPARE_BASE,
+        { "local_default", TEST_COMPARE_LINK, 0, 0, 0,
+          TEST_COMPARE_SIZE, 1, FALSE }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    guint i;
+
+    g_test_init(&argc, &argv, NULL);
+    for (i = 0; i < G_N_ELEMENTS(snep_tests); i++) {
+        const TestBenchConfig* test = snep_tests + i;
+        char* path = g_strconcat(TEST_("snep/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_snep);
+        g_free(path);
+    }
+    for (i = 0; i < G_N_ELEMENTS(bulk_tests); i++) {
+        const TestBenchConfig* test = bulk_tests + i;
+        char* path = g_strconcat(TEST_("bulk/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_bulk);
+        g_free(path);
+    }
+    for (i = 0; i < G_N_ELEMENTS(compare_tests); i++) {
+        const TestBenchCompare* test = compare_tests + i;
+        char* path = g_strconcat(TEST_("compare/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_compare);
+        g_free(path);
+    }
+    signal(SIGPIPE, SIG_IGN);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
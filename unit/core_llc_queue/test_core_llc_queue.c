@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "nfc_llc_queue.h"
+
+#include "test_common.h"
+
+static TestOpt test_opt;
+
+static
+GBytes*
+test_pdu_new(
+    guint id)
+{
+    guint8 pkt[2];
+
+    pkt[0] = (guint8)(id >> 8);
+    pkt[1] = (guint8)id;
+    return g_bytes_new(pkt, sizeof(pkt));
+}
+
+static
+guint
+test_pdu_id(
+    GBytes* pdu)
+{
+    gsize size;
+    const guint8* pkt = g_bytes_get_data(pdu, &size);
+
+    g_assert_cmpuint(size, == ,2);
+    return (((guint)pkt[0]) << 8) | pkt[1];
+}
+
+static
+void
+test_push(
+    NfcLlcQueue* queue,
+    NFC_LLC_QUEUE_CLASS cls,
+    guint id)
+{
+    GBytes* pdu = test_pdu_new(id);
+
+    nfc_llc_queue_push(queue, cls, pdu);
+    g_bytes_unref(pdu);
+}
+
+static
+void
+test_pop(
+    NfcLlcQueue* queue,
+    guint id)
+{
+    GBytes* pdu = nfc_llc_queue_pop(queue);
+
+    g_assert(pdu);
+    g_assert_cmpuint(test_pdu_id(pdu), == ,id);
+    g_bytes_unref(pdu);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    NfcLlcQueue* queue = nfc_llc_queue_new();
+    GBytes* pdu = test_pdu_new(0);
+
+    nfc_llc_queue_free(NULL);
+    nfc_llc_queue_push(NULL, NFC_LLC_QUEUE_DATA, pdu);
+    nfc_llc_queue_push(queue, NFC_LLC_QUEUE_DATA, NULL);
+    nfc_llc_queue_push(queue, NFC_LLC_QUEUE_CLASS_COUNT, pdu);
+    g_assert(!nfc_llc_queue_pop(NULL));
+    g_assert(!nfc_llc_queue_peek(NULL, 0));
+    g_assert_cmpuint(nfc_llc_queue_size(NULL), == ,0);
+    g_assert_cmpuint(nfc_llc_queue_count(NULL, NFC_LLC_QUEUE_DATA), == ,0);
+    g_assert_cmpuint(nfc_llc_queue_count(queue,
+        NFC_LLC_QUEUE_CLASS_COUNT), == ,0);
+
+    /* Nothing has been queued */
+    g_assert_cmpuint(nfc_llc_queue_size(queue), == ,0);
+    g_assert(!nfc_llc_queue_pop(queue));
+    g_assert(!nfc_llc_queue_peek(queue, 0));
+
+    g_bytes_unref(pdu);
+    nfc_llc_queue_free(queue);
+}
+
+/*==========================================================================*
+ * fifo
+ *==========================================================================*/
+
+static
+void
+test_fifo(
+    void)
+{
+    NfcLlcQueue* queue = nfc_llc_queue_new();
+    guint head = 0, tail = 0;
+    guint i, k;
+
+    /* Wrap around and grow the ring a few times */
+    for (k = 0; k < 5; k++) {
+        for (i = 0; i < 7 * (k + 1); i++) {
+            test_push(queue, NFC_LLC_QUEUE_DATA, tail++);
+        }
+        g_assert_cmpuint(nfc_llc_queue_size(queue), == ,tail - head);
+        for (i = 0; i < tail - head; i++) {
+            GBytes* pdu = nfc_llc_queue_peek(queue, i);
+
+            g_assert(pdu);
+            g_assert_cmpuint(test_pdu_id(pdu), == ,head + i);
+        }
+        g_assert(!nfc_llc_queue_peek(queue, tail - head));
+        for (i = 0; i < 5 * (k + 1); i++) {
+            test_pop(queue, head++);
+        }
+    }
+
+    /* Leave some PDUs in the queue, they get freed by nfc_llc_queue_free */
+    g_assert_cmpuint(nfc_llc_queue_count(queue, NFC_LLC_QUEUE_DATA), == ,
+        tail - head);
+    g_assert_cmpuint(nfc_llc_queue_count(queue, NFC_LLC_QUEUE_CONTROL), == ,
+        0);
+    nfc_llc_queue_free(queue);
+}
+
+/*==========================================================================*
+ * priority
+ *==========================================================================*/
+
+static
+void
+test_priority(
+    void)
+{
+    NfcLlcQueue* queue = nfc_llc_queue_new();
+
+    test_push(queue, NFC_LLC_QUEUE_DATA, 1);
+    test_push(queue, NFC_LLC_QUEUE_DATA, 2);
+    test_push(queue, NFC_LLC_QUEUE_CONTROL, 3);
+    test_push(queue, NFC_LLC_QUEUE_DATA, 4);
+    test_push(queue, NFC_LLC_QUEUE_CONTROL, 5);
+    g_assert_cmpuint(nfc_llc_queue_size(queue), == ,5);
+    g_assert_cmpuint(nfc_llc_queue_count(queue, NFC_LLC_QUEUE_CONTROL), == ,
+        2);
+    g_assert_cmpuint(nfc_llc_queue_count(queue, NFC_LLC_QUEUE_DATA), == ,3);
+
+    /* Control PDUs go first */
+    g_assert_cmpuint(test_pdu_id(nfc_llc_queue_peek(queue, 0)), == ,3);
+    g_assert_cmpuint(test_pdu_id(nfc_llc_queue_peek(queue, 1)), == ,5);
+    g_assert_cmpuint(test_pdu_id(nfc_llc_queue_peek(queue, 2)), == ,1);
+    g_assert_cmpuint(test_pdu_id(nfc_llc_queue_peek(queue, 4)), == ,4);
+    g_assert(!nfc_llc_queue_peek(queue, 5));
+
+    test_pop(queue, 3);
+    test_push(queue, NFC_LLC_QUEUE_CONTROL, 6);
+    test_pop(queue, 5);
+    test_pop(queue, 6);
+    test_pop(queue, 1);
+    test_push(queue, NFC_LLC_QUEUE_CONTROL, 7);
+    test_pop(queue, 7);
+    test_pop(queue, 2);
+    test_pop(queue, 4);
+    g_assert(!nfc_llc_queue_pop(queue));
+    g_assert_cmpuint(nfc_llc_queue_size(queue), == ,0);
+    nfc_llc_queue_free(queue);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/core/llc_queue/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("fifo"), test_fifo);
+    g_test_add_func(TEST_("priority"), test_priority);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
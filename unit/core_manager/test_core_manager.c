@@ -42,10 +42,13 @@
 #include "test_service.h"
 #include "test_host_app.h"
 #include "test_host_service.h"
+#include "test_target.h"
 
 #include "nfc_manager_p.h"
 #include "internal/nfc_manager_i.h"
 #include "nfc_adapter_impl.h"
+#include "nfc_tag.h"
+#include "nfc_target_recorder.h"
 
 #include <gutil_log.h>
 
@@ -255,6 +258,10 @@ test_null(
 
     /* The internal APIs are NULL tolerant too */
     g_assert(!nfc_manager_start(NULL));
+    nfc_manager_set_t2_cache_dir(NULL, NULL);
+    g_assert(!nfc_manager_t2_cache(NULL));
+    nfc_manager_set_trace_dir(NULL, NULL);
+    g_assert(!nfc_manager_trace_dir(NULL));
     g_assert(!nfc_manager_peer_services(NULL));
     g_assert(!nfc_manager_host_services(NULL));
     g_assert(!nfc_manager_host_apps(NULL));
@@ -574,6 +581,83 @@ test_block(
     nfc_adapter_unref(adapter);
 }
 
+/*==========================================================================*
+ * record
+ *==========================================================================*/
+
+static
+void
+test_record(
+    void)
+{
+    static const guint8 cmd[] = { 0x30, 0x00 };
+    static const guint8 resp[] = { 0x01, 0x02, 0x03, 0x04 };
+    NfcPluginsInfo pi;
+    NfcManager* manager;
+    NfcAdapter* adapter = NFC_ADAPTER(test_adapter_new());
+    NfcTarget* target = test_target_new_with_data(cmd, sizeof(cmd),
+        resp, sizeof(resp));
+    char* tmp = g_dir_make_tmp("test_XXXXXX", NULL);
+    char* dir = g_build_filename(tmp, "trace", NULL);
+    const char* adapter_name;
+    char* path;
+    gchar* contents = NULL;
+    gsize size = 0;
+    NfcTag* tag;
+    GDir* d;
+
+    memset(&pi, 0, sizeof(pi));
+    manager = nfc_manager_new(&pi);
+
+    /* The directory gets created */
+    nfc_manager_set_trace_dir(manager, dir);
+    g_assert_cmpstr(nfc_manager_trace_dir(manager), == ,dir);
+    g_assert(g_file_test(dir, G_FILE_TEST_IS_DIR));
+
+    /* Each tag gets recorded into a separate file */
+    adapter_name = nfc_manager_add_adapter(manager, adapter);
+    tag = nfc_adapter_add_other_tag2(adapter, target, NULL);
+    g_assert(tag);
+    g_assert(nfc_target_transmit(target, cmd, sizeof(cmd), NULL, NULL,
+        NULL, NULL));
+
+    /* Removing the tag closes the file */
+    nfc_adapter_remove_tag(adapter, tag->name);
+    d = g_dir_open(dir, 0, NULL);
+    g_assert(d);
+    path = g_build_filename(dir, g_dir_read_name(d), NULL);
+    g_assert(!g_dir_read_name(d));
+    g_dir_close(d);
+
+    g_assert(g_str_has_prefix(path + strlen(dir) + 1, adapter_name));
+    g_assert(g_str_has_suffix(path, ".nfct"));
+    g_assert(g_file_get_contents(path, &contents, &size, NULL));
+    g_assert_cmpuint(size, == ,NFC_TARGET_TRACE_HEADER_SIZE +
+        NFC_TARGET_TRACE_RECORD_SIZE + sizeof(cmd));
+    g_assert(!memcmp(contents, NFC_TARGET_TRACE_MAGIC, 4));
+    g_assert_cmpuint(contents[NFC_TARGET_TRACE_HEADER_SIZE], == ,
+        NFC_TARGET_TRACE_TRANSMIT);
+    g_assert(!memcmp(contents + NFC_TARGET_TRACE_HEADER_SIZE +
+        NFC_TARGET_TRACE_RECORD_SIZE, cmd, sizeof(cmd)));
+
+    /* And the recording can be switched off */
+    nfc_manager_set_trace_dir(manager, NULL);
+    g_assert(!nfc_manager_trace_dir(manager));
+
+    nfc_manager_remove_adapter(manager, adapter_name);
+    nfc_manager_unref(manager);
+    nfc_adapter_unref(adapter);
+    nfc_target_unref(target);
+
+    remove(path);
+    remove(dir);
+    remove(tmp);
+    g_free(contents);
+    g_free(path);
+    g_free(dir);
+    g_free(tmp);
+}
+
 /*==========================================================================*
  * tech
  *==========================================================================*/
@@ -870,6 +954,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("mode"), test_mode);
     g_test_add_func(TEST_("tech"), test_tech);
     g_test_add_func(TEST_("block"), test_block);
+    g_test_add_func(TEST_("record"), test_record);
     g_test_add_func(TEST_("service"), test_service);
     g_test_add_func(TEST_("host_service"), test_host_service);
     g_test_add_func(TEST_("host_app"), test_host_app);
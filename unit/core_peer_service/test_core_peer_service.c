@@ -35,6 +35,7 @@
 
 #include "nfc_peer_service_p.h"
 #include "nfc_llc.h"
+#include "nfc_llc_param.h"
 
 #include <gutil_log.h>
 
@@ -54,6 +55,9 @@ test_null(
     g_assert(!nfc_peer_service_ref(NULL));
     nfc_peer_service_unref(NULL);
     nfc_peer_service_disconnect_all(NULL);
+    nfc_peer_service_set_rw(NULL, 0);
+    nfc_peer_service_set_miu(NULL, 0);
+    nfc_peer_service_set_ack_delay(NULL, 0);
 }
 
 /*==========================================================================*
@@ -96,6 +100,47 @@ test_snep_sap(
     nfc_peer_service_unref(service);
 }
 
+/*==========================================================================*
+ * params
+ *==========================================================================*/
+
+static
+void
+test_params(
+    void)
+{
+    TestService* test_service = test_service_new("foo");
+    NfcPeerService* service = NFC_PEER_SERVICE(test_service);
+
+    g_assert_cmpuint(nfc_peer_service_rw(service), == ,NFC_LLC_LOCAL_RW);
+    g_assert_cmpuint(nfc_peer_service_miu(service), == ,NFC_LLC_LOCAL_MIU);
+    g_assert_cmpuint(nfc_peer_service_ack_delay(service), == ,0);
+
+    nfc_peer_service_set_rw(service, 4);
+    nfc_peer_service_set_miu(service, 256);
+    nfc_peer_service_set_ack_delay(service, 20);
+    g_assert_cmpuint(nfc_peer_service_rw(service), == ,4);
+    g_assert_cmpuint(nfc_peer_service_miu(service), == ,256);
+    g_assert_cmpuint(nfc_peer_service_ack_delay(service), == ,20);
+
+    /* Out of range values get clamped */
+    nfc_peer_service_set_rw(service, NFC_LLC_RW_MAX + 1);
+    nfc_peer_service_set_miu(service, NFC_LLC_MIU_MIN - 1);
+    g_assert_cmpuint(nfc_peer_service_rw(service), == ,NFC_LLC_RW_MAX);
+    g_assert_cmpuint(nfc_peer_service_miu(service), == ,NFC_LLC_MIU_MIN);
+    nfc_peer_service_set_miu(service, NFC_LLC_MIU_MAX + 1);
+    g_assert_cmpuint(nfc_peer_service_miu(service), == ,NFC_LLC_MIU_MAX);
+
+    /* Zero restores the defaults */
+    nfc_peer_service_set_rw(service, 0);
+    nfc_peer_service_set_miu(service, 0);
+    nfc_peer_service_set_ack_delay(service, 0);
+    g_assert_cmpuint(nfc_peer_service_rw(service), == ,NFC_LLC_LOCAL_RW);
+    g_assert_cmpuint(nfc_peer_service_miu(service), == ,NFC_LLC_LOCAL_MIU);
+    g_assert_cmpuint(nfc_peer_service_ack_delay(service), == ,0);
+    nfc_peer_service_unref(service);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -106,6 +151,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("null"), test_null);
     g_test_add_func(TEST_("basic"), test_basic);
     g_test_add_func(TEST_("snep_sap"), test_snep_sap);
+    g_test_add_func(TEST_("params"), test_params);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
@@ -33,6 +33,7 @@
 
 #include "nfc_tag_p.h"
 #include "nfc_tag_t2.h"
+#include "nfc_tag_t2_cache.h"
 #include "nfc_target_impl.h"
 #include "nfc_ndef.h"
 
@@ -354,9 +355,10 @@ static const guint8 test_data_ntag216[] = { /* "https://www.merproject.org" */
 
 static
 NfcTagType2*
-test_tag_new(
+test_tag_new_with_cache(
     TestTargetT2* test,
-    guint8 sel_res)
+    guint8 sel_res,
+    NfcTagType2Cache* cache)
 {
     static const guint8 nfcid1[] = {0x04, 0x9b, 0xfb, 0x4a, 0xeb, 0x2b, 0x80};
     NfcParamPollA param;
@@ -365,11 +367,20 @@ test_tag_new(
     memset(&param, 0, sizeof(param));
     TEST_BYTES_SET(param.nfcid1, nfcid1);
     param.sel_res = sel_res;
-    tag = nfc_tag_t2_new(&test->target, &param);
+    tag = nfc_tag_t2_new(&test->target, &param, cache);
     g_assert(tag);
     return tag;
 }
 
+static
+NfcTagType2*
+test_tag_new(
+    TestTargetT2* test,
+    guint8 sel_res)
+{
+    return test_tag_new_with_cache(test, sel_res, NULL);
+}
+
 /*==========================================================================*
  * null
  *==========================================================================*/
@@ -382,8 +393,8 @@ test_null(
     NfcTarget* target = g_object_new(TEST_TYPE_TARGET_T2, NULL);
 
     /* Public interfaces are NULL tolerant */
-    g_assert(!nfc_tag_t2_new(NULL, NULL));
-    g_assert(!nfc_tag_t2_new(target, NULL));
+    g_assert(!nfc_tag_t2_new(NULL, NULL, NULL));
+    g_assert(!nfc_tag_t2_new(target, NULL, NULL));
     g_assert(!nfc_tag_t2_read(NULL, 0, 0, NULL, NULL, NULL));
     g_assert(!nfc_tag_t2_read_data(NULL, 0, 0, NULL, NULL, NULL));
     g_assert(nfc_tag_t2_read_data_sync(NULL, 0, 0, NULL) ==
@@ -1616,6 +1627,855 @@ test_write_data_err2(
     g_main_loop_unref(loop);
 }
 
+/*==========================================================================*
+ * Sectors
+ *==========================================================================*/
+
+#define TEST_SECTORS_DATA_SIZE (1264) /* 1008 bytes in sector 0 + 256 */
+#define TEST_SECTORS_SIZE (TEST_SECTORS_DATA_SIZE + TEST_TARGET_T2_DATA_OFFSET)
+#define TEST_SECTORS_DATA0_SIZE \
+    (TEST_TARGET_T2_SECTOR_SIZE - TEST_TARGET_T2_DATA_OFFSET)
+#define TEST_SECTORS_READ_OFFSET (1000)
+#define TEST_SECTORS_READ_SIZE (32)
+#define TEST_SECTORS_WRITE_OFFSET (1006)
+
+static
+TestTargetT2*
+test_sectors_target_new(
+    void)
+{
+    guint8* bytes = g_malloc(TEST_SECTORS_SIZE);
+    TestTargetT2* test;
+    guint i;
+
+    /* Contents of the data area don't repeat from sector to sector */
+    memcpy(bytes, test_data_empty, TEST_TARGET_T2_DATA_OFFSET);
+    bytes[14] = TEST_SECTORS_DATA_SIZE / 8;
+    for (i = TEST_TARGET_T2_DATA_OFFSET; i < TEST_SECTORS_SIZE; i++) {
+        bytes[i] = (guint8)(i ^ (i >> 8));
+    }
+
+    /* Empty NDEF followed by Terminator TLV */
+    bytes[TEST_TARGET_T2_DATA_OFFSET] = 0x03;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 1] = 0x00;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 2] = 0xfe;
+
+    test = test_target_t2_new(bytes, TEST_SECTORS_SIZE);
+    g_free(bytes);
+    return test;
+}
+
+static
+void
+test_sectors_init_done(
+    NfcTag* tag,
+    void* loop)
+{
+    g_main_loop_quit((GMainLoop*)loop);
+}
+
+static
+NfcTagType2*
+test_sectors_tag_new(
+    TestTargetT2* test,
+    GMainLoop* loop)
+{
+    NfcTagType2* t2 = test_tag_new(test, 0);
+    NfcTag* tag = &t2->tag;
+    gulong id = nfc_tag_add_initialized_handler(tag,
+        test_sectors_init_done, loop);
+
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+    g_assert(tag->flags & NFC_TAG_FLAG_INITIALIZED);
+    g_assert_cmpuint(t2->data_size, == ,TEST_SECTORS_DATA_SIZE);
+    return t2;
+}
+
+static
+void
+test_sectors_flush(
+    NfcTagType2* t2,
+    GMainLoop* loop)
+{
+    /* Wait for the tag to return to sector 0 */
+    g_assert(nfc_tag_t2_read(t2, 0, 0, NULL, test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+}
+
+static
+void
+test_sectors_read_data_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTargetT2* test = TEST_TARGET_T2(t2->tag.target);
+
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_OK);
+    g_assert_cmpuint(len, == ,TEST_SECTORS_READ_SIZE);
+    g_assert(!memcmp(data, test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        TEST_SECTORS_READ_OFFSET, len));
+}
+
+static
+void
+test_sectors_read_done(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTargetT2* test = TEST_TARGET_T2(t2->tag.target);
+
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_OK);
+    g_assert_cmpuint(len, == ,TEST_TARGET_T2_READ_SIZE);
+    g_assert(!memcmp(data, test->data.bytes + TEST_TARGET_T2_SECTOR_SIZE +
+        2 * TEST_TARGET_T2_BLOCK_SIZE, len));
+}
+
+static
+void
+test_sectors_read(
+    void)
+{
+    TestTargetT2* test = test_sectors_target_new();
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_sectors_tag_new(test, loop);
+    NfcTag* tag = &t2->tag;
+    const guint8* expected = test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        TEST_SECTORS_READ_OFFSET;
+    guint8 buf[TEST_SECTORS_READ_SIZE + 8];
+
+    /* Nothing has been selected yet */
+    g_assert_cmpuint(test->sector_selects, == ,0);
+    g_assert(nfc_tag_t2_read_data_sync(t2, TEST_SECTORS_READ_OFFSET,
+        TEST_SECTORS_READ_SIZE, NULL) == NFC_TAG_T2_IO_STATUS_NOT_CACHED);
+
+    /* This one crosses the sector boundary */
+    g_assert(nfc_tag_t2_read_data(t2, TEST_SECTORS_READ_OFFSET,
+        TEST_SECTORS_READ_SIZE, test_sectors_read_data_done,
+        test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+
+    /* Sector 1 and then back to sector 0 */
+    g_assert_cmpuint(test->sector_selects, == ,2);
+    g_assert_cmpuint(test->sector, == ,0);
+
+    /* Both sectors have been (partially) cached */
+    g_assert(nfc_tag_t2_read_data_sync(t2, TEST_SECTORS_READ_OFFSET,
+        sizeof(buf), buf) == NFC_TAG_T2_IO_STATUS_OK);
+    g_assert(!memcmp(buf, expected, sizeof(buf)));
+    g_assert(nfc_tag_t2_read_data_sync(t2, TEST_SECTORS_READ_OFFSET,
+        sizeof(buf) + 4, NULL) == NFC_TAG_T2_IO_STATUS_NOT_CACHED);
+    g_assert(nfc_tag_t2_read_data_sync(t2, TEST_SECTORS_DATA_SIZE, 1,
+        NULL) == NFC_TAG_T2_IO_STATUS_BAD_BLOCK);
+
+    /* This time it's coming from the cache, no SECTOR SELECT */
+    g_assert(nfc_tag_t2_read_data(t2, TEST_SECTORS_READ_OFFSET,
+        TEST_SECTORS_READ_SIZE, test_sectors_read_data_done,
+        test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    g_assert_cmpuint(test->sector_selects, == ,2);
+
+    /* Raw read from sector 1 */
+    g_assert(!nfc_tag_t2_read(t2, 2, 0, NULL, NULL, NULL));
+    g_assert(!nfc_tag_t2_read(t2, 1, 0x100, NULL, NULL, NULL));
+    g_assert(nfc_tag_t2_read(t2, 1, 2, test_sectors_read_done,
+        test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+    g_assert_cmpuint(test->sector_selects, == ,4);
+    g_assert_cmpuint(test->sector, == ,0);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_sectors_write_data_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    guint written,
+    void* user_data)
+{
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_OK);
+    g_assert_cmpuint(written, == ,sizeof(jolla_rec) - 1);
+}
+
+static
+void
+test_sectors_write_done(
+    NfcTagType2* t2,
+    NFC_TRANSMIT_STATUS status,
+    guint written,
+    void* user_data)
+{
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_OK);
+    g_assert_cmpuint(written, == ,2 * TEST_TARGET_T2_BLOCK_SIZE);
+}
+
+static
+void
+test_sectors_write(
+    void)
+{
+    TestTargetT2* test = test_sectors_target_new();
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_sectors_tag_new(test, loop);
+    NfcTag* tag = &t2->tag;
+    guint8* expected = gutil_memdup(test->data.bytes, test->data.size);
+    GBytes* data = g_bytes_new_static(jolla_rec + 1, sizeof(jolla_rec) - 1);
+    GBytes* blocks = g_bytes_new_static(jolla_rec,
+        2 * TEST_TARGET_T2_BLOCK_SIZE);
+
+    /* Unaligned write across the sector boundary */
+    g_assert(nfc_tag_t2_write_data(t2, TEST_SECTORS_WRITE_OFFSET, data,
+        test_sectors_write_data_done, test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+    memcpy(expected + TEST_TARGET_T2_DATA_OFFSET + TEST_SECTORS_WRITE_OFFSET,
+        jolla_rec + 1, sizeof(jolla_rec) - 1);
+    g_assert(!memcmp(test->data.bytes, expected, test->data.size));
+    g_assert_cmpuint(test->sector_selects, == ,2);
+    g_assert_cmpuint(test->sector, == ,0);
+
+    /* Can't write past the end of data */
+    g_assert(!nfc_tag_t2_write_data(t2, TEST_SECTORS_DATA_SIZE - 1, data,
+        NULL, NULL, NULL));
+
+    /* Raw write to sector 1 */
+    g_assert(!nfc_tag_t2_write(t2, 2, 0, blocks, NULL, NULL, NULL));
+    g_assert(nfc_tag_t2_write(t2, 1, 10, blocks, test_sectors_write_done,
+        test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+    memcpy(expected + TEST_TARGET_T2_SECTOR_SIZE +
+        10 * TEST_TARGET_T2_BLOCK_SIZE, jolla_rec,
+        2 * TEST_TARGET_T2_BLOCK_SIZE);
+    g_assert(!memcmp(test->data.bytes, expected, test->data.size));
+    g_assert_cmpuint(test->sector_selects, == ,4);
+    g_assert_cmpuint(test->sector, == ,0);
+
+    g_bytes_unref(data);
+    g_bytes_unref(blocks);
+    g_free(expected);
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+}
+
+static
+void
+test_sectors_nack_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTargetT2* test = TEST_TARGET_T2(t2->tag.target);
+
+    /* Only got what was in sector 0 */
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_IO_ERROR);
+    g_assert_cmpuint(len, == ,TEST_SECTORS_DATA0_SIZE -
+        TEST_SECTORS_READ_OFFSET);
+    g_assert(!memcmp(data, test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        TEST_SECTORS_READ_OFFSET, len));
+}
+
+static
+void
+test_sectors_nack(
+    void)
+{
+    TestTargetT2* test = test_sectors_target_new();
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_sectors_tag_new(test, loop);
+    NfcTag* tag = &t2->tag;
+
+    test->sector_nack = TRUE;
+    g_assert(nfc_tag_t2_read_data(t2, TEST_SECTORS_READ_OFFSET,
+        TEST_SECTORS_READ_SIZE, test_sectors_nack_done,
+        test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+
+    /* The tag is (still) in sector 0 */
+    g_assert_cmpuint(test->sector, == ,0);
+    g_assert_cmpuint(test->sector_selects, == ,1);
+    g_assert(!test->sector_select);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * read_data_merge
+ *==========================================================================*/
+
+#define TEST_MERGE_OFFSET1 (100)
+#define TEST_MERGE_OFFSET2 (108)
+#define TEST_MERGE_SIZE (64)
+
+static
+void
+test_read_data_merge_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTargetT2* test = TEST_TARGET_T2(t2->tag.target);
+    const guint offset = GPOINTER_TO_UINT(user_data);
+
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_OK);
+    g_assert_cmpuint(len, == ,TEST_MERGE_SIZE);
+    g_assert(!memcmp(data, test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        offset, len));
+}
+
+static
+void
+test_read_data_merge_destroy(
+    gpointer loop)
+{
+    static guint count = 0;
+
+    if (++count == 2) {
+        g_main_loop_quit((GMainLoop*)loop);
+    }
+}
+
+static
+void
+test_read_data_merge(
+    void)
+{
+    TestTargetT2* test = test_sectors_target_new();
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_sectors_tag_new(test, loop);
+    NfcTag* tag = &t2->tag;
+    guint8 buf[TEST_MERGE_SIZE];
+
+    test->reads = 0;
+    g_assert(nfc_tag_t2_read_data(t2, TEST_MERGE_OFFSET1, TEST_MERGE_SIZE,
+        test_read_data_merge_done, test_read_data_merge_destroy, loop));
+    g_assert(nfc_tag_t2_read_data(t2, TEST_MERGE_OFFSET2, TEST_MERGE_SIZE,
+        test_read_data_merge_done, test_read_data_merge_destroy, loop));
+    test_run(&test_opt, loop);
+
+    /*
+     * The first reader needs 4 READs, the second one piggybacks on
+     * those and only needs to fetch its last 2 blocks on its own.
+     */
+    g_assert_cmpuint(test->reads, == ,5);
+    g_assert(nfc_tag_t2_read_data_sync(t2, TEST_MERGE_OFFSET2,
+        sizeof(buf), buf) == NFC_TAG_T2_IO_STATUS_OK);
+    g_assert(!memcmp(buf, test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        TEST_MERGE_OFFSET2, sizeof(buf)));
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * write_diff
+ *==========================================================================*/
+
+#define TEST_WRITE_DIFF_OFFSET (102)
+#define TEST_WRITE_DIFF_SIZE (40)  /* Blocks 25..35 */
+#define TEST_WRITE_DIFF_CHANGE (10) /* Block 28 */
+
+typedef struct test_write_diff {
+    GMainLoop* loop;
+    guint skipped;
+} TestWriteDiff;
+
+static
+void
+test_write_diff_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    guint written,
+    guint skipped,
+    void* user_data)
+{
+    TestWriteDiff* test = user_data;
+
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_OK);
+    g_assert_cmpuint(written, == ,TEST_WRITE_DIFF_SIZE);
+    g_assert_cmpuint(skipped, == ,test->skipped);
+    g_main_loop_quit(test->loop);
+}
+
+static
+void
+test_write_diff(
+    void)
+{
+    TestTargetT2* test = test_sectors_target_new();
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_sectors_tag_new(test, loop);
+    NfcTag* tag = &t2->tag;
+    guint8* data = gutil_memdup(test->data.bytes +
+        TEST_TARGET_T2_DATA_OFFSET + TEST_WRITE_DIFF_OFFSET,
+        TEST_WRITE_DIFF_SIZE);
+    GBytes* bytes;
+    TestWriteDiff wd;
+
+    data[TEST_WRITE_DIFF_CHANGE] ^= 0xff;
+    data[TEST_WRITE_DIFF_CHANGE + 1] ^= 0xff;
+    bytes = g_bytes_new_take(data, TEST_WRITE_DIFF_SIZE);
+
+    /* Invalid requests */
+    g_assert(!nfc_tag_t2_write_data_diff(NULL, 0, bytes, NULL, NULL, NULL,
+        NULL));
+    g_assert(!nfc_tag_t2_write_data_diff(t2, 0, NULL, NULL, NULL, NULL,
+        NULL));
+    g_assert(!nfc_tag_t2_write_data_diff(t2, TEST_SECTORS_DATA_SIZE - 1,
+        bytes, NULL, NULL, NULL, NULL));
+
+    /* 11 blocks, only one of them has changed */
+    memset(&wd, 0, sizeof(wd));
+    wd.loop = loop;
+    wd.skipped = 10;
+    test->reads = 0;
+    g_assert(nfc_tag_t2_write_data_diff(t2, TEST_WRITE_DIFF_OFFSET, bytes,
+        NULL, test_write_diff_done, NULL, &wd));
+    test_run(&test_opt, loop);
+    test_sectors_flush(t2, loop);
+    g_assert_cmpuint(test->reads, == ,3 + 1 /* flush */);
+    g_assert_cmpuint(test->writes, == ,1);
+    g_assert(!memcmp(test->data.bytes + TEST_TARGET_T2_DATA_OFFSET +
+        TEST_WRITE_DIFF_OFFSET, data, TEST_WRITE_DIFF_SIZE));
+
+    /* Everything is cached and nothing has changed */
+    wd.skipped = 11;
+    test->reads = 0;
+    g_assert(nfc_tag_t2_write_data_diff(t2, TEST_WRITE_DIFF_OFFSET, bytes,
+        NULL, test_write_diff_done, NULL, &wd));
+    test_run(&test_opt, loop);
+    g_assert_cmpuint(test->reads, == ,0);
+    g_assert_cmpuint(test->writes, == ,1);
+
+    g_bytes_unref(bytes);
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * FAST_READ
+ *==========================================================================*/
+
+#define TEST_FAST_READ_DATA_SIZE (872) /* NTAG216 */
+#define TEST_FAST_READ_SMALL_DATA_SIZE (48) /* MF0UL11 */
+
+typedef NfcTargetClass TestTargetNxpClass;
+typedef struct test_target_nxp {
+    TestTargetT2 parent;
+    const guint8* version;  /* NULL to NACK GET_VERSION */
+    guint max_frame_size;
+    guint reactivations;
+    guint get_versions;
+    guint fast_reads;
+    guint reads;
+    guint reactivate_id;
+} TestTargetNxp;
+
+typedef struct test_target_nxp_resp {
+    TestTargetNxp* target;
+    NFC_TRANSMIT_STATUS status;
+    guint8* data;
+    guint len;
+} TestTargetNxpResp;
+
+G_DEFINE_TYPE(TestTargetNxp, test_target_nxp, TEST_TYPE_TARGET_T2)
+#define TEST_TYPE_TARGET_NXP (test_target_nxp_get_type())
+#define TEST_TARGET_NXP(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_TARGET_NXP, TestTargetNxp))
+
+typedef struct test_fast_read_data {
+    const guint8* version;
+    guint max_frame_size;
+    guint data_size;
+    guint get_versions;
+    guint reactivations;
+    guint fast_reads;
+    guint reads;
+} TestFastReadData;
+
+static const guint8 test_version_ntag216[] = {
+    0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x13, 0x03
+};
+
+static const guint8 test_version_mf0ul11[] = {
+    0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0b, 0x03
+};
+
+/* 63 blocks per FAST_READ */
+static const TestFastReadData test_fast_read_252 = {
+    test_version_ntag216, 252, TEST_FAST_READ_DATA_SIZE, 1, 0, 4, 1
+};
+
+/* 16 blocks per FAST_READ by default */
+static const TestFastReadData test_fast_read_default = {
+    test_version_ntag216, 0, TEST_FAST_READ_DATA_SIZE, 1, 0, 14, 1
+};
+
+/* GET_VERSION is NACKed, falling back to READ */
+static const TestFastReadData test_fast_read_unsup = {
+    NULL, 252, TEST_FAST_READ_DATA_SIZE, 1, 1, 0, 56
+};
+
+/* 4 READs cover the whole thing, GET_VERSION is not even sent */
+static const TestFastReadData test_fast_read_small = {
+    test_version_mf0ul11, 0, TEST_FAST_READ_SMALL_DATA_SIZE, 0, 0, 0, 4
+};
+
+static
+gboolean
+test_target_nxp_resp_done(
+    gpointer user_data)
+{
+    TestTargetNxpResp* resp = user_data;
+    TestTargetT2* t2 = &resp->target->parent;
+
+    g_assert(t2->transmit_id);
+    t2->transmit_id = 0;
+    nfc_target_transmit_done(&t2->target, resp->status, resp->data,
+        resp->len);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_target_nxp_resp_free(
+    gpointer user_data)
+{
+    TestTargetNxpResp* resp = user_data;
+
+    g_free(resp->data);
+    g_free(resp);
+}
+
+static
+void
+test_target_nxp_resp(
+    TestTargetNxp* self,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len)
+{
+    TestTargetNxpResp* resp = g_new(TestTargetNxpResp, 1);
+
+    resp->target = self;
+    resp->status = status;
+    resp->data = gutil_memdup(data, len);
+    resp->len = len;
+    self->parent.transmit_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+        test_target_nxp_resp_done, resp, test_target_nxp_resp_free);
+}
+
+static
+gboolean
+test_target_nxp_transmit(
+    NfcTarget* target,
+    const void* data,
+    guint len)
+{
+    TestTargetNxp* self = TEST_TARGET_NXP(target);
+    const guint8* cmd = data;
+    static const guint8 nack = 0;
+
+    g_assert(!self->parent.transmit_id);
+    if (len == 1 && cmd[0] == 0x60) {
+        /* GET_VERSION */
+        self->get_versions++;
+        if (self->version) {
+            test_target_nxp_resp(self, NFC_TRANSMIT_STATUS_OK,
+                self->version, 8);
+        } else {
+            test_target_nxp_resp(self, NFC_TRANSMIT_STATUS_NACK, &nack, 1);
+        }
+        return TRUE;
+    } else if (len == 3 && cmd[0] == 0x3a) {
+        /* FAST_READ */
+        const GUtilData* storage = &self->parent.data;
+        const guint start = cmd[1] * TEST_TARGET_T2_BLOCK_SIZE;
+        const guint end = (cmd[2] + 1) * TEST_TARGET_T2_BLOCK_SIZE;
+
+        GDEBUG("Fast read blocks #%u..%u", cmd[1], cmd[2]);
+        self->fast_reads++;
+        g_assert(self->version);
+        g_assert_cmpuint(cmd[1], <= ,cmd[2]);
+        g_assert_cmpuint(end, <= ,storage->size);
+        if (self->max_frame_size) {
+            g_assert_cmpuint(end - start, <= ,self->max_frame_size);
+        }
+        test_target_nxp_resp(self, NFC_TRANSMIT_STATUS_OK,
+            storage->bytes + start, end - start);
+        return TRUE;
+    } else if (len == 2 && cmd[0] == 0x30) {
+        /* READ */
+        self->reads++;
+    }
+    return NFC_TARGET_CLASS(test_target_nxp_parent_class)->transmit(target,
+        data, len);
+}
+
+static
+gboolean
+test_target_nxp_reactivated(
+    gpointer user_data)
+{
+    TestTargetNxp* self = TEST_TARGET_NXP(user_data);
+
+    self->reactivate_id = 0;
+    nfc_target_reactivated(NFC_TARGET(self));
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_target_nxp_reactivate(
+    NfcTarget* target)
+{
+    TestTargetNxp* self = TEST_TARGET_NXP(target);
+
+    g_assert(!self->reactivate_id);
+    self->reactivations++;
+    self->reactivate_id = g_idle_add(test_target_nxp_reactivated, self);
+    return TRUE;
+}
+
+static
+void
+test_target_nxp_init(
+    TestTargetNxp* self)
+{
+}
+
+static
+void
+test_target_nxp_finalize(
+    GObject* object)
+{
+    TestTargetNxp* self = TEST_TARGET_NXP(object);
+
+    if (self->reactivate_id) {
+        g_source_remove(self->reactivate_id);
+    }
+    G_OBJECT_CLASS(test_target_nxp_parent_class)->finalize(object);
+}
+
+static
+void
+test_target_nxp_class_init(
+    NfcTargetClass* klass)
+{
+    klass->transmit = test_target_nxp_transmit;
+    klass->reactivate = test_target_nxp_reactivate;
+    G_OBJECT_CLASS(klass)->finalize = test_target_nxp_finalize;
+}
+
+static
+TestTargetNxp*
+test_target_nxp_new(
+    const TestFastReadData* test)
+{
+    TestTargetNxp* self = g_object_new(TEST_TYPE_TARGET_NXP, NULL);
+    TestTargetT2* t2 = &self->parent;
+    const guint size = test->data_size + TEST_TARGET_T2_DATA_OFFSET;
+    guint8* bytes = g_malloc(size);
+    guint i;
+
+    memcpy(bytes, test_data_empty, TEST_TARGET_T2_DATA_OFFSET);
+    bytes[14] = test->data_size / 8;
+    for (i = TEST_TARGET_T2_DATA_OFFSET; i < size; i++) {
+        bytes[i] = (guint8)(i ^ (i >> 8));
+    }
+
+    /* Empty NDEF followed by Terminator TLV */
+    bytes[TEST_TARGET_T2_DATA_OFFSET] = 0x03;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 1] = 0x00;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 2] = 0xfe;
+
+    t2->target.technology = NFC_TECHNOLOGY_A;
+    t2->data.bytes = t2->storage = bytes;
+    t2->data.size = size;
+    self->version = test->version;
+    self->max_frame_size = test->max_frame_size;
+    nfc_target_set_max_frame_size(&t2->target, test->max_frame_size);
+    return self;
+}
+
+static
+void
+test_fast_read_init_done(
+    NfcTag* tag,
+    void* loop)
+{
+    g_main_loop_quit((GMainLoop*)loop);
+}
+
+static
+void
+test_fast_read_done(
+    NfcTagType2* t2,
+    NFC_TAG_T2_IO_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTargetT2* test = TEST_TARGET_T2(t2->tag.target);
+
+    g_assert_cmpint(status, == ,NFC_TAG_T2_IO_STATUS_OK);
+    g_assert_cmpuint(len, == ,t2->data_size);
+    g_assert(!memcmp(data, test->data.bytes + TEST_TARGET_T2_DATA_OFFSET,
+        len));
+}
+
+static
+void
+test_fast_read(
+    gconstpointer data)
+{
+    const TestFastReadData* fr = data;
+    TestTargetNxp* test = test_target_nxp_new(fr);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTagType2* t2 = test_tag_new(&test->parent, 0);
+    NfcTag* tag = &t2->tag;
+    gulong id = nfc_tag_add_initialized_handler(tag,
+        test_fast_read_init_done, loop);
+
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+    g_assert(tag->flags & NFC_TAG_FLAG_INITIALIZED);
+    g_assert_cmpuint(t2->data_size, == ,fr->data_size);
+
+    /* Read the whole thing */
+    g_assert(nfc_tag_t2_read_data(t2, 0, fr->data_size,
+        test_fast_read_done, test_destroy_quit_loop, loop));
+    test_run(&test_opt, loop);
+
+    g_assert_cmpuint(test->get_versions, == ,fr->get_versions);
+    g_assert_cmpuint(test->reactivations, == ,fr->reactivations);
+    g_assert_cmpuint(test->fast_reads, == ,fr->fast_reads);
+    g_assert_cmpuint(test->reads, == ,fr->reads);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->parent.target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * cache
+ *==========================================================================*/
+
+#define TEST_CACHE_TMP_DIR_TEMPLATE "test_XXXXXX"
+#define TEST_CACHE_PROP_SIZE (80)
+#define TEST_CACHE_DATA_SIZE (112) /* 100 bytes of TLVs, 7 READs */
+#define TEST_CACHE_READS (1 + 7)   /* Control area + data */
+#define TEST_CACHE_HIT_READS (1 + 2) /* Control area + first and last */
+
+static
+void
+test_cache_data_init(
+    guint8* data)
+{
+    /* Proprietary TLV followed by NDEF TLV from test_data_google */
+    memcpy(data, test_data_google, sizeof(test_data_google));
+    data[TEST_TARGET_T2_DATA_OFFSET] = 0xfd;
+    data[TEST_TARGET_T2_DATA_OFFSET + 1] = TEST_CACHE_PROP_SIZE;
+    memset(data + TEST_TARGET_T2_DATA_OFFSET + 2, 0xaa, TEST_CACHE_PROP_SIZE);
+    memcpy(data + TEST_TARGET_T2_DATA_OFFSET + 2 + TEST_CACHE_PROP_SIZE,
+        test_data_google + TEST_TARGET_T2_DATA_OFFSET,
+        NDEF_GOOGLE_COM_SIZE_EXACT - TEST_TARGET_T2_DATA_OFFSET);
+}
+
+static
+guint
+test_cache_tap(
+    NfcTagType2Cache* cache,
+    const guint8* data,
+    guint size)
+{
+    TestTargetT2* test = test_target_t2_new(data, size);
+    NfcTagType2* t2 = test_tag_new_with_cache(test, 0, cache);
+    NfcTag* tag = &t2->tag;
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    gulong id = nfc_tag_add_initialized_handler(tag, test_basic_exit, loop);
+    guint reads;
+
+    test_run(&test_opt, loop);
+    g_assert(tag->ndef);
+    g_assert(NFC_IS_NDEF_REC_U(tag->ndef));
+    g_assert_cmpstr(NFC_NDEF_REC_U(tag->ndef)->uri, == ,"http://google.com");
+    reads = test->reads;
+
+    nfc_tag_remove_handler(tag, id);
+    nfc_tag_unref(tag);
+    nfc_target_unref(&test->target);
+    g_main_loop_unref(loop);
+    return reads;
+}
+
+static
+void
+test_cache(
+    void)
+{
+    guint8 data[sizeof(test_data_google)];
+    char* dir = g_dir_make_tmp(TEST_CACHE_TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 0);
+
+    g_assert(cache);
+    test_cache_data_init(data);
+
+    /* The first tap reads everything and fills the cache */
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_READS);
+
+    /* The second one only verifies the cached data */
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_HIT_READS);
+
+    /* The tail has changed, the cached data gets thrown away */
+    data[TEST_TARGET_T2_DATA_OFFSET + TEST_CACHE_DATA_SIZE - 1] ^= 0xff;
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_HIT_READS + 7);
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_HIT_READS);
+
+    /* The head has changed, the first verification read is reused */
+    data[TEST_TARGET_T2_DATA_OFFSET + 2] ^= 0xff;
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_READS);
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_HIT_READS);
+
+    /* Same length, rewritten in the middle - that goes unnoticed */
+    data[TEST_TARGET_T2_DATA_OFFSET + 52] ^= 0xff;
+    g_assert_cmpuint(test_cache_tap(cache, TEST_ARRAY_AND_SIZE(data)), == ,
+        TEST_CACHE_HIT_READS);
+
+    nfc_tag_t2_cache_flush(cache);
+    nfc_tag_t2_cache_unref(cache);
+    test_rmdir(dir);
+    g_free(dir);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -1649,6 +2509,20 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("write_err1"), test_write_err1);
     g_test_add_func(TEST_("write_data_err1"), test_write_data_err1);
     g_test_add_func(TEST_("write_data_err2"), test_write_data_err2);
+    g_test_add_func(TEST_("sectors_read"), test_sectors_read);
+    g_test_add_func(TEST_("sectors_write"), test_sectors_write);
+    g_test_add_func(TEST_("sectors_nack"), test_sectors_nack);
+    g_test_add_func(TEST_("read_data_merge"), test_read_data_merge);
+    g_test_add_func(TEST_("write_diff"), test_write_diff);
+    g_test_add_func(TEST_("cache"), test_cache);
+    g_test_add_data_func(TEST_("fast_read_252"), &test_fast_read_252,
+        test_fast_read);
+    g_test_add_data_func(TEST_("fast_read_default"),
+        &test_fast_read_default, test_fast_read);
+    g_test_add_data_func(TEST_("fast_read_unsup"), &test_fast_read_unsup,
+        test_fast_read);
+    g_test_add_data_func(TEST_("fast_read_small"), &test_fast_read_small,
+        test_fast_read);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
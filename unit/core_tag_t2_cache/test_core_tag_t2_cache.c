@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "nfc_tag_t2_cache.h"
+
+#include "test_common.h"
+
+#include <gutil_misc.h>
+
+#include <unistd.h>
+
+#define TMP_DIR_TEMPLATE "test_XXXXXX"
+
+static TestOpt test_opt;
+
+static const guint8 test_uid1[] = { 0x04, 0x9b, 0xfb, 0xec, 0x4a, 0xeb, 0x2b };
+static const guint8 test_uid2[] = { 0x04, 0x9b, 0xfb, 0xec, 0x4a, 0xeb, 0x2c };
+static const guint8 test_cc1[] = { 0xe1, 0x10, 0x12, 0x00 };
+static const guint8 test_cc2[] = { 0xe1, 0x10, 0x3e, 0x00 };
+static const guint8 test_data1[] = {
+    0x03, 0x0b, 0xd1, 0x01, 0x07, 0x54, 0x02, 0x65,
+    0x6e, 0x74, 0x65, 0x73, 0x74, 0xfe, 0x00, 0x00
+};
+static const guint8 test_data2[] = {
+    0x03, 0x00, 0xfe, 0x00
+};
+
+static
+void
+test_check_entry(
+    NfcTagType2Cache* cache,
+    const GUtilData* uid,
+    const guint8* cc,
+    const GUtilData* expected)
+{
+    GBytes* bytes = nfc_tag_t2_cache_lookup(cache, uid, cc);
+
+    if (expected) {
+        GUtilData data;
+
+        g_assert(bytes);
+        g_assert(gutil_data_equal(gutil_data_from_bytes(&data, bytes),
+            expected));
+        g_bytes_unref(bytes);
+    } else {
+        g_assert(!bytes);
+    }
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    GUtilData uid, data;
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 0);
+
+    g_assert(cache);
+    g_assert(!nfc_tag_t2_cache_new(NULL, 0));
+    g_assert(!nfc_tag_t2_cache_ref(NULL));
+    g_assert(!nfc_tag_t2_cache_lookup(NULL, NULL, NULL));
+    nfc_tag_t2_cache_unref(NULL);
+    nfc_tag_t2_cache_store(NULL, NULL, NULL, NULL);
+    nfc_tag_t2_cache_evict(NULL, NULL, NULL);
+    nfc_tag_t2_cache_flush(NULL);
+
+    /* Invalid keys */
+    memset(&uid, 0, sizeof(uid));
+    g_assert(!nfc_tag_t2_cache_lookup(cache, &uid, test_cc1));
+    g_assert(!nfc_tag_t2_cache_lookup(cache, NULL, test_cc1));
+    TEST_BYTES_SET(uid, test_uid1);
+    g_assert(!nfc_tag_t2_cache_lookup(cache, &uid, NULL));
+
+    /* Nothing to store */
+    memset(&data, 0, sizeof(data));
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, NULL);
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data);
+    g_assert(!nfc_tag_t2_cache_lookup(cache, &uid, test_cc1));
+
+    nfc_tag_t2_cache_unref(cache);
+    test_rmdir(dir);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    GUtilData uid1, uid2, data1, data2;
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 0);
+
+    TEST_BYTES_SET(uid1, test_uid1);
+    TEST_BYTES_SET(uid2, test_uid2);
+    TEST_BYTES_SET(data1, test_data1);
+    TEST_BYTES_SET(data2, test_data2);
+
+    g_assert(nfc_tag_t2_cache_ref(cache) == cache);
+    nfc_tag_t2_cache_unref(cache);
+
+    test_check_entry(cache, &uid1, test_cc1, NULL);
+    nfc_tag_t2_cache_store(cache, &uid1, test_cc1, &data1);
+    nfc_tag_t2_cache_store(cache, &uid2, test_cc1, &data2);
+    test_check_entry(cache, &uid1, test_cc1, &data1);
+    test_check_entry(cache, &uid2, test_cc1, &data2);
+
+    /* CC is part of the key */
+    test_check_entry(cache, &uid1, test_cc2, NULL);
+
+    /* Replace the existing entry */
+    nfc_tag_t2_cache_store(cache, &uid1, test_cc1, &data2);
+    test_check_entry(cache, &uid1, test_cc1, &data2);
+
+    /* The index survives re-opening */
+    nfc_tag_t2_cache_flush(cache);
+    nfc_tag_t2_cache_unref(cache);
+    cache = nfc_tag_t2_cache_new(dir, 0);
+    test_check_entry(cache, &uid1, test_cc1, &data2);
+    test_check_entry(cache, &uid2, test_cc1, &data2);
+
+    /* Evict one of them */
+    nfc_tag_t2_cache_evict(cache, &uid1, test_cc1);
+    nfc_tag_t2_cache_evict(cache, &uid1, test_cc1);
+    test_check_entry(cache, &uid1, test_cc1, NULL);
+    test_check_entry(cache, &uid2, test_cc1, &data2);
+
+    /* Changing the capacity resets the index */
+    nfc_tag_t2_cache_unref(cache);
+    cache = nfc_tag_t2_cache_new(dir, 2);
+    test_check_entry(cache, &uid2, test_cc1, NULL);
+
+    nfc_tag_t2_cache_unref(cache);
+    test_rmdir(dir);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * lru
+ *==========================================================================*/
+
+static
+void
+test_lru(
+    void)
+{
+    guint8 uid_bytes[sizeof(test_uid1)];
+    GUtilData uid1, uid2, uid3, data;
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 2);
+
+    TEST_BYTES_SET(uid1, test_uid1);
+    TEST_BYTES_SET(uid2, test_uid2);
+    TEST_BYTES_SET(data, test_data1);
+    memcpy(uid_bytes, test_uid1, sizeof(uid_bytes));
+    uid_bytes[0] ^= 0xff;
+    TEST_BYTES_SET(uid3, uid_bytes);
+
+    nfc_tag_t2_cache_store(cache, &uid1, test_cc1, &data);
+    nfc_tag_t2_cache_store(cache, &uid2, test_cc1, &data);
+
+    /* Touch the first one, the second one gets evicted */
+    test_check_entry(cache, &uid1, test_cc1, &data);
+    nfc_tag_t2_cache_store(cache, &uid3, test_cc1, &data);
+    test_check_entry(cache, &uid1, test_cc1, &data);
+    test_check_entry(cache, &uid2, test_cc1, NULL);
+    test_check_entry(cache, &uid3, test_cc1, &data);
+
+    nfc_tag_t2_cache_flush(cache);
+    nfc_tag_t2_cache_unref(cache);
+    test_rmdir(dir);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * pending
+ *==========================================================================*/
+
+static
+void
+test_pending(
+    void)
+{
+    GUtilData uid, data1, data2;
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 1);
+    char* file = g_build_filename(dir, "t2cache-0000.bin", NULL);
+    gchar* contents = NULL;
+    gsize len = 0;
+
+    TEST_BYTES_SET(uid, test_uid1);
+    TEST_BYTES_SET(data1, test_data1);
+    TEST_BYTES_SET(data2, test_data2);
+
+    /* Lookups don't have to wait for the writes */
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data1);
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data2);
+    test_check_entry(cache, &uid, test_cc1, &data2);
+
+    /* The last write wins */
+    nfc_tag_t2_cache_flush(cache);
+    g_assert(g_file_get_contents(file, &contents, &len, NULL));
+    g_assert_cmpuint(len, == ,data2.size);
+    g_assert(!memcmp(contents, data2.bytes, len));
+    g_free(contents);
+    test_check_entry(cache, &uid, test_cc1, &data2);
+
+    /* Eviction cancels the pending write */
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data1);
+    nfc_tag_t2_cache_evict(cache, &uid, test_cc1);
+    test_check_entry(cache, &uid, test_cc1, NULL);
+    nfc_tag_t2_cache_flush(cache);
+    test_check_entry(cache, &uid, test_cc1, NULL);
+
+    /* Flushing an idle cache is fine too */
+    nfc_tag_t2_cache_flush(cache);
+    nfc_tag_t2_cache_unref(cache);
+    test_rmdir(dir);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * broken
+ *==========================================================================*/
+
+static
+void
+test_broken(
+    void)
+{
+    static const guint8 junk[] = { 0x01, 0x02, 0x03 };
+    GUtilData uid, data;
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    NfcTagType2Cache* cache = nfc_tag_t2_cache_new(dir, 1);
+    char* file = g_build_filename(dir, "t2cache-0000.bin", NULL);
+
+    TEST_BYTES_SET(uid, test_uid1);
+    TEST_BYTES_SET(data, test_data1);
+
+    /* Damaged data file gets detected and the entry dropped */
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data);
+    nfc_tag_t2_cache_flush(cache);
+    g_assert(g_file_test(file, G_FILE_TEST_EXISTS));
+    g_assert(g_file_set_contents(file, (char*)junk, sizeof(junk), NULL));
+    test_check_entry(cache, &uid, test_cc1, NULL);
+    g_assert(!g_file_test(file, G_FILE_TEST_EXISTS));
+
+    /* Missing data file too */
+    nfc_tag_t2_cache_store(cache, &uid, test_cc1, &data);
+    nfc_tag_t2_cache_flush(cache);
+    g_assert(!unlink(file));
+    test_check_entry(cache, &uid, test_cc1, NULL);
+
+    nfc_tag_t2_cache_unref(cache);
+    g_free(file);
+
+    /* The directory is not writable */
+    file = g_build_filename(dir, "file", NULL);
+    g_assert(g_file_set_contents(file, (char*)junk, sizeof(junk), NULL));
+    g_assert(!nfc_tag_t2_cache_new(file, 0));
+
+    test_rmdir(dir);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/core/tag_t2_cache/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("lru"), test_lru);
+    g_test_add_func(TEST_("pending"), test_pending);
+    g_test_add_func(TEST_("broken"), test_broken);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
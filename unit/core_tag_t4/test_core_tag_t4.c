@@ -313,6 +313,11 @@ test_null(
     g_assert(!nfc_isodep_transmit(NULL, 0, 0, 0, 0, NULL, 0,
         NULL, NULL, NULL, NULL));
     g_assert(!nfc_isodep_reset(NULL, NULL, NULL, NULL, NULL));
+    g_assert(!nfc_isodep_transmit2(NULL, 0, 0, 0, 0, NULL, 0,
+        NFC_ISODEP_TX_FLAG_GET_RESPONSE, NULL, NULL, NULL, NULL));
+    g_assert(!nfc_isodep_cancel(NULL, 0));
+    g_assert(!nfc_isodep_select_stats(NULL));
+    nfc_isodep_set_select_cache(NULL, TRUE);
     nfc_target_unref(target);
 }
 
@@ -895,6 +900,412 @@ test_init_seq(
     nfc_target_unref(target);
 }
 
+/*==========================================================================*
+ * ext_len
+ *==========================================================================*/
+
+typedef struct test_ext_len_data {
+    const char* name;
+    GUtilData hb;       /* Historical bytes */
+    gboolean ext_le;    /* Whether extended Le is expected */
+} TestExtLenData;
+
+static const guint8 test_hb_ext_len_yes[] = {
+    0x80, 0x73, 0x00, 0x00, 0x40        /* Card capabilities */
+};
+static const guint8 test_hb_ext_len_no[] = {
+    0x00, 0x73, 0x00, 0x00, 0x00,       /* Card capabilities */
+    0x00, 0x90, 0x00                    /* Status indicator */
+};
+static const guint8 test_hb_ext_len_unknown[] = {
+    0x80, 0x31, 0xfe                    /* Card service data */
+};
+
+static const TestExtLenData ext_len_tests[] = {
+    { "yes", { TEST_ARRAY_AND_SIZE(test_hb_ext_len_yes) }, TRUE },
+    { "no", { TEST_ARRAY_AND_SIZE(test_hb_ext_len_no) }, FALSE },
+    { "unknown", { TEST_ARRAY_AND_SIZE(test_hb_ext_len_unknown) }, TRUE },
+    { "none", { NULL, 0 }, TRUE }
+};
+
+static const guint8 test_resp_read_ndef_cc_ext_mle[] = {
+    0x00, 0x0f, 0x20, 0x02, 0x00, 0x00, 0x34, /* Data */
+    /*              MLe ^^    ^^             */
+    0x04, 0x06, 0xe1, 0x04, 0x0f, 0xff, 0x00,
+    0xff,
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_resp_read_ndef_len_ext[] = {
+    0x01, 0x80,                               /* Data */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_cmd_read_ndef_ext[] = {
+    0x00, 0xb0, 0x00, 0x02, 0x00, 0x01, 0x80  /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_cmd_read_ndef_short_1[] = {
+    0x00, 0xb0, 0x00, 0x02, 0x00              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_cmd_read_ndef_short_2[] = {
+    0x00, 0xb0, 0x01, 0x02, 0x80              /* CLA|INS|P1|P2|Le  */
+};
+
+static
+void
+test_ext_len_add(
+    TestTarget* target,
+    const void* data,
+    guint size)
+{
+    GUtilData chunk;
+
+    chunk.bytes = data;
+    chunk.size = size;
+    g_ptr_array_add(target->cmd_resp, gutil_data_copy(&chunk));
+}
+
+static
+void
+test_ext_len_add_resp(
+    TestTarget* target,
+    const guint8* ndef,
+    guint size)
+{
+    GByteArray* resp = g_byte_array_new();
+
+    g_byte_array_append(resp, ndef, size);
+    g_byte_array_append(resp, TEST_ARRAY_AND_SIZE(test_resp_ok));
+    test_ext_len_add(target, resp->data, resp->len);
+    g_byte_array_free(resp, TRUE);
+}
+
+static
+void
+test_ext_len(
+    gconstpointer test_data)
+{
+    const TestExtLenData* test = test_data;
+    NfcTarget* target = g_object_new(TEST_TYPE_TARGET2, NULL);
+    TestTarget* test_target = TEST_TARGET(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcParamIsoDepPollA iso_dep_poll_a;
+    const guint ndef_size = 0x180;
+    guint8* ndef = g_malloc(ndef_size);
+    NfcTagType4* t4a;
+    NfcTag* tag;
+    gulong id;
+    guint i;
+
+    /* A single non-short record of unknown type */
+    ndef[0] = 0xc1; /* MB|ME|TNF=1 */
+    ndef[1] = 0x01; /* Type length */
+    ndef[2] = ndef[3] = 0x00; /* Payload length */
+    ndef[4] = (guint8) ((ndef_size - 7) >> 8);
+    ndef[5] = (guint8) (ndef_size - 7);
+    ndef[6] = 'x'; /* Type */
+    for (i = 7; i < ndef_size; i++) {
+        ndef[i] = (guint8) i;
+    }
+
+    test_ext_len_add(test_target,
+        TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app));
+    test_ext_len_add(test_target, TEST_ARRAY_AND_SIZE(test_resp_ok));
+    test_ext_len_add(test_target,
+        TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_cc));
+    test_ext_len_add(test_target, TEST_ARRAY_AND_SIZE(test_resp_ok));
+    test_ext_len_add(test_target, TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_cc));
+    test_ext_len_add(test_target,
+        TEST_ARRAY_AND_SIZE(test_resp_read_ndef_cc_ext_mle));
+    test_ext_len_add(test_target,
+        TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_ef));
+    test_ext_len_add(test_target, TEST_ARRAY_AND_SIZE(test_resp_ok));
+    test_ext_len_add(test_target, TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_len));
+    test_ext_len_add(test_target,
+        TEST_ARRAY_AND_SIZE(test_resp_read_ndef_len_ext));
+    if (test->ext_le) {
+        /* The whole thing is read at once */
+        test_ext_len_add(test_target,
+            TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_ext));
+        test_ext_len_add_resp(test_target, ndef, ndef_size);
+    } else {
+        /* Two short reads */
+        test_ext_len_add(test_target,
+            TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_short_1));
+        test_ext_len_add_resp(test_target, ndef, 0x100);
+        test_ext_len_add(test_target,
+            TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_short_2));
+        test_ext_len_add_resp(test_target, ndef + 0x100, ndef_size - 0x100);
+    }
+
+    memset(&iso_dep_poll_a, 0, sizeof(iso_dep_poll_a));
+    iso_dep_poll_a.fsc = 256;
+    iso_dep_poll_a.t1 = test->hb;
+    target->technology = NFC_TECHNOLOGY_A;
+    t4a = NFC_TAG_T4(nfc_tag_t4a_new(target, TRUE, NULL, &iso_dep_poll_a));
+    g_assert(NFC_IS_TAG_T4A(t4a));
+    tag = &t4a->tag;
+
+    id = nfc_tag_add_initialized_handler(tag, test_tag_quit_loop_cb, loop);
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+
+    /* All commands have been sent and NDEF has been read */
+    g_assert(tag->flags & NFC_TAG_FLAG_INITIALIZED);
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+    g_assert(tag->ndef);
+    g_assert_cmpuint(tag->ndef->payload.size, == ,ndef_size - 7);
+    g_assert(!memcmp(tag->ndef->payload.bytes, ndef + 7, ndef_size - 7));
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+    g_free(ndef);
+}
+
+/*==========================================================================*
+ * lazy
+ *==========================================================================*/
+
+typedef struct test_lazy_data {
+    const char* name;
+    const GUtilData* cmd_resp;
+    gsize count;
+    guint flags;
+
+#define TEST_LAZY_NDEF (0x01)
+#define TEST_LAZY_ON_DEMAND (0x02)
+
+} TestLazyData;
+
+static const TestLazyData lazy_tests[] = {
+    { "on_demand/success", TEST_ARRAY_AND_COUNT(test_init_data_success),
+      TEST_LAZY_NDEF | TEST_LAZY_ON_DEMAND },
+    { "on_demand/app_not_found",
+      TEST_ARRAY_AND_COUNT(test_init_data_app_not_found),
+      TEST_LAZY_ON_DEMAND },
+    { "idle/success", TEST_ARRAY_AND_COUNT(test_init_data_success),
+      TEST_LAZY_NDEF },
+    { "idle/ndef_read_err", TEST_ARRAY_AND_COUNT(test_init_data_ndef_read_err),
+      0 }
+};
+
+static
+void
+test_lazy(
+    gconstpointer test_data)
+{
+    const TestLazyData* test = test_data;
+    NfcTarget* target = g_object_new(TEST_TYPE_TARGET2, NULL);
+    TestTarget* test_target = TEST_TARGET(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcParamPollB poll_b;
+    NfcTagType4* t4b;
+    NfcTag* tag;
+    gulong id;
+    guint i;
+
+    for (i = 0; i < test->count; i++) {
+        g_ptr_array_add(test_target->cmd_resp,
+            gutil_data_copy(test->cmd_resp + i));
+    }
+
+    memset(&poll_b, 0, sizeof(poll_b));
+    poll_b.fsc = 0x0b; /* i.e. 256 */
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, NFC_TAG_T4_NDEF_LAZY,
+        &poll_b, NULL));
+    g_assert(NFC_IS_TAG_T4B(t4b));
+    tag = &t4b->tag;
+
+    /* The tag is initialized right away and nothing has been sent */
+    g_assert(tag->flags & NFC_TAG_FLAG_INITIALIZED);
+    g_assert(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+    g_assert(!tag->ndef);
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,test->count);
+
+    id = nfc_tag_add_ndef_ready_handler(tag, test_tag_quit_loop_cb, loop);
+    if (test->flags & TEST_LAZY_ON_DEMAND) {
+        g_assert(nfc_tag_read_ndef(tag));
+        g_assert(nfc_tag_read_ndef(tag)); /* Already reading */
+    }
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+
+    /* All commands have been sent */
+    g_assert(!(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED));
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+    g_assert(!tag->ndef == !(test->flags & TEST_LAZY_NDEF));
+    g_assert(!nfc_tag_read_ndef(tag)); /* Nothing to wait for */
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * lazy_busy
+ *==========================================================================*/
+
+static
+gboolean
+test_lazy_busy_timeout(
+    gpointer loop)
+{
+    g_main_loop_quit((GMainLoop*)loop);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_lazy_busy(
+    void)
+{
+    NfcTarget* target = g_object_new(TEST_TYPE_TARGET2, NULL);
+    TestTarget* test_target = TEST_TARGET(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcTargetSequence* seq;
+    NfcParamPollB poll_b;
+    NfcTagType4* t4b;
+    NfcTag* tag;
+    gulong id;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(test_init_data_success); i++) {
+        g_ptr_array_add(test_target->cmd_resp,
+            gutil_data_copy(test_init_data_success + i));
+    }
+
+    memset(&poll_b, 0, sizeof(poll_b));
+    poll_b.fsc = 0x0b; /* i.e. 256 */
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, NFC_TAG_T4_NDEF_LAZY,
+        &poll_b, NULL));
+    tag = &t4b->tag;
+    g_assert(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+
+    /* The tag isn't idle as long as someone is holding a sequence */
+    seq = nfc_target_sequence_new(target);
+    g_timeout_add(1200, test_lazy_busy_timeout, loop);
+    test_run(&test_opt, loop);
+    g_assert(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,
+        G_N_ELEMENTS(test_init_data_success));
+
+    /* Release the sequence and wait for NDEF to get read */
+    nfc_target_sequence_unref(seq);
+    id = nfc_tag_add_ndef_ready_handler(tag, test_tag_quit_loop_cb, loop);
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+    g_assert(!(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED));
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+    g_assert(tag->ndef);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * lazy_client
+ *==========================================================================*/
+
+static const guint8 test_lazy_client_cmd[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x02              /* CLA|INS|P1|P2|Le  */
+};
+
+static
+void
+test_lazy_client_done(
+    NfcTagType4* tag,
+    guint sw,  /* 16 bits (SW1 << 8)|SW2 */
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    g_assert_cmpuint(sw, == ,ISO_SW_OK);
+    g_main_loop_quit((GMainLoop*)user_data);
+}
+
+static
+void
+test_lazy_client(
+    void)
+{
+    NfcTarget* target = g_object_new(TEST_TYPE_TARGET2, NULL);
+    TestTarget* test_target = TEST_TARGET(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    NfcParamPollB poll_b;
+    NfcTagType4* t4b;
+    NfcTag* tag;
+    gulong id;
+    guint i;
+
+    memset(&poll_b, 0, sizeof(poll_b));
+    poll_b.fsc = 0x0b; /* i.e. 256 */
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, NFC_TAG_T4_NDEF_LAZY,
+        &poll_b, NULL));
+    tag = &t4b->tag;
+    g_assert(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+
+    /* Client talks to the tag before it gets idle */
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_lazy_client_cmd),
+        TEST_ARRAY_AND_SIZE(test_resp_ok));
+    g_assert(nfc_isodep_transmit(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 2,
+        NULL, test_lazy_client_done, NULL, loop));
+    test_run(&test_opt, loop);
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+
+    /* Its selection must survive the idle timeout */
+    g_timeout_add(1200, test_lazy_busy_timeout, loop);
+    test_run(&test_opt, loop);
+    g_assert(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+    g_assert(!tag->ndef);
+
+    /* NDEF can still be read on demand */
+    for (i = 0; i < G_N_ELEMENTS(test_init_data_success); i++) {
+        g_ptr_array_add(test_target->cmd_resp,
+            gutil_data_copy(test_init_data_success + i));
+    }
+    id = nfc_tag_add_ndef_ready_handler(tag, test_tag_quit_loop_cb, loop);
+    g_assert(nfc_tag_read_ndef(tag));
+    test_run(&test_opt, loop);
+    nfc_tag_remove_handler(tag, id);
+    g_assert(!(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED));
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+    g_assert(tag->ndef);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * lazy_no_react
+ *==========================================================================*/
+
+static
+void
+test_lazy_no_react(
+    void)
+{
+    NfcTarget* target = test_target_new_tech(NFC_TECHNOLOGY_B,
+        TEST_TARGET_FAIL_NONE);
+    NfcParamPollB poll_b;
+    NfcTagType4* t4b;
+    NfcTag* tag;
+
+    /* Without reactivation, there's no NDEF to wait for */
+    memset(&poll_b, 0, sizeof(poll_b));
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, NFC_TAG_T4_NDEF_LAZY,
+        &poll_b, NULL));
+    tag = &t4b->tag;
+    g_assert(tag->flags & NFC_TAG_FLAG_INITIALIZED);
+    g_assert(!(tag->flags & NFC_TAG_FLAG_NDEF_DEFERRED));
+    g_assert(!nfc_tag_read_ndef(tag));
+    g_assert(!nfc_tag_read_ndef(NULL));
+    g_assert(!tag->ndef);
+
+    nfc_tag_unref(tag);
+    nfc_target_unref(target);
+}
+
 /*==========================================================================*
  * apdu_ok
  *==========================================================================*/
@@ -1098,39 +1509,927 @@ test_apdu_fail(
 }
 
 /*==========================================================================*
- * Common
+ * transmit2
  *==========================================================================*/
 
-#define TEST_(name) "/core/tag_t4/" name
-
-int main(int argc, char* argv[])
-{
-    guint i;
-
-    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
-    g_type_init();
-    G_GNUC_END_IGNORE_DEPRECATIONS;
-    g_test_init(&argc, &argv, NULL);
-    g_test_add_func(TEST_("null"), test_null);
-    g_test_add_func(TEST_("basic"), test_basic);
-    g_test_add_func(TEST_("basic_a"), test_basic_a);
-    g_test_add_func(TEST_("basic_b"), test_basic_b);
-    g_test_add_func(TEST_("basic_reset"), test_basic_reset);
-    for (i = 0; i < G_N_ELEMENTS(init_tests); i++) {
-        const TestInitData* test = init_tests + i;
-        char* path = g_strconcat(TEST_("init_seq/"), test->name, NULL);
+typedef struct test_transmit2_data {
+    const char* name;
+    const GUtilData* cmd_resp;
+    gsize count;
+    guint8 cla;
+    guint8 ins;
+    GUtilData data;
+    guint le;
+    NFC_ISODEP_TX_FLAGS flags;
+    guint sw;
+    GUtilData resp;
+} TestTransmit2Data;
 
-        g_test_add_data_func(path, test, test_init_seq);
-        g_free(path);
-    }
-    for (i = 0; i < G_N_ELEMENTS(apdu_tests); i++) {
-        const TestApduData* test = apdu_tests + i;
-        char* path = g_strconcat(TEST_("apdu_ok/"), test->name, NULL);
+static const guint8 test_tx2_cmd_read[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x00              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_read_3[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x03              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_read_prop[] = {
+    0x90, 0xb0, 0x00, 0x00, 0x00              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_read_chan[] = {
+    0x01, 0xb0, 0x00, 0x00, 0x00              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_get_response_1[] = {
+    0x00, 0xc0, 0x00, 0x00, 0x01              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_get_response_2[] = {
+    0x00, 0xc0, 0x00, 0x00, 0x02              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_get_response_4[] = {
+    0x00, 0xc0, 0x00, 0x00, 0x04              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_get_response_256[] = {
+    0x00, 0xc0, 0x00, 0x00, 0x00              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_get_response_chan[] = {
+    0x01, 0xc0, 0x00, 0x00, 0x01              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_tx2_cmd_update_1[5 + 0xff] = {
+    0x10, 0xd6, 0x00, 0x00, 0xff              /* CLA|INS|P1|P2|Lc  */
+    /* 255 zeros */
+};
+static const guint8 test_tx2_cmd_update_2[5 + 0x2d] = {
+    0x00, 0xd6, 0x00, 0x00, 0x2d              /* CLA|INS|P1|P2|Lc  */
+    /* 45 zeros */
+};
+static const guint8 test_tx2_update_data[0xff + 0x2d] = { 0 };
+static const guint8 test_tx2_resp_more_4[] = {
+    0x01, 0x02,                               /* Data */
+    0x61, 0x04                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_more_2[] = {
+    0x61, 0x02                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_more_1[] = {
+    0x61, 0x01                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_more_256[] = {
+    0x03, 0x04, 0x05, 0x06,                   /* Data */
+    0x61, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_last[] = {
+    0x07,                                     /* Data */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_wrong_le_3[] = {
+    0x6c, 0x03                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_wrong_le_2[] = {
+    0x6c, 0x02                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_3[] = {
+    0x01, 0x02, 0x03,                         /* Data */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_resp_1[] = {
+    0xaa,                                     /* Data */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_tx2_data_7[] = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07
+};
+static const guint8 test_tx2_data_3[] = {
+    0x01, 0x02, 0x03
+};
+static const guint8 test_tx2_data_2[] = {
+    0x01, 0x02
+};
+static const guint8 test_tx2_data_1[] = {
+    0xaa
+};
+
+static const GUtilData test_tx2_none[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_4) }
+};
+static const GUtilData test_tx2_get_response[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_4) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_4) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_256) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_256) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_last) }
+};
+static const GUtilData test_tx2_get_response_err[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_2) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_2) }
+    /* Missing response becomes an I/O error */
+};
+static const GUtilData test_tx2_get_response_prop[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read_prop) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_1) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_1) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_1) }
+};
+static const GUtilData test_tx2_get_response_chan[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read_chan) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_1) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_chan) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_1) }
+};
+static const GUtilData test_tx2_wrong_le[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_wrong_le_3) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read_3) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_3) }
+};
+static const GUtilData test_tx2_wrong_le_twice[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_wrong_le_3) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_read_3) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_wrong_le_2) }
+};
+static const GUtilData test_tx2_chaining[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_update_1) },
+    { TEST_ARRAY_AND_SIZE(test_resp_ok) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_update_2) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_more_1) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_get_response_1) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_resp_1) }
+};
+static const GUtilData test_tx2_chaining_err[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_update_1) },
+    { TEST_ARRAY_AND_SIZE(test_resp_not_found) }
+};
+static const GUtilData test_tx2_chaining_io_err[] = {
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_update_1) },
+    { TEST_ARRAY_AND_SIZE(test_resp_ok) },
+    { TEST_ARRAY_AND_SIZE(test_tx2_cmd_update_2) }
+    /* Missing response becomes an I/O error */
+};
+
+static const TestTransmit2Data transmit2_tests[] = {
+#define TEST_TX2(x) #x, TEST_ARRAY_AND_COUNT(test_tx2_##x)
+#define TEST_TX2_UPDATE { TEST_ARRAY_AND_SIZE(test_tx2_update_data) }
+#define TEST_TX2_GR NFC_ISODEP_TX_FLAG_GET_RESPONSE
+#define TEST_TX2_CHAIN NFC_ISODEP_TX_FLAG_CHAINING
+    {
+        TEST_TX2(none), 0x00, 0xb0, { NULL, 0 }, 0x100,
+        NFC_ISODEP_TX_FLAGS_NONE, 0x6104,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_2) }
+    },{
+        TEST_TX2(get_response), 0x00, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, ISO_SW_OK,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_7) }
+    },{
+        TEST_TX2(get_response_err), 0x00, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, ISO_SW_IO_ERR, { NULL, 0 }
+    },{
+        TEST_TX2(get_response_prop), 0x90, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, ISO_SW_OK,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_1) }
+    },{
+        TEST_TX2(get_response_chan), 0x01, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, ISO_SW_OK,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_1) }
+    },{
+        TEST_TX2(wrong_le), 0x00, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, ISO_SW_OK,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_3) }
+    },{
+        TEST_TX2(wrong_le_twice), 0x00, 0xb0, { NULL, 0 }, 0x100,
+        TEST_TX2_GR, 0x6c02, { NULL, 0 }
+    },{
+        TEST_TX2(chaining), 0x00, 0xd6, TEST_TX2_UPDATE, 0,
+        TEST_TX2_CHAIN | TEST_TX2_GR, ISO_SW_OK,
+        { TEST_ARRAY_AND_SIZE(test_tx2_data_1) }
+    },{
+        TEST_TX2(chaining_err), 0x00, 0xd6, TEST_TX2_UPDATE, 0,
+        TEST_TX2_CHAIN, 0x6a82, { NULL, 0 }
+    },{
+        TEST_TX2(chaining_io_err), 0x00, 0xd6, TEST_TX2_UPDATE, 0,
+        TEST_TX2_CHAIN, ISO_SW_IO_ERR, { NULL, 0 }
+    }
+#undef TEST_TX2
+#undef TEST_TX2_UPDATE
+#undef TEST_TX2_GR
+#undef TEST_TX2_CHAIN
+};
+
+typedef struct test_transmit2 {
+    const TestTransmit2Data* data;
+    GMainLoop* loop;
+    gboolean destroyed;
+} TestTransmit2;
+
+static
+void
+test_transmit2_destroy(
+    void* user_data)
+{
+    TestTransmit2* test = user_data;
+
+    g_assert(!test->destroyed);
+    test->destroyed = TRUE;
+}
+
+static
+void
+test_transmit2_done(
+    NfcTagType4* tag,
+    guint sw,  /* 16 bits (SW1 << 8)|SW2 */
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTransmit2* test = user_data;
+    const GUtilData* resp = &test->data->resp;
+
+    GDEBUG("%04X (%u bytes)", sw, len);
+    g_assert(!test->destroyed);
+    g_assert_cmpuint(sw, == ,test->data->sw);
+    g_assert_cmpuint(len, == ,resp->size);
+    if (len) {
+        g_assert(!memcmp(data, resp->bytes, len));
+    }
+    g_main_loop_quit(test->loop);
+}
+
+static
+NfcTagType4*
+test_transmit2_tag(
+    NfcTarget* target)
+{
+    NfcParamPollB poll_b;
+    NfcTagType4* t4b;
+
+    memset(&poll_b, 0, sizeof(poll_b));
+    poll_b.fsc = 0x0b; /* i.e. 256 */
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, FALSE, &poll_b, NULL));
+    g_assert(NFC_IS_TAG_T4B(t4b));
+    g_assert(t4b->tag.flags & NFC_TAG_FLAG_INITIALIZED);
+    return t4b;
+}
+
+static
+void
+test_transmit2(
+    gconstpointer test_data)
+{
+    const TestTransmit2Data* data = test_data;
+    NfcTarget* target = test_target_new_tech(NFC_TECHNOLOGY_B,
+        TEST_TARGET_FAIL_NONE);
+    TestTarget* test_target = TEST_TARGET(target);
+    NfcTagType4* t4b;
+    TestTransmit2 test;
+    guint i;
+
+    memset(&test, 0, sizeof(test));
+    test.data = data;
+    test.loop = g_main_loop_new(NULL, TRUE);
+    for (i = 0; i < data->count; i++) {
+        g_ptr_array_add(test_target->cmd_resp,
+            gutil_data_copy(data->cmd_resp + i));
+    }
+
+    t4b = test_transmit2_tag(target);
+    g_assert(nfc_isodep_transmit2(t4b, data->cla, data->ins, 0x00, 0x00,
+        &data->data, data->le, data->flags, NULL, test_transmit2_done,
+        test_transmit2_destroy, &test));
+    test_run(&test_opt, test.loop);
+    g_assert(test.destroyed);
+    g_assert_cmpuint(test_target->cmd_resp->len, == ,0);
+
+    nfc_tag_unref(&t4b->tag);
+    nfc_target_unref(target);
+    g_main_loop_unref(test.loop);
+}
+
+/*==========================================================================*
+ * transmit2_cancel
+ *==========================================================================*/
+
+static
+void
+test_transmit2_cancel_done(
+    NfcTagType4* tag,
+    guint sw,  /* 16 bits (SW1 << 8)|SW2 */
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    g_assert_not_reached();
+}
+
+static
+void
+test_transmit2_cancel(
+    void)
+{
+    NfcTarget* target = test_target_new_tech(NFC_TECHNOLOGY_B,
+        TEST_TARGET_FAIL_NONE);
+    NfcTagType4* t4b = test_transmit2_tag(target);
+    TestTransmit2 test;
+    guint id;
+
+    memset(&test, 0, sizeof(test));
+
+    /* Submission failure */
+    TEST_TARGET(target)->fail_transmit++;
+    g_assert(!nfc_isodep_transmit2(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 0x100,
+        NFC_ISODEP_TX_FLAG_GET_RESPONSE, NULL, test_transmit2_cancel_done,
+        test_transmit2_destroy, &test));
+    g_assert(!test.destroyed);
+
+    /* Cancel the extended transmission */
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_tx2_cmd_read),
+        TEST_ARRAY_AND_SIZE(test_tx2_resp_more_4));
+    id = nfc_isodep_transmit2(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 0x100,
+        NFC_ISODEP_TX_FLAG_GET_RESPONSE, NULL, test_transmit2_cancel_done,
+        test_transmit2_destroy, &test);
+    g_assert(id);
+    g_assert(nfc_isodep_cancel(t4b, id));
+    g_assert(test.destroyed);
+    g_assert(!nfc_isodep_cancel(t4b, id));
+    g_ptr_array_set_size(TEST_TARGET(target)->cmd_resp, 0);
+
+    /* And the plain one */
+    test.destroyed = FALSE;
+    id = nfc_isodep_transmit2(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 0x100,
+        NFC_ISODEP_TX_FLAGS_NONE, NULL, test_transmit2_cancel_done,
+        test_transmit2_destroy, &test);
+    g_assert(id);
+    g_assert(nfc_isodep_cancel(t4b, id));
+    g_assert(test.destroyed);
+
+    /* Pending transfers are dropped together with the tag */
+    test.destroyed = FALSE;
+    g_assert(nfc_isodep_transmit2(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 0x100,
+        NFC_ISODEP_TX_FLAG_GET_RESPONSE, NULL, test_transmit2_cancel_done,
+        test_transmit2_destroy, &test));
+    nfc_tag_unref(&t4b->tag);
+    g_assert(test.destroyed);
+    nfc_target_unref(target);
+}
+
+/*==========================================================================*
+ * select_cache
+ *==========================================================================*/
+
+static const guint8 test_aid[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+static const guint8 test_cc_fid[] = { 0xe1, 0x03 };
+static const guint8 test_fci[] = { 0x6f, 0x03, 0x84, 0x01, 0x01 };
+static const guint8 test_resp_fci[] = {
+    0x6f, 0x03, 0x84, 0x01, 0x01,             /* Data */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_cmd_read_cc[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x02              /* CLA|INS|P1|P2|Le  */
+};
+
+typedef struct test_select_cache {
+    GMainLoop* loop;
+    const GUtilData* fci;
+    guint resp_count;
+    guint destroy_count;
+} TestSelectCache;
+
+static
+void
+test_select_cache_destroy(
+    void* user_data)
+{
+    TestSelectCache* test = user_data;
+
+    test->destroy_count++;
+}
+
+static
+void
+test_select_cache_resp(
+    NfcTagType4* tag,
+    guint sw,  /* 16 bits (SW1 << 8)|SW2 */
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestSelectCache* test = user_data;
+
+    GDEBUG("%04X (%u bytes)", sw, len);
+    if (test->fci) {
+        g_assert_cmpuint(sw, == ,ISO_SW_OK);
+        g_assert_cmpuint(len, == ,test->fci->size);
+        g_assert(!memcmp(data, test->fci->bytes, len));
+    }
+    test->resp_count++;
+    g_main_loop_quit(test->loop);
+}
+
+static
+void
+test_select_cache_select(
+    NfcTagType4* t4,
+    TestSelectCache* test,
+    const GUtilData* aid)
+{
+    static const GUtilData cc = { TEST_ARRAY_AND_SIZE(test_cc_fid) };
+
+    /* SELECT by DF name or CC file id */
+    g_assert(nfc_isodep_transmit(t4, 0x00, 0xa4, aid ? 0x04 : 0x00,
+        aid ? 0x00 : 0x0c, aid ? aid : &cc, aid ? 0x100 : 0,
+        NULL, test_select_cache_resp, test_select_cache_destroy, test));
+    test_run(&test_opt, test->loop);
+}
+
+static
+void
+test_select_cache(
+    void)
+{
+    static const GUtilData aid = { TEST_ARRAY_AND_SIZE(test_aid) };
+    static const GUtilData fci = { TEST_ARRAY_AND_SIZE(test_fci) };
+    static const GUtilData no_fci = { NULL, 0 };
+    TestTarget2* test_target = g_object_new(TEST_TYPE_TARGET2, NULL);
+    NfcTarget* target = NFC_TARGET(test_target);
+    GPtrArray* cmd_resp = test_target->parent.cmd_resp;
+    const NfcIsoDepSelectStats* stats;
+    NfcTagType4* t4b;
+    TestSelectCache test;
+    NfcParamPollB poll_b;
+    guint id;
+
+    memset(&test, 0, sizeof(test));
+    memset(&poll_b, 0, sizeof(poll_b));
+    test.loop = g_main_loop_new(NULL, TRUE);
+    t4b = NFC_TAG_T4(nfc_tag_t4b_new(target, FALSE, &poll_b, NULL));
+    stats = nfc_isodep_select_stats(t4b);
+    g_assert(stats);
+    nfc_isodep_set_select_cache(t4b, TRUE);
+
+    /* The first SELECT goes to the card, the second one doesn't */
+    test.fci = &fci;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,1);
+    g_assert_cmpuint(stats->cached, == ,1);
+
+    /* Same thing with EF */
+    test.fci = &no_fci;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_cc),
+        TEST_ARRAY_AND_SIZE(test_resp_ok));
+    test_select_cache_select(t4b, &test, NULL);
+    test_select_cache_select(t4b, &test, NULL);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,2);
+    g_assert_cmpuint(stats->cached, == ,2);
+
+    /* DF selection is not cached while EF is selected */
+    test.fci = &fci;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,3);
+
+    /* Failed SELECT doesn't change the selection */
+    test.fci = NULL;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_cc),
+        TEST_ARRAY_AND_SIZE(test_resp_not_found));
+    test_select_cache_select(t4b, &test, NULL);
+    test.fci = &fci;
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,4);
+    g_assert_cmpuint(stats->cached, == ,3);
+
+    /* Any other error invalidates it */
+    test.fci = NULL;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_read_cc),
+        TEST_ARRAY_AND_SIZE(test_resp_err));
+    g_assert(nfc_isodep_transmit(t4b, 0x00, 0xb0, 0x00, 0x00, NULL, 2,
+        NULL, test_select_cache_resp, NULL, &test));
+    test_run(&test_opt, test.loop);
+    test.fci = &fci;
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,5);
+    g_assert_cmpuint(stats->cached, == ,3);
+
+    /* Cached response can be cancelled */
+    test.resp_count = test.destroy_count = 0;
+    id = nfc_isodep_transmit(t4b, 0x00, 0xa4, 0x04, 0x00, &aid, 0x100,
+        NULL, test_transmit2_cancel_done, test_select_cache_destroy, &test);
+    g_assert(id);
+    g_assert_cmpuint(stats->cached, == ,4);
+    g_assert(nfc_isodep_cancel(t4b, id));
+    g_assert(!nfc_isodep_cancel(t4b, id));
+    g_assert_cmpuint(test.destroy_count, == ,1);
+
+    /* Reset invalidates the selection */
+    g_assert(nfc_isodep_reset(t4b, NULL, test_tag_reset_cb, NULL, test.loop));
+    test_run(&test_opt, test.loop);
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,6);
+
+    /* Cache can be switched off */
+    nfc_isodep_set_select_cache(t4b, FALSE);
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,7);
+    g_assert_cmpuint(stats->cached, == ,4);
+
+    /* Enabling the cache forgets the selection */
+    nfc_isodep_set_select_cache(t4b, TRUE);
+    test_target_add_data(target, TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app),
+        TEST_ARRAY_AND_SIZE(test_resp_fci));
+    test_select_cache_select(t4b, &test, &aid);
+    g_assert_cmpuint(cmd_resp->len, == ,0);
+    g_assert_cmpuint(stats->sent, == ,8);
+    g_assert_cmpuint(stats->cached, == ,4);
+
+    /* Pending cached response is dropped together with the tag */
+    test.destroy_count = 0;
+    g_assert(nfc_isodep_transmit(t4b, 0x00, 0xa4, 0x04, 0x00, &aid, 0x100,
+        NULL, test_transmit2_cancel_done, test_select_cache_destroy, &test));
+    nfc_tag_unref(&t4b->tag);
+    g_assert_cmpuint(test.destroy_count, == ,1);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(test.loop);
+}
+
+/*==========================================================================*
+ * write_ndef
+ *==========================================================================*/
+
+static const guint8 test_write_ndef_data[] = {
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9
+};
+static const guint8 test_write_resp_cc[] = {
+    0x00, 0x0f, 0x20, 0x00, 0x3b, 0x00, 0x04, /* Data (MLc = 4) */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x32, 0x00,
+    0x00,
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_write_resp_cc_mlc_255[] = {
+    0x00, 0x0f, 0x20, 0x00, 0x3b, 0x00, 0xff, /* Data (MLc = 255) */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x32, 0x00,
+    0x00,
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_write_resp_cc_read_only[] = {
+    0x00, 0x0f, 0x20, 0x00, 0x3b, 0x00, 0x04, /* Data */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x32, 0x00,
+    0xff,
+    /* ^^ no write access                    */
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_write_resp_cc_small[] = {
+    0x00, 0x0f, 0x20, 0x00, 0x3b, 0x00, 0x04, /* Data */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x0b, 0x00,
+    /*                       max size ^^     */
+    0x00,
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_write_cmd_select_ndef[] = {
+    0x00, 0xa4, 0x00, 0x0c, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0xe1, 0x04                                /* Data */
+};
+static const guint8 test_write_cmd_clear_nlen[] = {
+    0x00, 0xd6, 0x00, 0x00, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0x00, 0x00                                /* Data */
+};
+static const guint8 test_write_cmd_data_1[] = {
+    0x00, 0xd6, 0x00, 0x02, 0x04,             /* CLA|INS|P1|P2|Lc  */
+    0xb0, 0xb1, 0xb2, 0xb3                    /* Data */
+};
+static const guint8 test_write_cmd_data_2[] = {
+    0x00, 0xd6, 0x00, 0x06, 0x04,             /* CLA|INS|P1|P2|Lc  */
+    0xb4, 0xb5, 0xb6, 0xb7                    /* Data */
+};
+static const guint8 test_write_cmd_data_3[] = {
+    0x00, 0xd6, 0x00, 0x0a, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0xb8, 0xb9                                /* Data */
+};
+static const guint8 test_write_cmd_data_fsc[] = {
+    0x00, 0xd6, 0x00, 0x02, 0x08,             /* CLA|INS|P1|P2|Lc  */
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, /* Data */
+    0xb7
+};
+static const guint8 test_write_cmd_set_nlen[] = {
+    0x00, 0xd6, 0x00, 0x00, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0x00, 0x0a                                /* Data */
+};
+
+#define TEST_WRITE_TX_SELECT_APP \
+    { { TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app) }, \
+      { TEST_ARRAY_AND_SIZE(test_resp_ok) } }
+#define TEST_WRITE_TX_SELECT_CC \
+    { { TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_cc) }, \
+      { TEST_ARRAY_AND_SIZE(test_resp_ok) } }
+#define TEST_WRITE_TX_READ_CC(resp) \
+    { { TEST_ARRAY_AND_SIZE(test_cmd_read_ndef_cc) }, \
+      { TEST_ARRAY_AND_SIZE(resp) } }
+#define TEST_WRITE_TX_OK(cmd) \
+    { { TEST_ARRAY_AND_SIZE(cmd) }, \
+      { TEST_ARRAY_AND_SIZE(test_resp_ok) } }
+
+static const TestTx test_write_ok_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc),
+    TEST_WRITE_TX_OK(test_write_cmd_select_ndef),
+    TEST_WRITE_TX_OK(test_write_cmd_clear_nlen),
+    TEST_WRITE_TX_OK(test_write_cmd_data_1),
+    TEST_WRITE_TX_OK(test_write_cmd_data_2),
+    TEST_WRITE_TX_OK(test_write_cmd_data_3),
+    TEST_WRITE_TX_OK(test_write_cmd_set_nlen)
+};
+static const TestTx test_write_fsc_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc_mlc_255),
+    TEST_WRITE_TX_OK(test_write_cmd_select_ndef),
+    TEST_WRITE_TX_OK(test_write_cmd_clear_nlen),
+    /* FSC 16 leaves room for 8 bytes of data */
+    TEST_WRITE_TX_OK(test_write_cmd_data_fsc),
+    TEST_WRITE_TX_OK(test_write_cmd_data_3),
+    TEST_WRITE_TX_OK(test_write_cmd_set_nlen)
+};
+static const TestTx test_write_empty_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc),
+    TEST_WRITE_TX_OK(test_write_cmd_select_ndef),
+    TEST_WRITE_TX_OK(test_write_cmd_clear_nlen)
+};
+static const TestTx test_write_not_found_tx[] = {
+    { { TEST_ARRAY_AND_SIZE(test_cmd_select_ndef_app) },
+      { TEST_ARRAY_AND_SIZE(test_resp_not_found) } }
+};
+static const TestTx test_write_read_only_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc_read_only)
+};
+static const TestTx test_write_too_big_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc_small)
+};
+static const TestTx test_write_bad_cc_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_resp_read_ndef_cc_v3)
+};
+static const TestTx test_write_io_error_tx[] = {
+    TEST_WRITE_TX_SELECT_APP
+};
+static const TestTx test_write_update_error_tx[] = {
+    TEST_WRITE_TX_SELECT_APP,
+    TEST_WRITE_TX_SELECT_CC,
+    TEST_WRITE_TX_READ_CC(test_write_resp_cc),
+    TEST_WRITE_TX_OK(test_write_cmd_select_ndef),
+    { { TEST_ARRAY_AND_SIZE(test_write_cmd_clear_nlen) },
+      { TEST_ARRAY_AND_SIZE(test_resp_err) } }
+};
+
+typedef struct test_write_ndef_data {
+    const char* name;
+    GUtilData ndef;
+    const TestTx* tx;
+    guint tx_count;
+    NFC_TAG_T4_WRITE_STATUS status;
+    guint fsc; /* Zero for 256 */
+} TestWriteNdefData;
+
+static const TestWriteNdefData write_ndef_tests[] = {
+    { "ok", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_ok_tx), NFC_TAG_T4_WRITE_OK },
+    { "fsc", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_fsc_tx), NFC_TAG_T4_WRITE_OK, 16 },
+    { "empty", { test_write_ndef_data, 0 },
+      TEST_ARRAY_AND_COUNT(test_write_empty_tx), NFC_TAG_T4_WRITE_OK },
+    { "not_found", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_not_found_tx),
+      NFC_TAG_T4_WRITE_NOT_NDEF },
+    { "read_only", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_read_only_tx),
+      NFC_TAG_T4_WRITE_READ_ONLY },
+    { "too_big", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_too_big_tx),
+      NFC_TAG_T4_WRITE_TOO_BIG },
+    { "bad_cc", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_bad_cc_tx),
+      NFC_TAG_T4_WRITE_FAILURE },
+    { "io_error", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_io_error_tx),
+      NFC_TAG_T4_WRITE_IO_ERROR },
+    { "update_error", { TEST_ARRAY_AND_SIZE(test_write_ndef_data) },
+      TEST_ARRAY_AND_COUNT(test_write_update_error_tx),
+      NFC_TAG_T4_WRITE_FAILURE }
+};
+
+typedef struct test_write_ndef {
+    const TestWriteNdefData* data;
+    GMainLoop* loop;
+    gboolean destroyed;
+} TestWriteNdef;
+
+static
+void
+test_write_ndef_destroy(
+    void* user_data)
+{
+    TestWriteNdef* test = user_data;
+
+    g_assert(!test->destroyed);
+    test->destroyed = TRUE;
+}
+
+static
+void
+test_write_ndef_done(
+    NfcTagType4* tag,
+    NFC_TAG_T4_WRITE_STATUS status,
+    void* user_data)
+{
+    TestWriteNdef* test = user_data;
+
+    GDEBUG("Status %d", status);
+    g_assert(!test->destroyed);
+    g_assert_cmpint(status, == ,test->data->status);
+    g_main_loop_quit(test->loop);
+}
+
+static
+void
+test_write_ndef_not_reached(
+    NfcTagType4* tag,
+    NFC_TAG_T4_WRITE_STATUS status,
+    void* user_data)
+{
+    g_assert_not_reached();
+}
+
+static
+void
+test_write_ndef(
+    gconstpointer test_data)
+{
+    const TestWriteNdefData* data = test_data;
+    NfcTarget* target = test_target_new_with_tx(data->tx, data->tx_count);
+    NfcParamIsoDepPollA iso_dep_poll_a;
+    GBytes* ndef = g_bytes_new(data->ndef.bytes, data->ndef.size);
+    TestWriteNdef test;
+    NfcTagType4* t4a;
+
+    memset(&test, 0, sizeof(test));
+    memset(&iso_dep_poll_a, 0, sizeof(iso_dep_poll_a));
+    iso_dep_poll_a.fsc = data->fsc ? data->fsc : 256;
+    test.data = data;
+    test.loop = g_main_loop_new(NULL, TRUE);
+    t4a = NFC_TAG_T4(nfc_tag_t4a_new(target, FALSE, NULL, &iso_dep_poll_a));
+    g_assert(nfc_tag_t4_write_ndef(t4a, ndef, NULL, test_write_ndef_done,
+        test_write_ndef_destroy, &test));
+    test_run(&test_opt, test.loop);
+    g_assert(test.destroyed);
+    g_assert_cmpuint(test_target_tx_remaining(target), == ,0);
+
+    nfc_tag_unref(&t4a->tag);
+    nfc_target_unref(target);
+    g_bytes_unref(ndef);
+    g_main_loop_unref(test.loop);
+}
+
+static
+void
+test_write_ndef_cancel(
+    void)
+{
+    NfcTarget* target = test_target_new_with_tx(test_write_ok_tx,
+        G_N_ELEMENTS(test_write_ok_tx));
+    NfcParamIsoDepPollA iso_dep_poll_a;
+    GBytes* ndef = g_bytes_new_static(test_write_ndef_data,
+        sizeof(test_write_ndef_data));
+    GBytes* huge = g_bytes_new_take(g_malloc0(0x8000), 0x8000);
+    TestWriteNdef test;
+    NfcTagType4* t4a;
+    guint id;
+
+    memset(&test, 0, sizeof(test));
+    memset(&iso_dep_poll_a, 0, sizeof(iso_dep_poll_a));
+    iso_dep_poll_a.fsc = 256;
+    t4a = NFC_TAG_T4(nfc_tag_t4a_new(target, FALSE, NULL, &iso_dep_poll_a));
+
+    /* Invalid parameters */
+    g_assert(!nfc_tag_t4_write_ndef(NULL, ndef, NULL, NULL, NULL, NULL));
+    g_assert(!nfc_tag_t4_write_ndef(t4a, NULL, NULL, NULL, NULL, NULL));
+    g_assert(!nfc_tag_t4_write_ndef(t4a, huge, NULL, NULL, NULL, NULL));
+
+    /* Submission failure */
+    TEST_TARGET(target)->fail_transmit++;
+    g_assert(!nfc_tag_t4_write_ndef(t4a, ndef, NULL,
+        test_write_ndef_not_reached, test_write_ndef_destroy, &test));
+    g_assert(!test.destroyed);
+
+    /* Cancel */
+    id = nfc_tag_t4_write_ndef(t4a, ndef, NULL, test_write_ndef_not_reached,
+        test_write_ndef_destroy, &test);
+    g_assert(id);
+    g_assert(nfc_isodep_cancel(t4a, id));
+    g_assert(test.destroyed);
+    g_assert(!nfc_isodep_cancel(t4a, id));
+
+    /* Pending writes are dropped together with the tag */
+    test.destroyed = FALSE;
+    g_assert(nfc_tag_t4_write_ndef(t4a, ndef, NULL,
+        test_write_ndef_not_reached, test_write_ndef_destroy, &test));
+    nfc_tag_unref(&t4a->tag);
+    g_assert(test.destroyed);
+
+    nfc_target_unref(target);
+    g_bytes_unref(ndef);
+    g_bytes_unref(huge);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/core/tag_t4/" name
+
+int main(int argc, char* argv[])
+{
+    guint i;
+
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+    g_type_init();
+    G_GNUC_END_IGNORE_DEPRECATIONS;
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("basic_a"), test_basic_a);
+    g_test_add_func(TEST_("basic_b"), test_basic_b);
+    g_test_add_func(TEST_("basic_reset"), test_basic_reset);
+    for (i = 0; i < G_N_ELEMENTS(init_tests); i++) {
+        const TestInitData* test = init_tests + i;
+        char* path = g_strconcat(TEST_("init_seq/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_init_seq);
+        g_free(path);
+    }
+    for (i = 0; i < G_N_ELEMENTS(ext_len_tests); i++) {
+        const TestExtLenData* test = ext_len_tests + i;
+        char* path = g_strconcat(TEST_("ext_len/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_ext_len);
+        g_free(path);
+    }
+    for (i = 0; i < G_N_ELEMENTS(lazy_tests); i++) {
+        const TestLazyData* test = lazy_tests + i;
+        char* path = g_strconcat(TEST_("lazy/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_lazy);
+        g_free(path);
+    }
+    g_test_add_func(TEST_("lazy_busy"), test_lazy_busy);
+    g_test_add_func(TEST_("lazy_client"), test_lazy_client);
+    g_test_add_func(TEST_("lazy_no_react"), test_lazy_no_react);
+    for (i = 0; i < G_N_ELEMENTS(apdu_tests); i++) {
+        const TestApduData* test = apdu_tests + i;
+        char* path = g_strconcat(TEST_("apdu_ok/"), test->name, NULL);
 
         g_test_add_data_func(path, test, test_apdu_ok);
         g_free(path);
     }
     g_test_add_func(TEST_("apdu_fail"), test_apdu_fail);
+    for (i = 0; i < G_N_ELEMENTS(transmit2_tests); i++) {
+        const TestTransmit2Data* test = transmit2_tests + i;
+        char* path = g_strconcat(TEST_("transmit2/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_transmit2);
+        g_free(path);
+    }
+    g_test_add_func(TEST_("transmit2_cancel"), test_transmit2_cancel);
+    g_test_add_func(TEST_("select_cache"), test_select_cache);
+    for (i = 0; i < G_N_ELEMENTS(write_ndef_tests); i++) {
+        const TestWriteNdefData* test = write_ndef_tests + i;
+        char* path = g_strconcat(TEST_("write_ndef/"), test->name, NULL);
+
+        g_test_add_data_func(path, test, test_write_ndef);
+        g_free(path);
+    }
+    g_test_add_func(TEST_("write_ndef_cancel"), test_write_ndef_cancel);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
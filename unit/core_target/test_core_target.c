@@ -162,6 +162,8 @@ typedef struct test_target {
     NfcTarget target;
     gboolean deactivated;
     gboolean fail_transmit;
+    gboolean complete_sync;
+    gboolean no_response;
     guint transmit_id;
     GSList* transmit_responses;
     guint succeeded;
@@ -216,6 +218,14 @@ test_target_transmit(
         /* Base class fails the call */
         return NFC_TARGET_CLASS(test_target_parent_class)->transmit
             (target, data, len);
+    } else if (self->no_response) {
+        /* Let it time out */
+        return TRUE;
+    } else if (self->complete_sync) {
+        /* Complete the transmission before returning */
+        g_assert(!self->transmit_id);
+        test_target_transmit_cb(self);
+        return TRUE;
     } else {
         g_assert(!self->transmit_id);
         self->transmit_id = g_idle_add(test_target_transmit_cb, self);
@@ -369,6 +379,206 @@ test_target2_class_init(
     klass->reactivate = test_target2_reactivate;
 }
 
+/*==========================================================================*
+ * Test target with transmit_bytes
+ *==========================================================================*/
+
+typedef TestTargetClass TestTarget3Class;
+typedef struct test_target3 {
+    TestTarget parent;
+    GBytes* last;
+    guint count;
+} TestTarget3;
+
+G_DEFINE_TYPE(TestTarget3, test_target3, TEST_TYPE_TARGET)
+#define TEST_TYPE_TARGET3 (test_target3_get_type())
+#define TEST_TARGET3(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_TARGET3, TestTarget3))
+
+static
+TestTarget3*
+test_target3_new(
+    void)
+{
+    return g_object_new(TEST_TYPE_TARGET3, NULL);
+}
+
+static
+gboolean
+test_target3_transmit_bytes(
+    NfcTarget* target,
+    GBytes* data)
+{
+    TestTarget3* test = TEST_TARGET3(target);
+    gsize size;
+    const void* bytes = g_bytes_get_data(data, &size);
+
+    /* Keep the reference to make sure that it's not a temporary copy */
+    if (test->last) {
+        g_bytes_unref(test->last);
+    }
+    test->last = g_bytes_ref(data);
+    test->count++;
+    return NFC_TARGET_CLASS(test_target3_parent_class)->transmit(target,
+        bytes, size);
+}
+
+static
+void
+test_target3_init(
+    TestTarget3* self)
+{
+}
+
+static
+void
+test_target3_finalize(
+    GObject* object)
+{
+    TestTarget3* test = TEST_TARGET3(object);
+
+    if (test->last) {
+        g_bytes_unref(test->last);
+    }
+    G_OBJECT_CLASS(test_target3_parent_class)->finalize(object);
+}
+
+static
+void
+test_target3_class_init(
+    NfcTargetClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = test_target3_finalize;
+    klass->transmit_bytes = test_target3_transmit_bytes;
+}
+
+/*==========================================================================*
+ * Test target with transmit_batch
+ *==========================================================================*/
+
+typedef TestTargetClass TestTarget4Class;
+typedef struct test_target4 {
+    TestTarget parent;
+    GPtrArray* frames;
+    GByteArray* completed;
+    guint complete_id;
+    guint cancel_id;
+    guint fail_batch;
+    guint batches;
+    guint max_batch;
+    guint failed;
+} TestTarget4;
+
+G_DEFINE_TYPE(TestTarget4, test_target4, TEST_TYPE_TARGET)
+#define TEST_TYPE_TARGET4 (test_target4_get_type())
+#define TEST_TARGET4(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj, \
+        TEST_TYPE_TARGET4, TestTarget4))
+
+static
+TestTarget4*
+test_target4_new(
+    void)
+{
+    return g_object_new(TEST_TYPE_TARGET4, NULL);
+}
+
+static
+gboolean
+test_target4_complete(
+    gpointer user_data)
+{
+    TestTarget4* test = TEST_TARGET4(user_data);
+    NfcTarget* target = NFC_TARGET(test);
+
+    /* Echo the frames back, one by one */
+    test->complete_id = 0;
+    while (test->frames->len) {
+        GBytes* frame = g_bytes_ref(test->frames->pdata[0]);
+        gsize size;
+        const void* data = g_bytes_get_data(frame, &size);
+
+        g_ptr_array_remove_index(test->frames, 0);
+        nfc_target_transmit_done(target, NFC_TRANSMIT_STATUS_OK, data, size);
+        g_bytes_unref(frame);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_target4_transmit_batch(
+    NfcTarget* target,
+    GBytes* const* frames,
+    guint count)
+{
+    TestTarget4* test = TEST_TARGET4(target);
+    guint i;
+
+    if (test->fail_batch) {
+        test->fail_batch--;
+        return FALSE;
+    }
+    for (i = 0; i < count; i++) {
+        g_ptr_array_add(test->frames, g_bytes_ref(frames[i]));
+    }
+    test->batches++;
+    test->max_batch = MAX(test->max_batch, count);
+    if (!test->complete_id) {
+        test->complete_id = g_idle_add(test_target4_complete, test);
+    }
+    return TRUE;
+}
+
+static
+void
+test_target4_cancel_transmit(
+    NfcTarget* target)
+{
+    TestTarget4* test = TEST_TARGET4(target);
+
+    g_ptr_array_set_size(test->frames, 0);
+    if (test->complete_id) {
+        g_source_remove(test->complete_id);
+        test->complete_id = 0;
+    }
+    NFC_TARGET_CLASS(test_target4_parent_class)->cancel_transmit(target);
+}
+
+static
+void
+test_target4_init(
+    TestTarget4* self)
+{
+    self->frames = g_ptr_array_new_with_free_func((GDestroyNotify)
+        g_bytes_unref);
+    self->completed = g_byte_array_new();
+}
+
+static
+void
+test_target4_finalize(
+    GObject* object)
+{
+    TestTarget4* test = TEST_TARGET4(object);
+
+    if (test->complete_id) {
+        g_source_remove(test->complete_id);
+    }
+    g_ptr_array_free(test->frames, TRUE);
+    g_byte_array_free(test->completed, TRUE);
+    G_OBJECT_CLASS(test_target4_parent_class)->finalize(object);
+}
+
+static
+void
+test_target4_class_init(
+    NfcTargetClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = test_target4_finalize;
+    klass->transmit_batch = test_target4_transmit_batch;
+    klass->cancel_transmit = test_target4_cancel_transmit;
+}
+
 /*==========================================================================*
  * null
  *==========================================================================*/
@@ -519,6 +729,406 @@ test_transmit_ok(
     g_main_loop_unref(loop);
 }
 
+/*==========================================================================*
+ * dispatch_sync
+ *==========================================================================*/
+
+static
+void
+test_dispatch_sync(
+    void)
+{
+    static const guint8 data1[] = { 0x01 };
+    static const guint8 data2[] = { 0x01, 0x02 };
+    GUtilData resp1, resp2;
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    const NfcTargetDispatchStats* stats = nfc_target_dispatch_stats(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+
+    g_assert(stats);
+    g_assert_cmpuint(stats->sync, == ,0);
+    g_assert_cmpuint(stats->idle, == ,0);
+    nfc_target_set_dispatch_mode(target, NFC_TARGET_DISPATCH_SYNC);
+    nfc_target_set_dispatch_mode(target, NFC_TARGET_DISPATCH_SYNC); /* NOOP */
+    if (!(test_opt.flags & TEST_FLAG_DEBUG)) {
+        nfc_target_set_transmit_timeout(target, TEST_TIMEOUT_SEC * 1000);
+    }
+
+    TEST_BYTES_SET(resp1, data1);
+    TEST_BYTES_SET(resp2, data2);
+    test->transmit_responses = g_slist_append(g_slist_append(
+        test->transmit_responses,
+        test_transmit_response_new_from_bytes(&resp1)),
+        test_transmit_response_new_from_bytes(&resp2));
+
+    g_assert(nfc_target_transmit(target, data1, sizeof(data1), NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp1));
+    g_assert(nfc_target_transmit(target, data2, sizeof(data2), NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp2));
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+
+    test_run(&test_opt, loop);
+
+    /* The first request was submitted right away, two more on completion */
+    g_assert(test->succeeded == 2);
+    g_assert_cmpuint(stats->sync, == ,2);
+    g_assert_cmpuint(stats->idle, == ,0);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+    g_assert(!nfc_target_dispatch_stats(NULL));
+    nfc_target_set_dispatch_mode(NULL, NFC_TARGET_DISPATCH_SYNC);
+}
+
+/*==========================================================================*
+ * dispatch_nested
+ *==========================================================================*/
+
+static
+void
+test_dispatch_nested(
+    void)
+{
+    static const guint8 data1[] = { 0x01 };
+    static const guint8 data2[] = { 0x01, 0x02 };
+    GUtilData resp1, resp2;
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    const NfcTargetDispatchStats* stats = nfc_target_dispatch_stats(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+
+    nfc_target_set_dispatch_mode(target, NFC_TARGET_DISPATCH_SYNC);
+    TEST_BYTES_SET(resp1, data1);
+    TEST_BYTES_SET(resp2, data2);
+    test->transmit_responses = g_slist_append(g_slist_append(
+        test->transmit_responses,
+        test_transmit_response_new_from_bytes(&resp1)),
+        test_transmit_response_new_from_bytes(&resp2));
+
+    g_assert(nfc_target_transmit(target, data1, sizeof(data1), NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp1));
+    g_assert(nfc_target_transmit(target, data2, sizeof(data2), NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp2));
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+
+    /*
+     * The second request gets submitted synchronously and completes
+     * inside the transmit callback. That forces the third one to go
+     * through the idle callback.
+     */
+    test->complete_sync = TRUE;
+    test_run(&test_opt, loop);
+
+    g_assert(test->succeeded == 2);
+    g_assert_cmpuint(stats->sync, == ,1);
+    g_assert_cmpuint(stats->idle, == ,1);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * dispatch_idle
+ *==========================================================================*/
+
+typedef struct test_dispatch_idle_data {
+    NfcTarget* target;
+    GMainLoop* loop;
+    guint cancel_id;
+} TestDispatchIdleData;
+
+static
+gboolean
+test_dispatch_idle_quit(
+    gpointer loop)
+{
+    g_main_loop_quit((GMainLoop*)loop);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_dispatch_idle_cancel(
+    gpointer user_data)
+{
+    TestDispatchIdleData* test = user_data;
+
+    /* By now the idle dispatch is already scheduled */
+    g_assert(nfc_target_cancel_transmit(test->target, test->cancel_id));
+    g_idle_add(test_dispatch_idle_quit, test->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_dispatch_idle_resp(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    g_assert(status == NFC_TRANSMIT_STATUS_OK);
+    g_idle_add(test_dispatch_idle_cancel, user_data);
+}
+
+static
+void
+test_dispatch_idle(
+    void)
+{
+    static const guint8 data[] = { 0x01 };
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    const NfcTargetDispatchStats* stats = nfc_target_dispatch_stats(target);
+    TestDispatchIdleData idle;
+
+    memset(&idle, 0, sizeof(idle));
+    idle.target = target;
+    idle.loop = g_main_loop_new(NULL, TRUE);
+    if (!(test_opt.flags & TEST_FLAG_DEBUG)) {
+        nfc_target_set_transmit_timeout(target, TEST_TIMEOUT_SEC * 1000);
+    }
+
+    /*
+     * The second request gets cancelled after the idle dispatch has
+     * been scheduled but before it had a chance to run. Nothing gets
+     * submitted from the idle callback and nothing gets counted.
+     */
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        test_dispatch_idle_resp, NULL, &idle));
+    g_assert((idle.cancel_id = nfc_target_transmit(target, data,
+        sizeof(data), NULL, NULL, NULL, NULL)) != 0);
+
+    test_run(&test_opt, idle.loop);
+    g_assert_cmpuint(stats->sync, == ,0);
+    g_assert_cmpuint(stats->idle, == ,0);
+
+    /* And this one does get submitted from the idle callback */
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        NULL, NULL, NULL));
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        NULL, test_quit_loop, idle.loop));
+
+    test_run(&test_opt, idle.loop);
+    g_assert_cmpuint(stats->sync, == ,0);
+    g_assert_cmpuint(stats->idle, == ,1);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(idle.loop);
+}
+
+/*==========================================================================*
+ * transmit_bytes
+ *==========================================================================*/
+
+static
+void
+test_transmit_bytes(
+    void)
+{
+    static const guint8 data1[] = { 0x01 };
+    static const guint8 data2[] = { 0x01, 0x02 };
+    GUtilData resp1, resp2;
+    GBytes* bytes1 = g_bytes_new_static(data1, sizeof(data1));
+    GBytes* bytes2 = g_bytes_new_static(data2, sizeof(data2));
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+
+    g_assert(!nfc_target_transmit_bytes(NULL, bytes1, NULL, NULL, NULL,
+        NULL));
+    g_assert(!nfc_target_transmit_bytes(target, NULL, NULL, NULL, NULL,
+        NULL));
+
+    /* This target doesn't implement transmit_bytes */
+    TEST_BYTES_SET(resp1, data1);
+    TEST_BYTES_SET(resp2, data2);
+    test->transmit_responses = g_slist_append(g_slist_append(
+        test->transmit_responses,
+        test_transmit_response_new_from_bytes(&resp1)),
+        test_transmit_response_new_from_bytes(&resp2));
+
+    g_assert(nfc_target_transmit_bytes(target, bytes1, NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp1));
+    g_assert(nfc_target_transmit_bytes(target, bytes2, NULL,
+        test_transmit_ok_resp, test_clear_bytes, &resp2));
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+
+    test_run(&test_opt, loop);
+
+    g_assert(test->succeeded == 2);
+    g_assert(!resp1.bytes);
+    g_assert(!resp2.bytes);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+    g_bytes_unref(bytes1);
+    g_bytes_unref(bytes2);
+}
+
+/*==========================================================================*
+ * transmit_bytes2
+ *==========================================================================*/
+
+static
+void
+test_transmit_bytes2(
+    void)
+{
+    static const guint8 data1[] = { 0x01 };
+    static const guint8 data2[] = { 0x01, 0x02 };
+    static const guint8 data3[] = { 0x01, 0x02, 0x03 };
+    GBytes* bytes1 = g_bytes_new_static(data1, sizeof(data1));
+    GBytes* bytes2 = g_bytes_new_static(data2, sizeof(data2));
+    GBytes* bytes3 = g_bytes_new_static(data3, sizeof(data3));
+    TestTarget3* test = test_target3_new();
+    NfcTarget* target = NFC_TARGET(test);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+
+    /* The first one is submitted right away, as is */
+    g_assert(nfc_target_transmit_bytes(target, bytes1, NULL, NULL, NULL,
+        NULL));
+    g_assert(test->last == bytes1);
+    g_assert_cmpuint(test->count, == ,1);
+
+    /* These two get queued */
+    g_assert(nfc_target_transmit_bytes(target, bytes2, NULL, NULL, NULL,
+        NULL));
+    g_assert(nfc_target_transmit(target, data3, sizeof(data3), NULL, NULL,
+        test_quit_loop, loop));
+    g_assert_cmpuint(test->count, == ,1);
+
+    test_run(&test_opt, loop);
+
+    /* The last one is a copy */
+    g_assert_cmpuint(test->count, == ,3);
+    g_assert(test->last != bytes3);
+    g_assert(g_bytes_equal(test->last, bytes3));
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+    g_bytes_unref(bytes1);
+    g_bytes_unref(bytes2);
+    g_bytes_unref(bytes3);
+}
+
+/*==========================================================================*
+ * transmit_batch
+ *==========================================================================*/
+
+static
+void
+test_transmit_batch_resp(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTarget4* test = TEST_TARGET4(target);
+    const guint8* byte = user_data;
+
+    if (status == NFC_TRANSMIT_STATUS_OK) {
+        /* The first frame goes through the regular transmit */
+        if (len) {
+            g_assert_cmpuint(len, == ,1);
+            g_assert_cmpuint(*(const guint8*)data, == ,*byte);
+        }
+        g_byte_array_append(test->completed, byte, 1);
+        if (test->cancel_id && test->batches) {
+            /* The request is already in the batch */
+            g_assert(nfc_target_cancel_transmit(target, test->cancel_id));
+            g_assert(!nfc_target_cancel_transmit(target, test->cancel_id));
+            test->cancel_id = 0;
+        }
+    } else {
+        test->failed++;
+    }
+}
+
+static
+void
+test_transmit_batch(
+    void)
+{
+    static const guint8 data[] = { 0x00, 0x01, 0x02, 0x03, 0x04 };
+    static const guint8 expected[] = { 0x00, 0x01, 0x02, 0x04 };
+    TestTarget4* test = test_target4_new();
+    NfcTarget* target = NFC_TARGET(test);
+    NfcTargetSequence* seq = nfc_target_sequence_new(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    guint ids[G_N_ELEMENTS(data)];
+    guint i;
+
+    /* The first one is submitted right away, the rest get queued */
+    for (i = 0; i < G_N_ELEMENTS(data); i++) {
+        ids[i] = nfc_target_transmit(target, data + i, 1, seq,
+            test_transmit_batch_resp, NULL, (void*) (data + i));
+        g_assert(ids[i]);
+    }
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+    nfc_target_sequence_unref(seq);
+
+    /* The second frame cancels the fourth one */
+    test->cancel_id = ids[3];
+    test_run(&test_opt, loop);
+
+    /* Everything but the first one went in a single batch */
+    g_assert_cmpuint(test->batches, == ,1);
+    g_assert_cmpuint(test->max_batch, == ,4);
+    g_assert_cmpuint(test->failed, == ,0);
+    g_assert_cmpuint(test->completed->len, == ,sizeof(expected));
+    g_assert(!memcmp(test->completed->data, expected, sizeof(expected)));
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * transmit_batch_fail
+ *==========================================================================*/
+
+static
+void
+test_transmit_batch_fail(
+    void)
+{
+    static const guint8 data[] = { 0x00, 0x01, 0x02, 0x03, 0x04 };
+    static const guint8 expected[] = { 0x00, 0x02, 0x03, 0x04 };
+    TestTarget4* test = test_target4_new();
+    NfcTarget* target = NFC_TARGET(test);
+    NfcTargetSequence* seq = nfc_target_sequence_new(target);
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(data); i++) {
+        g_assert(nfc_target_transmit(target, data + i, 1, seq,
+            test_transmit_batch_resp, NULL, (void*) (data + i)));
+    }
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+    nfc_target_sequence_unref(seq);
+
+    /* Only the first frame of the failed batch fails */
+    test->fail_batch = 1;
+    test_run(&test_opt, loop);
+
+    g_assert_cmpuint(test->batches, == ,1);
+    g_assert_cmpuint(test->max_batch, == ,3);
+    g_assert_cmpuint(test->failed, == ,1);
+    g_assert_cmpuint(test->completed->len, == ,sizeof(expected));
+    g_assert(!memcmp(test->completed->data, expected, sizeof(expected)));
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
 /*==========================================================================*
  * transmit_fail
  *==========================================================================*/
@@ -602,6 +1212,104 @@ test_transmit_fail(
     g_main_loop_unref(loop);
 }
 
+/*==========================================================================*
+ * transmit_timeout
+ *==========================================================================*/
+
+static
+void
+test_transmit_timeout_resp(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestTarget* test = TEST_TARGET(target);
+
+    GDEBUG("Status %d", status);
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_TIMEOUT);
+    g_assert(!len);
+    test->failed++;
+}
+
+static
+void
+test_transmit_timeout(
+    void)
+{
+    static const guint8 data[] = { 0x01 };
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    gint64 start;
+
+    /* Each request gets its own deadline */
+    test->no_response = TRUE;
+    nfc_target_set_transmit_timeout(target, 50);
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        test_transmit_timeout_resp, NULL, NULL));
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        test_transmit_timeout_resp, NULL, NULL));
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        test_transmit_timeout_resp, test_quit_loop, loop));
+
+    start = g_get_monotonic_time();
+    test_run(&test_opt, loop);
+    g_assert_cmpint(g_get_monotonic_time() - start, >= ,
+        2 * 50 * G_TIME_SPAN_MILLISECOND);
+    g_assert_cmpuint(test->failed, == ,3);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
+/*==========================================================================*
+ * transmit_timeout_adaptive
+ *==========================================================================*/
+
+static
+void
+test_transmit_timeout_adaptive(
+    void)
+{
+    static const guint8 data[] = { 0x01 };
+    static const GUtilData empty = { NULL, 0 };
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    GMainLoop* loop = g_main_loop_new(NULL, TRUE);
+    gint64 start;
+    int i;
+
+    nfc_target_set_adaptive_timeout(NULL, TRUE);
+    nfc_target_set_transmit_timeout(target, 10000);
+    nfc_target_set_adaptive_timeout(target, TRUE);
+    nfc_target_set_adaptive_timeout(target, TRUE);
+
+    /* Collect some samples */
+    for (i = 0; i < 4; i++) {
+        g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+            test_transmit_ok_resp, NULL, (void*) &empty));
+    }
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, NULL,
+        test_quit_loop, loop));
+    test_run(&test_opt, loop);
+    g_assert_cmpuint(test->succeeded, == ,4);
+
+    /* Fast target gets a lot less than the configured timeout */
+    test->no_response = TRUE;
+    g_assert(nfc_target_transmit(target, data, sizeof(data), NULL,
+        test_transmit_timeout_resp, test_quit_loop, loop));
+    start = g_get_monotonic_time();
+    test_run(&test_opt, loop);
+    g_assert_cmpint(g_get_monotonic_time() - start, < ,
+        5000 * G_TIME_SPAN_MILLISECOND);
+    g_assert_cmpuint(test->failed, == ,1);
+
+    nfc_target_unref(target);
+    g_main_loop_unref(loop);
+}
+
 /*==========================================================================*
  * transmit_cancel
  *==========================================================================*/
@@ -889,6 +1597,125 @@ test_sequence2(
     g_main_loop_unref(loop);
 }
 
+/*==========================================================================*
+ * queue_bench
+ *==========================================================================*/
+
+#define TEST_QUEUE_BENCH_SEQ_COUNT (8)
+#define TEST_QUEUE_BENCH_REQ_COUNT (4000)
+#define TEST_QUEUE_BENCH_CANCEL (7) /* Cancel every 7th request */
+
+typedef struct test_queue_bench {
+    GMainLoop* loop;
+    GArray* completed;
+    guint remaining;
+} TestQueueBench;
+
+static
+void
+test_queue_bench_resp(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestQueueBench* bench = *(TestQueueBench**)user_data;
+    const guint k = GPOINTER_TO_UINT(((gpointer*)user_data)[1]);
+
+    g_assert(status == NFC_TRANSMIT_STATUS_OK);
+    g_array_append_val(bench->completed, k);
+    if (!--(bench->remaining)) {
+        g_main_loop_quit(bench->loop);
+    }
+}
+
+static
+void
+test_queue_bench(
+    void)
+{
+    static const guint8 data[] = { 0x30, 0x00 };
+    const guint n = TEST_QUEUE_BENCH_REQ_COUNT;
+    const guint nseq = TEST_QUEUE_BENCH_SEQ_COUNT;
+    TestTarget* test = test_target_new();
+    NfcTarget* target = &test->target;
+    NfcTargetSequence* seq[TEST_QUEUE_BENCH_SEQ_COUNT];
+    TestQueueBench bench;
+    gpointer* args = g_new(gpointer, 2 * n);
+    guint* ids = g_new(guint, n);
+    GArray* expected = g_array_sized_new(FALSE, FALSE, sizeof(guint), n);
+    gint64 start;
+    guint i, k;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.loop = g_main_loop_new(NULL, TRUE);
+    bench.completed = g_array_sized_new(FALSE, FALSE, sizeof(guint), n);
+    nfc_target_set_transmit_timeout(target, 0);
+    for (i = 0; i < nseq; i++) {
+        seq[i] = nfc_target_sequence_new(target);
+    }
+
+    /*
+     * Interleave requests between the sequences and requests without
+     * any sequence (every (nseq + 1)th request).
+     */
+    start = g_get_monotonic_time();
+    for (k = 0; k < n; k++) {
+        const guint s = k % (nseq + 1);
+
+        args[2 * k] = &bench;
+        args[2 * k + 1] = GUINT_TO_POINTER(k);
+        ids[k] = nfc_target_transmit(target, data, sizeof(data),
+            (s < nseq) ? seq[s] : NULL, test_queue_bench_resp, NULL,
+            args + 2 * k);
+        g_assert(ids[k]);
+    }
+    /* The first request is already active, don't cancel it */
+    bench.remaining = 1;
+    for (k = 1; k < n; k++) {
+        if (!(k % TEST_QUEUE_BENCH_CANCEL)) {
+            g_assert(nfc_target_cancel_transmit(target, ids[k]));
+            g_assert(!nfc_target_cancel_transmit(target, ids[k]));
+        } else {
+            bench.remaining++;
+        }
+    }
+    GDEBUG("Queued %u requests in %u us", n, (guint)
+        (g_get_monotonic_time() - start));
+
+    /*
+     * Sequences run one after another in the order of their first
+     * request, the requests without a sequence follow.
+     */
+    for (i = 0; i <= nseq; i++) {
+        for (k = i; k < n; k += nseq + 1) {
+            if (!k || (k % TEST_QUEUE_BENCH_CANCEL)) {
+                g_array_append_val(expected, k);
+            }
+        }
+    }
+    for (i = 0; i < nseq; i++) {
+        nfc_target_sequence_free(seq[i]);
+    }
+
+    start = g_get_monotonic_time();
+    test_run(&test_opt, bench.loop);
+    GDEBUG("Completed %u requests in %u us", expected->len, (guint)
+        (g_get_monotonic_time() - start));
+
+    g_assert_cmpuint(bench.completed->len, == ,expected->len);
+    g_assert(!memcmp(bench.completed->data, expected->data,
+        expected->len * sizeof(guint)));
+
+    nfc_target_unref(target);
+    g_main_loop_unref(bench.loop);
+    g_array_free(bench.completed, TRUE);
+    g_array_free(expected, TRUE);
+    g_free(args);
+    g_free(ids);
+}
+
 /*==========================================================================*
  * reactivate
  *==========================================================================*/
@@ -1051,12 +1878,23 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("null"), test_null);
     g_test_add_func(TEST_("basic"), test_basic);
     g_test_add_func(TEST_("transmit_ok"), test_transmit_ok);
+    g_test_add_func(TEST_("dispatch_sync"), test_dispatch_sync);
+    g_test_add_func(TEST_("dispatch_nested"), test_dispatch_nested);
+    g_test_add_func(TEST_("dispatch_idle"), test_dispatch_idle);
+    g_test_add_func(TEST_("transmit_bytes"), test_transmit_bytes);
+    g_test_add_func(TEST_("transmit_bytes2"), test_transmit_bytes2);
+    g_test_add_func(TEST_("transmit_batch"), test_transmit_batch);
+    g_test_add_func(TEST_("transmit_batch_fail"), test_transmit_batch_fail);
     g_test_add_func(TEST_("transmit_fail"), test_transmit_fail);
+    g_test_add_func(TEST_("transmit_timeout"), test_transmit_timeout);
+    g_test_add_func(TEST_("transmit_timeout_adaptive"),
+        test_transmit_timeout_adaptive);
     g_test_add_func(TEST_("transmit_cancel"), test_transmit_cancel);
     g_test_add_func(TEST_("transmit_destroy"), test_transmit_destroy);
     g_test_add_func(TEST_("sequence_basic"), test_sequence_basic);
     g_test_add_func(TEST_("sequence_ok"), test_sequence_ok);
     g_test_add_func(TEST_("sequence2"), test_sequence2);
+    g_test_add_func(TEST_("queue_bench"), test_queue_bench);
     g_test_add_func(TEST_("reactivate"), test_reactivate);
     g_test_add_func(TEST_("reactivate_ok"), test_reactivate_ok);
     g_test_add_func(TEST_("reactivate_gone"), test_reactivate_gone);
@@ -0,0 +1,521 @@
+/*
+ * Copyright (C) 2026 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfc_target_p.h"
+#include "nfc_target_impl.h"
+#include "nfc_target_recorder.h"
+
+#include "test_common.h"
+#include "test_target.h"
+#include "test_target_replay.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+
+#define TMP_DIR_TEMPLATE "test_XXXXXX"
+#define TRACE_FILE "trace"
+
+static TestOpt test_opt;
+
+static const guint8 test_cmd0[] = { 0x30, 0x00 };
+static const guint8 test_cmd1[] = { 0x30, 0x04 };
+static const guint8 test_resp1[] = { 0x01, 0x02, 0x03, 0x04 };
+static const guint8 test_cmd2[] = { 0x30, 0x08 };
+static const guint8 test_resp2[] = { 0x05, 0x06, 0x07, 0x08 };
+static const guint8 test_cmd3[] = { 0x30, 0x0c };
+
+typedef struct test_data {
+    GMainLoop* loop;
+    guint ok;
+    guint errors;
+} TestData;
+
+static
+void
+test_quit_loop(
+    void* user_data)
+{
+    g_main_loop_quit(((TestData*)user_data)->loop);
+}
+
+static
+void
+test_transmit_not_reached(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    g_assert_not_reached();
+}
+
+static
+void
+test_transmit_resp1(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_OK);
+    g_assert_cmpuint(len, == ,sizeof(test_resp1));
+    g_assert(!memcmp(data, test_resp1, len));
+    test->ok++;
+}
+
+static
+void
+test_transmit_resp2(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_OK);
+    g_assert_cmpuint(len, == ,sizeof(test_resp2));
+    g_assert(!memcmp(data, test_resp2, len));
+    test->ok++;
+}
+
+static
+void
+test_transmit_error(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    g_assert_cmpint(status, == ,NFC_TRANSMIT_STATUS_ERROR);
+    g_assert(!len);
+    test->errors++;
+}
+
+static
+void
+test_transmit_any(
+    NfcTarget* target,
+    NFC_TRANSMIT_STATUS status,
+    const void* data,
+    guint len,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    if (status == NFC_TRANSMIT_STATUS_OK) {
+        test->ok++;
+    } else {
+        test->errors++;
+    }
+}
+
+/*
+ * The same exchange is used for both recording and replaying:
+ *
+ * 1. cmd0 gets cancelled right away
+ * 2. cmd1 and cmd2 are sent as a sequence
+ * 3. cmd3 fails
+ */
+static
+void
+test_exchange(
+    NfcTarget* target,
+    TestData* test)
+{
+    NfcTargetSequence* seq;
+    guint id;
+
+    id = nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd0), NULL,
+        test_transmit_not_reached, NULL, NULL);
+    g_assert(id);
+    g_assert(nfc_target_cancel_transmit(target, id));
+
+    seq = nfc_target_sequence_new(target);
+    g_assert(nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd1), seq,
+        test_transmit_resp1, NULL, test));
+    g_assert(nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd2), seq,
+        test_transmit_resp2, NULL, test));
+    nfc_target_sequence_unref(seq);
+
+    g_assert(nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd3), NULL,
+        test_transmit_error, test_quit_loop, test));
+
+    test_run(&test_opt, test->loop);
+    g_assert_cmpuint(test->ok, == ,2);
+    g_assert_cmpuint(test->errors, == ,1);
+}
+
+static
+GBytes*
+test_trace_new(
+    const guint8* data,
+    gsize size)
+{
+    static const guint8 header[] = {
+        'N', 'F', 'C', 'T', NFC_TARGET_TRACE_VERSION,
+        NFC_TECHNOLOGY_A, NFC_PROTOCOL_T2_TAG, 0x00
+    };
+    GByteArray* buf = g_byte_array_new();
+
+    g_byte_array_append(buf, header, sizeof(header));
+    g_byte_array_append(buf, data, size);
+    return g_byte_array_free_to_bytes(buf);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    NfcTarget* target = test_target_new(TEST_TARGET_FAIL_ALL);
+
+    g_assert(!nfc_target_recorder_new(NULL, NULL));
+    g_assert(!nfc_target_recorder_new(target, NULL));
+    g_assert(!nfc_target_recorder_new(target, "/no/such/dir/" TRACE_FILE));
+    g_assert(!test_target_replay_new_from_file("/no/such/dir/" TRACE_FILE,
+        0));
+    nfc_target_recorder_free(NULL);
+    nfc_target_unref(target);
+}
+
+/*==========================================================================*
+ * record
+ *==========================================================================*/
+
+static
+void
+test_record(
+    void)
+{
+    static const TestTx tx[] = {
+        {
+            { TEST_ARRAY_AND_SIZE(test_cmd0) },
+            { NULL, 0 }
+        },{
+            { TEST_ARRAY_AND_SIZE(test_cmd1) },
+            { TEST_ARRAY_AND_SIZE(test_resp1) }
+        },{
+            { TEST_ARRAY_AND_SIZE(test_cmd2) },
+            { TEST_ARRAY_AND_SIZE(test_resp2) }
+        },{
+            { TEST_ARRAY_AND_SIZE(test_cmd3) },
+            { NULL, 0 }
+        }
+    };
+    guint counts[NFC_TARGET_TRACE_CANCEL + 1];
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    char* path = g_build_filename(dir, TRACE_FILE, NULL);
+    NfcTarget* target = test_target_new_with_tx(TEST_ARRAY_AND_COUNT(tx));
+    NfcTargetRecorder* recorder;
+    const guint8* ptr;
+    const guint8* end;
+    gchar* contents = NULL;
+    gsize size = 0;
+    TestData test;
+
+    memset(&test, 0, sizeof(test));
+    memset(counts, 0, sizeof(counts));
+    test.loop = g_main_loop_new(NULL, TRUE);
+    target->technology = NFC_TECHNOLOGY_A;
+    target->protocol = NFC_PROTOCOL_T2_TAG;
+
+    /* Only one recorder per target */
+    recorder = nfc_target_recorder_new(target, path);
+    g_assert(recorder);
+    g_assert(!nfc_target_recorder_new(target, path));
+
+    test_exchange(target, &test);
+    nfc_target_recorder_free(recorder);
+    nfc_target_unref(target);
+
+    /* Parse the trace */
+    g_assert(g_file_get_contents(path, &contents, &size, NULL));
+    g_assert_cmpuint(size, > ,NFC_TARGET_TRACE_HEADER_SIZE);
+    g_assert(!memcmp(contents, NFC_TARGET_TRACE_MAGIC, 4));
+    g_assert_cmpuint(contents[4], == ,NFC_TARGET_TRACE_VERSION);
+    g_assert_cmpuint(contents[5], == ,NFC_TECHNOLOGY_A);
+    g_assert_cmpuint(contents[6], == ,NFC_PROTOCOL_T2_TAG);
+    ptr = (guint8*)contents + NFC_TARGET_TRACE_HEADER_SIZE;
+    end = (guint8*)contents + size;
+    while (ptr < end) {
+        guint len;
+
+        g_assert_cmpuint(end - ptr, >= ,NFC_TARGET_TRACE_RECORD_SIZE);
+        g_assert_cmpuint(ptr[0], <= ,NFC_TARGET_TRACE_CANCEL);
+        counts[ptr[0]]++;
+        len = ((guint)ptr[6] << 24) | ((guint)ptr[7] << 16) |
+            ((guint)ptr[8] << 8) | ptr[9];
+        ptr += NFC_TARGET_TRACE_RECORD_SIZE + len;
+    }
+    g_assert(ptr == end);
+    g_assert_cmpuint(counts[NFC_TARGET_TRACE_TRANSMIT], == ,4);
+    g_assert_cmpuint(counts[NFC_TARGET_TRACE_RESPONSE], == ,3);
+    g_assert_cmpuint(counts[NFC_TARGET_TRACE_CANCEL], == ,1);
+    g_assert_cmpuint(counts[NFC_TARGET_TRACE_SEQUENCE_START], == ,1);
+    g_assert_cmpuint(counts[NFC_TARGET_TRACE_SEQUENCE_END], == ,1);
+    g_free(contents);
+
+    /* Replay it */
+    target = test_target_replay_new_from_file(path, 0);
+    g_assert(target);
+    g_assert_cmpint(target->technology, == ,NFC_TECHNOLOGY_A);
+    g_assert_cmpint(target->protocol, == ,NFC_PROTOCOL_T2_TAG);
+    g_assert_cmpuint(test_target_replay_remaining(target), == ,4);
+
+    test.ok = test.errors = 0;
+    test_exchange(target, &test);
+    g_assert_cmpuint(test_target_replay_remaining(target), == ,0);
+    g_assert_cmpuint(TEST_TARGET_REPLAY(target)->mismatches, == ,0);
+    nfc_target_unref(target);
+
+    g_main_loop_unref(test.loop);
+    g_assert_cmpint(test_rmdir(dir), == ,0);
+    g_free(path);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * record_gone
+ *==========================================================================*/
+
+static
+void
+test_record_gone(
+    void)
+{
+    char* dir = g_dir_make_tmp(TMP_DIR_TEMPLATE, NULL);
+    char* path = g_build_filename(dir, TRACE_FILE, NULL);
+    NfcTarget* target = test_target_new(TEST_TARGET_FAIL_NONE);
+    NfcTargetRecorder* recorder = nfc_target_recorder_new(target, path);
+    NfcTargetSequence* seq = nfc_target_sequence_new(target);
+    TestData test;
+
+    /* The target dies while the transmission is pending */
+    memset(&test, 0, sizeof(test));
+    g_assert(recorder);
+    g_assert(nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd1), seq,
+        test_transmit_error, NULL, &test));
+    nfc_target_sequence_unref(seq);
+    nfc_target_unref(target);
+    g_assert_cmpuint(test.errors, == ,1);
+    nfc_target_recorder_free(recorder);
+
+    /* The failure has been recorded */
+    target = test_target_replay_new_from_file(path, 0);
+    g_assert(target);
+    g_assert_cmpuint(test_target_replay_remaining(target), == ,1);
+    nfc_target_unref(target);
+
+    g_assert_cmpint(test_rmdir(dir), == ,0);
+    g_free(path);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * replay_broken
+ *==========================================================================*/
+
+static
+void
+test_replay_broken(
+    void)
+{
+    static const guint8 bad_magic[] = {
+        'N', 'F', 'C', 'X', NFC_TARGET_TRACE_VERSION, 0x00, 0x00, 0x00
+    };
+    static const guint8 truncated[] = {
+        NFC_TARGET_TRACE_TRANSMIT, 0x00,
+        TEST_INT32_BYTES(0), TEST_INT32_BYTES(0), TEST_INT32_BYTES(0)
+    };
+    static const guint8 one_byte[] = { NFC_TARGET_TRACE_TRANSMIT };
+    static const guint8 too_long[] = {
+        NFC_TARGET_TRACE_TRANSMIT, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x30
+    };
+    GBytes* trace = g_bytes_new_static(bad_magic, sizeof(bad_magic));
+
+    g_assert(!test_target_replay_new(trace, 0));
+    g_bytes_unref(trace);
+
+    trace = test_trace_new(truncated, sizeof(truncated) - 1);
+    g_assert(!test_target_replay_new(trace, 0));
+    g_bytes_unref(trace);
+
+    /* Not even the record type and status */
+    trace = test_trace_new(TEST_ARRAY_AND_SIZE(one_byte));
+    g_assert(!test_target_replay_new(trace, 0));
+    g_bytes_unref(trace);
+
+    trace = test_trace_new(TEST_ARRAY_AND_SIZE(too_long));
+    g_assert(!test_target_replay_new(trace, 0));
+    g_bytes_unref(trace);
+}
+
+/*==========================================================================*
+ * replay_mismatch
+ *==========================================================================*/
+
+static
+void
+test_replay_mismatch(
+    void)
+{
+    static const guint8 records[] = {
+        NFC_TARGET_TRACE_TRANSMIT, 0x00,
+        0x00, 0x00, 0x00, 0x01,     /* id */
+        0x00, 0x00, 0x00, 0x02,     /* length */
+        0x00, 0x00, 0x00, 0x00,     /* delta */
+        0x30, 0x04,
+        NFC_TARGET_TRACE_RESPONSE, NFC_TRANSMIT_STATUS_OK,
+        0x00, 0x00, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+    GBytes* trace = test_trace_new(TEST_ARRAY_AND_SIZE(records));
+    NfcTarget* target = test_target_replay_new(trace, 0);
+
+    g_assert(target);
+    g_assert(!nfc_target_transmit(target, TEST_ARRAY_AND_SIZE(test_cmd2),
+        NULL, NULL, NULL, NULL));
+    g_assert_cmpuint(TEST_TARGET_REPLAY(target)->mismatches, == ,1);
+    g_assert_cmpuint(test_target_replay_remaining(target), == ,1);
+    nfc_target_unref(target);
+    g_bytes_unref(trace);
+}
+
+/*==========================================================================*
+ * replay_timing
+ *==========================================================================*/
+
+static
+void
+test_replay_timing(
+    void)
+{
+    /* Response comes 100 ms after the command */
+    static const guint8 records[] = {
+        NFC_TARGET_TRACE_TRANSMIT, 0x00,
+        TEST_INT32_BYTES(0), TEST_INT32_BYTES(0), TEST_INT32_BYTES(0),
+        NFC_TARGET_TRACE_RESPONSE, NFC_TRANSMIT_STATUS_OK,
+        TEST_INT32_BYTES(0), TEST_INT32_BYTES(0), TEST_INT32_BYTES(0)
+    };
+    guint8* data = gutil_memdup(records, sizeof(records));
+    GBytes* trace;
+    NfcTarget* target;
+    gint64 start;
+    TestData test;
+
+    /* TEST_INT32_BYTES is host endian, fix the values up */
+    data[NFC_TARGET_TRACE_RECORD_SIZE + 10] = 0x00;
+    data[NFC_TARGET_TRACE_RECORD_SIZE + 11] = 0x01;
+    data[NFC_TARGET_TRACE_RECORD_SIZE + 12] = 0x86;
+    data[NFC_TARGET_TRACE_RECORD_SIZE + 13] = 0xa0;
+    trace = test_trace_new(data, sizeof(records));
+    g_free(data);
+
+    memset(&test, 0, sizeof(test));
+    test.loop = g_main_loop_new(NULL, TRUE);
+
+    /* Original timing */
+    target = test_target_replay_new(trace, 1);
+    g_assert(target);
+    nfc_target_set_transmit_timeout(target, 0);
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, test_transmit_any,
+        test_quit_loop, &test));
+    start = g_get_monotonic_time();
+    test_run(&test_opt, test.loop);
+    g_assert_cmpint(g_get_monotonic_time() - start, >= ,
+        100 * G_TIME_SPAN_MILLISECOND);
+    g_assert_cmpuint(test.ok, == ,1);
+    nfc_target_unref(target);
+
+    /* As fast as possible */
+    target = test_target_replay_new(trace, 0);
+    g_assert(target);
+    g_assert(nfc_target_transmit(target, NULL, 0, NULL, test_transmit_any,
+        test_quit_loop, &test));
+    test_run(&test_opt, test.loop);
+    g_assert_cmpuint(test.ok, == ,2);
+    nfc_target_unref(target);
+
+    g_main_loop_unref(test.loop);
+    g_bytes_unref(trace);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/core/target_recorder/" name
+
+int main(int argc, char* argv[])
+{
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+    g_type_init();
+    G_GNUC_END_IGNORE_DEPRECATIONS;
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("record"), test_record);
+    g_test_add_func(TEST_("record_gone"), test_record_gone);
+    g_test_add_func(TEST_("replay_broken"), test_replay_broken);
+    g_test_add_func(TEST_("replay_mismatch"), test_replay_mismatch);
+    g_test_add_func(TEST_("replay_timing"), test_replay_timing);
+    test_init(&test_opt, argc, argv);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -424,6 +424,10 @@ static const guint8 test_apdu_encoded_case4e_lc_256_le_256[] = {
     0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff, 0x01,
     0x00 /* Le */
 };
+static const guint8 test_apdu_encoded_case4e_lc_2_le_257[] = {
+ /* CLA   INS   P1    P2    00    LC1   LC2   BODY......  LE1   LE2 */
+    0x01, 0x02, 0x03, 0x04, 0x00, 0x00, 0x02, 0xdd, 0xdd, 0x01, 0x01
+};
 static const guint8 test_apdu_encoded_case4e_lc_256_le_65536[] = {
  /* CLA   INS   P1    P2    00    LC1   LC2   BODY...  LE1 LE2 */
     0x01, 0x02, 0x03, 0x04, 0x00, 0x01, 0x00, 0x00,
@@ -560,6 +564,11 @@ static const TestApduEncodeData tests_apdu_encode_decode[] = {
         { 0x01, 0x02, 0x03, 0x04,
         { test_apdu_encoded_case4e_lc_256_le_65536 + 7, 256 }, 65536 },
         { TEST_ARRAY_AND_SIZE(test_apdu_encoded_case4e_lc_256_le_65536) }
+    },{
+        "case4e/lc_2_le_257",
+        { 0x01, 0x02, 0x03, 0x04,
+        { test_apdu_encoded_case4e_lc_2_le_257 + 7, 2 }, 257 },
+        { TEST_ARRAY_AND_SIZE(test_apdu_encoded_case4e_lc_2_le_257) }
     }
 };
 
@@ -37,11 +37,13 @@
  */
 
 #include "nfc_types_p.h"
+#include "nfc_tag_p.h"
 
 #include "dbus_handlers/dbus_handlers.h"
 
 #include "test_common.h"
 #include "test_dbus.h"
+#include "test_target.h"
 #include "test.handler.h"
 
 #include <glib/gstdio.h>
@@ -748,6 +750,150 @@ test_no_return(
     test_data_cleanup(&test);
 }
 
+/*==========================================================================*
+ * tag
+ *==========================================================================*/
+
+typedef NfcTagClass TestTagClass;
+typedef struct test_tag {
+    NfcTag tag;
+    int read_ndef_count;
+} TestTag;
+
+#define TEST_TYPE_TAG (test_tag_get_type())
+#define TEST_TAG(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, TEST_TYPE_TAG, TestTag)
+G_DEFINE_TYPE(TestTag, test_tag, NFC_TYPE_TAG)
+
+static
+gboolean
+test_tag_read_ndef(
+    NfcTag* tag)
+{
+    /* The test completes the read by calling nfc_tag_set_ndef_ready() */
+    TEST_TAG(tag)->read_ndef_count++;
+    return TRUE;
+}
+
+static
+void
+test_tag_init(
+    TestTag* self)
+{
+}
+
+static
+void
+test_tag_class_init(
+    NfcTagClass* klass)
+{
+    klass->read_ndef = test_tag_read_ndef;
+}
+
+typedef struct test_tag_data {
+    TestData data;
+    NfcTag* tag;
+    DBusHandlersTag* tag_handlers;
+    gboolean deferred;
+    int count;
+} TestTagData;
+
+static
+gboolean
+test_tag_handle(
+    TestHandler* object,
+    GDBusMethodInvocation* call,
+    GVariant* data,
+    gpointer user_data)
+{
+    gsize size = 0;
+    const guint8* ndef = g_variant_get_fixed_array(data, &size, 1);
+    TestTagData* test = user_data;
+
+    test->count++;
+    GDEBUG("Handler received %u bytes NDEF message", (guint)size);
+    g_assert_cmpint(test->count, == ,1);
+    g_assert_cmpuint(size, == ,sizeof(test_ndef_data));
+    g_assert(!memcmp(ndef, test_ndef_data, size));
+    test_handler_complete_handle(object, call, TRUE);
+    test_quit_later_n(test->data.loop, 100); /* Allow everything to complete */
+    return TRUE;
+}
+
+static
+void
+test_tag_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestTagData* test = user_data;
+    TestData* data = &test->data;
+    NfcTag* tag = test->tag;
+
+    g_assert(g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
+        (data->dbus_handler), server, TEST_PATH, NULL));
+
+    data->handlers = dbus_handlers_new(client, data->dir);
+    g_assert(data->handlers);
+    test->tag_handlers = dbus_handlers_tag_new(tag, data->handlers);
+    g_assert(test->tag_handlers);
+
+    if (test->deferred) {
+        /* The tag is reported initialized before its NDEF is read */
+        tag->flags |= NFC_TAG_FLAG_NDEF_DEFERRED;
+        nfc_tag_set_initialized(tag);
+        /* The handlers need the records and ask for them */
+        g_assert_cmpint(TEST_TAG(tag)->read_ndef_count, == ,1);
+    }
+
+    /* The handlers are run once the whole message is there */
+    tag->ndef = ndef_rec_ref(data->rec);
+    if (test->deferred) {
+        nfc_tag_set_ndef_ready(tag);
+    } else {
+        nfc_tag_set_initialized(tag);
+    }
+}
+
+static
+void
+test_tag(
+    gconstpointer deferred)
+{
+    TestTagData test;
+    TestDBus* dbus;
+    NfcTarget* target = test_target_new(FALSE);
+    NfcParamPoll poll;
+    const char* config =
+        "[Handler]\n"
+        "Service = " TEST_SERVICE "\n"
+        "Method = " TEST_INTERFACE ".Handle\n"
+        "Path = " TEST_PATH "\n";
+
+    memset(&test, 0, sizeof(test));
+    memset(&poll, 0, sizeof(poll));
+    test_data_init(&test.data, config);
+    test.deferred = GPOINTER_TO_INT(deferred);
+    test.tag = g_object_new(TEST_TYPE_TAG, NULL);
+    nfc_tag_init_base(test.tag, target, &poll);
+    nfc_tag_set_name(test.tag, "tag0");
+
+    g_assert(g_signal_connect(test.data.dbus_handler, "handle-handle",
+        G_CALLBACK(test_tag_handle), &test));
+    g_assert(g_signal_connect(test.data.dbus_handler, "handle-notify",
+        G_CALLBACK(test_no_notify), &test));
+
+    dbus = test_dbus_new(test_tag_start, &test);
+    test_run(&test_opt, test.data.loop);
+    g_assert_cmpint(test.count, == ,1);
+
+    dbus_handlers_tag_free(test.tag_handlers);
+    nfc_tag_unref(test.tag);
+    nfc_target_unref(target);
+    test_dbus_free(dbus);
+    test_data_cleanup(&test.data);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -770,6 +916,9 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("listeners"), test_listeners);
     g_test_add_func(TEST_("invalid_return"), test_invalid_return);
     g_test_add_func(TEST_("no_return"), test_no_return);
+    g_test_add_data_func(TEST_("tag"), GINT_TO_POINTER(FALSE), test_tag);
+    g_test_add_data_func(TEST_("tag_deferred"), GINT_TO_POINTER(TRUE),
+        test_tag);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
@@ -272,6 +272,28 @@ test_call_transmit(
         TEST_DBUS_TIMEOUT, NULL, callback, test);
 }
 
+static
+void
+test_call_transmit2(
+    TestData* test,
+    guint8 cla,
+    guint8 ins,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    guint le,
+    guint flags,
+    GAsyncReadyCallback callback)
+{
+    g_assert(test->connection);
+    g_dbus_connection_call(test->connection, NULL,
+        test_tag_path(test, test->adapter->tags[0]), NFC_ISODEP_INTERFACE,
+        "Transmit2", g_variant_new("(yyyy@ayuu)", cla, ins, p1, p2,
+        g_variant_new_from_data(G_VARIANT_TYPE_BYTESTRING, data->bytes,
+        data->size, TRUE, NULL, NULL), le, flags), NULL,
+        G_DBUS_CALL_FLAGS_NONE, TEST_DBUS_TIMEOUT, NULL, callback, test);
+}
+
 static
 void
 test_call_no_args(
@@ -903,6 +925,284 @@ test_transmit_fail_early(
     test_dbus_free(dbus);
 }
 
+/*==========================================================================*
+ * transmit2/ok
+ *==========================================================================*/
+
+static const guint8 test_transmit2_cmd_read[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x00   /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_transmit2_resp_read[] = {
+    0x01, 0x02,                    /* Data */
+    0x61, 0x04                     /* SW1|SW2 */
+};
+static const guint8 test_transmit2_cmd_get_response[] = {
+    0x00, 0xc0, 0x00, 0x00, 0x04   /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_transmit2_resp_get_response[] = {
+    0x03, 0x04, 0x05, 0x06,        /* Data */
+    0x90, 0x00                     /* SW1|SW2 */
+};
+static const guint8 test_transmit2_data[] = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06
+};
+
+static
+void
+test_transmit2_ok_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    GVariant* data = NULL;
+    guint8 sw1, sw2;
+    GVariant* var = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object),
+        result, NULL);
+
+    g_assert(var);
+    g_variant_get(var, "(@ayyy)", &data, &sw1, &sw2);
+    g_assert(data);
+    GDEBUG("%02X %02X", sw1, sw2);
+    g_assert_cmpuint(sw1, == ,0x90);
+    g_assert_cmpuint(sw2, == ,0x00);
+    g_assert_cmpuint(g_variant_get_size(data), == ,
+        sizeof(test_transmit2_data));
+    g_assert(!memcmp(g_variant_get_data(data), test_transmit2_data,
+        sizeof(test_transmit2_data)));
+
+    g_variant_unref(data);
+    g_variant_unref(var);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_transmit2_ok_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+    const guint8* cmd = test_transmit2_cmd_read;
+    GUtilData cmd_data;
+
+    memset(&cmd_data, 0, sizeof(cmd_data));
+    nfc_tag_set_initialized(test->adapter->tags[0]);
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_adapter_new(test->adapter, server);
+    g_assert(test->service);
+    test_call_transmit2(test, cmd[0], cmd[1], cmd[2], cmd[3],
+        &cmd_data, 0x100, NFC_ISODEP_TX_FLAG_GET_RESPONSE,
+        test_transmit2_ok_done);
+}
+
+static
+void
+test_transmit2_ok(
+    void)
+{
+    TestData test;
+    TestDBus* dbus;
+    NfcTarget* target = test_target_create(0);
+
+    test_data_init_with_target_a(&test, target, 0);
+    test_target_add_data(target,
+        TEST_ARRAY_AND_SIZE(test_transmit2_cmd_read),
+        TEST_ARRAY_AND_SIZE(test_transmit2_resp_read));
+    test_target_add_data(target,
+        TEST_ARRAY_AND_SIZE(test_transmit2_cmd_get_response),
+        TEST_ARRAY_AND_SIZE(test_transmit2_resp_get_response));
+    nfc_target_unref(target);
+
+    dbus = test_dbus_new(test_transmit2_ok_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
+/*==========================================================================*
+ * write_ndef/ok
+ * write_ndef/fail
+ *==========================================================================*/
+
+static const guint8 test_write_ndef_data[] = { 0xd0, 0x00, 0x00 };
+static const guint8 test_write_ndef_cmd_select_app[] = {
+    0x00, 0xa4, 0x04, 0x00, 0x07,             /* CLA|INS|P1|P2|Lc  */
+    0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, /* Data */
+    0x00                                      /* Le */
+};
+static const guint8 test_write_ndef_cmd_select_cc[] = {
+    0x00, 0xa4, 0x00, 0x0c, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0xe1, 0x03                                /* Data */
+};
+static const guint8 test_write_ndef_cmd_read_cc[] = {
+    0x00, 0xb0, 0x00, 0x00, 0x0f              /* CLA|INS|P1|P2|Le  */
+};
+static const guint8 test_write_ndef_resp_cc[] = {
+    0x00, 0x0f, 0x20, 0x00, 0x3b, 0x00, 0x34, /* Data */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x32, 0x00,
+    0x00,
+    0x90, 0x00                                /* SW1|SW2 */
+};
+static const guint8 test_write_ndef_cmd_select_ndef[] = {
+    0x00, 0xa4, 0x00, 0x0c, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0xe1, 0x04                                /* Data */
+};
+static const guint8 test_write_ndef_cmd_clear_nlen[] = {
+    0x00, 0xd6, 0x00, 0x00, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0x00, 0x00                                /* Data */
+};
+static const guint8 test_write_ndef_cmd_data[] = {
+    0x00, 0xd6, 0x00, 0x02, 0x03,             /* CLA|INS|P1|P2|Lc  */
+    0xd0, 0x00, 0x00                          /* Data */
+};
+static const guint8 test_write_ndef_cmd_set_nlen[] = {
+    0x00, 0xd6, 0x00, 0x00, 0x02,             /* CLA|INS|P1|P2|Lc  */
+    0x00, 0x03                                /* Data */
+};
+static const guint8 test_write_ndef_resp_not_found[] = { 0x6a, 0x82 };
+
+static
+void
+test_call_write_ndef(
+    TestData* test,
+    GAsyncReadyCallback callback)
+{
+    g_assert(test->connection);
+    g_dbus_connection_call(test->connection, NULL,
+        test_tag_path(test, test->adapter->tags[0]), NFC_ISODEP_INTERFACE,
+        "WriteNdef", g_variant_new("(@ay)",
+        g_variant_new_from_data(G_VARIANT_TYPE_BYTESTRING,
+        test_write_ndef_data, sizeof(test_write_ndef_data), TRUE,
+        NULL, NULL)), NULL, G_DBUS_CALL_FLAGS_NONE,
+        TEST_DBUS_TIMEOUT, NULL, callback, test);
+}
+
+static
+void
+test_write_ndef_ok_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+
+    test_complete_ok(object, result);
+    g_assert_cmpuint(test_target_tx_remaining(test->adapter->tags[0]->
+        target), == ,0);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_write_ndef_ok_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    nfc_tag_set_initialized(test->adapter->tags[0]);
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_adapter_new(test->adapter, server);
+    g_assert(test->service);
+    test_call_write_ndef(test, test_write_ndef_ok_done);
+}
+
+static
+void
+test_write_ndef_ok(
+    void)
+{
+    static const TestTx tx[] = {
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_select_app) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_select_cc) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_read_cc) },
+          { TEST_ARRAY_AND_SIZE(test_write_ndef_resp_cc) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_select_ndef) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_clear_nlen) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_data) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } },
+        { { TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_set_nlen) },
+          { TEST_ARRAY_AND_SIZE(test_transmit_resp_ok) } }
+    };
+    TestData test;
+    TestDBus* dbus;
+    NfcTarget* target = test_target_new_with_tx(TEST_ARRAY_AND_COUNT(tx));
+
+    test_data_init_with_target_a(&test, target, 0);
+    nfc_target_unref(target);
+
+    dbus = test_dbus_new(test_write_ndef_ok_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
+static
+void
+test_write_ndef_fail_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    GError* error = NULL;
+    char* error_name;
+
+    g_assert(!g_dbus_connection_call_finish(G_DBUS_CONNECTION(object),
+        result, &error));
+    g_assert(error);
+    GDEBUG("%s", GERRMSG(error));
+    error_name = g_dbus_error_get_remote_error(error);
+    g_assert_cmpstr(error_name, == , "org.sailfishos.nfc.Error.NotSupported");
+    g_free(error_name);
+    g_error_free(error);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_write_ndef_fail_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    nfc_tag_set_initialized(test->adapter->tags[0]);
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_adapter_new(test->adapter, server);
+    g_assert(test->service);
+    test_call_write_ndef(test, test_write_ndef_fail_done);
+}
+
+static
+void
+test_write_ndef_fail(
+    void)
+{
+    TestData test;
+    TestDBus* dbus;
+    NfcTarget* target = test_target_create(0);
+
+    test_data_init_with_target_a(&test, target, 0);
+    test_target_add_data(target,
+        TEST_ARRAY_AND_SIZE(test_write_ndef_cmd_select_app),
+        TEST_ARRAY_AND_SIZE(test_write_ndef_resp_not_found));
+    nfc_target_unref(target);
+
+    dbus = test_dbus_new(test_write_ndef_fail_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
 /*==========================================================================*
  * reset/ok
  *==========================================================================*/
@@ -1009,6 +1309,135 @@ test_reset_unsupported(
     test_dbus_free(dbus);
 }
 
+/*==========================================================================*
+ * select_cache
+ *==========================================================================*/
+
+static
+void
+test_select_cache_transmit(
+    TestData* test,
+    GAsyncReadyCallback callback)
+{
+    const guint8* cmd = test_transmit_cmd_select_mf;
+    GUtilData cmd_data;
+
+    cmd_data.bytes = cmd + 5;
+    cmd_data.size = cmd[4];
+    test_call_transmit(test, cmd[0], cmd[1], cmd[2], cmd[3],
+        &cmd_data, 0, callback);
+}
+
+static
+void
+test_select_cache_stats_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    guint sent = 0, cached = 0;
+    GVariant* var = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object),
+        result, NULL);
+
+    g_assert(var);
+    g_variant_get(var, "(uu)", &sent, &cached);
+    GDEBUG("%u sent, %u cached", sent, cached);
+    g_assert_cmpuint(sent, == ,1);
+    g_assert_cmpuint(cached, == ,1);
+    g_variant_unref(var);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_select_cache_transmit2_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    guint8 sw1, sw2;
+    GVariant* var = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object),
+        result, NULL);
+
+    /* This one has been completed from the cache */
+    g_assert(var);
+    g_variant_get(var, "(@ayyy)", NULL, &sw1, &sw2);
+    g_assert_cmpuint(sw1, == ,0x90);
+    g_assert_cmpuint(sw2, == ,0x00);
+    g_variant_unref(var);
+    test_call_no_args(test, "GetSelectStats", test_select_cache_stats_done);
+}
+
+static
+void
+test_select_cache_transmit1_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+
+    test_complete_ok(object, result);
+    test_select_cache_transmit(test, test_select_cache_transmit2_done);
+}
+
+static
+void
+test_select_cache_enabled(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+
+    test_complete_ok(object, result);
+    test_select_cache_transmit(test, test_select_cache_transmit1_done);
+}
+
+static
+void
+test_select_cache_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    nfc_tag_set_initialized(test->adapter->tags[0]);
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_adapter_new(test->adapter, server);
+    g_assert(test->service);
+    g_dbus_connection_call(client, NULL,
+        test_tag_path(test, test->adapter->tags[0]), NFC_ISODEP_INTERFACE,
+        "SetSelectCache", g_variant_new("(b)", TRUE), NULL,
+        G_DBUS_CALL_FLAGS_NONE, TEST_DBUS_TIMEOUT, NULL,
+        test_select_cache_enabled, test);
+}
+
+static
+void
+test_select_cache(
+    void)
+{
+    TestData test;
+    TestDBus* dbus;
+    NfcTarget* target = test_target_create(0);
+
+    /* Only the first SELECT reaches the card */
+    test_data_init_with_target_a(&test, target, 0);
+    test_target_add_data(target,
+        TEST_ARRAY_AND_SIZE(test_transmit_cmd_select_mf),
+        TEST_ARRAY_AND_SIZE(test_transmit_resp_ok));
+    nfc_target_unref(target);
+
+    dbus = test_dbus_new(test_select_cache_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -1031,9 +1460,13 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("transmit/ok"), test_transmit_ok);
     g_test_add_func(TEST_("transmit/fail"), test_transmit_fail);
     g_test_add_func(TEST_("transmit/fail_early"), test_transmit_fail_early);
+    g_test_add_func(TEST_("transmit2/ok"), test_transmit2_ok);
+    g_test_add_func(TEST_("write_ndef/ok"), test_write_ndef_ok);
+    g_test_add_func(TEST_("write_ndef/fail"), test_write_ndef_fail);
     g_test_add_func(TEST_("reset/ok"), test_reset_ok);
     g_test_add_func(TEST_("reset/fail"), test_reset_fail);
     g_test_add_func(TEST_("reset/unsupported"), test_reset_unsupported);
+    g_test_add_func(TEST_("select_cache"), test_select_cache);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
@@ -41,6 +41,7 @@
 #include "nfc_types_p.h"
 #include "internal/nfc_manager_i.h"
 #include "nfc_adapter.h"
+#include "nfc_config.h"
 #include "nfc_version.h"
 
 #include "dbus_service/dbus_service.h"
@@ -434,6 +435,121 @@ test_basic(
     test_dbus_free(dbus);
 }
 
+/*==========================================================================*
+ * config
+ *==========================================================================*/
+
+static const char test_config_key_rw[] = "LlcpReceiveWindow";
+static const char test_config_key_miu[] = "LlcpMIU";
+static const char test_config_key_ack_delay[] = "LlcpAckDelay";
+
+static
+void
+test_config_changed(
+    NfcConfigurable* config,
+    const char* key,
+    GVariant* value,
+    void* user_data)
+{
+    int* count = user_data;
+
+    GDEBUG("%s changed", key);
+    (*count)++;
+}
+
+static
+void
+test_config_check(
+    NfcConfigurable* config,
+    const char* key,
+    gint32 expected)
+{
+    GVariant* value = nfc_config_get_value(config, key);
+
+    g_assert(value);
+    g_assert(g_variant_is_of_type(value, G_VARIANT_TYPE_INT32));
+    g_assert_cmpint(g_variant_get_int32(value), == ,expected);
+    g_variant_unref(value);
+}
+
+static
+void
+test_config_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+    DBusServicePlugin* test_plugin = test_dbus_service_plugin(test);
+    NfcConfigurable* config = NFC_CONFIGURABLE(test_plugin);
+    const char* const* keys = nfc_config_get_keys(config);
+    int count = 0;
+    gulong id;
+
+    g_assert_cmpuint(gutil_strv_length((GStrV*)keys), == ,3);
+    g_assert(gutil_strv_contains((GStrV*)keys, test_config_key_rw));
+    g_assert(gutil_strv_contains((GStrV*)keys, test_config_key_miu));
+    g_assert(gutil_strv_contains((GStrV*)keys, test_config_key_ack_delay));
+    g_assert(!nfc_config_get_value(config, "foo"));
+    g_assert(!nfc_config_set_value(config, "foo", NULL));
+
+    /* Zero means the default */
+    test_config_check(config, test_config_key_rw, 0);
+    test_config_check(config, test_config_key_miu, 0);
+    test_config_check(config, test_config_key_ack_delay, 0);
+
+    id = nfc_config_add_change_handler(config, test_config_key_rw,
+        test_config_changed, &count);
+    g_assert(id);
+    g_assert(nfc_config_set_value(config, test_config_key_rw,
+        g_variant_new_int32(4)));
+    g_assert_cmpint(count, == ,1);
+    test_config_check(config, test_config_key_rw, 4);
+    g_assert(nfc_config_set_value(config, test_config_key_rw,
+        g_variant_new_uint32(4)));
+    g_assert_cmpint(count, == ,1); /* No change => no notification */
+
+    /* The handler is only registered for the RW key */
+    g_assert(nfc_config_set_value(config, test_config_key_miu,
+        g_variant_new_int32(512)));
+    g_assert_cmpint(count, == ,1);
+    test_config_check(config, test_config_key_miu, 512);
+    g_assert(nfc_config_set_value(config, test_config_key_ack_delay,
+        g_variant_new_int32(20)));
+    test_config_check(config, test_config_key_ack_delay, 20);
+
+    /* Invalid values are rejected */
+    g_assert(!nfc_config_set_value(config, test_config_key_rw,
+        g_variant_new_int32(-1)));
+    g_assert(!nfc_config_set_value(config, test_config_key_miu,
+        g_variant_new_string("foo")));
+    test_config_check(config, test_config_key_rw, 4);
+    test_config_check(config, test_config_key_miu, 512);
+
+    /* NULL resets the value to the default */
+    g_assert(nfc_config_set_value(config, test_config_key_rw, NULL));
+    g_assert_cmpint(count, == ,2);
+    test_config_check(config, test_config_key_rw, 0);
+
+    nfc_config_remove_handler(config, id);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_config(
+    void)
+{
+    TestData test;
+    TestDBus* dbus;
+
+    test_data_init(&test);
+    dbus = test_dbus_new2(test_start, test_config_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
 /*==========================================================================*
  * stop
  *==========================================================================*/
@@ -2208,6 +2324,7 @@ int main(int argc, char* argv[])
     G_GNUC_END_IGNORE_DEPRECATIONS;
     g_test_init(&argc, &argv, NULL);
     g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("config"), test_config);
     g_test_add_func(TEST_("stop"), test_stop);
     g_test_add_func(TEST_("client_gone"), test_client_gone);
     g_test_add_func(TEST_("get_all"), test_get_all);
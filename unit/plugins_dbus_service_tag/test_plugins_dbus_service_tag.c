@@ -2310,6 +2310,420 @@ test_transceive_error3(
     test_dbus_free(dbus);
 }
 
+/*==========================================================================*
+ * Deferred NDEF
+ *==========================================================================*/
+
+typedef NfcTagClass TestTagClass;
+typedef struct test_tag {
+    NfcTag tag;
+    int read_ndef_count;
+} TestTag;
+
+#define TEST_TYPE_TAG (test_tag_get_type())
+#define TEST_TAG(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, TEST_TYPE_TAG, TestTag)
+#define TEST_DEFERRED_PARENT_PATH "/test"
+G_DEFINE_TYPE(TestTag, test_tag, NFC_TYPE_TAG)
+
+static
+gboolean
+test_tag_read_ndef(
+    NfcTag* tag)
+{
+    /* The test completes the read by calling nfc_tag_set_ndef_ready() */
+    TEST_TAG(tag)->read_ndef_count++;
+    return TRUE;
+}
+
+static
+void
+test_tag_init(
+    TestTag* self)
+{
+}
+
+static
+void
+test_tag_class_init(
+    NfcTagClass* klass)
+{
+    klass->read_ndef = test_tag_read_ndef;
+}
+
+typedef struct test_deferred_data {
+    GMainLoop* loop;
+    NfcTarget* target;
+    TestTag* tag;
+    DBusServiceTag* service;
+    GDBusConnection* connection;
+} TestDeferredData;
+
+static
+void
+test_deferred_data_init(
+    TestDeferredData* test)
+{
+    NfcTag* tag;
+
+    g_assert(!test_name_watch_count());
+    memset(test, 0, sizeof(*test));
+    test->target = test_target_new(FALSE);
+    test->tag = g_object_new(TEST_TYPE_TAG, NULL);
+    test->loop = g_main_loop_new(NULL, TRUE);
+
+    /* Tag is initialized but NDEF hasn't been read yet */
+    tag = &test->tag->tag;
+    nfc_tag_init_base(tag, test->target, NULL);
+    nfc_tag_set_name(tag, "tag0");
+    tag->flags |= NFC_TAG_FLAG_NDEF_DEFERRED;
+    nfc_tag_set_initialized(tag);
+}
+
+static
+void
+test_deferred_data_cleanup(
+    TestDeferredData* test)
+{
+    dbus_service_tag_free(test->service);
+    if (test->connection) {
+        g_object_unref(test->connection);
+    }
+    nfc_tag_unref(&test->tag->tag);
+    nfc_target_unref(test->target);
+    g_main_loop_unref(test->loop);
+    g_assert(!test_name_watch_count());
+}
+
+static
+void
+test_deferred_call(
+    TestDeferredData* test,
+    const char* method,
+    GVariant* args,
+    GAsyncReadyCallback callback)
+{
+    g_assert(test->connection);
+    g_assert(test->service);
+    g_dbus_connection_call(test->connection, NULL, test->service->path,
+        NFC_TAG_INTERFACE, method, args, NULL, G_DBUS_CALL_FLAGS_NONE,
+        TEST_DBUS_TIMEOUT, NULL, callback, test);
+}
+
+static
+void
+test_deferred_start_service(
+    TestDeferredData* test,
+    GDBusConnection* client,
+    GDBusConnection* server)
+{
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_tag_new(&test->tag->tag,
+        TEST_DEFERRED_PARENT_PATH, server);
+    g_assert(test->service);
+}
+
+static
+guint
+test_deferred_ndef_records_count(
+    GObject* connection,
+    GAsyncResult* result)
+{
+    gchar** records = NULL;
+    GVariant* var = g_dbus_connection_call_finish
+        (G_DBUS_CONNECTION(connection), result, NULL);
+    guint count;
+
+    g_assert(var);
+    g_variant_get(var, "(^ao)", &records);
+    g_assert(records);
+    count = g_strv_length(records);
+    GDEBUG("%u record(s)", count);
+    g_strfreev(records);
+    g_variant_unref(var);
+    return count;
+}
+
+/*==========================================================================*
+ * deferred_ndef
+ *==========================================================================*/
+
+static
+void
+test_deferred_ndef_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+
+    /* The call has been completed after the NDEF has been read */
+    g_assert(!(test->tag->tag.flags & NFC_TAG_FLAG_NDEF_DEFERRED));
+    g_assert_cmpuint(test_deferred_ndef_records_count(connection,
+        result), == ,1);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_deferred_ndef_continue(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+    NfcTag* tag = &test->tag->tag;
+
+    test_get_interface_version_complete_ok(connection, result);
+
+    /* GetNdefRecords has started the read and is waiting for it */
+    g_assert_cmpint(test->tag->read_ndef_count, == ,1);
+    tag->ndef = NDEF_REC(ndef_rec_t_new("test","en"));
+    nfc_tag_set_ndef_ready(tag);
+}
+
+static
+void
+test_deferred_ndef_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_deferred_start_service(test, client, server);
+    test_deferred_call(test, "GetNdefRecords", NULL,
+        test_deferred_ndef_done);
+    /* Wait for GetInterfaceVersion to complete before continuing */
+    test_deferred_call(test, "GetInterfaceVersion", NULL,
+        test_deferred_ndef_continue);
+}
+
+static
+void
+test_deferred_ndef(
+    void)
+{
+    TestDeferredData test;
+    TestDBus* dbus;
+
+    test_deferred_data_init(&test);
+    dbus = test_dbus_new(test_deferred_ndef_start, &test);
+    test_run(&test_opt, test.loop);
+    test_deferred_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
+/*==========================================================================*
+ * deferred_ndef_locked
+ *==========================================================================*/
+
+static
+void
+test_deferred_ndef_locked_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+
+    /* The lock holder doesn't wait for (and doesn't trigger) the read */
+    g_assert_cmpint(test->tag->read_ndef_count, == ,0);
+    g_assert(test->tag->tag.flags & NFC_TAG_FLAG_NDEF_DEFERRED);
+    g_assert_cmpuint(test_deferred_ndef_records_count(connection,
+        result), == ,0);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_deferred_ndef_locked_acquired(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_complete_ok(connection, result);
+    GDEBUG("Lock acquired");
+    test_deferred_call(test, "GetNdefRecords", NULL,
+        test_deferred_ndef_locked_done);
+}
+
+static
+void
+test_deferred_ndef_locked_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_sender = test_sender_1;
+    test_deferred_start_service(test, client, server);
+    test_deferred_call(test, "Acquire", g_variant_new("(b)", TRUE),
+        test_deferred_ndef_locked_acquired);
+}
+
+static
+void
+test_deferred_ndef_locked(
+    void)
+{
+    TestDeferredData test;
+    TestDBus* dbus;
+
+    test_deferred_data_init(&test);
+    dbus = test_dbus_new(test_deferred_ndef_locked_start, &test);
+    test_run(&test_opt, test.loop);
+    test_deferred_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
+/*==========================================================================*
+ * deferred_ndef_free
+ *==========================================================================*/
+
+static
+void
+test_deferred_ndef_free_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_complete_error(connection, result, DBUS_SERVICE_ERROR_ABORTED);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_deferred_ndef_free_continue(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_get_interface_version_complete_ok(connection, result);
+    g_assert_cmpint(test->tag->read_ndef_count, == ,1);
+
+    /* This completes pending GetNdefRecords with an error */
+    dbus_service_tag_free(test->service);
+    test->service = NULL;
+}
+
+static
+void
+test_deferred_ndef_free_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_deferred_start_service(test, client, server);
+    test_deferred_call(test, "GetNdefRecords", NULL,
+        test_deferred_ndef_free_done);
+    /* Wait for GetInterfaceVersion to complete before continuing */
+    test_deferred_call(test, "GetInterfaceVersion", NULL,
+        test_deferred_ndef_free_continue);
+}
+
+static
+void
+test_deferred_ndef_free(
+    void)
+{
+    TestDeferredData test;
+    TestDBus* dbus;
+
+    test_deferred_data_init(&test);
+    dbus = test_dbus_new(test_deferred_ndef_free_start, &test);
+    test_run(&test_opt, test.loop);
+    test_deferred_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
+/*==========================================================================*
+ * deferred_ndef_signal
+ *==========================================================================*/
+
+static
+void
+test_deferred_ndef_signal_changed(
+    GDBusConnection* connection,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* name,
+    GVariant* args,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+    gchar** records = NULL;
+
+    g_variant_get(args, "(^ao)", &records);
+    g_assert(records);
+    GDEBUG("%u record(s)", g_strv_length(records));
+    g_assert_cmpuint(g_strv_length(records), == ,1);
+    g_strfreev(records);
+
+    /* Nobody has asked for the records */
+    g_assert_cmpint(test->tag->read_ndef_count, == ,0);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_deferred_ndef_signal_continue(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestDeferredData* test = user_data;
+    NfcTag* tag = &test->tag->tag;
+
+    test_get_interface_version_complete_ok(connection, result);
+
+    /* The tag has read its NDEF by itself */
+    tag->ndef = NDEF_REC(ndef_rec_t_new("test","en"));
+    nfc_tag_set_ndef_ready(tag);
+}
+
+static
+void
+test_deferred_ndef_signal_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestDeferredData* test = user_data;
+
+    test_deferred_start_service(test, client, server);
+    g_assert(g_dbus_connection_signal_subscribe(client, NULL,
+        NFC_TAG_INTERFACE, "NdefRecordsChanged", test->service->path, NULL,
+        G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE, test_deferred_ndef_signal_changed,
+        test, NULL));
+    test_deferred_call(test, "GetInterfaceVersion", NULL,
+        test_deferred_ndef_signal_continue);
+}
+
+static
+void
+test_deferred_ndef_signal(
+    void)
+{
+    TestDeferredData test;
+    TestDBus* dbus;
+
+    test_deferred_data_init(&test);
+    dbus = test_dbus_new(test_deferred_ndef_signal_start, &test);
+    test_run(&test_opt, test.loop);
+    test_deferred_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -2352,6 +2766,11 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("transceive/error1"), test_transceive_error1);
     g_test_add_func(TEST_("transceive/error2"), test_transceive_error2);
     g_test_add_func(TEST_("transceive/error3"), test_transceive_error3);
+    g_test_add_func(TEST_("deferred_ndef"), test_deferred_ndef);
+    g_test_add_func(TEST_("deferred_ndef_locked"), test_deferred_ndef_locked);
+    g_test_add_func(TEST_("deferred_ndef_free"), test_deferred_ndef_free);
+    g_test_add_func(TEST_("deferred_ndef_signal"),
+        test_deferred_ndef_signal);
     test_init(&test_opt, argc, argv);
     return g_test_run();
 }
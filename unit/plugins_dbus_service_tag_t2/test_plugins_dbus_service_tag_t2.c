@@ -99,8 +99,10 @@ typedef struct test_data {
 
 static
 void
-test_data_init(
-    TestData* test)
+test_data_init_with_data(
+    TestData* test,
+    const guint8* bytes,
+    guint size)
 {
     NfcPluginsInfo pi;
     NfcTagParamT2 param;
@@ -110,8 +112,7 @@ test_data_init(
     memset(&pi, 0, sizeof(pi));
     g_assert((test->manager = nfc_manager_new(&pi)) != NULL);
     g_assert((test->adapter = test_adapter_new()) != NULL);
-    g_assert((test->target = test_target_t2_new
-        (TEST_ARRAY_AND_SIZE(test_tag_data))) != NULL);
+    g_assert((test->target = test_target_t2_new(bytes, size)) != NULL);
 
     memset(&param, 0, sizeof(param));
     TEST_BYTES_SET(param.nfcid1, test_nfcid1);
@@ -123,6 +124,14 @@ test_data_init(
     test->pool = gutil_idle_pool_new();
 }
 
+static
+void
+test_data_init(
+    TestData* test)
+{
+    test_data_init_with_data(test, TEST_ARRAY_AND_SIZE(test_tag_data));
+}
+
 static
 void
 test_data_cleanup(
@@ -1259,6 +1268,111 @@ test_write_data_txfail(
     test_dbus_free(dbus);
 }
 
+/*==========================================================================*
+ * sector1
+ *==========================================================================*/
+
+#define TEST_SECTOR1_DATA_SIZE (1264) /* 1008 bytes in sector 0 + 256 */
+#define TEST_SECTOR1_SIZE \
+    (TEST_SECTOR1_DATA_SIZE + TEST_TARGET_T2_DATA_OFFSET)
+#define TEST_SECTOR1_BLOCK (10)
+#define TEST_SECTOR1_OFFSET \
+    (TEST_TARGET_T2_SECTOR_SIZE + TEST_SECTOR1_BLOCK * \
+     TEST_TARGET_T2_BLOCK_SIZE)
+
+static
+void
+test_sector1_read_done(
+    GObject* conn,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    guint8 expected[TEST_TARGET_T2_READ_SIZE];
+
+    /* The block we have written followed by what was there before */
+    memcpy(expected, test->target->data.bytes + TEST_SECTOR1_OFFSET,
+        sizeof(expected));
+    g_assert(!memcmp(expected, test_write_data, sizeof(test_write_data)));
+    test_complete_ok_data(conn, result, expected, sizeof(expected));
+    g_assert_cmpuint(test->target->sector_selects, > ,0);
+    test_quit_later(test->loop);
+}
+
+static
+void
+test_sector1_write_done(
+    GObject* conn,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    TestData* test = user_data;
+    guint written = 0;
+    GVariant* var = g_dbus_connection_call_finish(G_DBUS_CONNECTION(conn),
+        result, NULL);
+
+    g_assert(var);
+    g_variant_get(var, "(u)", &written);
+    GDEBUG("written=%u", written);
+    g_assert_cmpuint(written, == ,sizeof(test_write_data));
+    g_variant_unref(var);
+
+    /* The data went to sector 1 */
+    g_assert(!memcmp(test->target->data.bytes + TEST_SECTOR1_OFFSET,
+        test_write_data, sizeof(test_write_data)));
+    g_assert(memcmp(test->target->data.bytes + TEST_SECTOR1_BLOCK *
+        TEST_TARGET_T2_BLOCK_SIZE, test_write_data, sizeof(test_write_data)));
+
+    /* Read it back */
+    test_call_read(test, 1, TEST_SECTOR1_BLOCK, test_sector1_read_done);
+}
+
+static
+void
+test_sector1_start(
+    GDBusConnection* client,
+    GDBusConnection* server,
+    void* user_data)
+{
+    TestData* test = user_data;
+
+    g_object_ref(test->connection = client);
+    test->service = dbus_service_adapter_new(test->adapter, server);
+    g_assert(test->service);
+    test_call_write(test, 1, TEST_SECTOR1_BLOCK,
+        TEST_ARRAY_AND_SIZE(test_write_data), test_sector1_write_done);
+}
+
+static
+void
+test_sector1(
+    void)
+{
+    guint8* bytes = g_malloc(TEST_SECTOR1_SIZE);
+    TestData test;
+    TestDBus* dbus;
+    guint i;
+
+    /* Same header, larger data area filled with non-repeating pattern */
+    memcpy(bytes, test_tag_data, TEST_TARGET_T2_DATA_OFFSET);
+    bytes[14] = TEST_SECTOR1_DATA_SIZE / 8;
+    for (i = TEST_TARGET_T2_DATA_OFFSET; i < TEST_SECTOR1_SIZE; i++) {
+        bytes[i] = (guint8)(i ^ (i >> 8));
+    }
+
+    /* Empty NDEF followed by Terminator TLV */
+    bytes[TEST_TARGET_T2_DATA_OFFSET] = 0x03;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 1] = 0x00;
+    bytes[TEST_TARGET_T2_DATA_OFFSET + 2] = 0xfe;
+
+    test_data_init_with_data(&test, bytes, TEST_SECTOR1_SIZE);
+    g_free(bytes);
+    dbus = test_dbus_new(test_sector1_start, &test);
+    test_run(&test_opt, test.loop);
+    test_data_cleanup(&test);
+    test_dbus_free(dbus);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -1292,6 +1406,7 @@ int main(int argc, char* argv[])
     g_test_add_func(TEST_("write_data/ok"), test_write_data_ok);
     g_test_add_func(TEST_("write_data/ioerr"), test_write_data_ioerr);
     g_test_add_func(TEST_("write_data/txfail"), test_write_data_txfail);
+    g_test_add_func(TEST_("sector1"), test_sector1);
     g_test_init(&argc, &argv, NULL);
     test_init(&test_opt, argc, argv);
     return g_test_run();